@@ -0,0 +1,328 @@
+#pragma once
+#include <stdexcept>
+#include "../OtpType.hpp"
+#include "../OtpInstrumentation.hpp"
+#include "OtpPlatform.hpp"
+#include "OtpCpuFeatures.hpp"
+#include "OtpCodecSimd.hpp"
+#include "OtpCodecTable.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // RFC 4648 Base32 with '=' padding. Decoding also accepts lower case letters and missing padding.
+    //
+
+    [[nodiscard]]
+    constexpr OtpTypeSize OtpBase32EncodedLength(OtpTypeSize cbBytes) noexcept {
+        return (cbBytes + 4) / 5 * 8;
+    }
+
+    //
+    // upper bound; the exact size is known only after padding has been seen.
+    //
+    [[nodiscard]]
+    constexpr OtpTypeSize OtpBase32DecodedMaxLength(OtpTypeSize cchBase32) noexcept {
+        return cchBase32 / 8 * 5 + cchBase32 % 8 * 5 / 8;
+    }
+
+#if WINOTP_SIMD_X86
+
+    //
+    // Encoding: every 5 input bytes become one 64-bit lane holding a 40-bit big-endian group, which is split
+    // in halves, quarters and then 5-bit indices so that each index lands in its own byte, in output order.
+    //
+
+    WINOTP_TARGET("ssse3,sse4.1")
+    WINOTP_FORCEINLINE __m128i OtpBase32EncodeCharsSse41(__m128i Bytes) noexcept {
+        __m128i Groups = _mm_shuffle_epi8(Bytes, _mm_setr_epi8(4, 3, 2, 1, 0, -1, -1, -1, 9, 8, 7, 6, 5, -1, -1, -1));
+        __m128i Halves = _mm_or_si128(_mm_srli_epi64(Groups, 20), _mm_slli_epi64(_mm_and_si128(Groups, _mm_set1_epi64x(0xFFFFF)), 32));
+        __m128i Quarters = _mm_or_si128(_mm_srli_epi32(Halves, 10), _mm_slli_epi32(_mm_and_si128(Halves, _mm_set1_epi32(0x3FF)), 16));
+        __m128i Indices = _mm_or_si128(_mm_srli_epi16(Quarters, 5), _mm_slli_epi16(_mm_and_si128(Quarters, _mm_set1_epi16(0x1F)), 8));
+
+        // 'A'..'Z' for 0..25, '2'..'7' for 26..31
+        __m128i Digits = _mm_and_si128(_mm_cmpgt_epi8(Indices, _mm_set1_epi8(25)), _mm_set1_epi8('2' - 26 - 'A'));
+        return _mm_add_epi8(_mm_add_epi8(Indices, _mm_set1_epi8('A')), Digits);
+    }
+
+    WINOTP_TARGET("avx2")
+    WINOTP_FORCEINLINE __m256i OtpBase32EncodeCharsAvx2(__m256i Bytes) noexcept {
+        __m256i Groups = _mm256_shuffle_epi8(Bytes, _mm256_setr_epi8(
+            4, 3, 2, 1, 0, -1, -1, -1, 9, 8, 7, 6, 5, -1, -1, -1,
+            4, 3, 2, 1, 0, -1, -1, -1, 9, 8, 7, 6, 5, -1, -1, -1
+        ));
+        __m256i Halves = _mm256_or_si256(_mm256_srli_epi64(Groups, 20), _mm256_slli_epi64(_mm256_and_si256(Groups, _mm256_set1_epi64x(0xFFFFF)), 32));
+        __m256i Quarters = _mm256_or_si256(_mm256_srli_epi32(Halves, 10), _mm256_slli_epi32(_mm256_and_si256(Halves, _mm256_set1_epi32(0x3FF)), 16));
+        __m256i Indices = _mm256_or_si256(_mm256_srli_epi16(Quarters, 5), _mm256_slli_epi16(_mm256_and_si256(Quarters, _mm256_set1_epi16(0x1F)), 8));
+
+        __m256i Digits = _mm256_and_si256(_mm256_cmpgt_epi8(Indices, _mm256_set1_epi8(25)), _mm256_set1_epi8('2' - 26 - 'A'));
+        return _mm256_add_epi8(_mm256_add_epi8(Indices, _mm256_set1_epi8('A')), Digits);
+    }
+
+    //
+    // Decoding: characters are range-checked and mapped to 5-bit values in one pass; Valid flags the lanes
+    // holding an alphabet character. maddubs/madd then merge value pairs into 10-bit words and 20-bit dwords,
+    // and each 64-bit lane is reassembled into its 40-bit group and byte-swapped into place.
+    //
+
+    WINOTP_TARGET("ssse3,sse4.1")
+    WINOTP_FORCEINLINE __m128i OtpBase32DecodeValuesSse41(__m128i Chars, __m128i& Valid) noexcept {
+        __m128i IsUpper = _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8('A' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), Chars));
+        __m128i IsLower = _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), Chars));
+        __m128i IsDigit = _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8('2' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('7' + 1), Chars));
+
+        Valid = _mm_or_si128(_mm_or_si128(IsUpper, IsLower), IsDigit);
+
+        return _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(IsUpper, _mm_sub_epi8(Chars, _mm_set1_epi8('A'))), _mm_and_si128(IsLower, _mm_sub_epi8(Chars, _mm_set1_epi8('a')))),
+            _mm_and_si128(IsDigit, _mm_sub_epi8(Chars, _mm_set1_epi8('2' - 26)))
+        );
+    }
+
+    //
+    // the 10 decoded bytes are in the low bytes of the result.
+    //
+    WINOTP_TARGET("ssse3,sse4.1")
+    WINOTP_FORCEINLINE __m128i OtpBase32PackSse41(__m128i Values) noexcept {
+        __m128i Words = _mm_maddubs_epi16(Values, _mm_set1_epi16(0x0120));
+        __m128i Dwords = _mm_madd_epi16(Words, _mm_set1_epi32(0x00010400));
+        __m128i Groups = _mm_or_si128(_mm_srli_epi64(_mm_slli_epi64(Dwords, 32), 12), _mm_srli_epi64(Dwords, 32));
+        return _mm_shuffle_epi8(Groups, _mm_setr_epi8(4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1));
+    }
+
+    WINOTP_TARGET("avx2")
+    WINOTP_FORCEINLINE __m256i OtpBase32DecodeValuesAvx2(__m256i Chars, __m256i& Valid) noexcept {
+        __m256i IsUpper = _mm256_and_si256(_mm256_cmpgt_epi8(Chars, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), Chars));
+        __m256i IsLower = _mm256_and_si256(_mm256_cmpgt_epi8(Chars, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), Chars));
+        __m256i IsDigit = _mm256_and_si256(_mm256_cmpgt_epi8(Chars, _mm256_set1_epi8('2' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('7' + 1), Chars));
+
+        Valid = _mm256_or_si256(_mm256_or_si256(IsUpper, IsLower), IsDigit);
+
+        return _mm256_or_si256(
+            _mm256_or_si256(_mm256_and_si256(IsUpper, _mm256_sub_epi8(Chars, _mm256_set1_epi8('A'))), _mm256_and_si256(IsLower, _mm256_sub_epi8(Chars, _mm256_set1_epi8('a')))),
+            _mm256_and_si256(IsDigit, _mm256_sub_epi8(Chars, _mm256_set1_epi8('2' - 26)))
+        );
+    }
+
+    //
+    // each 128-bit half holds 10 decoded bytes in its low bytes.
+    //
+    WINOTP_TARGET("avx2")
+    WINOTP_FORCEINLINE __m256i OtpBase32PackAvx2(__m256i Values) noexcept {
+        __m256i Words = _mm256_maddubs_epi16(Values, _mm256_set1_epi16(0x0120));
+        __m256i Dwords = _mm256_madd_epi16(Words, _mm256_set1_epi32(0x00010400));
+        __m256i Groups = _mm256_or_si256(_mm256_srli_epi64(_mm256_slli_epi64(Dwords, 32), 12), _mm256_srli_epi64(Dwords, 32));
+        return _mm256_shuffle_epi8(Groups, _mm256_setr_epi8(
+            4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1,
+            4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1
+        ));
+    }
+
+    //
+    // the block functions handle a prefix made of whole 5-byte / 8-character groups and return how much
+    // input they consumed; the scalar code finishes the rest. Loads never read past the end of the input.
+    //
+
+    template<typename __CharType>
+    WINOTP_TARGET("ssse3,sse4.1")
+    inline OtpTypeSize OtpBase32EncodeBlocksSse41(const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, __CharType* lpszBase32) noexcept {
+        OtpTypeSize i = 0;
+
+        for (; cbBytes - i >= 16; i += 10, lpszBase32 += 16) {
+            OtpCodecStoreChars16(lpszBase32, OtpBase32EncodeCharsSse41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lpBytes + i))));
+        }
+
+        return i;
+    }
+
+    template<typename __CharType>
+    WINOTP_TARGET("avx2")
+    inline OtpTypeSize OtpBase32EncodeBlocksAvx2(const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, __CharType* lpszBase32) noexcept {
+        OtpTypeSize i = 0;
+
+        for (; cbBytes - i >= 26; i += 20, lpszBase32 += 32) {
+            __m256i Bytes = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lpBytes + i))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(lpBytes + i + 10)),
+                1
+            );
+            OtpCodecStoreChars32(lpszBase32, OtpBase32EncodeCharsAvx2(Bytes));
+        }
+
+        return i;
+    }
+
+    //
+    // 32 characters are validated per iteration. A chunk containing anything other than alphabet characters,
+    // padding included, ends the block loop and is left to the scalar decoder, which reports the error.
+    //
+    template<typename __CharType>
+    WINOTP_TARGET("ssse3,sse4.1")
+    inline OtpTypeSize OtpBase32DecodeBlocksSse41(const __CharType* lpszBase32, OtpTypeSize cchBase32, OtpTypeByte* lpBytes) noexcept {
+        OtpTypeSize i = 0;
+
+        for (; cchBase32 - i >= 32; i += 32, lpBytes += 20) {
+            __m128i Valid0;
+            __m128i Valid1;
+            __m128i Values0 = OtpBase32DecodeValuesSse41(OtpCodecLoadChars16(lpszBase32 + i), Valid0);
+            __m128i Values1 = OtpBase32DecodeValuesSse41(OtpCodecLoadChars16(lpszBase32 + i + 16), Valid1);
+
+            if (_mm_movemask_epi8(_mm_and_si128(Valid0, Valid1)) != 0xFFFF) {
+                break;
+            }
+
+            OtpCodecStoreBytes(lpBytes, OtpBase32PackSse41(Values0), 10);
+            OtpCodecStoreBytes(lpBytes + 10, OtpBase32PackSse41(Values1), 10);
+        }
+
+        return i;
+    }
+
+    template<typename __CharType>
+    WINOTP_TARGET("avx2")
+    inline OtpTypeSize OtpBase32DecodeBlocksAvx2(const __CharType* lpszBase32, OtpTypeSize cchBase32, OtpTypeByte* lpBytes) noexcept {
+        OtpTypeSize i = 0;
+
+        for (; cchBase32 - i >= 32; i += 32, lpBytes += 20) {
+            __m256i Valid;
+            __m256i Values = OtpBase32DecodeValuesAvx2(OtpCodecLoadChars32(lpszBase32 + i), Valid);
+
+            if (_mm256_movemask_epi8(Valid) != -1) {
+                break;
+            }
+
+            __m256i Bytes = OtpBase32PackAvx2(Values);
+            OtpCodecStoreBytes(lpBytes, _mm256_castsi256_si128(Bytes), 10);
+            OtpCodecStoreBytes(lpBytes + 10, _mm256_extracti128_si256(Bytes, 1), 10);
+        }
+
+        return i;
+    }
+
+#endif
+
+    //
+    // portable encoder, one 5-byte group per iteration; writes OtpBase32EncodedLength(cbBytes) characters.
+    //
+    template<typename __CharType>
+    void OtpBase32EncodeScalar(const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, __CharType* lpszBase32) noexcept {
+        static constexpr char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+        for (OtpTypeSize i = 0; i < cbBytes; i += 5, lpszBase32 += 8) {
+            OtpTypeSize cbGroup = cbBytes - i < 5 ? cbBytes - i : 5;
+            OtpTypeSize cchGroup = (cbGroup * 8 + 4) / 5;
+            OtpTypeUInt64 Group = 0;
+
+            for (OtpTypeSize j = 0; j < 5; ++j) {
+                Group = (Group << 8) | (j < cbGroup ? lpBytes[i + j] : 0);
+            }
+
+            for (OtpTypeSize j = 0; j < 8; ++j) {
+                lpszBase32[j] = static_cast<__CharType>(j < cchGroup ? Alphabet[(Group >> (35 - 5 * j)) & 0x1F] : '=');
+            }
+        }
+    }
+
+    [[nodiscard]]
+    constexpr OtpCodecDecodeTable OtpBase32DecodeTableMake() noexcept {
+        OtpCodecDecodeTable Table = OtpCodecDecodeTableMake("ABCDEFGHIJKLMNOPQRSTUVWXYZ234567", 32);
+
+        for (OtpTypeSize i = 0; i < 26; ++i) {
+            Table.Values['a' + i] = static_cast<OtpTypeByte>(i);
+        }
+
+        return Table;
+    }
+
+    inline constexpr OtpCodecDecodeTable OtpBase32DecodeTable = OtpBase32DecodeTableMake();
+
+    //
+    // portable decoder, one character per iteration; returns the number of bytes written.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    OtpTypeSize OtpBase32DecodeScalar(const __CharType* lpszBase32, OtpTypeSize cchBase32, OtpTypeByte* lpBytes) {
+        OtpTypeSize cbBytes = 0;
+        OtpTypeUInt32 Bits = 0;
+        OtpTypeUInt32 BitsHave = 0;
+
+        for (OtpTypeSize i = 0; i < cchBase32; ++i) {
+            __CharType Char = lpszBase32[i];
+            OtpTypeByte Idx = OtpCodecDecodeLookup(OtpBase32DecodeTable, Char);
+
+            if (Idx != OtpCodecInvalid) {
+                Bits = (Bits << 5) | Idx;
+                BitsHave += 5;
+
+                if (BitsHave >= 8) {
+                    BitsHave -= 8;
+                    lpBytes[cbBytes++] = static_cast<OtpTypeByte>(Bits >> BitsHave);
+                    Bits &= (1u << BitsHave) - 1;
+                }
+            } else if (Char == '=') {
+                for (OtpTypeSize j = i + 1; j < cchBase32; ++j) {
+                    if (lpszBase32[j] != '=') {
+                        throw std::invalid_argument("Invalid padding schema detected.");
+                    }
+                }
+
+                break;
+            } else {
+                throw std::invalid_argument("Non-Base32 character detected.");
+            }
+        }
+
+        //
+        // leftover bits (fewer than 8) are the zero fill of the last character and do not form a byte.
+        //
+        return cbBytes;
+    }
+
+    //
+    // writes exactly OtpBase32EncodedLength(cbBytes) characters, padding included, and no terminator.
+    //
+    template<typename __CharType>
+    void OtpBase32Encode(const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, __CharType* lpszBase32) noexcept {
+        OtpInstrumentationScope Scope(OtpInstrumentedOperation::Base32Encode);
+        OtpTypeSize i = 0;
+
+#if WINOTP_SIMD_X86
+        const OtpCpuFeatures& Features = OtpCpuFeaturesGet();
+
+        if (Features.Avx2) {
+            i = OtpBase32EncodeBlocksAvx2(lpBytes, cbBytes, lpszBase32);
+        }
+
+        if (Features.Ssse3 && Features.Sse41) {
+            i += OtpBase32EncodeBlocksSse41(lpBytes + i, cbBytes - i, lpszBase32 + i / 5 * 8);
+        }
+#endif
+
+        OtpBase32EncodeScalar(lpBytes + i, cbBytes - i, lpszBase32 + i / 5 * 8);
+    }
+
+    //
+    // decodes into lpBytes, which must hold OtpBase32DecodedMaxLength(cchBase32) bytes, and returns the
+    // number of bytes written. Padding may only be followed by more padding.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    OtpTypeSize OtpBase32Decode(const __CharType* lpszBase32, OtpTypeSize cchBase32, OtpTypeByte* lpBytes) {
+        OtpInstrumentationScope Scope(OtpInstrumentedOperation::Base32Decode);
+        OtpTypeSize i = 0;
+
+#if WINOTP_SIMD_X86
+        const OtpCpuFeatures& Features = OtpCpuFeaturesGet();
+
+        if (Features.Avx2) {
+            i = OtpBase32DecodeBlocksAvx2(lpszBase32, cchBase32, lpBytes);
+        } else if (Features.Ssse3 && Features.Sse41) {
+            i = OtpBase32DecodeBlocksSse41(lpszBase32, cchBase32, lpBytes);
+        }
+#endif
+
+        // whole groups leave no bits pending, so the scalar decoder picks up from a clean state.
+        return i / 8 * 5 + OtpBase32DecodeScalar(lpszBase32 + i, cchBase32 - i, lpBytes + i / 8 * 5);
+    }
+
+}
@@ -0,0 +1,444 @@
+#pragma once
+#include <stdexcept>
+#include "../OtpType.hpp"
+#include "../OtpInstrumentation.hpp"
+#include "OtpPlatform.hpp"
+#include "OtpCpuFeatures.hpp"
+#include "OtpCodecSimd.hpp"
+#include "OtpCodecTable.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // RFC 4648 Base64 (section 4) and Base64url (section 5).
+    //
+    // Lenient decoding accepts '+' '-' for 62 and '/' '_' for 63, missing padding and non-zero trailing bits.
+    // Strict decoding accepts only the requested alphabet, requires padding for the standard alphabet (it is
+    // optional for Base64url, but must be right when present) and zero bits after the last byte.
+    //
+
+    [[nodiscard]]
+    constexpr OtpTypeSize OtpBase64EncodedLength(OtpTypeSize cbBytes, OtpBase64Alphabet Alphabet) noexcept {
+        return Alphabet == OtpBase64Alphabet::Standard ? (cbBytes + 2) / 3 * 4 : cbBytes / 3 * 4 + (cbBytes % 3 * 4 + 2) / 3;
+    }
+
+    //
+    // upper bound; the exact size is known only after padding has been seen.
+    //
+    [[nodiscard]]
+    constexpr OtpTypeSize OtpBase64DecodedMaxLength(OtpTypeSize cchBase64) noexcept {
+        return cchBase64 / 4 * 3 + cchBase64 % 4 * 3 / 4;
+    }
+
+    //
+    // the characters decoded as 62 and 63; each value has two accepted spellings, equal in strict mode.
+    //
+    struct OtpBase64Symbols {
+        char Value62[2];
+        char Value63[2];
+
+        [[nodiscard]]
+        static constexpr OtpBase64Symbols For(OtpBase64Alphabet Alphabet, OtpBase64Mode Mode) noexcept {
+            if (Mode == OtpBase64Mode::Lenient) {
+                return OtpBase64Symbols{ { '+', '-' }, { '/', '_' } };
+            } else if (Alphabet == OtpBase64Alphabet::Standard) {
+                return OtpBase64Symbols{ { '+', '+' }, { '/', '/' } };
+            } else {
+                return OtpBase64Symbols{ { '-', '-' }, { '_', '_' } };
+            }
+        }
+    };
+
+#if WINOTP_SIMD_X86
+
+    //
+    // Encoding: each 3-byte group is spread over one 32-bit lane so that multiplies can shift its four 6-bit
+    // indices into separate bytes; a 16-entry shuffle table then supplies the ASCII offset for each index
+    // range (A-Z, a-z, 0-9, 62, 63).
+    //
+
+    [[nodiscard]]
+    WINOTP_TARGET("ssse3,sse4.1")
+    inline __m128i OtpBase64EncodeShiftTableSse41(OtpBase64Alphabet Alphabet) noexcept {
+        char Value62 = Alphabet == OtpBase64Alphabet::Standard ? '+' : '-';
+        char Value63 = Alphabet == OtpBase64Alphabet::Standard ? '/' : '_';
+
+        return _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, static_cast<char>(Value62 - 62), static_cast<char>(Value63 - 63), 'A', 0, 0
+        );
+    }
+
+    WINOTP_TARGET("ssse3,sse4.1")
+    WINOTP_FORCEINLINE __m128i OtpBase64EncodeCharsSse41(__m128i Bytes, __m128i ShiftTable) noexcept {
+        __m128i Spread = _mm_shuffle_epi8(Bytes, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+        __m128i IndicesHigh = _mm_mulhi_epu16(_mm_and_si128(Spread, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        __m128i IndicesLow = _mm_mullo_epi16(_mm_and_si128(Spread, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        __m128i Indices = _mm_or_si128(IndicesHigh, IndicesLow);
+
+        // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+        __m128i Range = _mm_subs_epu8(Indices, _mm_set1_epi8(51));
+        Range = _mm_or_si128(Range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), Indices), _mm_set1_epi8(13)));
+
+        return _mm_add_epi8(Indices, _mm_shuffle_epi8(ShiftTable, Range));
+    }
+
+    WINOTP_TARGET("avx2")
+    WINOTP_FORCEINLINE __m256i OtpBase64EncodeCharsAvx2(__m256i Bytes, __m256i ShiftTable) noexcept {
+        __m256i Spread = _mm256_shuffle_epi8(Bytes, _mm256_setr_epi8(
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+        ));
+        __m256i IndicesHigh = _mm256_mulhi_epu16(_mm256_and_si256(Spread, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+        __m256i IndicesLow = _mm256_mullo_epi16(_mm256_and_si256(Spread, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+        __m256i Indices = _mm256_or_si256(IndicesHigh, IndicesLow);
+
+        __m256i Range = _mm256_subs_epu8(Indices, _mm256_set1_epi8(51));
+        Range = _mm256_or_si256(Range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), Indices), _mm256_set1_epi8(13)));
+
+        return _mm256_add_epi8(Indices, _mm256_shuffle_epi8(ShiftTable, Range));
+    }
+
+    //
+    // Decoding: alphabet membership is range-checked, letters and digits are mapped by an offset looked up
+    // from the high nibble, and the two symbol values are blended in. maddubs/madd merge the 6-bit values
+    // into 24-bit groups, which a final shuffle byte-swaps into place.
+    //
+
+    struct OtpBase64DecodeSymbolsSse41 {
+        __m128i Value62[2];
+        __m128i Value63[2];
+    };
+
+    WINOTP_TARGET("ssse3,sse4.1")
+    WINOTP_FORCEINLINE __m128i OtpBase64DecodeValuesSse41(__m128i Chars, const OtpBase64DecodeSymbolsSse41& Symbols, __m128i& Valid) noexcept {
+        __m128i IsUpper = _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8('A' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), Chars));
+        __m128i IsLower = _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), Chars));
+        __m128i IsDigit = _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), Chars));
+        __m128i Is62 = _mm_or_si128(_mm_cmpeq_epi8(Chars, Symbols.Value62[0]), _mm_cmpeq_epi8(Chars, Symbols.Value62[1]));
+        __m128i Is63 = _mm_or_si128(_mm_cmpeq_epi8(Chars, Symbols.Value63[0]), _mm_cmpeq_epi8(Chars, Symbols.Value63[1]));
+
+        Valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(IsUpper, IsLower), _mm_or_si128(IsDigit, Is62)), Is63);
+
+        // high nibble 3: '0'-'9', 4-5: 'A'-'Z', 6-7: 'a'-'z'
+        __m128i HighNibbles = _mm_and_si128(_mm_srli_epi16(Chars, 4), _mm_set1_epi8(0x0F));
+        __m128i Offsets = _mm_shuffle_epi8(_mm_setr_epi8(0, 0, 0, 52 - '0', -'A', -'A', 26 - 'a', 26 - 'a', 0, 0, 0, 0, 0, 0, 0, 0), HighNibbles);
+        __m128i Values = _mm_add_epi8(Chars, Offsets);
+        Values = _mm_blendv_epi8(Values, _mm_set1_epi8(62), Is62);
+        Values = _mm_blendv_epi8(Values, _mm_set1_epi8(63), Is63);
+
+        return Values;
+    }
+
+    //
+    // the 12 decoded bytes are in the low bytes of the result.
+    //
+    WINOTP_TARGET("ssse3,sse4.1")
+    WINOTP_FORCEINLINE __m128i OtpBase64PackSse41(__m128i Values) noexcept {
+        __m128i Words = _mm_maddubs_epi16(Values, _mm_set1_epi32(0x01400140));
+        __m128i Dwords = _mm_madd_epi16(Words, _mm_set1_epi32(0x00011000));
+        return _mm_shuffle_epi8(Dwords, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    }
+
+    struct OtpBase64DecodeSymbolsAvx2 {
+        __m256i Value62[2];
+        __m256i Value63[2];
+    };
+
+    WINOTP_TARGET("avx2")
+    WINOTP_FORCEINLINE __m256i OtpBase64DecodeValuesAvx2(__m256i Chars, const OtpBase64DecodeSymbolsAvx2& Symbols, __m256i& Valid) noexcept {
+        __m256i IsUpper = _mm256_and_si256(_mm256_cmpgt_epi8(Chars, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), Chars));
+        __m256i IsLower = _mm256_and_si256(_mm256_cmpgt_epi8(Chars, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), Chars));
+        __m256i IsDigit = _mm256_and_si256(_mm256_cmpgt_epi8(Chars, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), Chars));
+        __m256i Is62 = _mm256_or_si256(_mm256_cmpeq_epi8(Chars, Symbols.Value62[0]), _mm256_cmpeq_epi8(Chars, Symbols.Value62[1]));
+        __m256i Is63 = _mm256_or_si256(_mm256_cmpeq_epi8(Chars, Symbols.Value63[0]), _mm256_cmpeq_epi8(Chars, Symbols.Value63[1]));
+
+        Valid = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(IsUpper, IsLower), _mm256_or_si256(IsDigit, Is62)), Is63);
+
+        __m256i HighNibbles = _mm256_and_si256(_mm256_srli_epi16(Chars, 4), _mm256_set1_epi8(0x0F));
+        __m256i Offsets = _mm256_shuffle_epi8(_mm256_setr_epi8(
+            0, 0, 0, 52 - '0', -'A', -'A', 26 - 'a', 26 - 'a', 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 52 - '0', -'A', -'A', 26 - 'a', 26 - 'a', 0, 0, 0, 0, 0, 0, 0, 0
+        ), HighNibbles);
+        __m256i Values = _mm256_add_epi8(Chars, Offsets);
+        Values = _mm256_blendv_epi8(Values, _mm256_set1_epi8(62), Is62);
+        Values = _mm256_blendv_epi8(Values, _mm256_set1_epi8(63), Is63);
+
+        return Values;
+    }
+
+    //
+    // each 128-bit half holds 12 decoded bytes in its low bytes.
+    //
+    WINOTP_TARGET("avx2")
+    WINOTP_FORCEINLINE __m256i OtpBase64PackAvx2(__m256i Values) noexcept {
+        __m256i Words = _mm256_maddubs_epi16(Values, _mm256_set1_epi32(0x01400140));
+        __m256i Dwords = _mm256_madd_epi16(Words, _mm256_set1_epi32(0x00011000));
+        return _mm256_shuffle_epi8(Dwords, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+        ));
+    }
+
+    //
+    // the block functions handle a prefix made of whole 3-byte / 4-character groups and return how much
+    // input they consumed; the scalar code finishes the rest. Loads never read past the end of the input.
+    //
+
+    template<typename __CharType>
+    WINOTP_TARGET("ssse3,sse4.1")
+    inline OtpTypeSize OtpBase64EncodeBlocksSse41(const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, __CharType* lpszBase64, OtpBase64Alphabet Alphabet) noexcept {
+        __m128i ShiftTable = OtpBase64EncodeShiftTableSse41(Alphabet);
+        OtpTypeSize i = 0;
+
+        for (; cbBytes - i >= 16; i += 12, lpszBase64 += 16) {
+            OtpCodecStoreChars16(lpszBase64, OtpBase64EncodeCharsSse41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lpBytes + i)), ShiftTable));
+        }
+
+        return i;
+    }
+
+    template<typename __CharType>
+    WINOTP_TARGET("avx2")
+    inline OtpTypeSize OtpBase64EncodeBlocksAvx2(const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, __CharType* lpszBase64, OtpBase64Alphabet Alphabet) noexcept {
+        __m128i ShiftTable = OtpBase64EncodeShiftTableSse41(Alphabet);
+        __m256i ShiftTable2 = _mm256_inserti128_si256(_mm256_castsi128_si256(ShiftTable), ShiftTable, 1);
+        OtpTypeSize i = 0;
+
+        for (; cbBytes - i >= 28; i += 24, lpszBase64 += 32) {
+            __m256i Bytes = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lpBytes + i))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(lpBytes + i + 12)),
+                1
+            );
+            OtpCodecStoreChars32(lpszBase64, OtpBase64EncodeCharsAvx2(Bytes, ShiftTable2));
+        }
+
+        return i;
+    }
+
+    //
+    // 32 characters are validated per iteration. A chunk containing anything outside the accepted alphabet,
+    // padding included, ends the block loop and is left to the scalar decoder, which reports the error.
+    //
+    template<typename __CharType>
+    WINOTP_TARGET("ssse3,sse4.1")
+    inline OtpTypeSize OtpBase64DecodeBlocksSse41(const __CharType* lpszBase64, OtpTypeSize cchBase64, OtpTypeByte* lpBytes, OtpBase64Symbols Symbols) noexcept {
+        OtpBase64DecodeSymbolsSse41 SymbolVectors = {
+            { _mm_set1_epi8(Symbols.Value62[0]), _mm_set1_epi8(Symbols.Value62[1]) },
+            { _mm_set1_epi8(Symbols.Value63[0]), _mm_set1_epi8(Symbols.Value63[1]) }
+        };
+        OtpTypeSize i = 0;
+
+        for (; cchBase64 - i >= 32; i += 32, lpBytes += 24) {
+            __m128i Valid0;
+            __m128i Valid1;
+            __m128i Values0 = OtpBase64DecodeValuesSse41(OtpCodecLoadChars16(lpszBase64 + i), SymbolVectors, Valid0);
+            __m128i Values1 = OtpBase64DecodeValuesSse41(OtpCodecLoadChars16(lpszBase64 + i + 16), SymbolVectors, Valid1);
+
+            if (_mm_movemask_epi8(_mm_and_si128(Valid0, Valid1)) != 0xFFFF) {
+                break;
+            }
+
+            OtpCodecStoreBytes(lpBytes, OtpBase64PackSse41(Values0), 12);
+            OtpCodecStoreBytes(lpBytes + 12, OtpBase64PackSse41(Values1), 12);
+        }
+
+        return i;
+    }
+
+    template<typename __CharType>
+    WINOTP_TARGET("avx2")
+    inline OtpTypeSize OtpBase64DecodeBlocksAvx2(const __CharType* lpszBase64, OtpTypeSize cchBase64, OtpTypeByte* lpBytes, OtpBase64Symbols Symbols) noexcept {
+        OtpBase64DecodeSymbolsAvx2 SymbolVectors = {
+            { _mm256_set1_epi8(Symbols.Value62[0]), _mm256_set1_epi8(Symbols.Value62[1]) },
+            { _mm256_set1_epi8(Symbols.Value63[0]), _mm256_set1_epi8(Symbols.Value63[1]) }
+        };
+        OtpTypeSize i = 0;
+
+        for (; cchBase64 - i >= 32; i += 32, lpBytes += 24) {
+            __m256i Valid;
+            __m256i Values = OtpBase64DecodeValuesAvx2(OtpCodecLoadChars32(lpszBase64 + i), SymbolVectors, Valid);
+
+            if (_mm256_movemask_epi8(Valid) != -1) {
+                break;
+            }
+
+            __m256i Bytes = OtpBase64PackAvx2(Values);
+            OtpCodecStoreBytes(lpBytes, _mm256_castsi256_si128(Bytes), 12);
+            OtpCodecStoreBytes(lpBytes + 12, _mm256_extracti128_si256(Bytes, 1), 12);
+        }
+
+        return i;
+    }
+
+#endif
+
+    //
+    // portable encoder, one 3-byte group per iteration; writes OtpBase64EncodedLength(cbBytes, Alphabet) characters.
+    //
+    template<typename __CharType>
+    void OtpBase64EncodeScalar(const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, __CharType* lpszBase64, OtpBase64Alphabet Alphabet) noexcept {
+        static constexpr char AlphabetStandard[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        static constexpr char AlphabetUrl[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+        const char* lpszAlphabet = Alphabet == OtpBase64Alphabet::Standard ? AlphabetStandard : AlphabetUrl;
+        bool Padding = Alphabet == OtpBase64Alphabet::Standard;
+
+        for (OtpTypeSize i = 0; i < cbBytes; i += 3) {
+            OtpTypeSize cbGroup = cbBytes - i < 3 ? cbBytes - i : 3;
+            OtpTypeSize cchGroup = cbGroup + 1;
+            OtpTypeUInt32 Group = 0;
+
+            for (OtpTypeSize j = 0; j < 3; ++j) {
+                Group = (Group << 8) | (j < cbGroup ? lpBytes[i + j] : 0);
+            }
+
+            for (OtpTypeSize j = 0; j < 4; ++j) {
+                if (j < cchGroup) {
+                    *lpszBase64++ = static_cast<__CharType>(lpszAlphabet[(Group >> (18 - 6 * j)) & 0x3F]);
+                } else if (Padding) {
+                    *lpszBase64++ = static_cast<__CharType>('=');
+                }
+            }
+        }
+    }
+
+    [[nodiscard]]
+    constexpr OtpCodecDecodeTable OtpBase64DecodeTableMake(OtpBase64Symbols Symbols) noexcept {
+        OtpCodecDecodeTable Table = OtpCodecDecodeTableMake("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", 62);
+
+        for (OtpTypeSize i = 0; i < 2; ++i) {
+            Table.Values[static_cast<unsigned char>(Symbols.Value62[i])] = 62;
+            Table.Values[static_cast<unsigned char>(Symbols.Value63[i])] = 63;
+        }
+
+        return Table;
+    }
+
+    inline constexpr OtpCodecDecodeTable OtpBase64DecodeTables[3] = {
+        OtpBase64DecodeTableMake(OtpBase64Symbols::For(OtpBase64Alphabet::Standard, OtpBase64Mode::Strict)),
+        OtpBase64DecodeTableMake(OtpBase64Symbols::For(OtpBase64Alphabet::Url, OtpBase64Mode::Strict)),
+        OtpBase64DecodeTableMake(OtpBase64Symbols::For(OtpBase64Alphabet::Standard, OtpBase64Mode::Lenient))
+    };
+
+    [[nodiscard]]
+    constexpr const OtpCodecDecodeTable& OtpBase64DecodeTableFor(OtpBase64Alphabet Alphabet, OtpBase64Mode Mode) noexcept {
+        if (Mode == OtpBase64Mode::Lenient) {
+            return OtpBase64DecodeTables[2];
+        } else {
+            return OtpBase64DecodeTables[Alphabet == OtpBase64Alphabet::Standard ? 0 : 1];
+        }
+    }
+
+    //
+    // portable decoder, one character per iteration; returns the number of bytes written.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    OtpTypeSize OtpBase64DecodeScalar(const __CharType* lpszBase64, OtpTypeSize cchBase64, OtpTypeByte* lpBytes, OtpBase64Alphabet Alphabet, OtpBase64Mode Mode) {
+        const OtpCodecDecodeTable& Table = OtpBase64DecodeTableFor(Alphabet, Mode);
+        OtpTypeSize cbBytes = 0;
+        OtpTypeUInt32 Bits = 0;
+        OtpTypeUInt32 BitsHave = 0;
+        OtpTypeSize cchData = 0;
+
+        for (; cchData < cchBase64; ++cchData) {
+            __CharType Char = lpszBase64[cchData];
+            OtpTypeByte Idx = OtpCodecDecodeLookup(Table, Char);
+
+            if (Idx != OtpCodecInvalid) {
+                Bits = (Bits << 6) | Idx;
+                BitsHave += 6;
+
+                if (BitsHave >= 8) {
+                    BitsHave -= 8;
+                    lpBytes[cbBytes++] = static_cast<OtpTypeByte>(Bits >> BitsHave);
+                    Bits &= (1u << BitsHave) - 1;
+                }
+            } else if (Char == '=') {
+                for (OtpTypeSize j = cchData + 1; j < cchBase64; ++j) {
+                    if (lpszBase64[j] != '=') {
+                        throw std::invalid_argument("Invalid padding schema detected.");
+                    }
+                }
+
+                break;
+            } else {
+                throw std::invalid_argument("Non-Base64 character detected.");
+            }
+        }
+
+        //
+        // leftover bits (fewer than 8) are the zero fill of the last character and do not form a byte.
+        //
+        if (Mode == OtpBase64Mode::Strict) {
+            OtpTypeSize cchPadding = cchBase64 - cchData;
+
+            if (cchData % 4 == 1) {
+                throw std::invalid_argument("Invalid padding schema detected.");
+            }
+
+            if (cchPadding != 0 || Alphabet == OtpBase64Alphabet::Standard) {
+                if (cchBase64 % 4 != 0 || cchPadding > 2) {
+                    throw std::invalid_argument("Invalid padding schema detected.");
+                }
+            }
+
+            if (Bits != 0) {
+                throw std::invalid_argument("Non-canonical Base64 encoding detected.");
+            }
+        }
+
+        return cbBytes;
+    }
+
+    //
+    // writes exactly OtpBase64EncodedLength(cbBytes, Alphabet) characters and no terminator.
+    //
+    template<typename __CharType>
+    void OtpBase64Encode(const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, __CharType* lpszBase64, OtpBase64Alphabet Alphabet) noexcept {
+        OtpInstrumentationScope Scope(OtpInstrumentedOperation::Base64Encode);
+        OtpTypeSize i = 0;
+
+#if WINOTP_SIMD_X86
+        const OtpCpuFeatures& Features = OtpCpuFeaturesGet();
+
+        if (Features.Avx2) {
+            i = OtpBase64EncodeBlocksAvx2(lpBytes, cbBytes, lpszBase64, Alphabet);
+        }
+
+        if (Features.Ssse3 && Features.Sse41) {
+            i += OtpBase64EncodeBlocksSse41(lpBytes + i, cbBytes - i, lpszBase64 + i / 3 * 4, Alphabet);
+        }
+#endif
+
+        OtpBase64EncodeScalar(lpBytes + i, cbBytes - i, lpszBase64 + i / 3 * 4, Alphabet);
+    }
+
+    //
+    // decodes into lpBytes, which must hold OtpBase64DecodedMaxLength(cchBase64) bytes, and returns the
+    // number of bytes written. Padding may only be followed by more padding.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    OtpTypeSize OtpBase64Decode(const __CharType* lpszBase64, OtpTypeSize cchBase64, OtpTypeByte* lpBytes, OtpBase64Alphabet Alphabet, OtpBase64Mode Mode) {
+        OtpInstrumentationScope Scope(OtpInstrumentedOperation::Base64Decode);
+        OtpTypeSize i = 0;
+
+#if WINOTP_SIMD_X86
+        const OtpCpuFeatures& Features = OtpCpuFeaturesGet();
+        OtpBase64Symbols Symbols = OtpBase64Symbols::For(Alphabet, Mode);
+
+        if (Features.Avx2) {
+            i = OtpBase64DecodeBlocksAvx2(lpszBase64, cchBase64, lpBytes, Symbols);
+        } else if (Features.Ssse3 && Features.Sse41) {
+            i = OtpBase64DecodeBlocksSse41(lpszBase64, cchBase64, lpBytes, Symbols);
+        }
+#endif
+
+        // whole groups leave no bits pending and keep the length parity, so the scalar decoder's checks hold.
+        return i / 4 * 3 + OtpBase64DecodeScalar(lpszBase64 + i, cchBase64 - i, lpBytes + i / 4 * 3, Alphabet, Mode);
+    }
+
+}
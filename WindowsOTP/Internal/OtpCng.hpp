@@ -1,7 +1,7 @@
 #pragma once
 #include <windows.h>
 #include <bcrypt.h>
-#include <mutex>
+#include "OtpPlatform.hpp"
 #include "OtpExceptionCategory.hpp"
 #include "OtpResource.hpp"
 #include "OtpResourceTraitsGeneric.hpp"
@@ -84,80 +84,53 @@ namespace WinOTP::Internal {
     };
 
     [[nodiscard]]
-    const OtpCngHashProvider& OtpCngCategoryHmac(OtpCngHashEnum HashAlgorithm) {
-        static std::mutex InitializeMutex;
-        static OtpResource HmacSha1Provider(OtpResourceTraitsCppObject<OtpCngHashProvider>{});
-        static OtpResource HmacSha256Provider(OtpResourceTraitsCppObject<OtpCngHashProvider>{});
-        static OtpResource HmacSha384Provider(OtpResourceTraitsCppObject<OtpCngHashProvider>{});
-        static OtpResource HmacSha512Provider(OtpResourceTraitsCppObject<OtpCngHashProvider>{});
-
+    constexpr PCWSTR OtpCngHashAlgorithmId(OtpCngHashEnum HashAlgorithm) noexcept {
         switch (HashAlgorithm) {
             case OtpCngHashEnum::Sha1:
-                if (HmacSha1Provider.IsValid() == false) {
-                    std::lock_guard InitLock(InitializeMutex);
-
-                    if (HmacSha1Provider.IsValid() == false) {
-                        OtpCngHashProvider* volatile lpInstance = OtpCngHashProvider::CreateProvider(
-                            BCRYPT_SHA1_ALGORITHM,
-                            NULL,
-                            BCRYPT_ALG_HANDLE_HMAC_FLAG | BCRYPT_HASH_REUSABLE_FLAG
-                        );
-
-                        HmacSha1Provider.TakeOver(const_cast<OtpCngHashProvider*>(lpInstance));
-                    }
-                }
-                
-                return *HmacSha1Provider.Get();
+                return BCRYPT_SHA1_ALGORITHM;
             case OtpCngHashEnum::Sha256:
-                if (HmacSha256Provider.IsValid() == false) {
-                    std::lock_guard InitLock(InitializeMutex);
-
-                    if (HmacSha256Provider.IsValid() == false) {
-                        OtpCngHashProvider* volatile lpInstance = OtpCngHashProvider::CreateProvider(
-                            BCRYPT_SHA256_ALGORITHM,
-                            NULL,
-                            BCRYPT_ALG_HANDLE_HMAC_FLAG | BCRYPT_HASH_REUSABLE_FLAG
-                        );
-
-                        HmacSha256Provider.TakeOver(const_cast<OtpCngHashProvider*>(lpInstance));
-                    }
-                }
-
-                return *HmacSha256Provider.Get();
+                return BCRYPT_SHA256_ALGORITHM;
             case OtpCngHashEnum::Sha384:
-                if (HmacSha384Provider.IsValid() == false) {
-                    std::lock_guard InitLock(InitializeMutex);
-
-                    if (HmacSha384Provider.IsValid() == false) {
-                        OtpCngHashProvider* volatile lpInstance = OtpCngHashProvider::CreateProvider(
-                            BCRYPT_SHA384_ALGORITHM,
-                            NULL,
-                            BCRYPT_ALG_HANDLE_HMAC_FLAG | BCRYPT_HASH_REUSABLE_FLAG
-                        );
-
-                        HmacSha384Provider.TakeOver(const_cast<OtpCngHashProvider*>(lpInstance));
-                    }
-                }
-
-                return *HmacSha384Provider.Get();
+                return BCRYPT_SHA384_ALGORITHM;
             case OtpCngHashEnum::Sha512:
-                if (HmacSha512Provider.IsValid() == false) {
-                    std::lock_guard InitLock(InitializeMutex);
-
-                    if (HmacSha512Provider.IsValid() == false) {
-                        OtpCngHashProvider* volatile lpInstance = OtpCngHashProvider::CreateProvider(
-                            BCRYPT_SHA512_ALGORITHM,
-                            NULL,
-                            BCRYPT_ALG_HANDLE_HMAC_FLAG | BCRYPT_HASH_REUSABLE_FLAG
-                        );
+                return BCRYPT_SHA512_ALGORITHM;
+            default:
+                WINOTP_UNREACHABLE();
+        }
+    }
 
-                        HmacSha512Provider.TakeOver(const_cast<OtpCngHashProvider*>(lpInstance));
-                    }
-                }
+    //
+    // one provider per algorithm, opened on first use. Function-local statics are initialized exactly once
+    // even under concurrent first calls, and afterwards cost only an acquire load of the guard; a failed
+    // open throws and is retried on the next call.
+    //
+    template<OtpCngHashEnum __HashAlgorithm>
+    [[nodiscard]]
+    const OtpCngHashProvider& OtpCngCategoryHmacInstance() {
+        static const OtpResource<OtpResourceTraitsCppObject<OtpCngHashProvider>> Provider(
+            OtpCngHashProvider::CreateProvider(
+                OtpCngHashAlgorithmId(__HashAlgorithm),
+                NULL,
+                BCRYPT_ALG_HANDLE_HMAC_FLAG | BCRYPT_HASH_REUSABLE_FLAG
+            )
+        );
+
+        return *Provider.Get();
+    }
 
-                return *HmacSha512Provider.Get();
+    [[nodiscard]]
+    inline const OtpCngHashProvider& OtpCngCategoryHmac(OtpCngHashEnum HashAlgorithm) {
+        switch (HashAlgorithm) {
+            case OtpCngHashEnum::Sha1:
+                return OtpCngCategoryHmacInstance<OtpCngHashEnum::Sha1>();
+            case OtpCngHashEnum::Sha256:
+                return OtpCngCategoryHmacInstance<OtpCngHashEnum::Sha256>();
+            case OtpCngHashEnum::Sha384:
+                return OtpCngCategoryHmacInstance<OtpCngHashEnum::Sha384>();
+            case OtpCngHashEnum::Sha512:
+                return OtpCngCategoryHmacInstance<OtpCngHashEnum::Sha512>();
             default:
-                __assume(0);
+                WINOTP_UNREACHABLE();
         }
     }
 
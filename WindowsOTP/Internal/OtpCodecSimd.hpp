@@ -0,0 +1,86 @@
+#pragma once
+#include <string.h>
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+
+#if WINOTP_SIMD_X86
+#include <immintrin.h>
+
+namespace WinOTP::Internal {
+
+    //
+    // text codecs work on one byte per character. Wider characters are narrowed with unsigned saturation,
+    // which maps everything outside [0, 0xFF] to 0x00 or 0xFF; neither is in any alphabet, so a wide
+    // character can never alias a valid narrow one.
+    //
+    template<typename __CharType>
+    WINOTP_TARGET("ssse3,sse4.1")
+    WINOTP_FORCEINLINE __m128i OtpCodecLoadChars16(const __CharType* lpsz) noexcept {
+        const __m128i* p = reinterpret_cast<const __m128i*>(lpsz);
+
+        if constexpr (sizeof(__CharType) == 1) {
+            return _mm_loadu_si128(p);
+        } else if constexpr (sizeof(__CharType) == 2) {
+            return _mm_packus_epi16(_mm_loadu_si128(p), _mm_loadu_si128(p + 1));
+        } else {
+            static_assert(sizeof(__CharType) == 4);
+            return _mm_packus_epi16(
+                _mm_packus_epi32(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)),
+                _mm_packus_epi32(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3))
+            );
+        }
+    }
+
+    template<typename __CharType>
+    WINOTP_TARGET("ssse3,sse4.1")
+    WINOTP_FORCEINLINE void OtpCodecStoreChars16(__CharType* lpsz, __m128i Chars) noexcept {
+        __m128i* p = reinterpret_cast<__m128i*>(lpsz);
+
+        if constexpr (sizeof(__CharType) == 1) {
+            _mm_storeu_si128(p, Chars);
+        } else if constexpr (sizeof(__CharType) == 2) {
+            _mm_storeu_si128(p, _mm_cvtepu8_epi16(Chars));
+            _mm_storeu_si128(p + 1, _mm_cvtepu8_epi16(_mm_srli_si128(Chars, 8)));
+        } else {
+            static_assert(sizeof(__CharType) == 4);
+            _mm_storeu_si128(p, _mm_cvtepu8_epi32(Chars));
+            _mm_storeu_si128(p + 1, _mm_cvtepu8_epi32(_mm_srli_si128(Chars, 4)));
+            _mm_storeu_si128(p + 2, _mm_cvtepu8_epi32(_mm_srli_si128(Chars, 8)));
+            _mm_storeu_si128(p + 3, _mm_cvtepu8_epi32(_mm_srli_si128(Chars, 12)));
+        }
+    }
+
+    template<typename __CharType>
+    WINOTP_TARGET("avx2")
+    WINOTP_FORCEINLINE __m256i OtpCodecLoadChars32(const __CharType* lpsz) noexcept {
+        if constexpr (sizeof(__CharType) == 1) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lpsz));
+        } else {
+            return _mm256_inserti128_si256(_mm256_castsi128_si256(OtpCodecLoadChars16(lpsz)), OtpCodecLoadChars16(lpsz + 16), 1);
+        }
+    }
+
+    template<typename __CharType>
+    WINOTP_TARGET("avx2")
+    WINOTP_FORCEINLINE void OtpCodecStoreChars32(__CharType* lpsz, __m256i Chars) noexcept {
+        if constexpr (sizeof(__CharType) == 1) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lpsz), Chars);
+        } else {
+            OtpCodecStoreChars16(lpsz, _mm256_castsi256_si128(Chars));
+            OtpCodecStoreChars16(lpsz + 16, _mm256_extracti128_si256(Chars, 1));
+        }
+    }
+
+    //
+    // stores the low cbBytes (<= 16) bytes of Bytes without touching the memory after them.
+    //
+    WINOTP_TARGET("ssse3,sse4.1")
+    WINOTP_FORCEINLINE void OtpCodecStoreBytes(OtpTypeByte* lpBytes, __m128i Bytes, OtpTypeSize cbBytes) noexcept {
+        alignas(16) OtpTypeByte Buffer[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(Buffer), Bytes);
+        memcpy(lpBytes, Buffer, cbBytes);
+    }
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+#include <type_traits>
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // reverse lookup table for the scalar decoders: one entry per byte value, OtpCodecInvalid for every
+    // byte outside the alphabet. Tables are built at compile time by each codec.
+    //
+    inline constexpr OtpTypeByte OtpCodecInvalid = 0xFF;
+
+    struct OtpCodecDecodeTable {
+        OtpTypeByte Values[256];
+    };
+
+    [[nodiscard]]
+    constexpr OtpCodecDecodeTable OtpCodecDecodeTableMake(const char* lpszAlphabet, OtpTypeSize cchAlphabet) noexcept {
+        OtpCodecDecodeTable Table = {};
+
+        for (auto& Value : Table.Values) {
+            Value = OtpCodecInvalid;
+        }
+
+        for (OtpTypeSize i = 0; i < cchAlphabet; ++i) {
+            Table.Values[static_cast<unsigned char>(lpszAlphabet[i])] = static_cast<OtpTypeByte>(i);
+        }
+
+        return Table;
+    }
+
+    //
+    // works for any character type: code units above 0xFF are never in an alphabet.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    WINOTP_FORCEINLINE constexpr OtpTypeByte OtpCodecDecodeLookup(const OtpCodecDecodeTable& Table, __CharType Char) noexcept {
+        auto Code = static_cast<std::make_unsigned_t<__CharType>>(Char);
+
+        if constexpr (sizeof(__CharType) == 1) {
+            return Table.Values[Code];
+        } else {
+            return Code <= 0xFF ? Table.Values[Code] : OtpCodecInvalid;
+        }
+    }
+
+}
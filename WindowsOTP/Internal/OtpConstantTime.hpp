@@ -0,0 +1,30 @@
+#pragma once
+#include "../OtpType.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // branch-free helpers for comparing secrets: the instruction stream and memory accesses do not depend
+    // on the values compared.
+    //
+
+    //
+    // returns 1 if a == b, otherwise 0.
+    //
+    [[nodiscard]]
+    constexpr OtpTypeUInt32 OtpConstantTimeIsEqual(OtpTypeUInt32 a, OtpTypeUInt32 b) noexcept {
+        // a ^ b == 0 is the only value for which subtracting one borrows into the upper half.
+        return static_cast<OtpTypeUInt32>((static_cast<OtpTypeUInt64>(a ^ b) - 1) >> 63);
+    }
+
+    //
+    // returns a if Condition is 1, b if Condition is 0.
+    //
+    template<typename __IntegerType>
+    [[nodiscard]]
+    constexpr __IntegerType OtpConstantTimeSelect(OtpTypeUInt32 Condition, __IntegerType a, __IntegerType b) noexcept {
+        auto Mask = static_cast<__IntegerType>(0) - static_cast<__IntegerType>(Condition);
+        return b ^ ((a ^ b) & Mask);
+    }
+
+}
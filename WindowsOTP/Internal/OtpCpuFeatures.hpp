@@ -0,0 +1,94 @@
+#pragma once
+#include "OtpPlatform.hpp"
+
+#if WINOTP_ARCH_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace WinOTP::Internal {
+
+    struct OtpCpuFeatures {
+        bool Sse2;
+        bool Ssse3;
+        bool Sse41;
+        bool Avx2;
+        bool Avx512F;
+        bool Sha;
+    };
+
+#if WINOTP_ARCH_X86
+    inline void OtpCpuId(unsigned Leaf, unsigned SubLeaf, unsigned (&Registers)[4]) noexcept {
+#if defined(_MSC_VER)
+        int Values[4];
+        __cpuidex(Values, static_cast<int>(Leaf), static_cast<int>(SubLeaf));
+        for (int i = 0; i < 4; ++i) {
+            Registers[i] = static_cast<unsigned>(Values[i]);
+        }
+#else
+        __cpuid_count(Leaf, SubLeaf, Registers[0], Registers[1], Registers[2], Registers[3]);
+#endif
+    }
+
+    [[nodiscard]]
+    inline unsigned long long OtpXGetBv(unsigned Index) noexcept {
+#if defined(_MSC_VER)
+        return _xgetbv(Index);
+#else
+        unsigned Low, High;
+        __asm__ __volatile__("xgetbv" : "=a"(Low), "=d"(High) : "c"(Index));
+        return (static_cast<unsigned long long>(High) << 32) | Low;
+#endif
+    }
+#endif
+
+    [[nodiscard]]
+    inline OtpCpuFeatures OtpCpuFeaturesDetect() noexcept {
+        OtpCpuFeatures Features = {};
+
+#if WINOTP_ARCH_X86
+        unsigned Registers[4];
+
+        OtpCpuId(0, 0, Registers);
+        unsigned MaxLeaf = Registers[0];
+
+        if (MaxLeaf >= 1) {
+            OtpCpuId(1, 0, Registers);
+            Features.Sse2 = (Registers[3] >> 26) & 1;
+            Features.Ssse3 = (Registers[2] >> 9) & 1;
+            Features.Sse41 = (Registers[2] >> 19) & 1;
+
+            bool OsXSave = (Registers[2] >> 27) & 1;
+            bool Avx = (Registers[2] >> 28) & 1;
+
+            // the OS must save YMM (and for AVX-512, opmask/ZMM) state across context switches.
+            unsigned long long XCr0 = OsXSave ? OtpXGetBv(0) : 0;
+            bool OsAvx = Avx && (XCr0 & 0x06) == 0x06;
+            bool OsAvx512 = OsAvx && (XCr0 & 0xE0) == 0xE0;
+
+            if (MaxLeaf >= 7) {
+                OtpCpuId(7, 0, Registers);
+                Features.Avx2 = OsAvx && ((Registers[1] >> 5) & 1);
+                Features.Avx512F = OsAvx512 && ((Registers[1] >> 16) & 1);
+                Features.Sha = (Registers[1] >> 29) & 1;
+            }
+        }
+#endif
+
+        return Features;
+    }
+
+    //
+    // detected once; C++11 guarantees thread-safe initialization of the local static.
+    //
+    [[nodiscard]]
+    inline const OtpCpuFeatures& OtpCpuFeaturesGet() noexcept {
+        static const OtpCpuFeatures Features = OtpCpuFeaturesDetect();
+        return Features;
+    }
+
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include "../OtpType.hpp"
+#include <type_traits>
+
+namespace WinOTP::Internal {
+
+    template<typename __WordType>
+    [[nodiscard]]
+    constexpr __WordType OtpRotateLeft(__WordType Value, unsigned Shift) noexcept {
+        static_assert(std::is_unsigned_v<__WordType>);
+        return static_cast<__WordType>((Value << Shift) | (Value >> (sizeof(__WordType) * 8 - Shift)));
+    }
+
+    template<typename __WordType>
+    [[nodiscard]]
+    constexpr __WordType OtpRotateRight(__WordType Value, unsigned Shift) noexcept {
+        static_assert(std::is_unsigned_v<__WordType>);
+        return static_cast<__WordType>((Value >> Shift) | (Value << (sizeof(__WordType) * 8 - Shift)));
+    }
+
+    //
+    // byte-by-byte big-endian load/store, usable in constant expressions.
+    // compilers fold these into a single load/store + bswap.
+    //
+    template<typename __WordType>
+    [[nodiscard]]
+    constexpr __WordType OtpLoadBigEndian(const OtpTypeByte* lpBytes) noexcept {
+        static_assert(std::is_unsigned_v<__WordType>);
+
+        __WordType Value = 0;
+        for (OtpTypeSize i = 0; i < sizeof(__WordType); ++i) {
+            Value = static_cast<__WordType>((Value << 8) | lpBytes[i]);
+        }
+
+        return Value;
+    }
+
+    template<typename __WordType>
+    constexpr void OtpStoreBigEndian(__WordType Value, OtpTypeByte* lpBytes) noexcept {
+        static_assert(std::is_unsigned_v<__WordType>);
+
+        for (OtpTypeSize i = sizeof(__WordType); i > 0; --i) {
+            lpBytes[i - 1] = static_cast<OtpTypeByte>(Value);
+            Value = static_cast<__WordType>(Value >> 8);
+        }
+    }
+
+    //
+    // Merkle-Damgard streaming context shared by SHA-1 and the SHA-2 family.
+    //
+    // __HashTraits must provide:
+    //   WordType, StateType, BlockSize, DigestSize, LengthSize, InitialState,
+    //   Transform(StateType&, const OtpTypeByte*) and StoreDigest(const StateType&, OtpTypeByte*).
+    //
+    template<typename __HashTraits>
+    class OtpHashContext {
+    public:
+
+        using TraitsType = __HashTraits;
+        using StateType = typename __HashTraits::StateType;
+
+        static constexpr OtpTypeSize BlockSize = __HashTraits::BlockSize;
+        static constexpr OtpTypeSize DigestSize = __HashTraits::DigestSize;
+
+    private:
+
+        StateType       m_State;
+        OtpTypeByte     m_Block[BlockSize];
+        OtpTypeSize     m_BlockSize;
+        OtpTypeUInt64   m_MessageSize;
+
+    public:
+
+        constexpr OtpHashContext() noexcept :
+            m_State(__HashTraits::InitialState),
+            m_Block{},
+            m_BlockSize(0),
+            m_MessageSize(0) {}
+
+        //
+        // resumes hashing from a midstate captured after MessageSize bytes, which must be a multiple of BlockSize.
+        //
+        constexpr OtpHashContext(const StateType& State, OtpTypeUInt64 MessageSize) noexcept :
+            m_State(State),
+            m_Block{},
+            m_BlockSize(0),
+            m_MessageSize(MessageSize) {}
+
+        constexpr void Update(const OtpTypeByte* lpData, OtpTypeSize cbData) noexcept {
+            m_MessageSize += cbData;
+
+            if (m_BlockSize) {
+                while (cbData && m_BlockSize < BlockSize) {
+                    m_Block[m_BlockSize++] = *lpData++;
+                    --cbData;
+                }
+
+                if (m_BlockSize == BlockSize) {
+                    __HashTraits::Transform(m_State, m_Block);
+                    m_BlockSize = 0;
+                }
+            }
+
+            while (cbData >= BlockSize) {
+                __HashTraits::Transform(m_State, lpData);
+                lpData += BlockSize;
+                cbData -= BlockSize;
+            }
+
+            while (cbData) {
+                m_Block[m_BlockSize++] = *lpData++;
+                --cbData;
+            }
+        }
+
+        constexpr void Finish(OtpTypeByte* lpDigest) noexcept {
+            OtpTypeUInt64 MessageBits = m_MessageSize * 8;
+
+            m_Block[m_BlockSize++] = 0x80;
+
+            if (m_BlockSize > BlockSize - __HashTraits::LengthSize) {
+                while (m_BlockSize < BlockSize) {
+                    m_Block[m_BlockSize++] = 0;
+                }
+
+                __HashTraits::Transform(m_State, m_Block);
+                m_BlockSize = 0;
+            }
+
+            while (m_BlockSize < BlockSize - sizeof(OtpTypeUInt64)) {
+                m_Block[m_BlockSize++] = 0;
+            }
+
+            if constexpr (__HashTraits::LengthSize > sizeof(OtpTypeUInt64)) {
+                // the high word of a 128-bit length only receives the bits shifted out of MessageBits.
+                m_Block[BlockSize - sizeof(OtpTypeUInt64) - 1] = static_cast<OtpTypeByte>(m_MessageSize >> 61);
+            }
+
+            OtpStoreBigEndian(MessageBits, m_Block + BlockSize - sizeof(OtpTypeUInt64));
+
+            __HashTraits::Transform(m_State, m_Block);
+            __HashTraits::StoreDigest(m_State, lpDigest);
+
+            for (OtpTypeSize i = 0; i < BlockSize; ++i) {
+                m_Block[i] = 0;
+            }
+
+            m_BlockSize = 0;
+        }
+    };
+
+}
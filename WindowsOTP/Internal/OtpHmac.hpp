@@ -0,0 +1,191 @@
+#pragma once
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+#include "OtpHash.hpp"
+#include "OtpSha1.hpp"
+#include "OtpSha2.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // digest size of HMAC under HashMode, usable to size stack buffers at compile time.
+    //
+    [[nodiscard]]
+    constexpr OtpTypeSize OtpHmacDigestSize(OtpHashMode HashMode) noexcept {
+        switch (HashMode) {
+            case OtpHashMode::Sha1:
+                return OtpHashTraitsSha1::DigestSize;
+            case OtpHashMode::Sha256:
+                return OtpHashTraitsSha256::DigestSize;
+            case OtpHashMode::Sha384:
+                return OtpHashTraitsSha384::DigestSize;
+            case OtpHashMode::Sha512:
+                return OtpHashTraitsSha512::DigestSize;
+            default:
+                WINOTP_UNREACHABLE();
+        }
+    }
+
+    inline constexpr OtpTypeSize OtpHmacMaxDigestSize = OtpHmacDigestSize(OtpHashMode::Sha512);
+
+    static_assert(OtpHmacDigestSize(OtpHashMode::Sha1) <= OtpHmacMaxDigestSize);
+    static_assert(OtpHmacDigestSize(OtpHashMode::Sha256) <= OtpHmacMaxDigestSize);
+    static_assert(OtpHmacDigestSize(OtpHashMode::Sha384) <= OtpHmacMaxDigestSize);
+
+    //
+    // hash states after absorbing (K0 ^ ipad) and (K0 ^ opad) respectively.
+    // They are constant for a given key, so every HMAC only pays for the message and outer digest blocks.
+    //
+    template<typename __HashTraits>
+    struct OtpHmacKeyState {
+        typename __HashTraits::StateType Inner;
+        typename __HashTraits::StateType Outer;
+    };
+
+    //
+    // RFC 2104
+    //
+    template<typename __HashTraits>
+    struct OtpHmac {
+        using HashContext = OtpHashContext<__HashTraits>;
+        using StateType = typename __HashTraits::StateType;
+        using KeyStateType = OtpHmacKeyState<__HashTraits>;
+
+        static constexpr OtpTypeSize BlockSize = __HashTraits::BlockSize;
+        static constexpr OtpTypeSize DigestSize = __HashTraits::DigestSize;
+
+        //
+        // the outer message (the inner digest) always fits into a single final block.
+        //
+        static_assert(DigestSize + 1 + __HashTraits::LengthSize <= BlockSize);
+
+        //
+        // Derives (K0 ^ ipad) and (K0 ^ opad), each BlockSize bytes long.
+        //
+        static constexpr void PrepareKeyPads(const OtpTypeByte* lpKey, OtpTypeSize cbKey, OtpTypeByte* lpInnerPad, OtpTypeByte* lpOuterPad) noexcept {
+            OtpTypeByte Key[BlockSize] = {};
+
+            if (cbKey > BlockSize) {
+                HashContext KeyContext;
+                KeyContext.Update(lpKey, cbKey);
+                KeyContext.Finish(Key);
+            } else {
+                for (OtpTypeSize i = 0; i < cbKey; ++i) {
+                    Key[i] = lpKey[i];
+                }
+            }
+
+            for (OtpTypeSize i = 0; i < BlockSize; ++i) {
+                lpInnerPad[i] = Key[i] ^ 0x36;
+                lpOuterPad[i] = Key[i] ^ 0x5C;
+                Key[i] = 0;
+            }
+        }
+
+        static constexpr void PrepareKeyState(const OtpTypeByte* lpKey, OtpTypeSize cbKey, KeyStateType& KeyState) noexcept {
+            OtpTypeByte InnerPad[BlockSize] = {};
+            OtpTypeByte OuterPad[BlockSize] = {};
+
+            PrepareKeyPads(lpKey, cbKey, InnerPad, OuterPad);
+
+            KeyState.Inner = __HashTraits::InitialState;
+            KeyState.Outer = __HashTraits::InitialState;
+            __HashTraits::Transform(KeyState.Inner, InnerPad);
+            __HashTraits::Transform(KeyState.Outer, OuterPad);
+
+            for (OtpTypeSize i = 0; i < BlockSize; ++i) {
+                InnerPad[i] = 0;
+                OuterPad[i] = 0;
+            }
+        }
+
+        //
+        // pads cbData (< BlockSize - LengthSize) trailing bytes of a message that is BlockSize + cbData bytes
+        // long in total, and runs the final compression.
+        //
+        static constexpr void TransformFinalBlock(StateType& State, const OtpTypeByte* lpData, OtpTypeSize cbData) noexcept {
+            OtpTypeByte Block[BlockSize] = {};
+
+            for (OtpTypeSize i = 0; i < cbData; ++i) {
+                Block[i] = lpData[i];
+            }
+
+            Block[cbData] = 0x80;
+            OtpStoreBigEndian(static_cast<OtpTypeUInt64>((BlockSize + cbData) * 8), Block + BlockSize - sizeof(OtpTypeUInt64));
+
+            __HashTraits::Transform(State, Block);
+        }
+
+        static constexpr void Compute(const KeyStateType& KeyState, const OtpTypeByte* lpMessage, OtpTypeSize cbMessage, OtpTypeByte* lpDigest) noexcept {
+            OtpTypeByte InnerDigest[DigestSize] = {};
+
+            if (cbMessage + 1 + __HashTraits::LengthSize <= BlockSize) {
+                // short messages such as HOTP counters: exactly one compression.
+                StateType InnerState = KeyState.Inner;
+                TransformFinalBlock(InnerState, lpMessage, cbMessage);
+                __HashTraits::StoreDigest(InnerState, InnerDigest);
+            } else {
+                HashContext InnerContext(KeyState.Inner, BlockSize);
+                InnerContext.Update(lpMessage, cbMessage);
+                InnerContext.Finish(InnerDigest);
+            }
+
+            StateType OuterState = KeyState.Outer;
+            TransformFinalBlock(OuterState, InnerDigest, DigestSize);
+            __HashTraits::StoreDigest(OuterState, lpDigest);
+        }
+
+        static constexpr void Compute(const OtpTypeByte* lpKey, OtpTypeSize cbKey, const OtpTypeByte* lpMessage, OtpTypeSize cbMessage, OtpTypeByte* lpDigest) noexcept {
+            KeyStateType KeyState = {};
+
+            PrepareKeyState(lpKey, cbKey, KeyState);
+            Compute(KeyState, lpMessage, cbMessage, lpDigest);
+        }
+    };
+
+    //
+    // compile-time counterpart of OtpHashModeDispatch.
+    //
+    template<OtpHashMode __HashMode>
+    struct OtpHashTraitsOf;
+
+    template<>
+    struct OtpHashTraitsOf<OtpHashMode::Sha1> {
+        using Type = OtpHashTraitsSha1;
+    };
+
+    template<>
+    struct OtpHashTraitsOf<OtpHashMode::Sha256> {
+        using Type = OtpHashTraitsSha256;
+    };
+
+    template<>
+    struct OtpHashTraitsOf<OtpHashMode::Sha384> {
+        using Type = OtpHashTraitsSha384;
+    };
+
+    template<>
+    struct OtpHashTraitsOf<OtpHashMode::Sha512> {
+        using Type = OtpHashTraitsSha512;
+    };
+
+    //
+    // Invokes Visitor with a default-constructed hash traits object matching HashMode.
+    //
+    template<typename __VisitorType>
+    decltype(auto) OtpHashModeDispatch(OtpHashMode HashMode, __VisitorType&& Visitor) {
+        switch (HashMode) {
+            case OtpHashMode::Sha1:
+                return Visitor(OtpHashTraitsSha1{});
+            case OtpHashMode::Sha256:
+                return Visitor(OtpHashTraitsSha256{});
+            case OtpHashMode::Sha384:
+                return Visitor(OtpHashTraitsSha384{});
+            case OtpHashMode::Sha512:
+                return Visitor(OtpHashTraitsSha512{});
+            default:
+                WINOTP_UNREACHABLE();
+        }
+    }
+
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <windows.h>
+#include <bcrypt.h>
+#include <stdexcept>
+#include "../OtpType.hpp"
+#include "../OtpByteArray.hpp"
+#include "OtpPlatform.hpp"
+#include "OtpExceptionCategory.hpp"
+#include "OtpResource.hpp"
+#include "OtpResourceTraitsCng.hpp"
+#include "OtpCng.hpp"
+
+#pragma comment(lib, "bcrypt")
+
+namespace WinOTP::Internal {
+
+    //
+    // HMAC backend built on a keyed CNG hash handle that serves as a template for per-call duplicates.
+    //
+    class OtpHmacBackendCng {
+    private:
+
+        static constexpr OtpTypeSize HashObjectStackSize = 1024;
+
+        OtpHashMode         m_HashMode;
+        OtpByteArraySecure  m_HashObject;
+        OtpResource<OtpResourceTraitsCngHashHandle> m_HashHandle;
+
+        [[nodiscard]]
+        static constexpr OtpCngHashEnum ConvertToCngHashEnum(OtpHashMode HashMode) {
+            switch (HashMode) {
+                case OtpHashMode::Sha1:
+                    return OtpCngHashEnum::Sha1;
+                case OtpHashMode::Sha256:
+                    return OtpCngHashEnum::Sha256;
+                case OtpHashMode::Sha384:
+                    return OtpCngHashEnum::Sha384;
+                case OtpHashMode::Sha512:
+                    return OtpCngHashEnum::Sha512;
+                default:
+                    WINOTP_UNREACHABLE();
+            }
+        }
+
+    public:
+
+        explicit OtpHmacBackendCng(OtpHashMode HashMode) noexcept :
+            m_HashMode(HashMode) {}
+
+        [[nodiscard]]
+        OtpTypeSize GetDigestSize() const {
+            return OtpCngCategoryHmac(ConvertToCngHashEnum(m_HashMode)).GetHashSize();
+        }
+
+        void ImportKey(const OtpTypeByte* lpKey, OtpTypeSize cbKey) {
+            if (cbKey > ULONG_MAX) {
+                throw std::length_error("Secret is too long.");
+            }
+
+            const auto& HashProvider = OtpCngCategoryHmac(ConvertToCngHashEnum(m_HashMode));
+            OtpByteArraySecure HashObject(HashProvider.GetHashObjectSize());
+            OtpResource<OtpResourceTraitsCngHashHandle> HashHandle;
+
+            auto ntStatus = BCryptCreateHash(
+                HashProvider.GetNativeHandle(),
+                HashHandle.GetAddressOf(),
+                HashObject.data(),
+                static_cast<ULONG>(HashObject.size()),
+                const_cast<PUCHAR>(lpKey),
+                static_cast<ULONG>(cbKey),
+                BCRYPT_HASH_REUSABLE_FLAG
+            );
+            if (!BCRYPT_SUCCESS(ntStatus)) {
+                throw std::system_error(
+                    ntStatus,
+                    OtpExceptionWinNTCategory()
+                );
+            }
+
+            m_HashObject.swap(HashObject);
+            std::swap(m_HashHandle, HashHandle);
+        }
+
+        //
+        // lpDigest must be able to hold at least GetDigestSize() bytes.
+        // The keyed handle from ImportKey is never hashed into; each call duplicates it into a hash object on
+        // its own stack, so concurrent calls on one object are safe.
+        //
+        OtpTypeSize Compute(const OtpTypeByte* lpMessage, OtpTypeSize cbMessage, OtpTypeByte* lpDigest) const {
+            if (cbMessage > ULONG_MAX) {
+                throw std::length_error("Message is too long.");
+            }
+
+            const auto& HashProvider = OtpCngCategoryHmac(ConvertToCngHashEnum(m_HashMode));
+            auto cbDigest = HashProvider.GetHashSize();
+            auto cbHashObject = HashProvider.GetHashObjectSize();
+
+            //
+            // CNG HMAC objects are a few hundred bytes; only an unexpectedly large one goes to the heap.
+            //
+            alignas(16) OtpTypeByte HashObjectBuffer[HashObjectStackSize];
+            OtpByteArraySecure HashObjectHeap;
+            OtpTypeByte* lpHashObject = HashObjectBuffer;
+            if (cbHashObject > sizeof(HashObjectBuffer)) {
+                HashObjectHeap.resize(cbHashObject);
+                lpHashObject = HashObjectHeap.data();
+            }
+
+            NTSTATUS ntStatus;
+            {
+                OtpResource<OtpResourceTraitsCngHashHandle> HashHandle;
+
+                ntStatus = BCryptDuplicateHash(m_HashHandle.Get(), HashHandle.GetAddressOf(), lpHashObject, cbHashObject, 0);
+                if (BCRYPT_SUCCESS(ntStatus)) {
+                    ntStatus = BCryptHashData(HashHandle.Get(), const_cast<PUCHAR>(lpMessage), static_cast<ULONG>(cbMessage), 0);
+                }
+
+                if (BCRYPT_SUCCESS(ntStatus)) {
+                    ntStatus = BCryptFinishHash(HashHandle.Get(), lpDigest, cbDigest, 0);
+                }
+            }
+
+            // the duplicated object holds the keyed hash state.
+            OtpSecureZeroMemory(lpHashObject, cbHashObject);
+
+            if (!BCRYPT_SUCCESS(ntStatus)) {
+                throw std::system_error(
+                    ntStatus,
+                    OtpExceptionWinNTCategory()
+                );
+            }
+
+            return cbDigest;
+        }
+    };
+
+}
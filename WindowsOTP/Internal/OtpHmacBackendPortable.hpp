@@ -0,0 +1,98 @@
+#pragma once
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+#include "OtpHmac.hpp"
+#include "OtpHmacCounters.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // HMAC backend built on the in-process SHA-1/SHA-2 implementation.
+    // ImportKey caches the HMAC midstates, so each Compute over a short message costs exactly two compressions.
+    // No handles, no heap allocation; key material lives inside the object.
+    //
+    class OtpHmacBackendPortable {
+    private:
+
+        union KeyStateUnion {
+            OtpHmacKeyState<OtpHashTraitsSha1>      Sha1;
+            OtpHmacKeyState<OtpHashTraitsSha256>    Sha256;
+            OtpHmacKeyState<OtpHashTraitsSha384>    Sha384;
+            OtpHmacKeyState<OtpHashTraitsSha512>    Sha512;
+        };
+
+        OtpHashMode     m_HashMode;
+        KeyStateUnion   m_KeyState;
+
+        template<typename __HashTraits>
+        [[nodiscard]]
+        static constexpr auto& SelectKeyState(KeyStateUnion& KeyState) noexcept {
+            if constexpr (std::is_same_v<__HashTraits, OtpHashTraitsSha1>) {
+                return KeyState.Sha1;
+            } else if constexpr (std::is_same_v<__HashTraits, OtpHashTraitsSha256>) {
+                return KeyState.Sha256;
+            } else if constexpr (std::is_same_v<__HashTraits, OtpHashTraitsSha384>) {
+                return KeyState.Sha384;
+            } else {
+                static_assert(std::is_same_v<__HashTraits, OtpHashTraitsSha512>);
+                return KeyState.Sha512;
+            }
+        }
+
+        template<typename __HashTraits>
+        [[nodiscard]]
+        static constexpr const auto& SelectKeyState(const KeyStateUnion& KeyState) noexcept {
+            return SelectKeyState<__HashTraits>(const_cast<KeyStateUnion&>(KeyState));
+        }
+
+    public:
+
+        explicit OtpHmacBackendPortable(OtpHashMode HashMode) noexcept :
+            m_HashMode(HashMode),
+            m_KeyState{} {}
+
+        OtpHmacBackendPortable(const OtpHmacBackendPortable& Other) = default;
+
+        OtpHmacBackendPortable& operator=(const OtpHmacBackendPortable& Other) = default;
+
+        [[nodiscard]]
+        OtpTypeSize GetDigestSize() const noexcept {
+            return OtpHmacDigestSize(m_HashMode);
+        }
+
+        void ImportKey(const OtpTypeByte* lpKey, OtpTypeSize cbKey) noexcept {
+            OtpHashModeDispatch(m_HashMode, [this, lpKey, cbKey](auto HashTraits) {
+                using HashTraitsType = decltype(HashTraits);
+                OtpHmac<HashTraitsType>::PrepareKeyState(lpKey, cbKey, SelectKeyState<HashTraitsType>(m_KeyState));
+            });
+        }
+
+        //
+        // lpDigest must be able to hold at least GetDigestSize() bytes.
+        //
+        OtpTypeSize Compute(const OtpTypeByte* lpMessage, OtpTypeSize cbMessage, OtpTypeByte* lpDigest) const noexcept {
+            return OtpHashModeDispatch(m_HashMode, [this, lpMessage, cbMessage, lpDigest](auto HashTraits) {
+                using HashTraitsType = decltype(HashTraits);
+                OtpHmac<HashTraitsType>::Compute(SelectKeyState<HashTraitsType>(m_KeyState), lpMessage, cbMessage, lpDigest);
+                return OtpHmac<HashTraitsType>::DigestSize;
+            });
+        }
+
+        //
+        // computes HMAC(K, BigEndian64(FirstCounter + i)) for i in [0, Count) and hands each digest to
+        // Callback(i, lpDigest, cbDigest). The hash mode is dispatched once for the whole range.
+        //
+        template<typename __CallbackType>
+        void ComputeCounters(OtpTypeUInt64 FirstCounter, OtpTypeSize Count, __CallbackType&& Callback) const {
+            OtpHashModeDispatch(m_HashMode, [this, FirstCounter, Count, &Callback](auto HashTraits) {
+                using HashTraitsType = decltype(HashTraits);
+                OtpHmacComputeCounters(SelectKeyState<HashTraitsType>(m_KeyState), FirstCounter, Count, Callback);
+            });
+        }
+
+        ~OtpHmacBackendPortable() {
+            OtpSecureZeroMemory(&m_KeyState, sizeof(m_KeyState));
+        }
+    };
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <type_traits>
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+#include "OtpHmac.hpp"
+#include "OtpHmacMultiBuffer.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // computes HMAC(K, BigEndian64(FirstCounter + i)) for i in [0, Count) from cached key midstates and hands
+    // each digest to Callback(i, lpDigest, cbDigest), in increasing i.
+    //
+    template<typename __HashTraits, typename __CallbackType>
+    void OtpHmacComputeCounters(const OtpHmacKeyState<__HashTraits>& KeyState, OtpTypeUInt64 FirstCounter, OtpTypeSize Count, __CallbackType&& Callback) {
+        using HashTraitsType = __HashTraits;
+        using HmacType = OtpHmac<HashTraitsType>;
+
+        OtpTypeByte CounterBytes[sizeof(OtpTypeUInt64)];
+        OtpTypeByte Digest[HmacType::DigestSize];
+        OtpTypeSize i = 0;
+
+#if WINOTP_SIMD_X86
+        //
+        // SHA-1 and SHA-256 run several counters per call in SIMD lanes; whatever is narrower than the
+        // narrowest kernel falls through to the scalar loop below.
+        //
+        if constexpr (std::is_same_v<HashTraitsType, OtpHashTraitsSha1> || std::is_same_v<HashTraitsType, OtpHashTraitsSha256>) {
+            constexpr OtpTypeSize DigestWords = HmacType::DigestSize / sizeof(OtpTypeUInt32);
+
+            const OtpHmacMultiBufferKernelList& KernelList = OtpHmacMultiBufferKernels();
+            OtpTypeUInt64 Counters[OtpHmacMultiBufferMaxLanes];
+            OtpTypeUInt32 DigestWordsSoA[DigestWords * OtpHmacMultiBufferMaxLanes];
+
+            for (OtpTypeSize k = 0; k < KernelList.Count; ++k) {
+                const OtpHmacMultiBufferKernel& Kernel = KernelList.Kernels[k];
+
+                while (Count - i >= Kernel.Lanes) {
+                    for (OtpTypeSize Lane = 0; Lane < Kernel.Lanes; ++Lane) {
+                        Counters[Lane] = FirstCounter + i + Lane;
+                    }
+
+                    if constexpr (std::is_same_v<HashTraitsType, OtpHashTraitsSha1>) {
+                        Kernel.HmacSha1(KeyState, Counters, DigestWordsSoA);
+                    } else {
+                        Kernel.HmacSha256(KeyState, Counters, DigestWordsSoA);
+                    }
+
+                    for (OtpTypeSize Lane = 0; Lane < Kernel.Lanes; ++Lane, ++i) {
+                        for (OtpTypeSize Word = 0; Word < DigestWords; ++Word) {
+                            OtpStoreBigEndian<OtpTypeUInt32>(DigestWordsSoA[Word * Kernel.Lanes + Lane], Digest + Word * sizeof(OtpTypeUInt32));
+                        }
+                        Callback(i, static_cast<const OtpTypeByte*>(Digest), HmacType::DigestSize);
+                    }
+                }
+            }
+        }
+#endif
+
+        for (; i < Count; ++i) {
+            OtpStoreBigEndian<OtpTypeUInt64>(FirstCounter + i, CounterBytes);
+            HmacType::Compute(KeyState, CounterBytes, sizeof(CounterBytes), Digest);
+            Callback(i, static_cast<const OtpTypeByte*>(Digest), HmacType::DigestSize);
+        }
+    }
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <type_traits>
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+#include "OtpCpuFeatures.hpp"
+#include "OtpSimd.hpp"
+#include "OtpShaExtensions.hpp"
+#include "OtpHmac.hpp"
+
+#if WINOTP_SIMD_X86
+
+namespace WinOTP::Internal {
+
+#define WINOTP_MULTIBUFFER_NAMESPACE OtpHmacMultiBufferSse2
+#define WINOTP_MULTIBUFFER_SIMD OtpSimdU32x4
+#define WINOTP_MULTIBUFFER_ISA "sse2"
+#include "OtpHmacMultiBufferKernel.inl"
+#undef WINOTP_MULTIBUFFER_ISA
+#undef WINOTP_MULTIBUFFER_SIMD
+#undef WINOTP_MULTIBUFFER_NAMESPACE
+
+#define WINOTP_MULTIBUFFER_NAMESPACE OtpHmacMultiBufferAvx2
+#define WINOTP_MULTIBUFFER_SIMD OtpSimdU32x8
+#define WINOTP_MULTIBUFFER_ISA "avx2"
+#include "OtpHmacMultiBufferKernel.inl"
+#undef WINOTP_MULTIBUFFER_ISA
+#undef WINOTP_MULTIBUFFER_SIMD
+#undef WINOTP_MULTIBUFFER_NAMESPACE
+
+#define WINOTP_MULTIBUFFER_NAMESPACE OtpHmacMultiBufferAvx512
+#define WINOTP_MULTIBUFFER_SIMD OtpSimdU32x16
+#define WINOTP_MULTIBUFFER_ISA "avx512f"
+#include "OtpHmacMultiBufferKernel.inl"
+#undef WINOTP_MULTIBUFFER_ISA
+#undef WINOTP_MULTIBUFFER_SIMD
+#undef WINOTP_MULTIBUFFER_NAMESPACE
+
+    //
+    // one instruction set's multi-buffer kernels. Each call hashes exactly Lanes counters.
+    //
+    struct OtpHmacMultiBufferKernel {
+        const char* Name;
+        OtpTypeSize Lanes;
+        void (*HmacSha1)(const OtpHmacKeyState<OtpHashTraitsSha1>&, const OtpTypeUInt64*, OtpTypeUInt32*) noexcept;
+        void (*HmacSha256)(const OtpHmacKeyState<OtpHashTraitsSha256>&, const OtpTypeUInt64*, OtpTypeUInt32*) noexcept;
+    };
+
+    inline constexpr OtpTypeSize OtpHmacMultiBufferMaxLanes = 16;
+
+    struct OtpHmacMultiBufferKernelList {
+        OtpHmacMultiBufferKernel    Kernels[3];
+        OtpTypeSize                 Count;
+    };
+
+    //
+    // kernels usable on this CPU, widest first. Selected once at first use.
+    //
+    [[nodiscard]]
+    inline const OtpHmacMultiBufferKernelList& OtpHmacMultiBufferKernels() noexcept {
+        static const OtpHmacMultiBufferKernelList KernelList = [] {
+            const OtpCpuFeatures& Features = OtpCpuFeaturesGet();
+            OtpHmacMultiBufferKernelList List = {};
+
+            if (Features.Avx512F) {
+                List.Kernels[List.Count++] = {
+                    "AVX-512",
+                    OtpSimdU32x16::Lanes,
+                    OtpHmacMultiBufferAvx512::HmacCounters<OtpHashTraitsSha1>,
+                    OtpHmacMultiBufferAvx512::HmacCounters<OtpHashTraitsSha256>
+                };
+            }
+
+            if (Features.Avx2) {
+                List.Kernels[List.Count++] = {
+                    "AVX2",
+                    OtpSimdU32x8::Lanes,
+                    OtpHmacMultiBufferAvx2::HmacCounters<OtpHashTraitsSha1>,
+                    OtpHmacMultiBufferAvx2::HmacCounters<OtpHashTraitsSha256>
+                };
+            }
+
+            //
+            // four lanes of SSE2 lose to one SHA-NI stream; the scalar path uses SHA-NI whenever it is present.
+            //
+            if (Features.Sse2 && !OtpShaExtensionsAvailable()) {
+                List.Kernels[List.Count++] = {
+                    "SSE2",
+                    OtpSimdU32x4::Lanes,
+                    OtpHmacMultiBufferSse2::HmacCounters<OtpHashTraitsSha1>,
+                    OtpHmacMultiBufferSse2::HmacCounters<OtpHashTraitsSha256>
+                };
+            }
+
+            return List;
+        }();
+
+        return KernelList;
+    }
+
+}
+
+#endif
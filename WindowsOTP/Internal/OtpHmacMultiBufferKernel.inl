@@ -0,0 +1,180 @@
+//
+// Multi-buffer HMAC-SHA1/HMAC-SHA256 kernel over 8-byte big-endian counters.
+//
+// This file is included once per instruction set by OtpHmacMultiBuffer.hpp with
+//   WINOTP_MULTIBUFFER_NAMESPACE   namespace receiving the kernel
+//   WINOTP_MULTIBUFFER_SIMD        one of the OtpSimdU32xN wrappers
+//   WINOTP_MULTIBUFFER_ISA         target attribute string matching the wrapper
+// defined. Each lane hashes a different counter under the same key; because every message is a single
+// block whose only variable words are the counter halves (inner pass) or the inner digest (outer pass),
+// the message schedule is built directly in lane-parallel form with no transposition.
+//
+
+namespace WINOTP_MULTIBUFFER_NAMESPACE {
+
+    using SimdType = WINOTP_MULTIBUFFER_SIMD;
+    using VectorType = typename SimdType::Type;
+
+    WINOTP_TARGET(WINOTP_MULTIBUFFER_ISA)
+    inline void Sha1Transform(VectorType (&State)[5], VectorType (&W)[16]) noexcept {
+        VectorType A = State[0];
+        VectorType B = State[1];
+        VectorType C = State[2];
+        VectorType D = State[3];
+        VectorType E = State[4];
+
+        for (OtpTypeSize t = 0; t < 80; ++t) {
+            if (t >= 16) {
+                W[t % 16] = SimdType::RotateLeft<1>(
+                    SimdType::Xor(SimdType::Xor(W[(t - 3) % 16], W[(t - 8) % 16]), SimdType::Xor(W[(t - 14) % 16], W[t % 16]))
+                );
+            }
+
+            VectorType F;
+            VectorType K;
+            if (t < 20) {
+                F = SimdType::Xor(D, SimdType::And(B, SimdType::Xor(C, D)));
+                K = SimdType::Set1(0x5A827999);
+            } else if (t < 40) {
+                F = SimdType::Xor(SimdType::Xor(B, C), D);
+                K = SimdType::Set1(0x6ED9EBA1);
+            } else if (t < 60) {
+                F = SimdType::Or(SimdType::And(B, C), SimdType::And(D, SimdType::Or(B, C)));
+                K = SimdType::Set1(0x8F1BBCDC);
+            } else {
+                F = SimdType::Xor(SimdType::Xor(B, C), D);
+                K = SimdType::Set1(0xCA62C1D6);
+            }
+
+            VectorType T = SimdType::Add(SimdType::Add(SimdType::RotateLeft<5>(A), F), SimdType::Add(SimdType::Add(E, K), W[t % 16]));
+            E = D;
+            D = C;
+            C = SimdType::RotateLeft<30>(B);
+            B = A;
+            A = T;
+        }
+
+        State[0] = SimdType::Add(State[0], A);
+        State[1] = SimdType::Add(State[1], B);
+        State[2] = SimdType::Add(State[2], C);
+        State[3] = SimdType::Add(State[3], D);
+        State[4] = SimdType::Add(State[4], E);
+    }
+
+    WINOTP_TARGET(WINOTP_MULTIBUFFER_ISA)
+    inline void Sha256Transform(VectorType (&State)[8], VectorType (&W)[16]) noexcept {
+        VectorType A = State[0];
+        VectorType B = State[1];
+        VectorType C = State[2];
+        VectorType D = State[3];
+        VectorType E = State[4];
+        VectorType F = State[5];
+        VectorType G = State[6];
+        VectorType H = State[7];
+
+        for (OtpTypeSize t = 0; t < 64; ++t) {
+            if (t >= 16) {
+                VectorType W15 = W[(t - 15) % 16];
+                VectorType W2 = W[(t - 2) % 16];
+                VectorType S0 = SimdType::Xor(SimdType::Xor(SimdType::RotateRight<7>(W15), SimdType::RotateRight<18>(W15)), SimdType::ShiftRight<3>(W15));
+                VectorType S1 = SimdType::Xor(SimdType::Xor(SimdType::RotateRight<17>(W2), SimdType::RotateRight<19>(W2)), SimdType::ShiftRight<10>(W2));
+                W[t % 16] = SimdType::Add(SimdType::Add(W[t % 16], S0), SimdType::Add(W[(t - 7) % 16], S1));
+            }
+
+            VectorType Sigma1 = SimdType::Xor(SimdType::Xor(SimdType::RotateRight<6>(E), SimdType::RotateRight<11>(E)), SimdType::RotateRight<25>(E));
+            VectorType Choose = SimdType::Xor(SimdType::And(E, F), SimdType::AndNot(E, G));
+            VectorType T1 = SimdType::Add(
+                SimdType::Add(H, Sigma1),
+                SimdType::Add(SimdType::Add(Choose, SimdType::Set1(OtpHashTraitsSha256::RoundConstants[t])), W[t % 16])
+            );
+
+            VectorType Sigma0 = SimdType::Xor(SimdType::Xor(SimdType::RotateRight<2>(A), SimdType::RotateRight<13>(A)), SimdType::RotateRight<22>(A));
+            VectorType Majority = SimdType::Or(SimdType::And(A, B), SimdType::And(C, SimdType::Or(A, B)));
+            VectorType T2 = SimdType::Add(Sigma0, Majority);
+
+            H = G;
+            G = F;
+            F = E;
+            E = SimdType::Add(D, T1);
+            D = C;
+            C = B;
+            B = A;
+            A = SimdType::Add(T1, T2);
+        }
+
+        State[0] = SimdType::Add(State[0], A);
+        State[1] = SimdType::Add(State[1], B);
+        State[2] = SimdType::Add(State[2], C);
+        State[3] = SimdType::Add(State[3], D);
+        State[4] = SimdType::Add(State[4], E);
+        State[5] = SimdType::Add(State[5], F);
+        State[6] = SimdType::Add(State[6], G);
+        State[7] = SimdType::Add(State[7], H);
+    }
+
+    //
+    // lpCounters:    SimdType::Lanes counters
+    // lpDigestWords: receives the digest as big-endian words, word-major: lpDigestWords[Word * Lanes + Lane]
+    //
+    template<typename __HashTraits>
+    WINOTP_TARGET(WINOTP_MULTIBUFFER_ISA)
+    inline void HmacCounters(const OtpHmacKeyState<__HashTraits>& KeyState, const OtpTypeUInt64* lpCounters, OtpTypeUInt32* lpDigestWords) noexcept {
+        constexpr OtpTypeSize Lanes = SimdType::Lanes;
+        constexpr OtpTypeSize StateWords = std::tuple_size_v<typename __HashTraits::StateType>;
+        constexpr OtpTypeSize DigestWords = __HashTraits::DigestSize / sizeof(OtpTypeUInt32);
+
+        alignas(64) OtpTypeUInt32 CounterHigh[Lanes];
+        alignas(64) OtpTypeUInt32 CounterLow[Lanes];
+        for (OtpTypeSize i = 0; i < Lanes; ++i) {
+            CounterHigh[i] = static_cast<OtpTypeUInt32>(lpCounters[i] >> 32);
+            CounterLow[i] = static_cast<OtpTypeUInt32>(lpCounters[i]);
+        }
+
+        VectorType State[StateWords];
+        VectorType W[16];
+
+        // inner: H(K ^ ipad || counter), resumed from the ipad midstate
+        for (OtpTypeSize i = 0; i < StateWords; ++i) {
+            State[i] = SimdType::Set1(KeyState.Inner[i]);
+        }
+
+        W[0] = SimdType::Load(CounterHigh);
+        W[1] = SimdType::Load(CounterLow);
+        W[2] = SimdType::Set1(0x80000000);
+        for (OtpTypeSize i = 3; i < 15; ++i) {
+            W[i] = SimdType::Zero();
+        }
+        W[15] = SimdType::Set1(static_cast<OtpTypeUInt32>((__HashTraits::BlockSize + sizeof(OtpTypeUInt64)) * 8));
+
+        if constexpr (std::is_same_v<__HashTraits, OtpHashTraitsSha1>) {
+            Sha1Transform(State, W);
+        } else {
+            Sha256Transform(State, W);
+        }
+
+        // outer: H(K ^ opad || inner digest), resumed from the opad midstate
+        for (OtpTypeSize i = 0; i < DigestWords; ++i) {
+            W[i] = State[i];
+        }
+        W[DigestWords] = SimdType::Set1(0x80000000);
+        for (OtpTypeSize i = DigestWords + 1; i < 15; ++i) {
+            W[i] = SimdType::Zero();
+        }
+        W[15] = SimdType::Set1(static_cast<OtpTypeUInt32>((__HashTraits::BlockSize + __HashTraits::DigestSize) * 8));
+
+        for (OtpTypeSize i = 0; i < StateWords; ++i) {
+            State[i] = SimdType::Set1(KeyState.Outer[i]);
+        }
+
+        if constexpr (std::is_same_v<__HashTraits, OtpHashTraitsSha1>) {
+            Sha1Transform(State, W);
+        } else {
+            Sha256Transform(State, W);
+        }
+
+        for (OtpTypeSize i = 0; i < DigestWords; ++i) {
+            SimdType::Store(lpDigestWords + i * Lanes, State[i]);
+        }
+    }
+
+}
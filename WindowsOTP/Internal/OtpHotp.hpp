@@ -0,0 +1,116 @@
+#pragma once
+#include "../OtpType.hpp"
+#include "OtpHash.hpp"
+#include "OtpConstantTime.hpp"
+#include "OtpPlatform.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // 10^Digit
+    //
+    [[nodiscard]]
+    constexpr OtpTypeUInt32 OtpHotpModulus(OtpTypeUInt32 Digit) noexcept {
+        OtpTypeUInt32 Result = 1;
+
+        for (OtpTypeUInt32 i = 0; i < Digit; ++i) {
+            Result *= 10;
+        }
+
+        return Result;
+    }
+
+    inline constexpr OtpTypeUInt32 OtpHotpMaxDigit = 8;
+
+    //
+    // writes Code as exactly Digit decimal characters, zero-padded on the left, without a terminator.
+    //
+    template<typename __CharType>
+    constexpr void OtpHotpFormat(OtpTypeUInt32 Code, OtpTypeUInt32 Digit, __CharType* lpszCode) noexcept {
+        for (OtpTypeUInt32 i = Digit; i > 0; --i) {
+            lpszCode[i - 1] = static_cast<__CharType>('0' + Code % 10);
+            Code /= 10;
+        }
+    }
+
+    //
+    // RFC 4226, section 5.3: dynamic truncation of an HMAC value to a __Digit-digit code.
+    // With the digit count fixed the modulus is a constant, which compilers reduce to a multiply and shift.
+    //
+    template<OtpTypeUInt32 __Digit>
+    [[nodiscard]]
+    WINOTP_FORCEINLINE OtpTypeUInt32 OtpHotpTruncate(const OtpTypeByte* lpHmacHash, OtpTypeSize cbHmacHash) noexcept {
+        static_assert(6 <= __Digit && __Digit <= OtpHotpMaxDigit);
+
+        OtpTypeByte Offset = lpHmacHash[cbHmacHash - 1] & 0xF;
+        OtpTypeUInt32 Code = OtpLoadBigEndian<OtpTypeUInt32>(lpHmacHash + Offset);
+
+        return (Code & static_cast<OtpTypeUInt32>(0x7FFFFFFF)) % OtpHotpModulus(__Digit);
+    }
+
+    //
+    // runtime digit count: one switch into the constant-modulus forms above.
+    //
+    [[nodiscard]]
+    inline OtpTypeUInt32 OtpHotpTruncate(const OtpTypeByte* lpHmacHash, OtpTypeSize cbHmacHash, OtpTypeUInt32 Digit) noexcept {
+        switch (Digit) {
+            case 6:
+                return OtpHotpTruncate<6>(lpHmacHash, cbHmacHash);
+            case 7:
+                return OtpHotpTruncate<7>(lpHmacHash, cbHmacHash);
+            case 8:
+                return OtpHotpTruncate<8>(lpHmacHash, cbHmacHash);
+            default:
+                WINOTP_UNREACHABLE();
+        }
+    }
+
+    //
+    // the counters [Center - Behind, Center + Ahead], clamped to [0, UINT64_MAX] instead of wrapping around.
+    //
+    struct OtpHotpWindow {
+        OtpTypeUInt64   FirstCounter;
+        OtpTypeSize     Count;
+
+        [[nodiscard]]
+        static constexpr OtpHotpWindow Around(OtpTypeUInt64 Center, OtpTypeUInt64 Behind, OtpTypeUInt64 Ahead) noexcept {
+            OtpTypeUInt64 First = Center < Behind ? 0 : Center - Behind;
+            OtpTypeUInt64 Last = Center + Ahead < Center ? UINT64_MAX : Center + Ahead;
+            return OtpHotpWindow{ First, static_cast<OtpTypeSize>(Last - First) + 1 };
+        }
+    };
+
+    //
+    // accumulates the first candidate index equal to Code, in constant time.
+    // Feed every candidate of the window through Update, then read Result.
+    //
+    class OtpHotpWindowMatch {
+    private:
+
+        OtpTypeUInt32   m_Code;
+        OtpTypeUInt32   m_Found;
+        OtpTypeSize     m_MatchedIndex;
+
+    public:
+
+        OtpHotpWindowMatch(OtpTypeUInt32 Code, OtpTypeSize Count) noexcept :
+            m_Code(Code),
+            m_Found(0),
+            m_MatchedIndex(Count) {}
+
+        void Update(OtpTypeSize i, OtpTypeUInt32 Candidate) noexcept {
+            OtpTypeUInt32 IsFirstMatch = OtpConstantTimeIsEqual(Candidate, m_Code) & (m_Found ^ 1);
+            m_MatchedIndex = OtpConstantTimeSelect<OtpTypeSize>(IsFirstMatch, i, m_MatchedIndex);
+            m_Found |= IsFirstMatch;
+        }
+
+        //
+        // index of the first match, or the window size if nothing matched.
+        //
+        [[nodiscard]]
+        OtpTypeSize Result() const noexcept {
+            return m_MatchedIndex;
+        }
+    };
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <stdint.h>
+#include <string_view>
+#include <system_error>
+#include <stdexcept>
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+#include "OtpResource.hpp"
+#include "OtpResourceTraitsFile.hpp"
+
+#if WINOTP_PLATFORM_WINDOWS
+#include <windows.h>
+#include "OtpExceptionCategory.hpp"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace WinOTP::Internal {
+
+    //
+    // read-only mapping of a whole file. The file and mapping handles are closed right after mapping; the view
+    // alone keeps the pages reachable. An empty file yields an empty view, since neither OS maps zero bytes.
+    //
+    class OtpMappedFile {
+    private:
+
+        const char* m_lpView;
+        OtpTypeSize m_cbView;
+
+#if WINOTP_PLATFORM_WINDOWS
+        void Map(OtpResource<OtpResourceTraitsWin32File>& File) {
+            LARGE_INTEGER FileSize;
+
+            if (File.IsValid() == false || GetFileSizeEx(File.Get(), &FileSize) == false) {
+                throw std::system_error(GetLastError(), OtpExceptionWin32Category());
+            }
+
+            if (static_cast<ULONGLONG>(FileSize.QuadPart) > SIZE_MAX) {
+                throw std::length_error("File is too large to be mapped.");
+            }
+
+            if (FileSize.QuadPart != 0) {
+                OtpResource<OtpResourceTraitsWin32FileMapping> Mapping(CreateFileMappingW(File.Get(), NULL, PAGE_READONLY, 0, 0, NULL));
+                if (Mapping.IsValid() == false) {
+                    throw std::system_error(GetLastError(), OtpExceptionWin32Category());
+                }
+
+                m_lpView = reinterpret_cast<const char*>(MapViewOfFile(Mapping.Get(), FILE_MAP_READ, 0, 0, 0));
+                if (m_lpView == nullptr) {
+                    throw std::system_error(GetLastError(), OtpExceptionWin32Category());
+                }
+
+                m_cbView = static_cast<OtpTypeSize>(FileSize.QuadPart);
+            }
+        }
+#endif
+
+    public:
+
+#if WINOTP_PLATFORM_WINDOWS
+        explicit OtpMappedFile(const char* lpszPath) :
+            m_lpView(nullptr),
+            m_cbView(0)
+        {
+            OtpResource<OtpResourceTraitsWin32File> File(CreateFileA(lpszPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL));
+            Map(File);
+        }
+
+        explicit OtpMappedFile(const wchar_t* lpszPath) :
+            m_lpView(nullptr),
+            m_cbView(0)
+        {
+            OtpResource<OtpResourceTraitsWin32File> File(CreateFileW(lpszPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL));
+            Map(File);
+        }
+#else
+        explicit OtpMappedFile(const char* lpszPath) :
+            m_lpView(nullptr),
+            m_cbView(0)
+        {
+            OtpResource<OtpResourceTraitsPosixFileDescriptor> File(open(lpszPath, O_RDONLY | O_CLOEXEC));
+            struct stat FileStatus;
+
+            if (File.IsValid() == false || fstat(File.Get(), &FileStatus) != 0) {
+                throw std::system_error(errno, std::generic_category());
+            }
+
+            if (static_cast<uintmax_t>(FileStatus.st_size) > SIZE_MAX) {
+                throw std::length_error("File is too large to be mapped.");
+            }
+
+            if (FileStatus.st_size != 0) {
+                void* lpView = mmap(nullptr, static_cast<size_t>(FileStatus.st_size), PROT_READ, MAP_PRIVATE, File.Get(), 0);
+                if (lpView == MAP_FAILED) {
+                    throw std::system_error(errno, std::generic_category());
+                }
+
+                // only a hint: the whole file is about to be read, mostly front to back.
+                madvise(lpView, static_cast<size_t>(FileStatus.st_size), MADV_WILLNEED);
+
+                m_lpView = reinterpret_cast<const char*>(lpView);
+                m_cbView = static_cast<OtpTypeSize>(FileStatus.st_size);
+            }
+        }
+#endif
+
+        OtpMappedFile(const OtpMappedFile& Other) = delete;
+
+        OtpMappedFile& operator=(const OtpMappedFile& Other) = delete;
+
+        ~OtpMappedFile() {
+            if (m_lpView != nullptr) {
+#if WINOTP_PLATFORM_WINDOWS
+                UnmapViewOfFile(m_lpView);
+#else
+                munmap(const_cast<char*>(m_lpView), m_cbView);
+#endif
+            }
+        }
+
+        [[nodiscard]]
+        std::string_view GetText() const noexcept {
+            return std::string_view(m_lpView, m_cbView);
+        }
+    };
+
+}
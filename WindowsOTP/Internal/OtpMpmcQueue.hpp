@@ -0,0 +1,132 @@
+#pragma once
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace WinOTP::Internal {
+
+    //
+    // bounded multi-producer multi-consumer ring after Dmitry Vyukov's design. Every cell carries a sequence
+    // number telling whose turn it is: a push or pop is one CAS on its position plus one release store on the
+    // cell, and a full or empty ring is detected without a lock. The two positions sit on their own cache
+    // lines so producers and consumers do not invalidate each other's.
+    //
+    template<typename __ValueType>
+    class OtpMpmcQueue {
+    private:
+
+        struct Cell {
+            std::atomic<OtpTypeSize>    Sequence;
+            __ValueType                 Value;
+        };
+
+        std::unique_ptr<Cell[]>     m_Cells;
+        OtpTypeSize                 m_Mask;
+
+        alignas(WINOTP_CACHE_LINE_SIZE) std::atomic<OtpTypeSize> m_EnqueuePosition;
+        alignas(WINOTP_CACHE_LINE_SIZE) std::atomic<OtpTypeSize> m_DequeuePosition;
+
+    public:
+
+        //
+        // Capacity is rounded up to a power of two, at least 2.
+        //
+        explicit OtpMpmcQueue(OtpTypeSize Capacity) :
+            m_Mask(0),
+            m_EnqueuePosition(0),
+            m_DequeuePosition(0)
+        {
+            OtpTypeSize CellCount = 2;
+
+            while (CellCount < Capacity) {
+                if (CellCount > SIZE_MAX / 2 / sizeof(Cell)) {
+                    throw std::length_error("Queue capacity is too large.");
+                }
+                CellCount *= 2;
+            }
+
+            m_Cells.reset(new Cell[CellCount]);
+            m_Mask = CellCount - 1;
+
+            for (OtpTypeSize i = 0; i < CellCount; ++i) {
+                m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        OtpMpmcQueue(const OtpMpmcQueue& Other) = delete;
+
+        OtpMpmcQueue& operator=(const OtpMpmcQueue& Other) = delete;
+
+        //
+        // false if the queue is full.
+        //
+        [[nodiscard]]
+        bool TryPush(const __ValueType& Value) noexcept {
+            OtpTypeSize Position = m_EnqueuePosition.load(std::memory_order_relaxed);
+
+            for (;;) {
+                Cell& Target = m_Cells[Position & m_Mask];
+                OtpTypeSize Sequence = Target.Sequence.load(std::memory_order_acquire);
+                intptr_t Lag = static_cast<intptr_t>(Sequence) - static_cast<intptr_t>(Position);
+
+                if (Lag == 0) {
+                    if (m_EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed)) {
+                        Target.Value = Value;
+                        Target.Sequence.store(Position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (Lag < 0) {
+                    return false;
+                } else {
+                    Position = m_EnqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        //
+        // false if the queue is empty, or its oldest value is still being pushed.
+        //
+        [[nodiscard]]
+        bool TryPop(__ValueType& Value) noexcept {
+            OtpTypeSize Position = m_DequeuePosition.load(std::memory_order_relaxed);
+
+            for (;;) {
+                Cell& Target = m_Cells[Position & m_Mask];
+                OtpTypeSize Sequence = Target.Sequence.load(std::memory_order_acquire);
+                intptr_t Lag = static_cast<intptr_t>(Sequence) - static_cast<intptr_t>(Position + 1);
+
+                if (Lag == 0) {
+                    if (m_DequeuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed)) {
+                        Value = Target.Value;
+                        Target.Sequence.store(Position + m_Mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (Lag < 0) {
+                    return false;
+                } else {
+                    Position = m_DequeuePosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        //
+        // values pushed and not yet popped. Only a snapshot while other threads push or pop.
+        //
+        [[nodiscard]]
+        OtpTypeSize GetSize() const noexcept {
+            OtpTypeSize DequeuePosition = m_DequeuePosition.load(std::memory_order_seq_cst);
+            OtpTypeSize EnqueuePosition = m_EnqueuePosition.load(std::memory_order_seq_cst);
+            return EnqueuePosition > DequeuePosition ? EnqueuePosition - DequeuePosition : 0;
+        }
+
+        [[nodiscard]]
+        OtpTypeSize GetCapacity() const noexcept {
+            return m_Mask + 1;
+        }
+    };
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define WINOTP_PLATFORM_WINDOWS 1
+#include <windows.h>
+#else
+#define WINOTP_PLATFORM_WINDOWS 0
+#endif
+
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#define WINOTP_UNREACHABLE() __assume(0)
+#define WINOTP_FORCEINLINE __forceinline
+#else
+#define WINOTP_UNREACHABLE() __builtin_unreachable()
+#define WINOTP_FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WINOTP_ARCH_X86 1
+#else
+#define WINOTP_ARCH_X86 0
+#endif
+
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define WINOTP_ARCH_ARM64 1
+#else
+#define WINOTP_ARCH_ARM64 0
+#endif
+
+//
+// alignment that keeps independently written atomics off each other's cache lines. 64 bytes on every x86
+// and on the ARM64 cores Windows runs on; std::hardware_destructive_interference_size is not available
+// everywhere yet.
+//
+#define WINOTP_CACHE_LINE_SIZE 64
+
+//
+// define WINOTP_INSTRUMENTATION to record operation counts, latency histograms and TOTP drift (see
+// OtpInstrumentation.hpp). Without it the hooks compile to nothing.
+//
+#if defined(WINOTP_INSTRUMENTATION)
+#define WINOTP_INSTRUMENTATION_ENABLED 1
+#else
+#define WINOTP_INSTRUMENTATION_ENABLED 0
+#endif
+
+//
+// define WINOTP_NO_SIMD to compile only the portable scalar code paths.
+//
+#if WINOTP_ARCH_X86 && !defined(WINOTP_NO_SIMD)
+#define WINOTP_SIMD_X86 1
+#else
+#define WINOTP_SIMD_X86 0
+#endif
+
+//
+// ARMv8 SHA-1/SHA-256 instructions are used only when the compiler already targets them;
+// Windows on ARM64 requires them, so MSVC always qualifies.
+//
+#if WINOTP_ARCH_ARM64 && !defined(WINOTP_NO_SIMD) && (defined(_M_ARM64) || defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#define WINOTP_SIMD_ARM64_SHA 1
+#else
+#define WINOTP_SIMD_ARM64_SHA 0
+#endif
+
+//
+// true while a constexpr function is being evaluated at compile time, where intrinsics are not allowed.
+// GCC 9+, Clang 9+ and MSVC 19.25+ (Visual Studio 2019 16.5) provide the builtin in C++17 mode as well.
+// Older MSVC always takes the runtime path, so the hash functions are then only usable at run time.
+//
+#if defined(_MSC_VER) && !defined(__clang__) && _MSC_VER < 1925
+#define WINOTP_IS_CONSTANT_EVALUATED() false
+#else
+#define WINOTP_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+//
+// MSVC lets any function use any intrinsic; GCC and Clang need the instruction set enabled per function.
+//
+#if defined(_MSC_VER) && !defined(__clang__)
+#define WINOTP_TARGET(Isa)
+#else
+#define WINOTP_TARGET(Isa) __attribute__((target(Isa)))
+#endif
+
+namespace WinOTP::Internal {
+
+    [[nodiscard]]
+    inline uint16_t OtpByteSwap16(uint16_t Value) noexcept {
+#if defined(_MSC_VER)
+        return _byteswap_ushort(Value);
+#else
+        return __builtin_bswap16(Value);
+#endif
+    }
+
+    [[nodiscard]]
+    inline uint32_t OtpByteSwap32(uint32_t Value) noexcept {
+#if defined(_MSC_VER)
+        return _byteswap_ulong(Value);
+#else
+        return __builtin_bswap32(Value);
+#endif
+    }
+
+    [[nodiscard]]
+    inline uint64_t OtpByteSwap64(uint64_t Value) noexcept {
+#if defined(_MSC_VER)
+        return _byteswap_uint64(Value);
+#else
+        return __builtin_bswap64(Value);
+#endif
+    }
+
+    inline void OtpSecureZeroMemory(void* lpBuffer, size_t cbBuffer) noexcept {
+#if WINOTP_PLATFORM_WINDOWS
+        SecureZeroMemory(lpBuffer, cbBuffer);
+#else
+        //
+        // writes through a volatile pointer cannot be elided by the optimizer.
+        //
+        volatile unsigned char* p = reinterpret_cast<volatile unsigned char*>(lpBuffer);
+        while (cbBuffer--) {
+            *p++ = 0;
+        }
+#endif
+    }
+
+}
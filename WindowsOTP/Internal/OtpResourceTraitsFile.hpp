@@ -0,0 +1,63 @@
+#pragma once
+#include "OtpPlatform.hpp"
+
+#if WINOTP_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace WinOTP::Internal {
+
+#if WINOTP_PLATFORM_WINDOWS
+
+    struct OtpResourceTraitsWin32File {
+        using HandleType = HANDLE;
+
+        static inline const HandleType InvalidValue = INVALID_HANDLE_VALUE;
+
+        [[nodiscard]]
+        static bool IsValid(const HandleType& Handle) noexcept {
+            return Handle != InvalidValue;
+        }
+
+        static void Release(const HandleType& Handle) noexcept {
+            CloseHandle(Handle);
+        }
+    };
+
+    struct OtpResourceTraitsWin32FileMapping {
+        using HandleType = HANDLE;
+
+        static inline const HandleType InvalidValue = NULL;
+
+        [[nodiscard]]
+        static bool IsValid(const HandleType& Handle) noexcept {
+            return Handle != InvalidValue;
+        }
+
+        static void Release(const HandleType& Handle) noexcept {
+            CloseHandle(Handle);
+        }
+    };
+
+#else
+
+    struct OtpResourceTraitsPosixFileDescriptor {
+        using HandleType = int;
+
+        static inline const HandleType InvalidValue = -1;
+
+        [[nodiscard]]
+        static bool IsValid(const HandleType& Handle) noexcept {
+            return Handle != InvalidValue;
+        }
+
+        static void Release(const HandleType& Handle) noexcept {
+            close(Handle);
+        }
+    };
+
+#endif
+
+}
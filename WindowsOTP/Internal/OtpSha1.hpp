@@ -0,0 +1,117 @@
+#pragma once
+#include "OtpHash.hpp"
+#include "OtpShaExtensions.hpp"
+#include <array>
+
+namespace WinOTP::Internal {
+
+    //
+    // FIPS 180-4, section 6.1
+    //
+    struct OtpHashTraitsSha1 {
+        using WordType = OtpTypeUInt32;
+        using StateType = std::array<WordType, 5>;
+
+        static constexpr OtpTypeSize BlockSize = 64;
+        static constexpr OtpTypeSize DigestSize = 20;
+        static constexpr OtpTypeSize LengthSize = 8;
+
+        static constexpr StateType InitialState = {
+            0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+        };
+
+        static constexpr void TransformGeneric(StateType& State, const OtpTypeByte* lpBlock) noexcept {
+            WordType W[16] = {};
+            for (OtpTypeSize i = 0; i < 16; ++i) {
+                W[i] = OtpLoadBigEndian<WordType>(lpBlock + i * sizeof(WordType));
+            }
+
+            WordType A = State[0];
+            WordType B = State[1];
+            WordType C = State[2];
+            WordType D = State[3];
+            WordType E = State[4];
+
+            //
+            // rounds are unrolled by five with the working variables rotated through the argument list,
+            // which avoids the register shuffle at the end of every round.
+            //
+            auto Schedule = [&W](OtpTypeSize t) constexpr {
+                if (t >= 16) {
+                    W[t % 16] = OtpRotateLeft(W[(t - 3) % 16] ^ W[(t - 8) % 16] ^ W[(t - 14) % 16] ^ W[t % 16], 1);
+                }
+
+                return W[t % 16];
+            };
+
+            auto Round = [&Schedule](OtpTypeSize t, WordType a, WordType& b, WordType c, WordType d, WordType& e, WordType f, WordType k) constexpr {
+                (void)c;
+                (void)d;
+                e += OtpRotateLeft(a, 5) + f + k + Schedule(t);
+                b = OtpRotateLeft(b, 30);
+            };
+
+            auto Choose = [](WordType b, WordType c, WordType d) constexpr { return d ^ (b & (c ^ d)); };
+            auto Parity = [](WordType b, WordType c, WordType d) constexpr { return b ^ c ^ d; };
+            auto Majority = [](WordType b, WordType c, WordType d) constexpr { return (b & c) | (d & (b | c)); };
+
+            for (OtpTypeSize t = 0; t < 20; t += 5) {
+                Round(t + 0, A, B, C, D, E, Choose(B, C, D), 0x5A827999);
+                Round(t + 1, E, A, B, C, D, Choose(A, B, C), 0x5A827999);
+                Round(t + 2, D, E, A, B, C, Choose(E, A, B), 0x5A827999);
+                Round(t + 3, C, D, E, A, B, Choose(D, E, A), 0x5A827999);
+                Round(t + 4, B, C, D, E, A, Choose(C, D, E), 0x5A827999);
+            }
+
+            for (OtpTypeSize t = 20; t < 40; t += 5) {
+                Round(t + 0, A, B, C, D, E, Parity(B, C, D), 0x6ED9EBA1);
+                Round(t + 1, E, A, B, C, D, Parity(A, B, C), 0x6ED9EBA1);
+                Round(t + 2, D, E, A, B, C, Parity(E, A, B), 0x6ED9EBA1);
+                Round(t + 3, C, D, E, A, B, Parity(D, E, A), 0x6ED9EBA1);
+                Round(t + 4, B, C, D, E, A, Parity(C, D, E), 0x6ED9EBA1);
+            }
+
+            for (OtpTypeSize t = 40; t < 60; t += 5) {
+                Round(t + 0, A, B, C, D, E, Majority(B, C, D), 0x8F1BBCDC);
+                Round(t + 1, E, A, B, C, D, Majority(A, B, C), 0x8F1BBCDC);
+                Round(t + 2, D, E, A, B, C, Majority(E, A, B), 0x8F1BBCDC);
+                Round(t + 3, C, D, E, A, B, Majority(D, E, A), 0x8F1BBCDC);
+                Round(t + 4, B, C, D, E, A, Majority(C, D, E), 0x8F1BBCDC);
+            }
+
+            for (OtpTypeSize t = 60; t < 80; t += 5) {
+                Round(t + 0, A, B, C, D, E, Parity(B, C, D), 0xCA62C1D6);
+                Round(t + 1, E, A, B, C, D, Parity(A, B, C), 0xCA62C1D6);
+                Round(t + 2, D, E, A, B, C, Parity(E, A, B), 0xCA62C1D6);
+                Round(t + 3, C, D, E, A, B, Parity(D, E, A), 0xCA62C1D6);
+                Round(t + 4, B, C, D, E, A, Parity(C, D, E), 0xCA62C1D6);
+            }
+
+            State[0] += A;
+            State[1] += B;
+            State[2] += C;
+            State[3] += D;
+            State[4] += E;
+        }
+
+        //
+        // uses the SHA instructions when the CPU has them, except during constant evaluation.
+        //
+        static constexpr void Transform(StateType& State, const OtpTypeByte* lpBlock) noexcept {
+#if WINOTP_SHA_EXTENSIONS
+            if (!WINOTP_IS_CONSTANT_EVALUATED() && OtpShaExtensionsAvailable()) {
+                OtpSha1TransformShaExtensions(State.data(), lpBlock);
+                return;
+            }
+#endif
+            TransformGeneric(State, lpBlock);
+        }
+
+        static constexpr void StoreDigest(const StateType& State, OtpTypeByte* lpDigest) noexcept {
+            for (OtpTypeSize i = 0; i < DigestSize / sizeof(WordType); ++i) {
+                OtpStoreBigEndian(State[i], lpDigest + i * sizeof(WordType));
+            }
+        }
+    };
+
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include "OtpHash.hpp"
+#include "OtpShaExtensions.hpp"
+#include <array>
+
+namespace WinOTP::Internal {
+
+    //
+    // FIPS 180-4, section 6.2
+    //
+    struct OtpHashTraitsSha256 {
+        using WordType = OtpTypeUInt32;
+        using StateType = std::array<WordType, 8>;
+
+        static constexpr OtpTypeSize BlockSize = 64;
+        static constexpr OtpTypeSize DigestSize = 32;
+        static constexpr OtpTypeSize LengthSize = 8;
+
+        static constexpr StateType InitialState = {
+            0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+            0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+        };
+
+        static constexpr WordType RoundConstants[64] = {
+            0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+            0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+            0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+            0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+            0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+            0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+            0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+            0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+        };
+
+        static constexpr void TransformGeneric(StateType& State, const OtpTypeByte* lpBlock) noexcept {
+            WordType W[16] = {};
+            for (OtpTypeSize i = 0; i < 16; ++i) {
+                W[i] = OtpLoadBigEndian<WordType>(lpBlock + i * sizeof(WordType));
+            }
+
+            WordType A = State[0];
+            WordType B = State[1];
+            WordType C = State[2];
+            WordType D = State[3];
+            WordType E = State[4];
+            WordType F = State[5];
+            WordType G = State[6];
+            WordType H = State[7];
+
+            for (OtpTypeSize t = 0; t < 64; ++t) {
+                if (t >= 16) {
+                    WordType W15 = W[(t - 15) % 16];
+                    WordType W2 = W[(t - 2) % 16];
+                    WordType S0 = OtpRotateRight(W15, 7) ^ OtpRotateRight(W15, 18) ^ (W15 >> 3);
+                    WordType S1 = OtpRotateRight(W2, 17) ^ OtpRotateRight(W2, 19) ^ (W2 >> 10);
+                    W[t % 16] += S0 + W[(t - 7) % 16] + S1;
+                }
+
+                WordType T1 = H + (OtpRotateRight(E, 6) ^ OtpRotateRight(E, 11) ^ OtpRotateRight(E, 25)) + ((E & F) ^ (~E & G)) + RoundConstants[t] + W[t % 16];
+                WordType T2 = (OtpRotateRight(A, 2) ^ OtpRotateRight(A, 13) ^ OtpRotateRight(A, 22)) + ((A & B) ^ (A & C) ^ (B & C));
+                H = G;
+                G = F;
+                F = E;
+                E = D + T1;
+                D = C;
+                C = B;
+                B = A;
+                A = T1 + T2;
+            }
+
+            State[0] += A;
+            State[1] += B;
+            State[2] += C;
+            State[3] += D;
+            State[4] += E;
+            State[5] += F;
+            State[6] += G;
+            State[7] += H;
+        }
+
+        //
+        // uses the SHA instructions when the CPU has them, except during constant evaluation.
+        //
+        static constexpr void Transform(StateType& State, const OtpTypeByte* lpBlock) noexcept {
+#if WINOTP_SHA_EXTENSIONS
+            if (!WINOTP_IS_CONSTANT_EVALUATED() && OtpShaExtensionsAvailable()) {
+                OtpSha256TransformShaExtensions(State.data(), lpBlock, RoundConstants);
+                return;
+            }
+#endif
+            TransformGeneric(State, lpBlock);
+        }
+
+        static constexpr void StoreDigest(const StateType& State, OtpTypeByte* lpDigest) noexcept {
+            for (OtpTypeSize i = 0; i < DigestSize / sizeof(WordType); ++i) {
+                OtpStoreBigEndian(State[i], lpDigest + i * sizeof(WordType));
+            }
+        }
+    };
+
+    //
+    // FIPS 180-4, section 6.4
+    //
+    struct OtpHashTraitsSha512 {
+        using WordType = OtpTypeUInt64;
+        using StateType = std::array<WordType, 8>;
+
+        static constexpr OtpTypeSize BlockSize = 128;
+        static constexpr OtpTypeSize DigestSize = 64;
+        static constexpr OtpTypeSize LengthSize = 16;
+
+        static constexpr StateType InitialState = {
+            0x6A09E667F3BCC908, 0xBB67AE8584CAA73B, 0x3C6EF372FE94F82B, 0xA54FF53A5F1D36F1,
+            0x510E527FADE682D1, 0x9B05688C2B3E6C1F, 0x1F83D9ABFB41BD6B, 0x5BE0CD19137E2179
+        };
+
+        static constexpr WordType RoundConstants[80] = {
+            0x428A2F98D728AE22, 0x7137449123EF65CD, 0xB5C0FBCFEC4D3B2F, 0xE9B5DBA58189DBBC,
+            0x3956C25BF348B538, 0x59F111F1B605D019, 0x923F82A4AF194F9B, 0xAB1C5ED5DA6D8118,
+            0xD807AA98A3030242, 0x12835B0145706FBE, 0x243185BE4EE4B28C, 0x550C7DC3D5FFB4E2,
+            0x72BE5D74F27B896F, 0x80DEB1FE3B1696B1, 0x9BDC06A725C71235, 0xC19BF174CF692694,
+            0xE49B69C19EF14AD2, 0xEFBE4786384F25E3, 0x0FC19DC68B8CD5B5, 0x240CA1CC77AC9C65,
+            0x2DE92C6F592B0275, 0x4A7484AA6EA6E483, 0x5CB0A9DCBD41FBD4, 0x76F988DA831153B5,
+            0x983E5152EE66DFAB, 0xA831C66D2DB43210, 0xB00327C898FB213F, 0xBF597FC7BEEF0EE4,
+            0xC6E00BF33DA88FC2, 0xD5A79147930AA725, 0x06CA6351E003826F, 0x142929670A0E6E70,
+            0x27B70A8546D22FFC, 0x2E1B21385C26C926, 0x4D2C6DFC5AC42AED, 0x53380D139D95B3DF,
+            0x650A73548BAF63DE, 0x766A0ABB3C77B2A8, 0x81C2C92E47EDAEE6, 0x92722C851482353B,
+            0xA2BFE8A14CF10364, 0xA81A664BBC423001, 0xC24B8B70D0F89791, 0xC76C51A30654BE30,
+            0xD192E819D6EF5218, 0xD69906245565A910, 0xF40E35855771202A, 0x106AA07032BBD1B8,
+            0x19A4C116B8D2D0C8, 0x1E376C085141AB53, 0x2748774CDF8EEB99, 0x34B0BCB5E19B48A8,
+            0x391C0CB3C5C95A63, 0x4ED8AA4AE3418ACB, 0x5B9CCA4F7763E373, 0x682E6FF3D6B2B8A3,
+            0x748F82EE5DEFB2FC, 0x78A5636F43172F60, 0x84C87814A1F0AB72, 0x8CC702081A6439EC,
+            0x90BEFFFA23631E28, 0xA4506CEBDE82BDE9, 0xBEF9A3F7B2C67915, 0xC67178F2E372532B,
+            0xCA273ECEEA26619C, 0xD186B8C721C0C207, 0xEADA7DD6CDE0EB1E, 0xF57D4F7FEE6ED178,
+            0x06F067AA72176FBA, 0x0A637DC5A2C898A6, 0x113F9804BEF90DAE, 0x1B710B35131C471B,
+            0x28DB77F523047D84, 0x32CAAB7B40C72493, 0x3C9EBE0A15C9BEBC, 0x431D67C49C100D4C,
+            0x4CC5D4BECB3E42B6, 0x597F299CFC657E2A, 0x5FCB6FAB3AD6FAEC, 0x6C44198C4A475817
+        };
+
+        static constexpr void Transform(StateType& State, const OtpTypeByte* lpBlock) noexcept {
+            WordType W[16] = {};
+            for (OtpTypeSize i = 0; i < 16; ++i) {
+                W[i] = OtpLoadBigEndian<WordType>(lpBlock + i * sizeof(WordType));
+            }
+
+            WordType A = State[0];
+            WordType B = State[1];
+            WordType C = State[2];
+            WordType D = State[3];
+            WordType E = State[4];
+            WordType F = State[5];
+            WordType G = State[6];
+            WordType H = State[7];
+
+            for (OtpTypeSize t = 0; t < 80; ++t) {
+                if (t >= 16) {
+                    WordType W15 = W[(t - 15) % 16];
+                    WordType W2 = W[(t - 2) % 16];
+                    WordType S0 = OtpRotateRight(W15, 1) ^ OtpRotateRight(W15, 8) ^ (W15 >> 7);
+                    WordType S1 = OtpRotateRight(W2, 19) ^ OtpRotateRight(W2, 61) ^ (W2 >> 6);
+                    W[t % 16] += S0 + W[(t - 7) % 16] + S1;
+                }
+
+                WordType T1 = H + (OtpRotateRight(E, 14) ^ OtpRotateRight(E, 18) ^ OtpRotateRight(E, 41)) + ((E & F) ^ (~E & G)) + RoundConstants[t] + W[t % 16];
+                WordType T2 = (OtpRotateRight(A, 28) ^ OtpRotateRight(A, 34) ^ OtpRotateRight(A, 39)) + ((A & B) ^ (A & C) ^ (B & C));
+                H = G;
+                G = F;
+                F = E;
+                E = D + T1;
+                D = C;
+                C = B;
+                B = A;
+                A = T1 + T2;
+            }
+
+            State[0] += A;
+            State[1] += B;
+            State[2] += C;
+            State[3] += D;
+            State[4] += E;
+            State[5] += F;
+            State[6] += G;
+            State[7] += H;
+        }
+
+        static constexpr void StoreDigest(const StateType& State, OtpTypeByte* lpDigest) noexcept {
+            for (OtpTypeSize i = 0; i < DigestSize / sizeof(WordType); ++i) {
+                OtpStoreBigEndian(State[i], lpDigest + i * sizeof(WordType));
+            }
+        }
+    };
+
+    //
+    // FIPS 180-4, section 6.5: SHA-512 compression with its own IV, truncated to 384 bits.
+    //
+    struct OtpHashTraitsSha384 : OtpHashTraitsSha512 {
+        static constexpr OtpTypeSize DigestSize = 48;
+
+        static constexpr StateType InitialState = {
+            0xCBBB9D5DC1059ED8, 0x629A292A367CD507, 0x9159015A3070DD17, 0x152FECD8F70E5939,
+            0x67332667FFC00B31, 0x8EB44A8768581511, 0xDB0C2E0D64F98FA7, 0x47B5481DBEFA4FA4
+        };
+
+        static constexpr void StoreDigest(const StateType& State, OtpTypeByte* lpDigest) noexcept {
+            for (OtpTypeSize i = 0; i < DigestSize / sizeof(WordType); ++i) {
+                OtpStoreBigEndian(State[i], lpDigest + i * sizeof(WordType));
+            }
+        }
+    };
+
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+#include "OtpCpuFeatures.hpp"
+
+#if WINOTP_SIMD_X86
+#include <immintrin.h>
+#elif WINOTP_SIMD_ARM64_SHA
+#include <arm_neon.h>
+#endif
+
+//
+// SHA-1/SHA-256 compression on the dedicated CPU instructions: Intel SHA extensions (SHA-NI) on x86,
+// the ARMv8 cryptography extension on ARM64. Both take the state as plain words and one 64-byte block,
+// and produce exactly what OtpHashTraitsSha1/OtpHashTraitsSha256::TransformGeneric do.
+//
+#if WINOTP_SIMD_X86 || WINOTP_SIMD_ARM64_SHA
+#define WINOTP_SHA_EXTENSIONS 1
+#else
+#define WINOTP_SHA_EXTENSIONS 0
+#endif
+
+#if WINOTP_SHA_EXTENSIONS
+
+namespace WinOTP::Internal {
+
+    //
+    // x86 needs a CPUID check; on ARM64 the code is only compiled in when the target guarantees the instructions.
+    //
+    [[nodiscard]]
+    inline bool OtpShaExtensionsAvailable() noexcept {
+#if WINOTP_SIMD_X86
+        static const bool Available = [] {
+            const OtpCpuFeatures& Features = OtpCpuFeaturesGet();
+            return Features.Sha && Features.Ssse3 && Features.Sse41;
+        }();
+        return Available;
+#else
+        return true;
+#endif
+    }
+
+#if WINOTP_SIMD_X86
+
+    //
+    // extends the message schedule by words [4g, 4g + 4); Message holds the previous sixteen words.
+    //
+    WINOTP_TARGET("sha,sse4.1")
+    inline void OtpSha1ScheduleShaExtensions(__m128i (&Message)[4], OtpTypeSize g) noexcept {
+        Message[g % 4] = _mm_sha1msg2_epu32(
+            _mm_xor_si128(_mm_sha1msg1_epu32(Message[g % 4], Message[(g + 1) % 4]), Message[(g + 2) % 4]),
+            Message[(g + 3) % 4]
+        );
+    }
+
+    WINOTP_TARGET("sha,sse4.1")
+    inline void OtpSha1TransformShaExtensions(OtpTypeUInt32* lpState, const OtpTypeByte* lpBlock) noexcept {
+        const __m128i ByteSwapMask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090A0B0C0D0E0FULL);
+
+        // A lives in the highest lane, E in the highest lane of its own register.
+        __m128i Abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lpState)), 0x1B);
+        __m128i E = _mm_set_epi32(static_cast<int>(lpState[4]), 0, 0, 0);
+        __m128i AbcdSave = Abcd;
+        __m128i ESave = E;
+        __m128i AbcdPrevious;
+        __m128i Message[4];
+
+        //
+        // each step is four rounds. sha1nexte derives the E of the next step from the A four rounds back.
+        //
+        for (OtpTypeSize g = 0; g < 4; ++g) {
+            Message[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lpBlock + 16 * g)), ByteSwapMask);
+        }
+
+        E = _mm_add_epi32(E, Message[0]);
+        AbcdPrevious = Abcd;
+        Abcd = _mm_sha1rnds4_epu32(Abcd, E, 0);
+
+        for (OtpTypeSize g = 1; g < 5; ++g) {
+            if (g >= 4) {
+                OtpSha1ScheduleShaExtensions(Message, g);
+            }
+            E = _mm_sha1nexte_epu32(AbcdPrevious, Message[g % 4]);
+            AbcdPrevious = Abcd;
+            Abcd = _mm_sha1rnds4_epu32(Abcd, E, 0);
+        }
+
+        for (OtpTypeSize g = 5; g < 10; ++g) {
+            OtpSha1ScheduleShaExtensions(Message, g);
+            E = _mm_sha1nexte_epu32(AbcdPrevious, Message[g % 4]);
+            AbcdPrevious = Abcd;
+            Abcd = _mm_sha1rnds4_epu32(Abcd, E, 1);
+        }
+
+        for (OtpTypeSize g = 10; g < 15; ++g) {
+            OtpSha1ScheduleShaExtensions(Message, g);
+            E = _mm_sha1nexte_epu32(AbcdPrevious, Message[g % 4]);
+            AbcdPrevious = Abcd;
+            Abcd = _mm_sha1rnds4_epu32(Abcd, E, 2);
+        }
+
+        for (OtpTypeSize g = 15; g < 20; ++g) {
+            OtpSha1ScheduleShaExtensions(Message, g);
+            E = _mm_sha1nexte_epu32(AbcdPrevious, Message[g % 4]);
+            AbcdPrevious = Abcd;
+            Abcd = _mm_sha1rnds4_epu32(Abcd, E, 3);
+        }
+
+        E = _mm_sha1nexte_epu32(AbcdPrevious, ESave);
+        Abcd = _mm_add_epi32(Abcd, AbcdSave);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lpState), _mm_shuffle_epi32(Abcd, 0x1B));
+        lpState[4] = static_cast<OtpTypeUInt32>(_mm_extract_epi32(E, 3));
+    }
+
+    WINOTP_TARGET("sha,sse4.1")
+    inline void OtpSha256TransformShaExtensions(OtpTypeUInt32* lpState, const OtpTypeByte* lpBlock, const OtpTypeUInt32* lpRoundConstants) noexcept {
+        const __m128i ByteSwapMask = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+
+        // sha256rnds2 wants the state split as ABEF / CDGH.
+        __m128i Dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lpState)), 0xB1);
+        __m128i Hgfe = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lpState + 4)), 0x1B);
+        __m128i Abef = _mm_alignr_epi8(Dcba, Hgfe, 8);
+        __m128i Cdgh = _mm_blend_epi16(Hgfe, Dcba, 0xF0);
+        __m128i AbefSave = Abef;
+        __m128i CdghSave = Cdgh;
+        __m128i Message[4];
+
+        for (OtpTypeSize g = 0; g < 16; ++g) {
+            if (g < 4) {
+                Message[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lpBlock + 16 * g)), ByteSwapMask);
+            } else {
+                Message[g % 4] = _mm_sha256msg2_epu32(
+                    _mm_add_epi32(_mm_sha256msg1_epu32(Message[g % 4], Message[(g + 1) % 4]), _mm_alignr_epi8(Message[(g + 3) % 4], Message[(g + 2) % 4], 4)),
+                    Message[(g + 3) % 4]
+                );
+            }
+
+            __m128i MessageWithConstants = _mm_add_epi32(Message[g % 4], _mm_loadu_si128(reinterpret_cast<const __m128i*>(lpRoundConstants + 4 * g)));
+            Cdgh = _mm_sha256rnds2_epu32(Cdgh, Abef, MessageWithConstants);
+            Abef = _mm_sha256rnds2_epu32(Abef, Cdgh, _mm_shuffle_epi32(MessageWithConstants, 0x0E));
+        }
+
+        Abef = _mm_add_epi32(Abef, AbefSave);
+        Cdgh = _mm_add_epi32(Cdgh, CdghSave);
+
+        __m128i Feba = _mm_shuffle_epi32(Abef, 0x1B);
+        __m128i Dchg = _mm_shuffle_epi32(Cdgh, 0xB1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lpState), _mm_blend_epi16(Feba, Dchg, 0xF0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lpState + 4), _mm_alignr_epi8(Dchg, Feba, 8));
+    }
+
+#else
+
+    inline void OtpSha1TransformShaExtensions(OtpTypeUInt32* lpState, const OtpTypeByte* lpBlock) noexcept {
+        uint32x4_t Abcd = vld1q_u32(lpState);
+        uint32_t E = lpState[4];
+        uint32x4_t AbcdSave = Abcd;
+        uint32_t ESave = E;
+        uint32x4_t Message[4];
+
+        static constexpr uint32_t RoundConstants[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+
+        for (OtpTypeSize g = 0; g < 4; ++g) {
+            Message[g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(lpBlock + 16 * g)));
+        }
+
+        for (OtpTypeSize g = 0; g < 20; ++g) {
+            if (g >= 4) {
+                Message[g % 4] = vsha1su1q_u32(vsha1su0q_u32(Message[g % 4], Message[(g + 1) % 4], Message[(g + 2) % 4]), Message[(g + 3) % 4]);
+            }
+
+            uint32x4_t MessageWithConstants = vaddq_u32(Message[g % 4], vdupq_n_u32(RoundConstants[g / 5]));
+            uint32_t ENext = vsha1h_u32(vgetq_lane_u32(Abcd, 0));
+
+            if (g < 5) {
+                Abcd = vsha1cq_u32(Abcd, E, MessageWithConstants);
+            } else if (g < 10 || g >= 15) {
+                Abcd = vsha1pq_u32(Abcd, E, MessageWithConstants);
+            } else {
+                Abcd = vsha1mq_u32(Abcd, E, MessageWithConstants);
+            }
+
+            E = ENext;
+        }
+
+        vst1q_u32(lpState, vaddq_u32(Abcd, AbcdSave));
+        lpState[4] = E + ESave;
+    }
+
+    inline void OtpSha256TransformShaExtensions(OtpTypeUInt32* lpState, const OtpTypeByte* lpBlock, const OtpTypeUInt32* lpRoundConstants) noexcept {
+        uint32x4_t Abcd = vld1q_u32(lpState);
+        uint32x4_t Efgh = vld1q_u32(lpState + 4);
+        uint32x4_t AbcdSave = Abcd;
+        uint32x4_t EfghSave = Efgh;
+        uint32x4_t Message[4];
+
+        for (OtpTypeSize g = 0; g < 4; ++g) {
+            Message[g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(lpBlock + 16 * g)));
+        }
+
+        for (OtpTypeSize g = 0; g < 16; ++g) {
+            if (g >= 4) {
+                Message[g % 4] = vsha256su1q_u32(vsha256su0q_u32(Message[g % 4], Message[(g + 1) % 4]), Message[(g + 2) % 4], Message[(g + 3) % 4]);
+            }
+
+            uint32x4_t MessageWithConstants = vaddq_u32(Message[g % 4], vld1q_u32(lpRoundConstants + 4 * g));
+            uint32x4_t AbcdPrevious = Abcd;
+            Abcd = vsha256hq_u32(Abcd, Efgh, MessageWithConstants);
+            Efgh = vsha256h2q_u32(Efgh, AbcdPrevious, MessageWithConstants);
+        }
+
+        vst1q_u32(lpState, vaddq_u32(Abcd, AbcdSave));
+        vst1q_u32(lpState + 4, vaddq_u32(Efgh, EfghSave));
+    }
+
+#endif
+
+}
+
+#endif
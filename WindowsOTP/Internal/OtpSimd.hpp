@@ -0,0 +1,96 @@
+#pragma once
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+
+#if WINOTP_SIMD_X86
+#include <immintrin.h>
+
+namespace WinOTP::Internal {
+
+    //
+    // thin wrappers giving SSE2/AVX2/AVX-512 the same 32-bit lane interface, so one kernel source serves every width.
+    // Every member carries the target attribute of its instruction set; callers must carry the same one.
+    //
+
+    struct OtpSimdU32x4 {
+        using Type = __m128i;
+
+        static constexpr OtpTypeSize Lanes = 4;
+
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type Zero() noexcept { return _mm_setzero_si128(); }
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type Set1(OtpTypeUInt32 x) noexcept { return _mm_set1_epi32(static_cast<int>(x)); }
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type Load(const OtpTypeUInt32* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE void Store(OtpTypeUInt32* p, Type a) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type Add(Type a, Type b) noexcept { return _mm_add_epi32(a, b); }
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type And(Type a, Type b) noexcept { return _mm_and_si128(a, b); }
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type AndNot(Type a, Type b) noexcept { return _mm_andnot_si128(a, b); }
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type Or(Type a, Type b) noexcept { return _mm_or_si128(a, b); }
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type Xor(Type a, Type b) noexcept { return _mm_xor_si128(a, b); }
+
+        template<int __Shift>
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type ShiftRight(Type a) noexcept { return _mm_srli_epi32(a, __Shift); }
+
+        template<int __Shift>
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type RotateLeft(Type a) noexcept { return _mm_or_si128(_mm_slli_epi32(a, __Shift), _mm_srli_epi32(a, 32 - __Shift)); }
+
+        template<int __Shift>
+        WINOTP_TARGET("sse2") static WINOTP_FORCEINLINE Type RotateRight(Type a) noexcept { return _mm_or_si128(_mm_srli_epi32(a, __Shift), _mm_slli_epi32(a, 32 - __Shift)); }
+    };
+
+    struct OtpSimdU32x8 {
+        using Type = __m256i;
+
+        static constexpr OtpTypeSize Lanes = 8;
+
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type Zero() noexcept { return _mm256_setzero_si256(); }
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type Set1(OtpTypeUInt32 x) noexcept { return _mm256_set1_epi32(static_cast<int>(x)); }
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type Load(const OtpTypeUInt32* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE void Store(OtpTypeUInt32* p, Type a) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type Add(Type a, Type b) noexcept { return _mm256_add_epi32(a, b); }
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type And(Type a, Type b) noexcept { return _mm256_and_si256(a, b); }
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type AndNot(Type a, Type b) noexcept { return _mm256_andnot_si256(a, b); }
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type Or(Type a, Type b) noexcept { return _mm256_or_si256(a, b); }
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type Xor(Type a, Type b) noexcept { return _mm256_xor_si256(a, b); }
+
+        template<int __Shift>
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type ShiftRight(Type a) noexcept { return _mm256_srli_epi32(a, __Shift); }
+
+        template<int __Shift>
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type RotateLeft(Type a) noexcept { return _mm256_or_si256(_mm256_slli_epi32(a, __Shift), _mm256_srli_epi32(a, 32 - __Shift)); }
+
+        template<int __Shift>
+        WINOTP_TARGET("avx2") static WINOTP_FORCEINLINE Type RotateRight(Type a) noexcept { return _mm256_or_si256(_mm256_srli_epi32(a, __Shift), _mm256_slli_epi32(a, 32 - __Shift)); }
+    };
+
+    //
+    // the all-lanes maskz forms compile to the same instructions as the unmasked ones, but avoid GCC 12
+    // flagging the _mm512_undefined_epi32() passthrough of the unmasked intrinsics as uninitialized.
+    //
+    struct OtpSimdU32x16 {
+        using Type = __m512i;
+
+        static constexpr OtpTypeSize Lanes = 16;
+
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type Zero() noexcept { return _mm512_setzero_si512(); }
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type Set1(OtpTypeUInt32 x) noexcept { return _mm512_set1_epi32(static_cast<int>(x)); }
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type Load(const OtpTypeUInt32* p) noexcept { return _mm512_loadu_si512(p); }
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE void Store(OtpTypeUInt32* p, Type a) noexcept { _mm512_storeu_si512(p, a); }
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type Add(Type a, Type b) noexcept { return _mm512_add_epi32(a, b); }
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type And(Type a, Type b) noexcept { return _mm512_and_si512(a, b); }
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type AndNot(Type a, Type b) noexcept { return _mm512_maskz_andnot_epi32(0xFFFF, a, b); }
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type Or(Type a, Type b) noexcept { return _mm512_or_si512(a, b); }
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type Xor(Type a, Type b) noexcept { return _mm512_xor_si512(a, b); }
+
+        template<int __Shift>
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type ShiftRight(Type a) noexcept { return _mm512_maskz_srli_epi32(0xFFFF, a, __Shift); }
+
+        template<int __Shift>
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type RotateLeft(Type a) noexcept { return _mm512_maskz_rol_epi32(0xFFFF, a, __Shift); }
+
+        template<int __Shift>
+        WINOTP_TARGET("avx512f") static WINOTP_FORCEINLINE Type RotateRight(Type a) noexcept { return _mm512_maskz_ror_epi32(0xFFFF, a, __Shift); }
+    };
+
+}
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+#include "../OtpType.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // splitmix64 finalizer, for hash tables keyed by user IDs: those are often sequential, so they must be
+    // scrambled before masking.
+    //
+    [[nodiscard]]
+    constexpr OtpTypeUInt64 OtpSplitMix64(OtpTypeUInt64 Value) noexcept {
+        Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBULL;
+        return Value ^ (Value >> 31);
+    }
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <string_view>
+#include <type_traits>
+#include "../OtpType.hpp"
+#include "OtpPlatform.hpp"
+
+namespace WinOTP::Internal {
+
+    //
+    // character-level helpers for the otpauth:// URI parser and serializer. They work on any character type
+    // and only ever treat ASCII code units as meaningful.
+    //
+
+    template<typename __CharType>
+    [[nodiscard]]
+    constexpr bool OtpUriIsDigit(__CharType Char) noexcept {
+        return '0' <= Char && Char <= '9';
+    }
+
+    template<typename __CharType>
+    [[nodiscard]]
+    constexpr __CharType OtpUriToLower(__CharType Char) noexcept {
+        return 'A' <= Char && Char <= 'Z' ? static_cast<__CharType>(Char - 'A' + 'a') : Char;
+    }
+
+    //
+    // ASCII case-insensitive comparison against a lower case literal.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    constexpr bool OtpUriEqualsIgnoreCase(std::basic_string_view<__CharType> szText, std::string_view szLowerCase) noexcept {
+        if (szText.length() != szLowerCase.length()) {
+            return false;
+        }
+
+        for (OtpTypeSize i = 0; i < szText.length(); ++i) {
+            if (OtpUriToLower(szText[i]) != static_cast<__CharType>(szLowerCase[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //
+    // plain decimal digits only, no sign or whitespace; false when empty or when the value overflows.
+    //
+    template<typename __CharType, typename __IntegerType>
+    [[nodiscard]]
+    constexpr bool OtpUriParseDecimal(std::basic_string_view<__CharType> szText, __IntegerType& Value) noexcept {
+        static_assert(std::is_unsigned_v<__IntegerType>);
+
+        if (szText.empty()) {
+            return false;
+        }
+
+        __IntegerType Result = 0;
+
+        for (__CharType Char : szText) {
+            if (OtpUriIsDigit(Char) == false) {
+                return false;
+            }
+
+            auto Digit = static_cast<__IntegerType>(Char - '0');
+            if (Result > (static_cast<__IntegerType>(-1) - Digit) / 10) {
+                return false;
+            }
+
+            Result = Result * 10 + Digit;
+        }
+
+        Value = Result;
+        return true;
+    }
+
+    [[nodiscard]]
+    constexpr OtpTypeSize OtpUriDecimalLength(OtpTypeUInt64 Value) noexcept {
+        OtpTypeSize cchValue = 1;
+
+        while (Value >= 10) {
+            Value /= 10;
+            ++cchValue;
+        }
+
+        return cchValue;
+    }
+
+    //
+    // appends to a buffer already known to be large enough.
+    //
+    template<typename __CharType>
+    class OtpUriWriter {
+    private:
+
+        __CharType* m_lpszCursor;
+
+    public:
+
+        explicit OtpUriWriter(__CharType* lpszBuffer) noexcept :
+            m_lpszCursor(lpszBuffer) {}
+
+        [[nodiscard]]
+        __CharType* GetCursor() const noexcept {
+            return m_lpszCursor;
+        }
+
+        OtpUriWriter& AppendAscii(std::string_view szAscii) noexcept {
+            for (char Char : szAscii) {
+                *m_lpszCursor++ = static_cast<__CharType>(Char);
+            }
+            return *this;
+        }
+
+        OtpUriWriter& Append(std::basic_string_view<__CharType> szText) noexcept {
+            for (__CharType Char : szText) {
+                *m_lpszCursor++ = Char;
+            }
+            return *this;
+        }
+
+        OtpUriWriter& AppendDecimal(OtpTypeUInt64 Value) noexcept {
+            OtpTypeSize cchValue = OtpUriDecimalLength(Value);
+
+            for (OtpTypeSize i = cchValue; i > 0; --i) {
+                m_lpszCursor[i - 1] = static_cast<__CharType>('0' + Value % 10);
+                Value /= 10;
+            }
+
+            m_lpszCursor += cchValue;
+            return *this;
+        }
+    };
+
+}
@@ -0,0 +1,341 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include "Internal/OtpHotp.hpp"
+#include "Internal/OtpUri.hpp"
+#include "OtpByteArray.hpp"
+#include "OtpBase32.hpp"
+#include "OtpGeneratorRfc4226.hpp"
+#include "OtpGeneratorRfc6238.hpp"
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <type_traits>
+
+namespace WinOTP {
+
+    //
+    // Key URI format used by authenticator apps for provisioning:
+    //
+    //     otpauth://totp/Example:alice%40example.com?secret=JBSWY3DPEHPK3PXP&issuer=Example&algorithm=SHA256&digits=8&period=60
+    //     otpauth://hotp/Example:alice%40example.com?secret=JBSWY3DPEHPK3PXP&counter=42
+    //
+    // The parser does not copy anything: Label, Issuer and Secret point into the parsed text, so the text must
+    // outlive the result. Label and Issuer are left percent-encoded (OtpAuthUriUnescapeA decodes them), and
+    // Secret is the Base32 text with any trailing padding, plain or percent-encoded, removed. Parameters that
+    // are absent keep the defaults below, which are also the defaults of Google Authenticator.
+    //
+    template<typename __CharType>
+    struct OtpAuthUriBasic {
+        using StringViewType = std::basic_string_view<__CharType>;
+
+        OtpAuthType     Type = OtpAuthType::Totp;
+        StringViewType  Label;
+        StringViewType  Issuer;
+        StringViewType  Secret;
+        OtpHashMode     HashMode = OtpHashMode::Sha1;
+        OtpTypeUInt32   Digit = 6;
+        OtpTypeUInt32   Period = 30;
+        OtpTypeUInt64   Counter = 0;
+
+        [[nodiscard]]
+        OtpGeneratorRfc4226 CreateHotp(OtpHashBackend HashBackend = OtpHashBackend::Portable) const {
+            if (Type != OtpAuthType::Hotp) {
+                throw std::invalid_argument("otpauth URI is not of hotp type.");
+            } else {
+                OtpGeneratorRfc4226 Hotp(HashMode, Digit, HashBackend);
+                ImportSecret(Hotp);
+                return Hotp;
+            }
+        }
+
+        [[nodiscard]]
+        OtpGeneratorRfc6238 CreateTotp(OtpHashBackend HashBackend = OtpHashBackend::Portable) const {
+            if (Type != OtpAuthType::Totp) {
+                throw std::invalid_argument("otpauth URI is not of totp type.");
+            } else {
+                OtpGeneratorRfc6238 Totp(HashMode, Digit, Period, HashBackend);
+                ImportSecret(Totp);
+                return Totp;
+            }
+        }
+
+    private:
+
+        void ImportSecret(OtpGeneratorRfc4226& Generator) const {
+            if constexpr (std::is_same_v<__CharType, char>) {
+                Generator.ImportSecretBase32A(Secret);
+            } else if constexpr (std::is_same_v<__CharType, wchar_t>) {
+                Generator.ImportSecretBase32W(Secret);
+            } else {
+                OtpByteArraySecure RawSecret(OtpBase32DecodedLength(Secret.length()));
+                RawSecret.resize(OtpBase32Decode<__CharType>(Secret, RawSecret.data(), RawSecret.size()));
+                Generator.ImportSecretRaw(RawSecret.data(), RawSecret.size());
+            }
+        }
+    };
+
+    using OtpAuthUriA = OtpAuthUriBasic<char>;
+    using OtpAuthUriW = OtpAuthUriBasic<wchar_t>;
+
+    //
+    // throws std::invalid_argument when the text is not an otpauth URI, has no secret, or has a parameter
+    // value this library cannot honour. Unknown parameters (image, ...) are ignored.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    OtpAuthUriBasic<__CharType> OtpAuthUriParse(std::basic_string_view<__CharType> szUri) {
+        using StringViewType = std::basic_string_view<__CharType>;
+
+        OtpAuthUriBasic<__CharType> Uri;
+
+        if (szUri.length() < 15 || Internal::OtpUriEqualsIgnoreCase(szUri.substr(0, 10), "otpauth://") == false || szUri[14] != '/') {
+            throw std::invalid_argument("Not an otpauth URI.");
+        }
+
+        if (Internal::OtpUriEqualsIgnoreCase(szUri.substr(10, 4), "totp")) {
+            Uri.Type = OtpAuthType::Totp;
+        } else if (Internal::OtpUriEqualsIgnoreCase(szUri.substr(10, 4), "hotp")) {
+            Uri.Type = OtpAuthType::Hotp;
+        } else {
+            throw std::invalid_argument("otpauth URI type must be totp or hotp.");
+        }
+
+        szUri.remove_prefix(15);
+        szUri = szUri.substr(0, szUri.find('#'));
+
+        OtpTypeSize iQuery = szUri.find('?');
+        Uri.Label = szUri.substr(0, iQuery);
+
+        StringViewType szQuery = iQuery == StringViewType::npos ? StringViewType() : szUri.substr(iQuery + 1);
+        bool HasSecret = false;
+
+        while (szQuery.empty() == false) {
+            StringViewType szParameter = szQuery.substr(0, szQuery.find('&'));
+            szQuery.remove_prefix(szParameter.length() < szQuery.length() ? szParameter.length() + 1 : szQuery.length());
+
+            OtpTypeSize iEqual = szParameter.find('=');
+            StringViewType szKey = szParameter.substr(0, iEqual);
+            StringViewType szValue = iEqual == StringViewType::npos ? StringViewType() : szParameter.substr(iEqual + 1);
+
+            if (Internal::OtpUriEqualsIgnoreCase(szKey, "secret")) {
+                for (;;) {
+                    if (szValue.empty() == false && szValue.back() == '=') {
+                        szValue.remove_suffix(1);
+                    } else if (szValue.length() >= 3 && Internal::OtpUriEqualsIgnoreCase(szValue.substr(szValue.length() - 3), "%3d")) {
+                        szValue.remove_suffix(3);
+                    } else {
+                        break;
+                    }
+                }
+
+                Uri.Secret = szValue;
+                HasSecret = true;
+            } else if (Internal::OtpUriEqualsIgnoreCase(szKey, "issuer")) {
+                Uri.Issuer = szValue;
+            } else if (Internal::OtpUriEqualsIgnoreCase(szKey, "algorithm")) {
+                if (Internal::OtpUriEqualsIgnoreCase(szValue, "sha1")) {
+                    Uri.HashMode = OtpHashMode::Sha1;
+                } else if (Internal::OtpUriEqualsIgnoreCase(szValue, "sha256")) {
+                    Uri.HashMode = OtpHashMode::Sha256;
+                } else if (Internal::OtpUriEqualsIgnoreCase(szValue, "sha384")) {
+                    Uri.HashMode = OtpHashMode::Sha384;
+                } else if (Internal::OtpUriEqualsIgnoreCase(szValue, "sha512")) {
+                    Uri.HashMode = OtpHashMode::Sha512;
+                } else {
+                    throw std::invalid_argument("otpauth URI has an unsupported algorithm.");
+                }
+            } else if (Internal::OtpUriEqualsIgnoreCase(szKey, "digits")) {
+                if (Internal::OtpUriParseDecimal(szValue, Uri.Digit) == false || (6 <= Uri.Digit && Uri.Digit <= Internal::OtpHotpMaxDigit) == false) {
+                    throw std::invalid_argument("otpauth URI digits must be between 6 to 8.");
+                }
+            } else if (Internal::OtpUriEqualsIgnoreCase(szKey, "period")) {
+                if (Internal::OtpUriParseDecimal(szValue, Uri.Period) == false || Uri.Period == 0) {
+                    throw std::invalid_argument("otpauth URI has an invalid period.");
+                }
+            } else if (Internal::OtpUriEqualsIgnoreCase(szKey, "counter")) {
+                if (Internal::OtpUriParseDecimal(szValue, Uri.Counter) == false) {
+                    throw std::invalid_argument("otpauth URI has an invalid counter.");
+                }
+            }
+        }
+
+        if (HasSecret == false || Uri.Secret.empty()) {
+            throw std::invalid_argument("otpauth URI has no secret.");
+        }
+
+        return Uri;
+    }
+
+    [[nodiscard]]
+    inline OtpAuthUriA OtpAuthUriParseA(std::string_view szUri) {
+        return OtpAuthUriParse<char>(szUri);
+    }
+
+    [[nodiscard]]
+    inline OtpAuthUriW OtpAuthUriParseW(std::wstring_view szUri) {
+        return OtpAuthUriParse<wchar_t>(szUri);
+    }
+
+    //
+    // characters OtpAuthUriFormat writes for Uri, no terminator. Label, Issuer and Secret are written as they
+    // are, so they must already be percent-encoded (see OtpAuthUriEscapeA); the secret's padding is dropped.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    OtpTypeSize OtpAuthUriFormattedLength(const OtpAuthUriBasic<__CharType>& Uri) noexcept {
+        OtpTypeSize cchSecret = Uri.Secret.find_last_not_of(static_cast<__CharType>('=')) + 1;
+        OtpTypeSize cchUri = 0;
+
+        cchUri += sizeof("otpauth://totp/") - 1 + Uri.Label.length();
+        cchUri += sizeof("?secret=") - 1 + cchSecret;
+        cchUri += Uri.Issuer.empty() ? 0 : sizeof("&issuer=") - 1 + Uri.Issuer.length();
+        cchUri += sizeof("&algorithm=SHA1") - 1 + (Uri.HashMode == OtpHashMode::Sha1 ? 0 : 2);
+        cchUri += sizeof("&digits=") - 1 + Internal::OtpUriDecimalLength(Uri.Digit);
+
+        if (Uri.Type == OtpAuthType::Totp) {
+            cchUri += sizeof("&period=") - 1 + Internal::OtpUriDecimalLength(Uri.Period);
+        } else {
+            cchUri += sizeof("&counter=") - 1 + Internal::OtpUriDecimalLength(Uri.Counter);
+        }
+
+        return cchUri;
+    }
+
+    //
+    // writes OtpAuthUriFormattedLength(Uri) characters, no terminator, and returns that count. Every
+    // parameter is written explicitly, since not all authenticator apps apply the defaults.
+    //
+    template<typename __CharType>
+    OtpTypeSize OtpAuthUriFormat(const OtpAuthUriBasic<__CharType>& Uri, __CharType* lpszUri, size_t cchUri) {
+        static constexpr std::string_view AlgorithmNames[] = { "SHA1", "SHA256", "SHA384", "SHA512" };
+
+        OtpTypeSize cchFormatted = OtpAuthUriFormattedLength(Uri);
+
+        if (cchUri < cchFormatted) {
+            throw std::length_error("URI buffer is too small.");
+        }
+
+        Internal::OtpUriWriter<__CharType> Writer(lpszUri);
+
+        Writer.AppendAscii(Uri.Type == OtpAuthType::Totp ? "otpauth://totp/" : "otpauth://hotp/").Append(Uri.Label);
+        Writer.AppendAscii("?secret=").Append(Uri.Secret.substr(0, Uri.Secret.find_last_not_of(static_cast<__CharType>('=')) + 1));
+
+        if (Uri.Issuer.empty() == false) {
+            Writer.AppendAscii("&issuer=").Append(Uri.Issuer);
+        }
+
+        Writer.AppendAscii("&algorithm=").AppendAscii(AlgorithmNames[static_cast<OtpTypeSize>(Uri.HashMode)]);
+        Writer.AppendAscii("&digits=").AppendDecimal(Uri.Digit);
+
+        if (Uri.Type == OtpAuthType::Totp) {
+            Writer.AppendAscii("&period=").AppendDecimal(Uri.Period);
+        } else {
+            Writer.AppendAscii("&counter=").AppendDecimal(Uri.Counter);
+        }
+
+        return cchFormatted;
+    }
+
+    template<typename __CharType>
+    [[nodiscard]]
+    std::basic_string<__CharType> OtpAuthUriFormat(const OtpAuthUriBasic<__CharType>& Uri) {
+        std::basic_string<__CharType> szUri(OtpAuthUriFormattedLength(Uri), __CharType{});
+        OtpAuthUriFormat(Uri, szUri.data(), szUri.length());
+        return szUri;
+    }
+
+    [[nodiscard]]
+    inline std::string OtpAuthUriFormatA(const OtpAuthUriA& Uri) {
+        return OtpAuthUriFormat(Uri);
+    }
+
+    [[nodiscard]]
+    inline std::wstring OtpAuthUriFormatW(const OtpAuthUriW& Uri) {
+        return OtpAuthUriFormat(Uri);
+    }
+
+    inline OtpTypeSize OtpAuthUriFormatA(const OtpAuthUriA& Uri, char* lpszUri, size_t cchUri) {
+        return OtpAuthUriFormat(Uri, lpszUri, cchUri);
+    }
+
+    inline OtpTypeSize OtpAuthUriFormatW(const OtpAuthUriW& Uri, wchar_t* lpszUri, size_t cchUri) {
+        return OtpAuthUriFormat(Uri, lpszUri, cchUri);
+    }
+
+    //
+    // percent-encoding of UTF-8 labels and issuers: everything but RFC 3986 unreserved characters is escaped,
+    // ':' included, so compose a label as OtpAuthUriEscapeA(Issuer) + ":" + OtpAuthUriEscapeA(Account).
+    //
+    [[nodiscard]]
+    inline std::string OtpAuthUriEscapeA(std::string_view szText) {
+        static constexpr char HexDigits[] = "0123456789ABCDEF";
+
+        std::string szEscaped;
+        szEscaped.reserve(szText.length());
+
+        for (char Char : szText) {
+            bool Unreserved =
+                ('A' <= Char && Char <= 'Z') || ('a' <= Char && Char <= 'z') || ('0' <= Char && Char <= '9') ||
+                Char == '-' || Char == '.' || Char == '_' || Char == '~';
+
+            if (Unreserved) {
+                szEscaped.push_back(Char);
+            } else {
+                auto Byte = static_cast<unsigned char>(Char);
+                szEscaped.push_back('%');
+                szEscaped.push_back(HexDigits[Byte >> 4]);
+                szEscaped.push_back(HexDigits[Byte & 0x0F]);
+            }
+        }
+
+        return szEscaped;
+    }
+
+    [[nodiscard]]
+    inline std::string OtpAuthUriUnescapeA(std::string_view szText) {
+        auto HexValue = [](char Char) -> int {
+            if ('0' <= Char && Char <= '9') {
+                return Char - '0';
+            } else if ('a' <= Internal::OtpUriToLower(Char) && Internal::OtpUriToLower(Char) <= 'f') {
+                return Internal::OtpUriToLower(Char) - 'a' + 10;
+            } else {
+                return -1;
+            }
+        };
+
+        std::string szUnescaped;
+        szUnescaped.reserve(szText.length());
+
+        for (OtpTypeSize i = 0; i < szText.length(); ++i) {
+            if (szText[i] != '%') {
+                szUnescaped.push_back(szText[i]);
+            } else if (i + 2 < szText.length() && HexValue(szText[i + 1]) >= 0 && HexValue(szText[i + 2]) >= 0) {
+                szUnescaped.push_back(static_cast<char>(HexValue(szText[i + 1]) * 16 + HexValue(szText[i + 2])));
+                i += 2;
+            } else {
+                throw std::invalid_argument("Invalid percent-encoding detected.");
+            }
+        }
+
+        return szUnescaped;
+    }
+
+#if defined(_UNICODE) || defined(UNICODE)
+    using OtpAuthUri = OtpAuthUriW;
+
+    [[nodiscard]]
+    inline OtpAuthUriW OtpAuthUriParse(std::wstring_view szUri) {
+        return OtpAuthUriParseW(szUri);
+    }
+#else
+    using OtpAuthUri = OtpAuthUriA;
+
+    [[nodiscard]]
+    inline OtpAuthUriA OtpAuthUriParse(std::string_view szUri) {
+        return OtpAuthUriParseA(szUri);
+    }
+#endif
+
+}
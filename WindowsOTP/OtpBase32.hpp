@@ -1,215 +1,110 @@
 #pragma once
 #include "OtpType.hpp"
 #include "OtpByteArray.hpp"
-#include <stdexcept>
+#include "Internal/OtpBase32Codec.hpp"
 #include <string>
+#include <string_view>
+#include <stdexcept>
 
 namespace WinOTP {
 
+    //
+    // buffer sizes for the overloads below that write into caller storage instead of allocating.
+    //
     [[nodiscard]]
-    inline std::string OtpBase32EncodeA(const OtpByteArray& Bytes) {
-        static const std::string::value_type Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
-        static constexpr std::string::value_type PaddingChar = '=';
-
-        std::string szBase32;
-
-        if (Bytes.size()) {
-            szBase32.reserve((Bytes.size() * 8 + 4) / 5);
-
-            OtpTypeByte Idx = 0;
-            OtpTypeByte BitsLeft = 8;
-            for (size_t i = 0; i < Bytes.size();) {
-                if (BitsLeft < 5) {
-                    Idx = Bytes[i] << (5 - BitsLeft);
-
-                    ++i;
-                    if (i != Bytes.size()) {
-                        Idx |= Bytes[i] >> (3 + BitsLeft);
-                    }
-
-                    Idx &= 0x1F;
-                    BitsLeft += 3;
-                } else {
-                    Idx = Bytes[i] >> (BitsLeft - 5);
-
-                    Idx &= 0x1F;
-                    BitsLeft -= 5;
-                }
-
-                szBase32.append(1, Alphabet[Idx]);
-
-                if (BitsLeft == 0) {
-                    BitsLeft = 8;
-                    ++i;
-                }
-            }
-
-            if (szBase32.length() % 8) {
-                size_t Padding = 8 - szBase32.length() % 8;
-                szBase32.append(Padding, PaddingChar);
-            }
-        }
+    constexpr OtpTypeSize OtpBase32EncodedLength(OtpTypeSize cbBytes) noexcept {
+        return Internal::OtpBase32EncodedLength(cbBytes);
+    }
 
+    //
+    // upper bound of the decoded size; the decode overloads return the exact one.
+    //
+    [[nodiscard]]
+    constexpr OtpTypeSize OtpBase32DecodedLength(OtpTypeSize cchBase32) noexcept {
+        return Internal::OtpBase32DecodedMaxLength(cchBase32);
+    }
+
+    //
+    // one implementation for every character type: char, wchar_t, char8_t, char16_t and char32_t. The
+    // encoders need the type spelled out, e.g. OtpBase32Encode<char16_t>(Bytes); the A/W functions below are
+    // the char and wchar_t instances.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    std::basic_string<__CharType> OtpBase32Encode(const OtpByteArray& Bytes) {
+        std::basic_string<__CharType> szBase32(OtpBase32EncodedLength(Bytes.size()), __CharType{});
+        Internal::OtpBase32Encode(Bytes.data(), Bytes.size(), szBase32.data());
         return szBase32;
     }
 
+    template<typename __CharType>
     [[nodiscard]]
-    inline std::wstring OtpBase32EncodeW(const OtpByteArray& Bytes) {
-        static const std::wstring::value_type Alphabet[] = L"ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
-        static constexpr std::wstring::value_type PaddingChar = L'=';
-
-        std::wstring szBase32;
-
-        if (Bytes.size()) {
-            szBase32.reserve((Bytes.size() * 8 + 4) / 5);
-
-            OtpTypeByte Idx = 0;
-            OtpTypeByte BitsLeft = 8;
-            for (size_t i = 0; i < Bytes.size();) {
-                if (BitsLeft < 5) {
-                    Idx = Bytes[i] << (5 - BitsLeft);
-
-                    ++i;
-                    if (i != Bytes.size()) {
-                        Idx |= Bytes[i] >> (3 + BitsLeft);
-                    }
-
-                    Idx &= 0x1F;
-                    BitsLeft += 3;
-                } else {
-                    Idx = Bytes[i] >> (BitsLeft - 5);
-
-                    Idx &= 0x1F;
-                    BitsLeft -= 5;
-                }
-
-                szBase32.append(1, Alphabet[Idx]);
-
-                if (BitsLeft == 0) {
-                    BitsLeft = 8;
-                    ++i;
-                }
-            }
-
-            if (szBase32.length() % 8) {
-                size_t Padding = 8 - szBase32.length() % 8;
-                szBase32.append(Padding, PaddingChar);
-            }
+    OtpByteArray OtpBase32Decode(std::basic_string_view<__CharType> szBase32) {
+        OtpByteArray Bytes(OtpBase32DecodedLength(szBase32.length()));
+        Bytes.resize(Internal::OtpBase32Decode(szBase32.data(), szBase32.length(), Bytes.data()));
+        return Bytes;
+    }
+
+    //
+    // writes OtpBase32EncodedLength(cbBytes) characters, no terminator, and returns that count.
+    //
+    template<typename __CharType>
+    OtpTypeSize OtpBase32Encode(const void* lpBytes, size_t cbBytes, __CharType* lpszBase32, size_t cchBase32) {
+        if (cchBase32 < OtpBase32EncodedLength(cbBytes)) {
+            throw std::length_error("Base32 buffer is too small.");
+        } else {
+            Internal::OtpBase32Encode(reinterpret_cast<const OtpTypeByte*>(lpBytes), cbBytes, lpszBase32);
+            return OtpBase32EncodedLength(cbBytes);
         }
+    }
 
-        return szBase32;
+    //
+    // lpBytes must hold OtpBase32DecodedLength(szBase32.length()) bytes; returns the number written.
+    // On a decoding error the bytes already written are left in the buffer.
+    //
+    template<typename __CharType>
+    OtpTypeSize OtpBase32Decode(std::basic_string_view<__CharType> szBase32, void* lpBytes, size_t cbBytes) {
+        if (cbBytes < OtpBase32DecodedLength(szBase32.length())) {
+            throw std::length_error("Byte buffer is too small.");
+        } else {
+            return Internal::OtpBase32Decode(szBase32.data(), szBase32.length(), reinterpret_cast<OtpTypeByte*>(lpBytes));
+        }
     }
 
     [[nodiscard]]
-    inline OtpByteArray OtpBase32DecodeA(std::string_view szBase32) {
-        static constexpr std::string::value_type PaddingChar = '=';
-
-        OtpByteArray Bytes;
-
-        if (szBase32.length()) {
-            Bytes.reserve((szBase32.length() * 5 + 7) / 8);
-
-            OtpTypeByte Byte = 0;
-            OtpTypeByte BitsNeed = 8;
-            for (size_t i = 0; i < szBase32.length(); ++i) {
-                OtpTypeByte Idx;
-                if ('A' <= szBase32[i] && szBase32[i] <= 'Z') {
-                    Idx = szBase32[i] - 'A';
-                } else if ('a' <= szBase32[i] && szBase32[i] <= 'z') {
-                    Idx = szBase32[i] - 'a';
-                } else if ('2' <= szBase32[i] && szBase32[i] <= '7') {
-                    Idx = szBase32[i] - '2' + 26;
-                } else if (szBase32[i] == PaddingChar) {
-                    for (size_t j = i + 1; j < szBase32.length(); ++j) {
-                        if (szBase32[j] != PaddingChar) {
-                            throw std::invalid_argument("Invalid padding schema detected.");
-                        }
-                    }
-
-                    break;
-                } else {
-                    throw std::invalid_argument("Non-Base32 character detected.");
-                }
-
-                if (BitsNeed >= 5) {
-                    Byte |= Idx;
-
-                    BitsNeed -= 5;
-                    Byte <<= BitsNeed;
-                } else {
-                    Byte |= Idx >> (5 - BitsNeed);
-                    Bytes.push_back(Byte);
-
-                    BitsNeed += 3;
-                    Byte = Idx << BitsNeed;
-                    if (BitsNeed > 5) {
-                        Byte >>= BitsNeed - 5;
-                    }
-                }
-            }
-
-            if (BitsNeed < 5) {
-                Bytes.push_back(Byte);
-            }
-        }
+    inline std::string OtpBase32EncodeA(const OtpByteArray& Bytes) {
+        return OtpBase32Encode<char>(Bytes);
+    }
 
-        return Bytes;
+    [[nodiscard]]
+    inline std::wstring OtpBase32EncodeW(const OtpByteArray& Bytes) {
+        return OtpBase32Encode<wchar_t>(Bytes);
+    }
+
+    [[nodiscard]]
+    inline OtpByteArray OtpBase32DecodeA(std::string_view szBase32) {
+        return OtpBase32Decode<char>(szBase32);
     }
 
     [[nodiscard]]
     inline OtpByteArray OtpBase32DecodeW(std::wstring_view szBase32) {
-        static constexpr std::wstring::value_type PaddingChar = L'=';
-
-        OtpByteArray Bytes;
-
-        if (szBase32.length()) {
-            Bytes.reserve((szBase32.length() * 5 + 7) / 8);
-
-            OtpTypeByte Byte = 0;
-            OtpTypeByte BitsNeed = 8;
-            for (size_t i = 0; i < szBase32.length(); ++i) {
-                OtpTypeByte Idx;
-                if (L'A' <= szBase32[i] && szBase32[i] <= L'Z') {
-                    Idx = szBase32[i] - L'A';
-                } else if (L'a' <= szBase32[i] && szBase32[i] <= L'z') {
-                    Idx = szBase32[i] - L'a';
-                } else if (L'2' <= szBase32[i] && szBase32[i] <= L'7') {
-                    Idx = szBase32[i] - L'2' + 26;
-                } else if (szBase32[i] == PaddingChar) {
-                    for (size_t j = i + 1; j < szBase32.length(); ++j) {
-                        if (szBase32[j] != PaddingChar) {
-                            throw std::invalid_argument("Invalid padding schema detected.");
-                        }
-                    }
-
-                    break;
-                } else {
-                    throw std::invalid_argument("Non-Base32 character detected.");
-                }
-
-                if (BitsNeed >= 5) {
-                    Byte |= Idx;
-
-                    BitsNeed -= 5;
-                    Byte <<= BitsNeed;
-                } else {
-                    Byte |= Idx >> (5 - BitsNeed);
-                    Bytes.push_back(Byte);
-
-                    BitsNeed += 3;
-                    Byte = Idx << BitsNeed;
-                    if (BitsNeed > 5) {
-                        Byte >>= BitsNeed - 5;
-                    }
-                }
-            }
-
-            if (BitsNeed < 5) {
-                Bytes.push_back(Byte);
-            }
-        }
+        return OtpBase32Decode<wchar_t>(szBase32);
+    }
 
-        return Bytes;
+    inline OtpTypeSize OtpBase32EncodeA(const void* lpBytes, size_t cbBytes, char* lpszBase32, size_t cchBase32) {
+        return OtpBase32Encode<char>(lpBytes, cbBytes, lpszBase32, cchBase32);
+    }
+
+    inline OtpTypeSize OtpBase32EncodeW(const void* lpBytes, size_t cbBytes, wchar_t* lpszBase32, size_t cchBase32) {
+        return OtpBase32Encode<wchar_t>(lpBytes, cbBytes, lpszBase32, cchBase32);
+    }
+
+    inline OtpTypeSize OtpBase32DecodeA(std::string_view szBase32, void* lpBytes, size_t cbBytes) {
+        return OtpBase32Decode<char>(szBase32, lpBytes, cbBytes);
+    }
+
+    inline OtpTypeSize OtpBase32DecodeW(std::wstring_view szBase32, void* lpBytes, size_t cbBytes) {
+        return OtpBase32Decode<wchar_t>(szBase32, lpBytes, cbBytes);
     }
 
 #if defined(_UNICODE) || defined(UNICODE)
@@ -222,6 +117,10 @@ namespace WinOTP {
     inline OtpByteArray OtpBase32Decode(std::wstring_view szBase32) {
         return OtpBase32DecodeW(szBase32);
     }
+
+    inline OtpTypeSize OtpBase32Decode(std::wstring_view szBase32, void* lpBytes, size_t cbBytes) {
+        return OtpBase32DecodeW(szBase32, lpBytes, cbBytes);
+    }
 #else
     [[nodiscard]]
     inline std::string OtpBase32Encode(const OtpByteArray& Bytes) {
@@ -232,6 +131,10 @@ namespace WinOTP {
     inline OtpByteArray OtpBase32Decode(std::string_view szBase32) {
         return OtpBase32DecodeA(szBase32);
     }
+
+    inline OtpTypeSize OtpBase32Decode(std::string_view szBase32, void* lpBytes, size_t cbBytes) {
+        return OtpBase32DecodeA(szBase32, lpBytes, cbBytes);
+    }
 #endif
 
 }
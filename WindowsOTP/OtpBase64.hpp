@@ -1,223 +1,188 @@
 #pragma once
 #include "OtpType.hpp"
 #include "OtpByteArray.hpp"
-#include <stdexcept>
+#include "Internal/OtpBase64Codec.hpp"
 #include <string>
+#include <string_view>
+#include <stdexcept>
 
 namespace WinOTP {
 
+    //
+    // buffer sizes for the overloads below that write into caller storage instead of allocating.
+    //
     [[nodiscard]]
-    inline std::string OtpBase64EncodeA(const OtpByteArray& Bytes) {
-        static const std::string::value_type Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-        static constexpr std::string::value_type PaddingChar = '=';
-
-        std::string szBase64;
-
-        if (Bytes.size()) {
-            szBase64.reserve((Bytes.size() * 8 + 5) / 6);
-
-            OtpTypeByte Idx = 0;
-            OtpTypeByte BitsLeft = 8;
-            for (size_t i = 0; i < Bytes.size();) {
-                if (BitsLeft < 6) {
-                    Idx = Bytes[i] << (6 - BitsLeft);
-
-                    ++i;
-                    if (i != Bytes.size()) {
-                        Idx |= Bytes[i] >> (2 + BitsLeft);
-                    }
-
-                    Idx &= 0x3F;
-                    BitsLeft += 2;
-                } else {
-                    Idx = Bytes[i] >> (BitsLeft - 6);
-
-                    Idx &= 0x3F;
-                    BitsLeft -= 6;
-                }
-
-                szBase64.append(1, Alphabet[Idx]);
-
-                if (BitsLeft == 0) {
-                    BitsLeft = 8;
-                    ++i;
-                }
-            }
-
-            if (szBase64.length() % 4) {
-                size_t Padding = 4 - szBase64.length() % 4;
-                szBase64.append(Padding, PaddingChar);
-            }
-        }
+    constexpr OtpTypeSize OtpBase64EncodedLength(OtpTypeSize cbBytes) noexcept {
+        return Internal::OtpBase64EncodedLength(cbBytes, OtpBase64Alphabet::Standard);
+    }
+
+    [[nodiscard]]
+    constexpr OtpTypeSize OtpBase64UrlEncodedLength(OtpTypeSize cbBytes) noexcept {
+        return Internal::OtpBase64EncodedLength(cbBytes, OtpBase64Alphabet::Url);
+    }
+
+    //
+    // upper bound of the decoded size for either alphabet; the decode overloads return the exact one.
+    //
+    [[nodiscard]]
+    constexpr OtpTypeSize OtpBase64DecodedLength(OtpTypeSize cchBase64) noexcept {
+        return Internal::OtpBase64DecodedMaxLength(cchBase64);
+    }
 
+    //
+    // one implementation for every character type: char, wchar_t, char8_t, char16_t and char32_t. The
+    // encoders need the type spelled out, e.g. OtpBase64Encode<char16_t>(Bytes); the A/W functions below are
+    // the char and wchar_t instances.
+    //
+    // The buffer encoders write OtpBase64EncodedLength/OtpBase64UrlEncodedLength(cbBytes) characters, no
+    // terminator, and return that count. The buffer decoders need OtpBase64DecodedLength(szBase64.length())
+    // bytes and return the number written; on a decoding error the bytes already written are left in the
+    // buffer. Lenient decoding (the default) also accepts the other alphabet and missing padding; see
+    // OtpBase64Mode.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    std::basic_string<__CharType> OtpBase64Encode(const OtpByteArray& Bytes) {
+        std::basic_string<__CharType> szBase64(OtpBase64EncodedLength(Bytes.size()), __CharType{});
+        Internal::OtpBase64Encode(Bytes.data(), Bytes.size(), szBase64.data(), OtpBase64Alphabet::Standard);
         return szBase64;
     }
 
+    template<typename __CharType>
     [[nodiscard]]
-    inline std::wstring OtpBase64EncodeW(const OtpByteArray& Bytes) {
-        static const std::wstring::value_type Alphabet[] = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-        static constexpr std::wstring::value_type PaddingChar = L'=';
-
-        std::wstring szBase64;
-
-        if (Bytes.size()) {
-            szBase64.reserve((Bytes.size() * 8 + 5) / 6);
-
-            OtpTypeByte Idx = 0;
-            OtpTypeByte BitsLeft = 8;
-            for (size_t i = 0; i < Bytes.size();) {
-                if (BitsLeft < 6) {
-                    Idx = Bytes[i] << (6 - BitsLeft);
-
-                    ++i;
-                    if (i != Bytes.size()) {
-                        Idx |= Bytes[i] >> (2 + BitsLeft);
-                    }
-
-                    Idx &= 0x3F;
-                    BitsLeft += 2;
-                } else {
-                    Idx = Bytes[i] >> (BitsLeft - 6);
-
-                    Idx &= 0x3F;
-                    BitsLeft -= 6;
-                }
-
-                szBase64.append(1, Alphabet[Idx]);
-
-                if (BitsLeft == 0) {
-                    BitsLeft = 8;
-                    ++i;
-                }
-            }
-
-            if (szBase64.length() % 4) {
-                size_t Padding = 4 - szBase64.length() % 4;
-                szBase64.append(Padding, PaddingChar);
-            }
+    OtpByteArray OtpBase64Decode(std::basic_string_view<__CharType> szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        OtpByteArray Bytes(OtpBase64DecodedLength(szBase64.length()));
+        Bytes.resize(Internal::OtpBase64Decode(szBase64.data(), szBase64.length(), Bytes.data(), OtpBase64Alphabet::Standard, Mode));
+        return Bytes;
+    }
+
+    template<typename __CharType>
+    OtpTypeSize OtpBase64Encode(const void* lpBytes, size_t cbBytes, __CharType* lpszBase64, size_t cchBase64) {
+        if (cchBase64 < OtpBase64EncodedLength(cbBytes)) {
+            throw std::length_error("Base64 buffer is too small.");
+        } else {
+            Internal::OtpBase64Encode(reinterpret_cast<const OtpTypeByte*>(lpBytes), cbBytes, lpszBase64, OtpBase64Alphabet::Standard);
+            return OtpBase64EncodedLength(cbBytes);
         }
+    }
 
+    template<typename __CharType>
+    OtpTypeSize OtpBase64Decode(std::basic_string_view<__CharType> szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        if (cbBytes < OtpBase64DecodedLength(szBase64.length())) {
+            throw std::length_error("Byte buffer is too small.");
+        } else {
+            return Internal::OtpBase64Decode(szBase64.data(), szBase64.length(), reinterpret_cast<OtpTypeByte*>(lpBytes), OtpBase64Alphabet::Standard, Mode);
+        }
+    }
+
+    //
+    // Base64url, for secrets carried in URLs and JSON: '-' and '_' instead of '+' and '/', no padding.
+    //
+    template<typename __CharType>
+    [[nodiscard]]
+    std::basic_string<__CharType> OtpBase64UrlEncode(const OtpByteArray& Bytes) {
+        std::basic_string<__CharType> szBase64(OtpBase64UrlEncodedLength(Bytes.size()), __CharType{});
+        Internal::OtpBase64Encode(Bytes.data(), Bytes.size(), szBase64.data(), OtpBase64Alphabet::Url);
         return szBase64;
     }
 
+    template<typename __CharType>
     [[nodiscard]]
-    inline OtpByteArray OtpBase64DecodeA(std::string_view szBase64) {
-        static constexpr std::string::value_type PaddingChar = '=';
-
-        OtpByteArray Bytes;
-
-        if (szBase64.length()) {
-            Bytes.reserve((szBase64.length() * 6 + 7) / 8);
-
-            OtpTypeByte Byte = 0;
-            OtpTypeByte BitsNeed = 8;
-            for (size_t i = 0; i < szBase64.length(); ++i) {
-                OtpTypeByte Idx;
-                if ('A' <= szBase64[i] && szBase64[i] <= 'Z') {
-                    Idx = szBase64[i] - 'A';
-                } else if ('a' <= szBase64[i] && szBase64[i] <= 'z') {
-                    Idx = szBase64[i] - 'a' + 26;
-                } else if ('0' <= szBase64[i] && szBase64[i] <= '9') {
-                    Idx = szBase64[i] - '0' + 26 + 26;
-                } else if (szBase64[i] == '+') {
-                    Idx = 26 + 26 + 10;
-                } else if (szBase64[i] == '/') {
-                    Idx = 26 + 26 + 10 + 1;
-                } else if (szBase64[i] == PaddingChar) {
-                    for (size_t j = i + 1; j < szBase64.length(); ++j) {
-                        if (szBase64[j] != PaddingChar) {
-                            throw std::invalid_argument("Invalid padding schema detected.");
-                        }
-                    }
-
-                    break;
-                } else {
-                    throw std::invalid_argument("Non-Base64 character detected.");
-                }
-
-                if (BitsNeed >= 6) {
-                    Byte |= Idx;
-
-                    BitsNeed -= 6;
-                    Byte <<= BitsNeed;
-                } else {
-                    Byte |= Idx >> (6 - BitsNeed);
-                    Bytes.push_back(Byte);
-
-                    BitsNeed += 2;
-                    Byte = Idx << BitsNeed;
-                    if (BitsNeed > 6) {
-                        Byte >>= BitsNeed - 6;
-                    }
-                }
-            }
-
-            if (BitsNeed < 6) {
-                Bytes.push_back(Byte);
-            }
+    OtpByteArray OtpBase64UrlDecode(std::basic_string_view<__CharType> szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        OtpByteArray Bytes(OtpBase64DecodedLength(szBase64.length()));
+        Bytes.resize(Internal::OtpBase64Decode(szBase64.data(), szBase64.length(), Bytes.data(), OtpBase64Alphabet::Url, Mode));
+        return Bytes;
+    }
+
+    template<typename __CharType>
+    OtpTypeSize OtpBase64UrlEncode(const void* lpBytes, size_t cbBytes, __CharType* lpszBase64, size_t cchBase64) {
+        if (cchBase64 < OtpBase64UrlEncodedLength(cbBytes)) {
+            throw std::length_error("Base64 buffer is too small.");
+        } else {
+            Internal::OtpBase64Encode(reinterpret_cast<const OtpTypeByte*>(lpBytes), cbBytes, lpszBase64, OtpBase64Alphabet::Url);
+            return OtpBase64UrlEncodedLength(cbBytes);
         }
+    }
 
-        return Bytes;
+    template<typename __CharType>
+    OtpTypeSize OtpBase64UrlDecode(std::basic_string_view<__CharType> szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        if (cbBytes < OtpBase64DecodedLength(szBase64.length())) {
+            throw std::length_error("Byte buffer is too small.");
+        } else {
+            return Internal::OtpBase64Decode(szBase64.data(), szBase64.length(), reinterpret_cast<OtpTypeByte*>(lpBytes), OtpBase64Alphabet::Url, Mode);
+        }
     }
 
     [[nodiscard]]
-    inline OtpByteArray OtpBase64DecodeW(std::wstring_view szBase64) {
-        static constexpr std::wstring::value_type PaddingChar = L'=';
-
-        OtpByteArray Bytes;
-
-        if (szBase64.length()) {
-            Bytes.reserve((szBase64.length() * 6 + 7) / 8);
-
-            OtpTypeByte Byte = 0;
-            OtpTypeByte BitsNeed = 8;
-            for (size_t i = 0; i < szBase64.length(); ++i) {
-                OtpTypeByte Idx;
-                if (L'A' <= szBase64[i] && szBase64[i] <= L'Z') {
-                    Idx = szBase64[i] - L'A';
-                } else if (L'a' <= szBase64[i] && szBase64[i] <= L'z') {
-                    Idx = szBase64[i] - L'a' + 26;
-                } else if (L'0' <= szBase64[i] && szBase64[i] <= L'9') {
-                    Idx = szBase64[i] - L'0' + 26 + 26;
-                } else if (szBase64[i] == L'+') {
-                    Idx = 26 + 26 + 10;
-                } else if (szBase64[i] == L'/') {
-                    Idx = 26 + 26 + 10 + 1;
-                } else if (szBase64[i] == PaddingChar) {
-                    for (size_t j = i + 1; j < szBase64.length(); ++j) {
-                        if (szBase64[j] != PaddingChar) {
-                            throw std::invalid_argument("Invalid padding schema detected.");
-                        }
-                    }
-
-                    break;
-                } else {
-                    throw std::invalid_argument("Non-Base64 character detected.");
-                }
-
-                if (BitsNeed >= 6) {
-                    Byte |= Idx;
-
-                    BitsNeed -= 6;
-                    Byte <<= BitsNeed;
-                } else {
-                    Byte |= Idx >> (6 - BitsNeed);
-                    Bytes.push_back(Byte);
-
-                    BitsNeed += 2;
-                    Byte = Idx << BitsNeed;
-                    if (BitsNeed > 6) {
-                        Byte >>= BitsNeed - 6;
-                    }
-                }
-            }
-
-            if (BitsNeed < 6) {
-                Bytes.push_back(Byte);
-            }
-        }
+    inline std::string OtpBase64EncodeA(const OtpByteArray& Bytes) {
+        return OtpBase64Encode<char>(Bytes);
+    }
 
-        return Bytes;
+    [[nodiscard]]
+    inline OtpByteArray OtpBase64DecodeA(std::string_view szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64Decode<char>(szBase64, Mode);
+    }
+
+    inline OtpTypeSize OtpBase64EncodeA(const void* lpBytes, size_t cbBytes, char* lpszBase64, size_t cchBase64) {
+        return OtpBase64Encode<char>(lpBytes, cbBytes, lpszBase64, cchBase64);
+    }
+
+    inline OtpTypeSize OtpBase64DecodeA(std::string_view szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64Decode<char>(szBase64, lpBytes, cbBytes, Mode);
+    }
+
+    [[nodiscard]]
+    inline std::wstring OtpBase64EncodeW(const OtpByteArray& Bytes) {
+        return OtpBase64Encode<wchar_t>(Bytes);
+    }
+
+    [[nodiscard]]
+    inline OtpByteArray OtpBase64DecodeW(std::wstring_view szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64Decode<wchar_t>(szBase64, Mode);
+    }
+
+    inline OtpTypeSize OtpBase64EncodeW(const void* lpBytes, size_t cbBytes, wchar_t* lpszBase64, size_t cchBase64) {
+        return OtpBase64Encode<wchar_t>(lpBytes, cbBytes, lpszBase64, cchBase64);
+    }
+
+    inline OtpTypeSize OtpBase64DecodeW(std::wstring_view szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64Decode<wchar_t>(szBase64, lpBytes, cbBytes, Mode);
+    }
+
+    [[nodiscard]]
+    inline std::string OtpBase64UrlEncodeA(const OtpByteArray& Bytes) {
+        return OtpBase64UrlEncode<char>(Bytes);
+    }
+
+    [[nodiscard]]
+    inline OtpByteArray OtpBase64UrlDecodeA(std::string_view szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64UrlDecode<char>(szBase64, Mode);
+    }
+
+    inline OtpTypeSize OtpBase64UrlEncodeA(const void* lpBytes, size_t cbBytes, char* lpszBase64, size_t cchBase64) {
+        return OtpBase64UrlEncode<char>(lpBytes, cbBytes, lpszBase64, cchBase64);
+    }
+
+    inline OtpTypeSize OtpBase64UrlDecodeA(std::string_view szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64UrlDecode<char>(szBase64, lpBytes, cbBytes, Mode);
+    }
+
+    [[nodiscard]]
+    inline std::wstring OtpBase64UrlEncodeW(const OtpByteArray& Bytes) {
+        return OtpBase64UrlEncode<wchar_t>(Bytes);
+    }
+
+    [[nodiscard]]
+    inline OtpByteArray OtpBase64UrlDecodeW(std::wstring_view szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64UrlDecode<wchar_t>(szBase64, Mode);
+    }
+
+    inline OtpTypeSize OtpBase64UrlEncodeW(const void* lpBytes, size_t cbBytes, wchar_t* lpszBase64, size_t cchBase64) {
+        return OtpBase64UrlEncode<wchar_t>(lpBytes, cbBytes, lpszBase64, cchBase64);
+    }
+
+    inline OtpTypeSize OtpBase64UrlDecodeW(std::wstring_view szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64UrlDecode<wchar_t>(szBase64, lpBytes, cbBytes, Mode);
     }
 
 #if defined(_UNICODE) || defined(UNICODE)
@@ -227,8 +192,26 @@ namespace WinOTP {
     }
 
     [[nodiscard]]
-    inline OtpByteArray OtpBase64Decode(std::wstring_view szBase64) {
-        return OtpBase64DecodeW(szBase64);
+    inline OtpByteArray OtpBase64Decode(std::wstring_view szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64DecodeW(szBase64, Mode);
+    }
+
+    inline OtpTypeSize OtpBase64Decode(std::wstring_view szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64DecodeW(szBase64, lpBytes, cbBytes, Mode);
+    }
+
+    [[nodiscard]]
+    inline std::wstring OtpBase64UrlEncode(const OtpByteArray& Bytes) {
+        return OtpBase64UrlEncodeW(Bytes);
+    }
+
+    [[nodiscard]]
+    inline OtpByteArray OtpBase64UrlDecode(std::wstring_view szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64UrlDecodeW(szBase64, Mode);
+    }
+
+    inline OtpTypeSize OtpBase64UrlDecode(std::wstring_view szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64UrlDecodeW(szBase64, lpBytes, cbBytes, Mode);
     }
 #else
     [[nodiscard]]
@@ -237,9 +220,26 @@ namespace WinOTP {
     }
 
     [[nodiscard]]
-    inline OtpByteArray OtpBase64Decode(std::string_view szBase64) {
-        return OtpBase64DecodeA(szBase64);
+    inline OtpByteArray OtpBase64Decode(std::string_view szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64DecodeA(szBase64, Mode);
+    }
+
+    inline OtpTypeSize OtpBase64Decode(std::string_view szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64DecodeA(szBase64, lpBytes, cbBytes, Mode);
+    }
+
+    [[nodiscard]]
+    inline std::string OtpBase64UrlEncode(const OtpByteArray& Bytes) {
+        return OtpBase64UrlEncodeA(Bytes);
+    }
+
+    [[nodiscard]]
+    inline OtpByteArray OtpBase64UrlDecode(std::string_view szBase64, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64UrlDecodeA(szBase64, Mode);
+    }
+
+    inline OtpTypeSize OtpBase64UrlDecode(std::string_view szBase64, void* lpBytes, size_t cbBytes, OtpBase64Mode Mode = OtpBase64Mode::Lenient) {
+        return OtpBase64UrlDecodeA(szBase64, lpBytes, cbBytes, Mode);
     }
 #endif
 }
-
@@ -1,6 +1,6 @@
 #pragma once
 #include "OtpType.hpp"
-#include <windows.h>
+#include "Internal/OtpPlatform.hpp"
 #include <vector>
 
 namespace WinOTP {
@@ -37,7 +37,7 @@ namespace WinOTP {
         OtpByteArraySecure& operator=(OtpByteArraySecure&& Other) = default;
 
         ~OtpByteArraySecure() {
-            SecureZeroMemory(data(), size());
+            Internal::OtpSecureZeroMemory(data(), size());
         }
     };
 
@@ -0,0 +1,138 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <time.h>
+
+namespace WinOTP {
+
+    //
+    // Source of the current Unix time for TOTP generators that are asked for "now".
+    //
+    // A generator only keeps a pointer to its clock, so the clock must outlive it. One clock may serve any
+    // number of generators and threads: GetUnixTime is safe to call concurrently on every clock here.
+    //
+    class OtpClock {
+    public:
+
+        [[nodiscard]]
+        virtual OtpTypeUInt64 GetUnixTime() const noexcept = 0;
+
+        virtual ~OtpClock() = default;
+    };
+
+    //
+    // the wall clock, read on every call. This is what generators use when no clock is given.
+    //
+    class OtpClockSystem : public OtpClock {
+    public:
+
+        [[nodiscard]]
+        static OtpTypeUInt64 Read() noexcept {
+#if WINOTP_PLATFORM_WINDOWS
+            return _time64(nullptr);
+#else
+            return time(nullptr);
+#endif
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetUnixTime() const noexcept override {
+            return Read();
+        }
+    };
+
+    //
+    // the wall clock read once, then advanced by the monotonic clock.
+    //
+    // GetUnixTime is a single relaxed atomic load of the value computed by the last Refresh, so a server
+    // calls Refresh once per tick or per verification burst and every verification in between costs no
+    // clock read at all. The time never goes backwards, even if the wall clock is stepped; Resync picks up
+    // such a step (e.g. after NTP corrections) and needs exclusive access.
+    //
+    class OtpClockCoarse : public OtpClock {
+    private:
+
+        std::chrono::steady_clock::time_point   m_AnchorSteadyTime;
+        OtpTypeUInt64                           m_AnchorUnixTime;
+        std::atomic<OtpTypeUInt64>              m_UnixTime;
+
+    public:
+
+        OtpClockCoarse() noexcept :
+            m_AnchorSteadyTime(std::chrono::steady_clock::now()),
+            m_AnchorUnixTime(OtpClockSystem::Read()),
+            m_UnixTime(m_AnchorUnixTime) {}
+
+        OtpClockCoarse(const OtpClockCoarse& Other) = delete;
+
+        OtpClockCoarse& operator=(const OtpClockCoarse& Other) = delete;
+
+        //
+        // recomputes the cached time from the monotonic clock and returns it. May run concurrently with
+        // itself and with GetUnixTime.
+        //
+        OtpTypeUInt64 Refresh() noexcept {
+            auto Elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - m_AnchorSteadyTime);
+            OtpTypeUInt64 UnixTime = m_AnchorUnixTime + static_cast<OtpTypeUInt64>(Elapsed.count());
+            OtpTypeUInt64 CachedUnixTime = m_UnixTime.load(std::memory_order_relaxed);
+
+            // racing refreshes may finish out of order; only ever move forward.
+            while (CachedUnixTime < UnixTime && m_UnixTime.compare_exchange_weak(CachedUnixTime, UnixTime, std::memory_order_relaxed) == false) {}
+
+            return CachedUnixTime < UnixTime ? UnixTime : CachedUnixTime;
+        }
+
+        //
+        // re-anchors on the wall clock. A backward step is absorbed: the cached time holds until the wall
+        // clock catches up with it.
+        //
+        void Resync() noexcept {
+            m_AnchorSteadyTime = std::chrono::steady_clock::now();
+            m_AnchorUnixTime = OtpClockSystem::Read();
+            Refresh();
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetUnixTime() const noexcept override {
+            return m_UnixTime.load(std::memory_order_relaxed);
+        }
+    };
+
+    //
+    // a clock that only moves when told to, for tests and for replaying a timeline at full speed.
+    //
+    class OtpClockFixed : public OtpClock {
+    private:
+
+        std::atomic<OtpTypeUInt64> m_UnixTime;
+
+    public:
+
+        explicit OtpClockFixed(OtpTypeUInt64 UnixTime = 0) noexcept :
+            m_UnixTime(UnixTime) {}
+
+        OtpClockFixed(const OtpClockFixed& Other) = delete;
+
+        OtpClockFixed& operator=(const OtpClockFixed& Other) = delete;
+
+        void Set(OtpTypeUInt64 UnixTime) noexcept {
+            m_UnixTime.store(UnixTime, std::memory_order_relaxed);
+        }
+
+        //
+        // returns the new time.
+        //
+        OtpTypeUInt64 Advance(OtpTypeUInt64 Seconds) noexcept {
+            return m_UnixTime.fetch_add(Seconds, std::memory_order_relaxed) + Seconds;
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetUnixTime() const noexcept override {
+            return m_UnixTime.load(std::memory_order_relaxed);
+        }
+    };
+
+}
@@ -0,0 +1,290 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include "Internal/OtpUri.hpp"
+#include "Internal/OtpMappedFile.hpp"
+#include "OtpByteArray.hpp"
+#include "OtpBase32.hpp"
+#include "OtpAuthUri.hpp"
+#include "OtpCredentialStore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace WinOTP {
+
+    //
+    // Bulk enrolment of credentials into an OtpCredentialStore.
+    //
+    // The text holds one record per line, '\n' or "\r\n" terminated. Blank lines and lines starting with '#'
+    // are skipped. A record is a decimal user ID, a comma, and then either an otpauth:// URI or CSV fields:
+    //
+    //     1001,otpauth://totp/Example:alice?secret=JBSWY3DPEHPK3PXP&algorithm=SHA256&digits=8
+    //     1002,JBSWY3DPEHPK3PXP
+    //     1003,JBSWY3DPEHPK3PXP,SHA512,8,60
+    //     1004,JBSWY3DPEHPK3PXP,SHA1,6,0
+    //
+    // CSV fields after the Base32 secret are optional: algorithm (SHA1), digits (6) and period (30); period 0
+    // makes a HOTP-only credential, as do hotp URIs. The store keeps no counters, so a URI's counter is ignored.
+    //
+    // The text is split at line boundaries into one chunk per thread. Each thread parses its chunk, decodes the
+    // secrets and runs the HMAC key schedule into its own OtpCredentialStore::Batch; the calling thread then
+    // commits the batches in text order, so a user ID listed twice ends up with its last record. Either every
+    // record is imported or, when any line is rejected or the store cannot grow, none is.
+    //
+    struct OtpCredentialImportResult {
+        OtpTypeSize RecordCount;
+        OtpTypeSize ByteCount;
+        double      Seconds;
+
+        [[nodiscard]]
+        double GetRecordsPerSecond() const noexcept {
+            return Seconds > 0 ? RecordCount / Seconds : 0;
+        }
+    };
+
+    namespace Internal {
+
+        //
+        // chunks smaller than this are not worth a thread.
+        //
+        inline constexpr OtpTypeSize OtpCredentialImportMinChunk = 64 * 1024;
+
+        [[nodiscard]]
+        inline std::string_view OtpCredentialImportNextField(std::string_view& szFields) noexcept {
+            OtpTypeSize iComma = szFields.find(',');
+            std::string_view szField = szFields.substr(0, iComma);
+            szFields.remove_prefix(iComma == std::string_view::npos ? szFields.length() : iComma + 1);
+            return szField;
+        }
+
+        class OtpCredentialImportChunk {
+        private:
+
+            OtpCredentialStore::Batch   m_Batch;
+            OtpByteArraySecure          m_Secret;
+
+            void AddRecord(std::string_view szLine) {
+                OtpCredentialStore::UserIdType UserId;
+                OtpHashMode HashMode = OtpHashMode::Sha1;
+                OtpTypeUInt32 Digit = 6;
+                OtpTypeUInt32 Interval = 30;
+                std::string_view szSecret;
+
+                OtpTypeSize iComma = szLine.find(',');
+                if (iComma == std::string_view::npos || OtpUriParseDecimal(szLine.substr(0, iComma), UserId) == false) {
+                    throw std::invalid_argument("Record must start with a decimal user ID and a comma.");
+                }
+
+                std::string_view szFields = szLine.substr(iComma + 1);
+
+                if (szFields.length() >= 10 && OtpUriEqualsIgnoreCase(szFields.substr(0, 10), "otpauth://")) {
+                    OtpAuthUriA Uri = OtpAuthUriParseA(szFields);
+                    HashMode = Uri.HashMode;
+                    Digit = Uri.Digit;
+                    Interval = Uri.Type == OtpAuthType::Totp ? Uri.Period : 0;
+                    szSecret = Uri.Secret;
+                } else {
+                    szSecret = OtpCredentialImportNextField(szFields);
+
+                    if (szFields.empty() == false) {
+                        std::string_view szAlgorithm = OtpCredentialImportNextField(szFields);
+                        if (OtpUriEqualsIgnoreCase(szAlgorithm, "sha1")) {
+                            HashMode = OtpHashMode::Sha1;
+                        } else if (OtpUriEqualsIgnoreCase(szAlgorithm, "sha256")) {
+                            HashMode = OtpHashMode::Sha256;
+                        } else if (OtpUriEqualsIgnoreCase(szAlgorithm, "sha384")) {
+                            HashMode = OtpHashMode::Sha384;
+                        } else if (OtpUriEqualsIgnoreCase(szAlgorithm, "sha512")) {
+                            HashMode = OtpHashMode::Sha512;
+                        } else {
+                            throw std::invalid_argument("Record has an unsupported algorithm.");
+                        }
+                    }
+
+                    if (szFields.empty() == false && OtpUriParseDecimal(OtpCredentialImportNextField(szFields), Digit) == false) {
+                        throw std::invalid_argument("Record has invalid digits.");
+                    }
+
+                    if (szFields.empty() == false && OtpUriParseDecimal(OtpCredentialImportNextField(szFields), Interval) == false) {
+                        throw std::invalid_argument("Record has an invalid period.");
+                    }
+
+                    if (szFields.empty() == false) {
+                        throw std::invalid_argument("Record has too many fields.");
+                    }
+                }
+
+                //
+                // one scratch buffer per chunk; when it must grow the old one is swapped out and zeroed.
+                //
+                if (m_Secret.size() < OtpBase32DecodedLength(szSecret.length())) {
+                    OtpByteArraySecure Larger(OtpBase32DecodedLength(szSecret.length()));
+                    m_Secret.swap(Larger);
+                }
+
+                OtpTypeSize cbSecret = OtpBase32DecodeA(szSecret, m_Secret.data(), m_Secret.size());
+                m_Batch.Add(UserId, HashMode, Digit, Interval, m_Secret.data(), cbSecret);
+            }
+
+        public:
+
+            std::string_view    Text;
+            OtpTypeSize         LineCount = 0;
+
+            // the first rejected line, 1-based within Text
+            OtpTypeSize         ErrorLine = 0;
+            std::string         ErrorMessage;
+            std::exception_ptr  Error;
+
+            //
+            // never throws; failures are recorded for the importing thread to report.
+            //
+            void Run() noexcept {
+                try {
+                    std::string_view szText = Text;
+
+                    while (szText.empty() == false) {
+                        OtpTypeSize iNewLine = szText.find('\n');
+                        std::string_view szLine = szText.substr(0, iNewLine);
+                        szText.remove_prefix(iNewLine == std::string_view::npos ? szText.length() : iNewLine + 1);
+
+                        ++LineCount;
+
+                        if (szLine.empty() == false && szLine.back() == '\r') {
+                            szLine.remove_suffix(1);
+                        }
+
+                        if (szLine.empty() == false && szLine[0] != '#') {
+                            AddRecord(szLine);
+                        }
+                    }
+                } catch (const std::invalid_argument& Exception) {
+                    ErrorLine = LineCount;
+                    ErrorMessage = Exception.what();
+                } catch (...) {
+                    Error = std::current_exception();
+                }
+            }
+
+            [[nodiscard]]
+            OtpCredentialStore::Batch& GetBatch() noexcept {
+                return m_Batch;
+            }
+        };
+
+    }
+
+    //
+    // ThreadCount 0 uses every hardware thread. Throws std::invalid_argument("Line N: ...") for the first
+    // rejected line, in which case Store is left unchanged.
+    //
+    inline OtpCredentialImportResult OtpCredentialImport(OtpCredentialStore& Store, std::string_view szText, unsigned ThreadCount = 0) {
+        auto StartTime = std::chrono::steady_clock::now();
+
+        if (ThreadCount == 0) {
+            ThreadCount = std::thread::hardware_concurrency();
+        }
+
+        OtpTypeSize ChunkCount = szText.length() / Internal::OtpCredentialImportMinChunk;
+        if (ChunkCount > ThreadCount) {
+            ChunkCount = ThreadCount;
+        }
+        if (ChunkCount == 0) {
+            ChunkCount = 1;
+        }
+
+        std::vector<Internal::OtpCredentialImportChunk> Chunks(ChunkCount);
+
+        for (OtpTypeSize i = 0, iBegin = 0; i < ChunkCount; ++i) {
+            OtpTypeSize iEnd = szText.length();
+
+            if (i + 1 < ChunkCount) {
+                iEnd = szText.find('\n', (std::max)(iBegin, szText.length() / ChunkCount * (i + 1)));
+                iEnd = iEnd == std::string_view::npos ? szText.length() : iEnd + 1;
+            }
+
+            Chunks[i].Text = szText.substr(iBegin, iEnd - iBegin);
+            iBegin = iEnd;
+        }
+
+        std::vector<std::thread> Workers;
+        Workers.reserve(ChunkCount - 1);
+
+        try {
+            for (OtpTypeSize i = 1; i < ChunkCount; ++i) {
+                Workers.emplace_back(&Internal::OtpCredentialImportChunk::Run, &Chunks[i]);
+            }
+        } catch (...) {
+            for (auto& Worker : Workers) {
+                Worker.join();
+            }
+            throw;
+        }
+
+        Chunks[0].Run();
+
+        for (auto& Worker : Workers) {
+            Worker.join();
+        }
+
+        OtpTypeSize LineBase = 0;
+        OtpTypeSize RecordCount = 0;
+
+        for (auto& Chunk : Chunks) {
+            if (Chunk.Error) {
+                std::rethrow_exception(Chunk.Error);
+            }
+
+            if (Chunk.ErrorLine != 0) {
+                throw std::invalid_argument("Line " + std::to_string(LineBase + Chunk.ErrorLine) + ": " + Chunk.ErrorMessage);
+            }
+
+            LineBase += Chunk.LineCount;
+            RecordCount += Chunk.GetBatch().GetCount();
+        }
+
+        std::vector<OtpCredentialStore::Batch*> Batches;
+        for (auto& Chunk : Chunks) {
+            Batches.push_back(&Chunk.GetBatch());
+        }
+
+        Store.Insert(Batches.data(), Batches.size());
+
+        std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - StartTime;
+        return OtpCredentialImportResult{ RecordCount, szText.length(), Elapsed.count() };
+    }
+
+    //
+    // maps the file read-only instead of reading it, so the only copies of the secrets made in memory are the
+    // page cache and the transient decode buffers, which are zeroed.
+    //
+    inline OtpCredentialImportResult OtpCredentialImportFileA(OtpCredentialStore& Store, const char* lpszPath, unsigned ThreadCount = 0) {
+        Internal::OtpMappedFile File(lpszPath);
+        return OtpCredentialImport(Store, File.GetText(), ThreadCount);
+    }
+
+#if WINOTP_PLATFORM_WINDOWS
+    inline OtpCredentialImportResult OtpCredentialImportFileW(OtpCredentialStore& Store, const wchar_t* lpszPath, unsigned ThreadCount = 0) {
+        Internal::OtpMappedFile File(lpszPath);
+        return OtpCredentialImport(Store, File.GetText(), ThreadCount);
+    }
+#endif
+
+#if defined(_UNICODE) || defined(UNICODE)
+    inline OtpCredentialImportResult OtpCredentialImportFile(OtpCredentialStore& Store, const wchar_t* lpszPath, unsigned ThreadCount = 0) {
+        return OtpCredentialImportFileW(Store, lpszPath, ThreadCount);
+    }
+#else
+    inline OtpCredentialImportResult OtpCredentialImportFile(OtpCredentialStore& Store, const char* lpszPath, unsigned ThreadCount = 0) {
+        return OtpCredentialImportFileA(Store, lpszPath, ThreadCount);
+    }
+#endif
+
+}
@@ -0,0 +1,803 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include "Internal/OtpHmac.hpp"
+#include "Internal/OtpHmacCounters.hpp"
+#include "Internal/OtpHotp.hpp"
+#include "Internal/OtpSplitMix.hpp"
+#include "OtpInstrumentation.hpp"
+
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace WinOTP {
+
+    //
+    // Server-side store of many OTP credentials, keyed by a 64-bit user ID.
+    //
+    // Only the HMAC midstates derived from each secret are kept, never the secret itself. They live in one
+    // structure-of-arrays arena per hash mode, and an open-addressing index maps user IDs to arena slots.
+    // A credential therefore costs a few dozen bytes in a handful of contiguous arrays, with no per-user heap
+    // allocation or OS handle, and lookup and verification are O(1).
+    //
+    // Const member functions may run concurrently; Insert/Erase/Reserve need exclusive access.
+    //
+    class OtpCredentialStore {
+    public:
+
+        using UserIdType = OtpTypeUInt64;
+
+    private:
+
+        template<typename __HashTraits>
+        struct Arena {
+            std::vector<UserIdType>                                 UserIds;
+            std::vector<Internal::OtpHmacKeyState<__HashTraits>>    KeyStates;
+            std::vector<OtpTypeUInt8>                               Digits;
+            std::vector<OtpTypeUInt32>                              Intervals;
+
+            [[nodiscard]]
+            OtpTypeSize GetMemoryUsage() const noexcept {
+                return UserIds.capacity() * sizeof(UserIdType) +
+                    KeyStates.capacity() * sizeof(Internal::OtpHmacKeyState<__HashTraits>) +
+                    Digits.capacity() * sizeof(OtpTypeUInt8) +
+                    Intervals.capacity() * sizeof(OtpTypeUInt32);
+            }
+
+            //
+            // std::vector would leave the old copy of the key states in freed memory when it grows.
+            //
+            void ReserveSecure(OtpTypeSize Count) {
+                if (Count > KeyStates.capacity()) {
+                    std::vector<Internal::OtpHmacKeyState<__HashTraits>> NewKeyStates;
+                    NewKeyStates.reserve(Count);
+                    NewKeyStates.assign(KeyStates.begin(), KeyStates.end());
+
+                    Internal::OtpSecureZeroMemory(KeyStates.data(), KeyStates.size() * sizeof(KeyStates[0]));
+                    KeyStates.swap(NewKeyStates);
+                }
+
+                UserIds.reserve(Count);
+                Digits.reserve(Count);
+                Intervals.reserve(Count);
+            }
+
+            //
+            // credentials that fit before any of the arrays has to grow.
+            //
+            [[nodiscard]]
+            OtpTypeSize GetCapacity() const noexcept {
+                OtpTypeSize Capacity = KeyStates.capacity();
+                Capacity = UserIds.capacity() < Capacity ? UserIds.capacity() : Capacity;
+                Capacity = Digits.capacity() < Capacity ? Digits.capacity() : Capacity;
+                Capacity = Intervals.capacity() < Capacity ? Intervals.capacity() : Capacity;
+                return Capacity;
+            }
+
+            //
+            // appends a credential with a zeroed key state for the caller to fill in, and returns its index.
+            // Does not allocate, and so cannot throw, while the arena is below GetCapacity().
+            //
+            OtpTypeSize Append(UserIdType UserId, OtpTypeUInt32 Digit, OtpTypeUInt32 Interval) {
+                OtpTypeSize Index = KeyStates.size();
+
+                if (Index == GetCapacity()) {
+                    ReserveSecure(Index < 16 ? 16 : Index * 2);
+                }
+
+                KeyStates.emplace_back();
+                UserIds.push_back(UserId);
+                Digits.push_back(static_cast<OtpTypeUInt8>(Digit));
+                Intervals.push_back(Interval);
+
+                return Index;
+            }
+
+            void Clear() noexcept {
+                Internal::OtpSecureZeroMemory(KeyStates.data(), KeyStates.size() * sizeof(KeyStates[0]));
+                UserIds.clear();
+                KeyStates.clear();
+                Digits.clear();
+                Intervals.clear();
+            }
+
+            ~Arena() {
+                Internal::OtpSecureZeroMemory(KeyStates.data(), KeyStates.size() * sizeof(KeyStates[0]));
+            }
+        };
+
+        struct ArenaSet {
+            Arena<Internal::OtpHashTraitsSha1>      Sha1;
+            Arena<Internal::OtpHashTraitsSha256>    Sha256;
+            Arena<Internal::OtpHashTraitsSha384>    Sha384;
+            Arena<Internal::OtpHashTraitsSha512>    Sha512;
+
+            template<typename __HashTraits>
+            [[nodiscard]]
+            auto& Select() noexcept {
+                if constexpr (std::is_same_v<__HashTraits, Internal::OtpHashTraitsSha1>) {
+                    return Sha1;
+                } else if constexpr (std::is_same_v<__HashTraits, Internal::OtpHashTraitsSha256>) {
+                    return Sha256;
+                } else if constexpr (std::is_same_v<__HashTraits, Internal::OtpHashTraitsSha384>) {
+                    return Sha384;
+                } else {
+                    static_assert(std::is_same_v<__HashTraits, Internal::OtpHashTraitsSha512>);
+                    return Sha512;
+                }
+            }
+
+            [[nodiscard]]
+            OtpTypeSize GetMemoryUsage() const noexcept {
+                return Sha1.GetMemoryUsage() + Sha256.GetMemoryUsage() + Sha384.GetMemoryUsage() + Sha512.GetMemoryUsage();
+            }
+
+            void Clear() noexcept {
+                Sha1.Clear();
+                Sha256.Clear();
+                Sha384.Clear();
+                Sha512.Clear();
+            }
+        };
+
+        //
+        // a slot handle packs the hash mode into the top two bits and the arena index into the rest.
+        //
+        static constexpr OtpTypeUInt32 HandleEmpty = 0xFFFFFFFF;
+        static constexpr unsigned HandleModeShift = 30;
+        static constexpr OtpTypeUInt32 HandleIndexMask = (1u << HandleModeShift) - 1;
+
+        std::vector<UserIdType>     m_SlotUserIds;
+        std::vector<OtpTypeUInt32>  m_SlotHandles;
+        OtpTypeSize                 m_Count;
+        ArenaSet                    m_Arenas;
+
+        [[nodiscard]]
+        static constexpr OtpTypeUInt32 MakeHandle(OtpHashMode HashMode, OtpTypeSize Index) noexcept {
+            return (static_cast<OtpTypeUInt32>(HashMode) << HandleModeShift) | static_cast<OtpTypeUInt32>(Index);
+        }
+
+        static void ValidateCredential(OtpTypeUInt32 Digit, OtpTypeSize cbSecret) {
+            if ((6 <= Digit && Digit <= 8) == false) {
+                throw std::invalid_argument("Digit is required to be between 6 to 8.");
+            }
+
+            if (cbSecret == 0) {
+                throw std::invalid_argument("Secret cannot be empty.");
+            }
+        }
+
+        template<typename __HashTraits>
+        [[nodiscard]]
+        auto& SelectArena() noexcept {
+            return m_Arenas.Select<__HashTraits>();
+        }
+
+        template<typename __HashTraits>
+        [[nodiscard]]
+        const auto& SelectArena() const noexcept {
+            return const_cast<OtpCredentialStore*>(this)->SelectArena<__HashTraits>();
+        }
+
+        [[nodiscard]]
+        static constexpr OtpTypeUInt64 HashUserId(UserIdType UserId) noexcept {
+            return Internal::OtpSplitMix64(UserId);
+        }
+
+        [[nodiscard]]
+        OtpTypeSize GetSlotMask() const noexcept {
+            return m_SlotHandles.size() - 1;
+        }
+
+        //
+        // linear probing: the slot holding UserId, or the empty slot ending its probe sequence.
+        //
+        [[nodiscard]]
+        OtpTypeSize FindSlot(UserIdType UserId) const noexcept {
+            OtpTypeSize SlotMask = GetSlotMask();
+            OtpTypeSize Slot = static_cast<OtpTypeSize>(HashUserId(UserId)) & SlotMask;
+
+            while (m_SlotHandles[Slot] != HandleEmpty && m_SlotUserIds[Slot] != UserId) {
+                Slot = (Slot + 1) & SlotMask;
+            }
+
+            return Slot;
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt32 FindHandle(UserIdType UserId) const {
+            if (m_SlotHandles.empty() == false) {
+                OtpTypeUInt32 Handle = m_SlotHandles[FindSlot(UserId)];
+                if (Handle != HandleEmpty) {
+                    return Handle;
+                }
+            }
+
+            throw std::out_of_range("User is not found.");
+        }
+
+        void Rehash(OtpTypeSize SlotCount) {
+            std::vector<UserIdType> OldSlotUserIds(SlotCount);
+            std::vector<OtpTypeUInt32> OldSlotHandles(SlotCount, HandleEmpty);
+
+            m_SlotUserIds.swap(OldSlotUserIds);
+            m_SlotHandles.swap(OldSlotHandles);
+
+            for (OtpTypeSize i = 0; i < OldSlotHandles.size(); ++i) {
+                if (OldSlotHandles[i] != HandleEmpty) {
+                    OtpTypeSize Slot = FindSlot(OldSlotUserIds[i]);
+                    m_SlotUserIds[Slot] = OldSlotUserIds[i];
+                    m_SlotHandles[Slot] = OldSlotHandles[i];
+                }
+            }
+        }
+
+        //
+        // keeps the load factor at or below 3/4.
+        //
+        void ReserveSlots(OtpTypeSize Count) {
+            OtpTypeSize SlotCount = m_SlotHandles.empty() ? 16 : m_SlotHandles.size();
+
+            while (SlotCount - SlotCount / 4 < Count) {
+                SlotCount *= 2;
+            }
+
+            if (SlotCount != m_SlotHandles.size()) {
+                Rehash(SlotCount);
+            }
+        }
+
+        //
+        // backward-shift deletion, so no tombstones accumulate and probe sequences stay short.
+        //
+        void EraseSlot(OtpTypeSize Slot) noexcept {
+            OtpTypeSize SlotMask = GetSlotMask();
+            OtpTypeSize Hole = Slot;
+
+            for (OtpTypeSize Next = (Hole + 1) & SlotMask; m_SlotHandles[Next] != HandleEmpty; Next = (Next + 1) & SlotMask) {
+                OtpTypeSize Home = static_cast<OtpTypeSize>(HashUserId(m_SlotUserIds[Next])) & SlotMask;
+
+                // the entry may move into the hole only if its home slot is not cyclically within (Hole, Next].
+                if (((Next - Home) & SlotMask) >= ((Next - Hole) & SlotMask)) {
+                    m_SlotUserIds[Hole] = m_SlotUserIds[Next];
+                    m_SlotHandles[Hole] = m_SlotHandles[Next];
+                    Hole = Next;
+                }
+            }
+
+            m_SlotHandles[Hole] = HandleEmpty;
+        }
+
+        //
+        // appends to the arena of a batch; the key state is left for the caller.
+        //
+        template<typename __HashTraits>
+        static OtpTypeUInt32 ArenaAppend(ArenaSet& Arenas, UserIdType UserId, OtpTypeUInt32 Digit, OtpTypeUInt32 Interval) {
+            auto& ArenaRef = Arenas.Select<__HashTraits>();
+
+            if (ArenaRef.KeyStates.size() > HandleIndexMask - 1) {
+                throw std::length_error("Too many credentials of one hash mode.");
+            }
+
+            return static_cast<OtpTypeUInt32>(ArenaRef.Append(UserId, Digit, Interval));
+        }
+
+        //
+        // room for Count more credentials in the arena of __HashTraits, grown geometrically.
+        //
+        template<typename __HashTraits>
+        void ReserveArena(OtpTypeSize Count) {
+            auto& ArenaRef = SelectArena<__HashTraits>();
+            OtpTypeSize Size = ArenaRef.KeyStates.size();
+            OtpTypeSize Capacity = ArenaRef.GetCapacity();
+
+            if (Count > HandleIndexMask - Size) {
+                throw std::length_error("Too many credentials of one hash mode.");
+            }
+
+            if (Size + Count > Capacity) {
+                OtpTypeSize NewCapacity = Capacity < 8 ? 16 : Capacity * 2;
+                ArenaRef.ReserveSecure(Size + Count > NewCapacity ? Size + Count : NewCapacity);
+            }
+        }
+
+        //
+        // moves the arena's last credential into the erased index and fixes up its slot.
+        //
+        template<typename __HashTraits>
+        void ArenaErase(OtpTypeUInt32 Handle) noexcept {
+            auto& ArenaRef = SelectArena<__HashTraits>();
+            OtpTypeSize Index = Handle & HandleIndexMask;
+            OtpTypeSize Last = ArenaRef.KeyStates.size() - 1;
+
+            if (Index != Last) {
+                ArenaRef.UserIds[Index] = ArenaRef.UserIds[Last];
+                ArenaRef.KeyStates[Index] = ArenaRef.KeyStates[Last];
+                ArenaRef.Digits[Index] = ArenaRef.Digits[Last];
+                ArenaRef.Intervals[Index] = ArenaRef.Intervals[Last];
+                m_SlotHandles[FindSlot(ArenaRef.UserIds[Index])] = Handle;
+            }
+
+            Internal::OtpSecureZeroMemory(&ArenaRef.KeyStates[Last], sizeof(ArenaRef.KeyStates[Last]));
+            ArenaRef.UserIds.pop_back();
+            ArenaRef.KeyStates.pop_back();
+            ArenaRef.Digits.pop_back();
+            ArenaRef.Intervals.pop_back();
+        }
+
+        //
+        // the store side of an insertion, once ReserveSlots and ReserveArena made room for it: overwrites the
+        // credential of UserId in place when it has one of the same hash mode, and otherwise moves or adds it.
+        // Nothing here allocates, so a failed insertion never gets as far as touching the old credential.
+        // Returns the key state for the caller to fill in.
+        //
+        template<typename __HashTraits>
+        Internal::OtpHmacKeyState<__HashTraits>& Commit(UserIdType UserId, OtpHashMode HashMode, OtpTypeUInt32 Digit, OtpTypeUInt32 Interval) {
+            auto& ArenaRef = SelectArena<__HashTraits>();
+            OtpTypeSize Slot = FindSlot(UserId);
+            OtpTypeUInt32 Handle = m_SlotHandles[Slot];
+            OtpTypeSize Index;
+
+            if (Handle != HandleEmpty && static_cast<OtpHashMode>(Handle >> HandleModeShift) == HashMode) {
+                Index = Handle & HandleIndexMask;
+                ArenaRef.Digits[Index] = static_cast<OtpTypeUInt8>(Digit);
+                ArenaRef.Intervals[Index] = Interval;
+                return ArenaRef.KeyStates[Index];
+            }
+
+            if (Handle != HandleEmpty) {
+                Internal::OtpHashModeDispatch(static_cast<OtpHashMode>(Handle >> HandleModeShift), [this, Handle](auto HashTraits) {
+                    ArenaErase<decltype(HashTraits)>(Handle);
+                });
+            } else {
+                m_SlotUserIds[Slot] = UserId;
+                ++m_Count;
+            }
+
+            Index = ArenaRef.Append(UserId, Digit, Interval);
+            m_SlotHandles[Slot] = MakeHandle(HashMode, Index);
+            return ArenaRef.KeyStates[Index];
+        }
+
+        //
+        // Invokes Visitor(Arena, Index) for the credential behind Handle.
+        //
+        template<typename __VisitorType>
+        decltype(auto) VisitHandle(OtpTypeUInt32 Handle, __VisitorType&& Visitor) const {
+            auto HashMode = static_cast<OtpHashMode>(Handle >> HandleModeShift);
+            OtpTypeSize Index = Handle & HandleIndexMask;
+
+            return Internal::OtpHashModeDispatch(HashMode, [this, Index, &Visitor](auto HashTraits) {
+                return Visitor(SelectArena<decltype(HashTraits)>(), Index);
+            });
+        }
+
+        //
+        // constant-time match of Code against the codes of the credential at Index for [FirstCounter, FirstCounter + Count).
+        //
+        template<typename __ArenaType>
+        [[nodiscard]]
+        static OtpTypeSize MatchCounters(const __ArenaType& ArenaRef, OtpTypeSize Index, OtpTypeUInt32 Code, OtpTypeUInt64 FirstCounter, OtpTypeSize Count) {
+            OtpTypeUInt32 Digit = ArenaRef.Digits[Index];
+            Internal::OtpHotpWindowMatch Match(Code, Count);
+
+            Internal::OtpHmacComputeCounters(
+                ArenaRef.KeyStates[Index],
+                FirstCounter,
+                Count,
+                [Digit, &Match](OtpTypeSize i, const OtpTypeByte* lpHmacHash, OtpTypeSize cbHmacHash) {
+                    Match.Update(i, Internal::OtpHotpTruncate(lpHmacHash, cbHmacHash, Digit));
+                }
+            );
+
+            return Match.Result();
+        }
+
+        [[nodiscard]]
+        OtpTypeSize VerifyCounters(OtpTypeUInt32 Handle, OtpTypeUInt32 Code, OtpTypeUInt64 FirstCounter, OtpTypeSize Count) const {
+            return VisitHandle(Handle, [Code, FirstCounter, Count](const auto& ArenaRef, OtpTypeSize Index) {
+                return MatchCounters(ArenaRef, Index, Code, FirstCounter, Count);
+            });
+        }
+
+    public:
+
+        //
+        // credentials whose key states are prepared away from any store, typically on worker threads, and
+        // committed later with Insert(Batch&). Different batches may be filled concurrently.
+        //
+        class Batch {
+        private:
+
+            friend class OtpCredentialStore;
+
+            ArenaSet                    m_Arenas;
+            std::vector<OtpTypeUInt32>  m_Handles;  // in the order of Add
+
+        public:
+
+            Batch() = default;
+
+            Batch(const Batch& Other) = delete;
+
+            Batch& operator=(const Batch& Other) = delete;
+
+            //
+            // same arguments and checks as OtpCredentialStore::Insert; this is where the HMAC key schedule runs.
+            //
+            void Add(UserIdType UserId, OtpHashMode HashMode, OtpTypeUInt32 Digit, OtpTypeUInt32 Interval, const void* lpSecret, OtpTypeSize cbSecret) {
+                ValidateCredential(Digit, cbSecret);
+
+                OtpTypeUInt32 Index = Internal::OtpHashModeDispatch(HashMode, [&](auto HashTraits) {
+                    using HashTraitsType = decltype(HashTraits);
+
+                    OtpTypeUInt32 Index = ArenaAppend<HashTraitsType>(m_Arenas, UserId, Digit, Interval);
+                    Internal::OtpHmac<HashTraitsType>::PrepareKeyState(
+                        reinterpret_cast<const OtpTypeByte*>(lpSecret),
+                        cbSecret,
+                        m_Arenas.Select<HashTraitsType>().KeyStates[Index]
+                    );
+                    return Index;
+                });
+
+                m_Handles.push_back(MakeHandle(HashMode, Index));
+            }
+
+            [[nodiscard]]
+            OtpTypeSize GetCount() const noexcept {
+                return m_Handles.size();
+            }
+
+            void Clear() noexcept {
+                m_Arenas.Clear();
+                m_Handles.clear();
+            }
+        };
+
+        enum class VerifyStatus {
+            Accepted,
+            Rejected,
+            UnknownUser,    // no credential for the user ID
+            NotTotp         // a TOTP request for a HOTP-only credential
+        };
+
+        //
+        // one verification for VerifyBatch. Build it with Hotp or Totp, which take the arguments of
+        // VerifyHotp and VerifyTotp.
+        //
+        struct VerifyRequest {
+            UserIdType      UserId;
+            OtpTypeUInt64   CounterOrTime;  // HOTP: first counter of the window. TOTP: Unix time
+            OtpTypeUInt32   Code;
+            OtpTypeUInt32   StepsBehind;    // TOTP only
+            OtpTypeUInt32   StepsAhead;     // HOTP: look-ahead
+            bool            IsTotp;
+
+            [[nodiscard]]
+            static constexpr VerifyRequest Hotp(UserIdType UserId, OtpTypeUInt32 Code, OtpTypeUInt64 Counter, OtpTypeUInt32 LookAhead = 0) noexcept {
+                return VerifyRequest{ UserId, Counter, Code, 0, LookAhead, false };
+            }
+
+            [[nodiscard]]
+            static constexpr VerifyRequest Totp(UserIdType UserId, OtpTypeUInt32 Code, OtpTypeUInt64 UnixTimestamp, OtpTypeUInt32 StepsBehind = 1, OtpTypeUInt32 StepsAhead = 1) noexcept {
+                return VerifyRequest{ UserId, UnixTimestamp, Code, StepsBehind, StepsAhead, true };
+            }
+        };
+
+        struct VerifyResult {
+            VerifyStatus    Status;
+            OtpTypeInt64    Offset;         // when Accepted: the value VerifyHotp or VerifyTotp would return
+        };
+
+    private:
+
+        template<typename __ArenaType>
+        [[nodiscard]]
+        static VerifyResult VerifyRequestAt(const __ArenaType& ArenaRef, OtpTypeSize Index, const VerifyRequest& Request) {
+            OtpTypeUInt64 T = Request.CounterOrTime;
+            OtpTypeUInt64 Behind = 0;
+
+            if (Request.IsTotp) {
+                OtpTypeUInt32 Interval = ArenaRef.Intervals[Index];
+
+                if (Interval == 0) {
+                    return VerifyResult{ VerifyStatus::NotTotp, 0 };
+                }
+
+                T = Request.CounterOrTime / Interval;
+                Behind = Request.StepsBehind;
+            }
+
+            auto Window = Internal::OtpHotpWindow::Around(T, Behind, Request.StepsAhead);
+            auto MatchedIndex = MatchCounters(ArenaRef, Index, Request.Code, Window.FirstCounter, Window.Count);
+            std::optional<OtpTypeInt64> Offset;
+
+            if (MatchedIndex < Window.Count) {
+                Offset = static_cast<OtpTypeInt64>(Window.FirstCounter + MatchedIndex - T);
+            }
+
+            if (Request.IsTotp) {
+                Internal::OtpInstrumentationRecordDrift(Offset);
+            }
+
+            if (Offset.has_value()) {
+                return VerifyResult{ VerifyStatus::Accepted, Offset.value() };
+            } else {
+                return VerifyResult{ VerifyStatus::Rejected, 0 };
+            }
+        }
+
+    public:
+
+        OtpCredentialStore() noexcept :
+            m_Count(0) {}
+
+        //
+        // copies or moved-from buffers would leave key material behind; keep the store in one place.
+        //
+        OtpCredentialStore(const OtpCredentialStore& Other) = delete;
+
+        OtpCredentialStore& operator=(const OtpCredentialStore& Other) = delete;
+
+        //
+        // sizes the index for Count credentials and the arena of HashMode for Count more of that mode,
+        // so that loading them does not rehash or reallocate.
+        //
+        void Reserve(OtpTypeSize Count, OtpHashMode HashMode = OtpHashMode::Sha1) {
+            ReserveSlots(Count);
+            Internal::OtpHashModeDispatch(HashMode, [this, Count](auto HashTraits) {
+                auto& ArenaRef = SelectArena<decltype(HashTraits)>();
+                ArenaRef.ReserveSecure(ArenaRef.KeyStates.size() + Count);
+            });
+        }
+
+        //
+        // adds the credential of UserId, replacing any previous one.
+        // Interval is the TOTP time step in seconds; pass 0 for a HOTP-only credential.
+        // Either the credential is stored or, when this throws, the store is unchanged.
+        //
+        void Insert(UserIdType UserId, OtpHashMode HashMode, OtpTypeUInt32 Digit, OtpTypeUInt32 Interval, const void* lpSecret, OtpTypeSize cbSecret) {
+            ValidateCredential(Digit, cbSecret);
+
+            ReserveSlots(m_Count + 1);
+
+            Internal::OtpHashModeDispatch(HashMode, [&](auto HashTraits) {
+                using HashTraitsType = decltype(HashTraits);
+
+                ReserveArena<HashTraitsType>(1);
+                Internal::OtpHmac<HashTraitsType>::PrepareKeyState(
+                    reinterpret_cast<const OtpTypeByte*>(lpSecret),
+                    cbSecret,
+                    Commit<HashTraitsType>(UserId, HashMode, Digit, Interval)
+                );
+            });
+        }
+
+        //
+        // inserts the credentials of lpSources[0], lpSources[1], ... in the order they were added, exactly as
+        // a sequence of Insert calls would, but only copies the prepared key states. Room for all of them is
+        // made first, so either every credential is inserted and every batch left empty or, when this throws,
+        // the store and the batches are unchanged.
+        //
+        void Insert(Batch* const* lpSources, OtpTypeSize SourceCount) {
+            OtpTypeSize Count = 0;
+            OtpTypeSize ModeCounts[4] = {};
+
+            for (OtpTypeSize i = 0; i < SourceCount; ++i) {
+                Count += lpSources[i]->GetCount();
+                ModeCounts[0] += lpSources[i]->m_Arenas.Sha1.KeyStates.size();
+                ModeCounts[1] += lpSources[i]->m_Arenas.Sha256.KeyStates.size();
+                ModeCounts[2] += lpSources[i]->m_Arenas.Sha384.KeyStates.size();
+                ModeCounts[3] += lpSources[i]->m_Arenas.Sha512.KeyStates.size();
+            }
+
+            ReserveSlots(m_Count + Count);
+            ReserveArena<Internal::OtpHashTraitsSha1>(ModeCounts[0]);
+            ReserveArena<Internal::OtpHashTraitsSha256>(ModeCounts[1]);
+            ReserveArena<Internal::OtpHashTraitsSha384>(ModeCounts[2]);
+            ReserveArena<Internal::OtpHashTraitsSha512>(ModeCounts[3]);
+
+            for (OtpTypeSize i = 0; i < SourceCount; ++i) {
+                Batch& Source = *lpSources[i];
+
+                for (OtpTypeUInt32 SourceHandle : Source.m_Handles) {
+                    auto HashMode = static_cast<OtpHashMode>(SourceHandle >> HandleModeShift);
+                    OtpTypeSize SourceIndex = SourceHandle & HandleIndexMask;
+
+                    Internal::OtpHashModeDispatch(HashMode, [&](auto HashTraits) {
+                        using HashTraitsType = decltype(HashTraits);
+
+                        auto& SourceArena = Source.m_Arenas.Select<HashTraitsType>();
+                        Commit<HashTraitsType>(SourceArena.UserIds[SourceIndex], HashMode, SourceArena.Digits[SourceIndex], SourceArena.Intervals[SourceIndex]) =
+                            SourceArena.KeyStates[SourceIndex];
+                    });
+                }
+
+                Source.Clear();
+            }
+        }
+
+        void Insert(Batch& Source) {
+            Batch* lpSource = &Source;
+            Insert(&lpSource, 1);
+        }
+
+        //
+        // returns false if UserId has no credential.
+        //
+        bool Erase(UserIdType UserId) noexcept {
+            if (m_SlotHandles.empty()) {
+                return false;
+            }
+
+            OtpTypeSize Slot = FindSlot(UserId);
+            OtpTypeUInt32 Handle = m_SlotHandles[Slot];
+
+            if (Handle == HandleEmpty) {
+                return false;
+            }
+
+            EraseSlot(Slot);
+            Internal::OtpHashModeDispatch(static_cast<OtpHashMode>(Handle >> HandleModeShift), [this, Handle](auto HashTraits) {
+                ArenaErase<decltype(HashTraits)>(Handle);
+            });
+            --m_Count;
+
+            return true;
+        }
+
+        [[nodiscard]]
+        bool Contains(UserIdType UserId) const noexcept {
+            return m_SlotHandles.empty() == false && m_SlotHandles[FindSlot(UserId)] != HandleEmpty;
+        }
+
+        [[nodiscard]]
+        OtpTypeSize GetCount() const noexcept {
+            return m_Count;
+        }
+
+        //
+        // bytes held by the index and the arenas, including spare capacity.
+        //
+        [[nodiscard]]
+        OtpTypeSize GetMemoryUsage() const noexcept {
+            return m_SlotUserIds.capacity() * sizeof(UserIdType) +
+                m_SlotHandles.capacity() * sizeof(OtpTypeUInt32) +
+                m_Arenas.GetMemoryUsage();
+        }
+
+        //
+        // throws std::out_of_range if UserId has no credential.
+        //
+        [[nodiscard]]
+        OtpTypeUInt32 GenerateCode(UserIdType UserId, OtpTypeUInt64 Counter) const {
+            return VisitHandle(FindHandle(UserId), [Counter](const auto& ArenaRef, OtpTypeSize Index) {
+                OtpTypeUInt32 Code = 0;
+
+                Internal::OtpHmacComputeCounters(
+                    ArenaRef.KeyStates[Index],
+                    Counter,
+                    1,
+                    [&Code, Digit = ArenaRef.Digits[Index]](OtpTypeSize, const OtpTypeByte* lpHmacHash, OtpTypeSize cbHmacHash) {
+                        Code = Internal::OtpHotpTruncate(lpHmacHash, cbHmacHash, Digit);
+                    }
+                );
+
+                return Code;
+            });
+        }
+
+        //
+        // the TOTP time step of UserId in seconds, 0 for a HOTP-only credential.
+        // Throws std::out_of_range if UserId has no credential.
+        //
+        [[nodiscard]]
+        OtpTypeUInt32 GetInterval(UserIdType UserId) const {
+            return VisitHandle(FindHandle(UserId), [](const auto& ArenaRef, OtpTypeSize Index) { return ArenaRef.Intervals[Index]; });
+        }
+
+        //
+        // same contract as OtpGeneratorRfc4226::VerifyWindow. Throws std::out_of_range if UserId has no credential.
+        //
+        [[nodiscard]]
+        std::optional<OtpTypeUInt64> VerifyHotp(UserIdType UserId, OtpTypeUInt32 Code, OtpTypeUInt64 Counter, OtpTypeSize LookAhead = 0) const {
+            auto Window = Internal::OtpHotpWindow::Around(Counter, 0, LookAhead);
+            auto MatchedIndex = VerifyCounters(FindHandle(UserId), Code, Window.FirstCounter, Window.Count);
+
+            if (MatchedIndex < Window.Count) {
+                return MatchedIndex;
+            } else {
+                return std::nullopt;
+            }
+        }
+
+        //
+        // same contract as OtpGeneratorRfc6238::VerifyWindow, using the credential's own interval.
+        // Throws std::out_of_range if UserId has no credential, std::invalid_argument if it is HOTP-only.
+        //
+        [[nodiscard]]
+        std::optional<OtpTypeInt64> VerifyTotp(
+            UserIdType UserId,
+            OtpTypeUInt32 Code,
+            OtpTypeUInt64 UnixTimestamp,
+            OtpTypeUInt32 StepsBehind = 1,
+            OtpTypeUInt32 StepsAhead = 1,
+            OtpTypeUInt64 UnixTimestampStartCounting = 0) const
+        {
+            OtpTypeUInt32 Handle = FindHandle(UserId);
+            OtpTypeUInt32 Interval = VisitHandle(Handle, [](const auto& ArenaRef, OtpTypeSize Index) { return ArenaRef.Intervals[Index]; });
+
+            if (Interval == 0) {
+                throw std::invalid_argument("Credential has no TOTP interval.");
+            }
+
+            auto T = (UnixTimestamp - UnixTimestampStartCounting) / Interval;
+            auto Window = Internal::OtpHotpWindow::Around(T, StepsBehind, StepsAhead);
+            auto MatchedIndex = VerifyCounters(Handle, Code, Window.FirstCounter, Window.Count);
+            std::optional<OtpTypeInt64> Offset;
+
+            if (MatchedIndex < Window.Count) {
+                Offset = static_cast<OtpTypeInt64>(Window.FirstCounter + MatchedIndex - T);
+            }
+
+            Internal::OtpInstrumentationRecordDrift(Offset);
+            return Offset;
+        }
+
+        //
+        // answers lpRequests[i] in lpResults[i]. Requests are looked up first and then verified grouped by
+        // hash mode, so every group dispatches once and runs one HMAC implementation back to back over one
+        // arena. TOTP requests count from Unix time 0. Unknown users and mismatched requests get a status
+        // instead of an exception, so one bad request cannot fail the others.
+        //
+        void VerifyBatch(const VerifyRequest* lpRequests, OtpTypeSize Count, VerifyResult* lpResults) const {
+            constexpr OtpTypeSize GroupSize = 64;
+            constexpr OtpTypeSize ModeCount = 4;
+
+            for (OtpTypeSize Base = 0; Base < Count; Base += GroupSize) {
+                OtpTypeSize Size = Count - Base < GroupSize ? Count - Base : GroupSize;
+                OtpTypeUInt32 Handles[GroupSize];
+                OtpTypeUInt8 Order[GroupSize];
+                OtpTypeSize ModeStarts[ModeCount + 1] = {};
+
+                for (OtpTypeSize i = 0; i < Size; ++i) {
+                    Handles[i] = m_SlotHandles.empty() ? HandleEmpty : m_SlotHandles[FindSlot(lpRequests[Base + i].UserId)];
+
+                    if (Handles[i] == HandleEmpty) {
+                        lpResults[Base + i] = VerifyResult{ VerifyStatus::UnknownUser, 0 };
+                    } else {
+                        ++ModeStarts[(Handles[i] >> HandleModeShift) + 1];
+                    }
+                }
+
+                for (OtpTypeSize Mode = 0; Mode < ModeCount; ++Mode) {
+                    ModeStarts[Mode + 1] += ModeStarts[Mode];
+                }
+
+                OtpTypeSize ModeEnds[ModeCount] = { ModeStarts[0], ModeStarts[1], ModeStarts[2], ModeStarts[3] };
+                for (OtpTypeSize i = 0; i < Size; ++i) {
+                    if (Handles[i] != HandleEmpty) {
+                        Order[ModeEnds[Handles[i] >> HandleModeShift]++] = static_cast<OtpTypeUInt8>(i);
+                    }
+                }
+
+                for (OtpTypeSize Mode = 0; Mode < ModeCount; ++Mode) {
+                    if (ModeStarts[Mode] == ModeStarts[Mode + 1]) {
+                        continue;
+                    }
+
+                    Internal::OtpHashModeDispatch(static_cast<OtpHashMode>(Mode), [&](auto HashTraits) {
+                        const auto& ArenaRef = SelectArena<decltype(HashTraits)>();
+
+                        for (OtpTypeSize j = ModeStarts[Mode]; j < ModeStarts[Mode + 1]; ++j) {
+                            OtpTypeSize i = Order[j];
+                            lpResults[Base + i] = VerifyRequestAt(ArenaRef, Handles[i] & HandleIndexMask, lpRequests[Base + i]);
+                        }
+                    });
+                }
+            }
+        }
+    };
+
+}
@@ -0,0 +1,430 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include "Internal/OtpHmac.hpp"
+#include "Internal/OtpHmacCounters.hpp"
+#include "Internal/OtpHotp.hpp"
+#include "OtpByteArray.hpp"
+#include "OtpBase32.hpp"
+#include "OtpBase64.hpp"
+#include "OtpClock.hpp"
+#include "OtpInstrumentation.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+namespace WinOTP {
+
+    //
+    // OTP generator with the hash algorithm, digit count and TOTP time step fixed at compile time.
+    //
+    // The digest size, the truncation modulus and the time step are constants, so there is no dispatch left
+    // in GenerateCode: it inlines to two compressions, a multiply-and-shift for the modulus and, for TOTP, a
+    // multiply-and-shift for the division by the time step. Only the portable hash backend is available.
+    //
+    // OtpGenerator<HashMode, Digit, 0> is a HOTP generator with the interface of OtpGeneratorRfc4226, and any
+    // other Interval gives a TOTP generator with the interface of OtpGeneratorRfc6238. Those runtime classes
+    // remain the choice when the parameters are only known at runtime, e.g. from an otpauth:// URI.
+    //
+    // Thread-safety is the same as OtpGeneratorRfc4226.
+    //
+    template<OtpHashMode __HashMode = OtpHashMode::Sha1, OtpTypeUInt32 __Digit = 6, OtpTypeUInt32 __Interval = 30>
+    class OtpGenerator;
+
+    template<OtpHashMode __HashMode, OtpTypeUInt32 __Digit>
+    class OtpGenerator<__HashMode, __Digit, 0> {
+        static_assert(6 <= __Digit && __Digit <= Internal::OtpHotpMaxDigit, "Digit is required to be between 6 to 8.");
+
+    public:
+
+        using HashTraitsType = typename Internal::OtpHashTraitsOf<__HashMode>::Type;
+
+        static constexpr OtpHashMode HashMode = __HashMode;
+        static constexpr OtpTypeUInt32 Digit = __Digit;
+
+        //
+        // characters needed by the buffer overloads of GenerateCodeString, terminator included.
+        //
+        static constexpr OtpTypeSize CodeStringLength = __Digit + 1;
+
+    protected:
+
+        using HmacType = Internal::OtpHmac<HashTraitsType>;
+
+        Internal::OtpHmacKeyState<HashTraitsType>   m_KeyState;
+        bool                                        m_HasSecret;
+
+        void CheckSecret() const {
+            if (m_HasSecret == false) {
+                throw std::runtime_error("Secret is not given.");
+            }
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt32 ComputeCode(OtpTypeUInt64 Counter) const noexcept {
+            OtpTypeByte CounterBytes[sizeof(OtpTypeUInt64)];
+            OtpTypeByte HmacHash[HmacType::DigestSize];
+
+            Internal::OtpStoreBigEndian<OtpTypeUInt64>(Counter, CounterBytes);
+            HmacType::Compute(m_KeyState, CounterBytes, sizeof(CounterBytes), HmacHash);
+
+            return Internal::OtpHotpTruncate<__Digit>(HmacHash, HmacType::DigestSize);
+        }
+
+        //
+        // see OtpGeneratorRfc4226::VerifyCounters.
+        //
+        [[nodiscard]]
+        OtpTypeSize VerifyCounters(OtpTypeUInt32 Code, OtpTypeUInt64 FirstCounter, OtpTypeSize Count) const {
+            CheckSecret();
+
+            Internal::OtpHotpWindowMatch Match(Code, Count);
+
+            Internal::OtpHmacComputeCounters(
+                m_KeyState,
+                FirstCounter,
+                Count,
+                [&Match](OtpTypeSize i, const OtpTypeByte* lpHmacHash, OtpTypeSize cbHmacHash) {
+                    Match.Update(i, Internal::OtpHotpTruncate<__Digit>(lpHmacHash, cbHmacHash));
+                }
+            );
+
+            return Match.Result();
+        }
+
+        template<typename __CharType>
+        static OtpTypeSize FormatCode(OtpTypeUInt32 Code, __CharType* lpszCode, OtpTypeSize cchCode) {
+            if (cchCode < CodeStringLength) {
+                throw std::length_error("Code buffer is too small.");
+            } else {
+                Internal::OtpHotpFormat(Code, __Digit, lpszCode);
+                lpszCode[__Digit] = 0;
+                return __Digit;
+            }
+        }
+
+        template<typename __StringType>
+        static __StringType FormatCode(OtpTypeUInt32 Code) {
+            __StringType CodeString(__Digit, 0);
+            Internal::OtpHotpFormat(Code, __Digit, CodeString.data());
+            return CodeString;
+        }
+
+    public:
+
+        OtpGenerator() noexcept :
+            m_KeyState{},
+            m_HasSecret(false) {}
+
+        OtpGenerator(const OtpGenerator& Other) = default;
+
+        OtpGenerator& operator=(const OtpGenerator& Other) = default;
+
+        //
+        // only the HMAC midstates are kept, so there is no ExportSecret.
+        //
+        OtpGenerator& ImportSecretRaw(const void* lpRawSecret, size_t cbRawSecret) noexcept {
+            HmacType::PrepareKeyState(reinterpret_cast<const OtpTypeByte*>(lpRawSecret), cbRawSecret, m_KeyState);
+            m_HasSecret = cbRawSecret != 0;
+            return *this;
+        }
+
+        OtpGenerator& ImportSecretBase32A(std::string_view Base32Secret) {
+            OtpByteArraySecure RawSecret(OtpBase32DecodedLength(Base32Secret.length()));
+            RawSecret.resize(OtpBase32DecodeA(Base32Secret, RawSecret.data(), RawSecret.size()));
+            return ImportSecretRaw(RawSecret.data(), RawSecret.size());
+        }
+
+        OtpGenerator& ImportSecretBase32W(std::wstring_view Base32Secret) {
+            OtpByteArraySecure RawSecret(OtpBase32DecodedLength(Base32Secret.length()));
+            RawSecret.resize(OtpBase32DecodeW(Base32Secret, RawSecret.data(), RawSecret.size()));
+            return ImportSecretRaw(RawSecret.data(), RawSecret.size());
+        }
+
+        OtpGenerator& ImportSecretBase64A(std::string_view Base64Secret) {
+            OtpByteArraySecure RawSecret(OtpBase64DecodedLength(Base64Secret.length()));
+            RawSecret.resize(OtpBase64DecodeA(Base64Secret, RawSecret.data(), RawSecret.size()));
+            return ImportSecretRaw(RawSecret.data(), RawSecret.size());
+        }
+
+        OtpGenerator& ImportSecretBase64W(std::wstring_view Base64Secret) {
+            OtpByteArraySecure RawSecret(OtpBase64DecodedLength(Base64Secret.length()));
+            RawSecret.resize(OtpBase64DecodeW(Base64Secret, RawSecret.data(), RawSecret.size()));
+            return ImportSecretRaw(RawSecret.data(), RawSecret.size());
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt32 GenerateCode(OtpTypeUInt64 Counter) const {
+            CheckSecret();
+            return ComputeCode(Counter);
+        }
+
+        //
+        // see OtpGeneratorRfc4226::GenerateCodes.
+        //
+        void GenerateCodes(OtpTypeUInt64 FirstCounter, OtpTypeSize Count, OtpTypeUInt32* lpCodes) const {
+            CheckSecret();
+
+            Internal::OtpHmacComputeCounters(
+                m_KeyState,
+                FirstCounter,
+                Count,
+                [lpCodes](OtpTypeSize i, const OtpTypeByte* lpHmacHash, OtpTypeSize cbHmacHash) {
+                    lpCodes[i] = Internal::OtpHotpTruncate<__Digit>(lpHmacHash, cbHmacHash);
+                }
+            );
+        }
+
+        [[nodiscard]]
+        bool Verify(OtpTypeUInt32 Code, OtpTypeUInt64 Counter) const {
+            return VerifyCounters(Code, Counter, 1) == 0;
+        }
+
+        //
+        // see OtpGeneratorRfc4226::VerifyWindow.
+        //
+        [[nodiscard]]
+        std::optional<OtpTypeUInt64> VerifyWindow(OtpTypeUInt32 Code, OtpTypeUInt64 Counter, OtpTypeSize LookAhead) const {
+            auto Window = Internal::OtpHotpWindow::Around(Counter, 0, LookAhead);
+            auto MatchedIndex = VerifyCounters(Code, Window.FirstCounter, Window.Count);
+
+            if (MatchedIndex < Window.Count) {
+                return MatchedIndex;
+            } else {
+                return std::nullopt;
+            }
+        }
+
+        [[nodiscard]]
+        std::string GenerateCodeStringA(OtpTypeUInt64 Counter) const {
+            return FormatCode<std::string>(GenerateCode(Counter));
+        }
+
+        [[nodiscard]]
+        std::wstring GenerateCodeStringW(OtpTypeUInt64 Counter) const {
+            return FormatCode<std::wstring>(GenerateCode(Counter));
+        }
+
+        OtpTypeSize GenerateCodeStringA(OtpTypeUInt64 Counter, char* lpszCode, OtpTypeSize cchCode) const {
+            return FormatCode(GenerateCode(Counter), lpszCode, cchCode);
+        }
+
+        OtpTypeSize GenerateCodeStringW(OtpTypeUInt64 Counter, wchar_t* lpszCode, OtpTypeSize cchCode) const {
+            return FormatCode(GenerateCode(Counter), lpszCode, cchCode);
+        }
+
+#if defined(_UNICODE) || defined(UNICODE)
+        OtpGenerator& ImportSecretBase32(std::wstring_view Base32Secret) {
+            return ImportSecretBase32W(Base32Secret);
+        }
+
+        OtpGenerator& ImportSecretBase64(std::wstring_view Base64Secret) {
+            return ImportSecretBase64W(Base64Secret);
+        }
+
+        [[nodiscard]]
+        std::wstring GenerateCodeString(OtpTypeUInt64 Counter) const {
+            return GenerateCodeStringW(Counter);
+        }
+
+        OtpTypeSize GenerateCodeString(OtpTypeUInt64 Counter, wchar_t* lpszCode, OtpTypeSize cchCode) const {
+            return GenerateCodeStringW(Counter, lpszCode, cchCode);
+        }
+#else
+        OtpGenerator& ImportSecretBase32(std::string_view Base32Secret) {
+            return ImportSecretBase32A(Base32Secret);
+        }
+
+        OtpGenerator& ImportSecretBase64(std::string_view Base64Secret) {
+            return ImportSecretBase64A(Base64Secret);
+        }
+
+        [[nodiscard]]
+        std::string GenerateCodeString(OtpTypeUInt64 Counter) const {
+            return GenerateCodeStringA(Counter);
+        }
+
+        OtpTypeSize GenerateCodeString(OtpTypeUInt64 Counter, char* lpszCode, OtpTypeSize cchCode) const {
+            return GenerateCodeStringA(Counter, lpszCode, cchCode);
+        }
+#endif
+
+        ~OtpGenerator() {
+            Internal::OtpSecureZeroMemory(&m_KeyState, sizeof(m_KeyState));
+        }
+    };
+
+    template<OtpHashMode __HashMode, OtpTypeUInt32 __Digit, OtpTypeUInt32 __Interval>
+    class OtpGenerator : public OtpGenerator<__HashMode, __Digit, 0> {
+    protected:
+
+        using HotpType = OtpGenerator<__HashMode, __Digit, 0>;
+
+        using HotpType::ComputeCode;
+        using HotpType::VerifyCounters;
+        using HotpType::FormatCode;
+        using HotpType::GenerateCodes;
+
+        const OtpClock* m_lpClock = nullptr;
+
+        [[nodiscard]]
+        static constexpr OtpTypeUInt64 TimeStep(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting) noexcept {
+            return (UnixTimestamp - UnixTimestampStartCounting) / __Interval;
+        }
+
+    public:
+
+        static constexpr OtpTypeUInt32 Interval = __Interval;
+
+        OtpGenerator() noexcept = default;
+
+        //
+        // see OtpGeneratorRfc6238::SetClock.
+        //
+        OtpGenerator& SetClock(const OtpClock* lpClock) noexcept {
+            m_lpClock = lpClock;
+            return *this;
+        }
+
+        [[nodiscard]]
+        const OtpClock* GetClock() const noexcept {
+            return m_lpClock;
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetUnixTime() const noexcept {
+            return m_lpClock != nullptr ? m_lpClock->GetUnixTime() : OtpClockSystem::Read();
+        }
+
+        OtpGenerator& ImportSecretRaw(const void* lpRawSecret, size_t cbRawSecret) noexcept {
+            HotpType::ImportSecretRaw(lpRawSecret, cbRawSecret);
+            return *this;
+        }
+
+        OtpGenerator& ImportSecretBase32A(std::string_view Base32Secret) {
+            HotpType::ImportSecretBase32A(Base32Secret);
+            return *this;
+        }
+
+        OtpGenerator& ImportSecretBase32W(std::wstring_view Base32Secret) {
+            HotpType::ImportSecretBase32W(Base32Secret);
+            return *this;
+        }
+
+        OtpGenerator& ImportSecretBase64A(std::string_view Base64Secret) {
+            HotpType::ImportSecretBase64A(Base64Secret);
+            return *this;
+        }
+
+        OtpGenerator& ImportSecretBase64W(std::wstring_view Base64Secret) {
+            HotpType::ImportSecretBase64W(Base64Secret);
+            return *this;
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt32 GenerateCode(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return HotpType::GenerateCode(TimeStep(UnixTimestamp, UnixTimestampStartCounting));
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt32 GenerateCode() const {
+            return GenerateCode(GetUnixTime(), 0);
+        }
+
+        [[nodiscard]]
+        bool Verify(OtpTypeUInt32 Code, OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return HotpType::Verify(Code, TimeStep(UnixTimestamp, UnixTimestampStartCounting));
+        }
+
+        //
+        // see OtpGeneratorRfc6238::VerifyWindow.
+        //
+        [[nodiscard]]
+        std::optional<OtpTypeInt64> VerifyWindow(
+            OtpTypeUInt32 Code,
+            OtpTypeUInt64 UnixTimestamp,
+            OtpTypeUInt32 StepsBehind,
+            OtpTypeUInt32 StepsAhead,
+            OtpTypeUInt64 UnixTimestampStartCounting = 0) const
+        {
+            auto T = TimeStep(UnixTimestamp, UnixTimestampStartCounting);
+            auto Window = Internal::OtpHotpWindow::Around(T, StepsBehind, StepsAhead);
+            auto MatchedIndex = VerifyCounters(Code, Window.FirstCounter, Window.Count);
+            std::optional<OtpTypeInt64> Offset;
+
+            if (MatchedIndex < Window.Count) {
+                Offset = static_cast<OtpTypeInt64>(Window.FirstCounter + MatchedIndex - T);
+            }
+
+            Internal::OtpInstrumentationRecordDrift(Offset);
+            return Offset;
+        }
+
+        [[nodiscard]]
+        std::string GenerateCodeStringA(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return HotpType::template FormatCode<std::string>(GenerateCode(UnixTimestamp, UnixTimestampStartCounting));
+        }
+
+        [[nodiscard]]
+        std::wstring GenerateCodeStringW(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return HotpType::template FormatCode<std::wstring>(GenerateCode(UnixTimestamp, UnixTimestampStartCounting));
+        }
+
+        OtpTypeSize GenerateCodeStringA(OtpTypeUInt64 UnixTimestamp, char* lpszCode, OtpTypeSize cchCode, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return FormatCode(GenerateCode(UnixTimestamp, UnixTimestampStartCounting), lpszCode, cchCode);
+        }
+
+        OtpTypeSize GenerateCodeStringW(OtpTypeUInt64 UnixTimestamp, wchar_t* lpszCode, OtpTypeSize cchCode, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return FormatCode(GenerateCode(UnixTimestamp, UnixTimestampStartCounting), lpszCode, cchCode);
+        }
+
+#if defined(_UNICODE) || defined(UNICODE)
+        OtpGenerator& ImportSecretBase32(std::wstring_view Base32Secret) {
+            HotpType::ImportSecretBase32(Base32Secret);
+            return *this;
+        }
+
+        OtpGenerator& ImportSecretBase64(std::wstring_view Base64Secret) {
+            HotpType::ImportSecretBase64(Base64Secret);
+            return *this;
+        }
+
+        [[nodiscard]]
+        std::wstring GenerateCodeString(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return GenerateCodeStringW(UnixTimestamp, UnixTimestampStartCounting);
+        }
+
+        OtpTypeSize GenerateCodeString(OtpTypeUInt64 UnixTimestamp, wchar_t* lpszCode, OtpTypeSize cchCode, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return GenerateCodeStringW(UnixTimestamp, lpszCode, cchCode, UnixTimestampStartCounting);
+        }
+#else
+        OtpGenerator& ImportSecretBase32(std::string_view Base32Secret) {
+            HotpType::ImportSecretBase32(Base32Secret);
+            return *this;
+        }
+
+        OtpGenerator& ImportSecretBase64(std::string_view Base64Secret) {
+            HotpType::ImportSecretBase64(Base64Secret);
+            return *this;
+        }
+
+        [[nodiscard]]
+        std::string GenerateCodeString(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return GenerateCodeStringA(UnixTimestamp, UnixTimestampStartCounting);
+        }
+
+        OtpTypeSize GenerateCodeString(OtpTypeUInt64 UnixTimestamp, char* lpszCode, OtpTypeSize cchCode, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return GenerateCodeStringA(UnixTimestamp, lpszCode, cchCode, UnixTimestampStartCounting);
+        }
+#endif
+    };
+
+    template<OtpHashMode __HashMode = OtpHashMode::Sha1, OtpTypeUInt32 __Digit = 6>
+    using OtpGeneratorHotp = OtpGenerator<__HashMode, __Digit, 0>;
+
+    template<OtpHashMode __HashMode = OtpHashMode::Sha1, OtpTypeUInt32 __Digit = 6, OtpTypeUInt32 __Interval = 30>
+    using OtpGeneratorTotp = OtpGenerator<__HashMode, __Digit, __Interval>;
+
+}
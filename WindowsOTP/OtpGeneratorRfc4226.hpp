@@ -1,111 +1,166 @@
 #pragma once
 #include "OtpType.hpp"
-#include "Internal/OtpExceptionCategory.hpp"
-#include "Internal/OtpResource.hpp"
-#include "Internal/OtpResourceTraitsCng.hpp"
-#include "Internal/OtpCng.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include "Internal/OtpHmac.hpp"
+#include "Internal/OtpHotp.hpp"
+#include "Internal/OtpHmacBackendPortable.hpp"
+#if WINOTP_PLATFORM_WINDOWS
+#include "Internal/OtpHmacBackendCng.hpp"
+#endif
 #include "OtpByteArray.hpp"
 #include "OtpBase32.hpp"
 #include "OtpBase64.hpp"
 #include "OtpSerialization.hpp"
+#include "OtpInstrumentation.hpp"
 
-#include <windows.h>
-#include <bcrypt.h>
+#include <optional>
+#include <string>
 #include <stdexcept>
 
-#pragma comment(lib, "bcrypt")
-
 namespace WinOTP {
 
-    enum class OtpHashMode {
-        Sha1,
-        Sha256,
-        Sha384,
-        Sha512
-    };
-
+    //
+    // const member functions (GenerateCode, GenerateCodes, Verify...) keep all hashing state on the caller's
+    // stack and may be called from any number of threads at once; importing a secret needs exclusive access.
+    //
     class OtpGeneratorRfc4226 {
     protected:
 
-        const OtpHashMode   m_HashMode;
-        const OtpTypeUInt32 m_Digit;
-        OtpByteArraySecure  m_RawSecret;
-        OtpByteArraySecure  m_HashObject;
-        Internal::OtpResource<Internal::OtpResourceTraitsCngHashHandle> m_HashHandle;
+        const OtpHashMode       m_HashMode;
+        const OtpHashBackend    m_HashBackend;
+        const OtpTypeUInt32     m_Digit;
+        OtpByteArraySecure      m_RawSecret;
+        Internal::OtpHmacBackendPortable m_HmacPortable;
+#if WINOTP_PLATFORM_WINDOWS
+        Internal::OtpHmacBackendCng m_HmacCng;
+#endif
 
         [[nodiscard]]
-        static constexpr Internal::OtpCngHashEnum ConvertToCngHashEnum(OtpHashMode HashMode) {
-            switch (HashMode) {
-                case OtpHashMode::Sha1:
-                    return Internal::OtpCngHashEnum::Sha1;
-                case OtpHashMode::Sha256:
-                    return Internal::OtpCngHashEnum::Sha256;
-                case OtpHashMode::Sha384:
-                    return Internal::OtpCngHashEnum::Sha384;
-                case OtpHashMode::Sha512:
-                    return Internal::OtpCngHashEnum::Sha512;
-                default:
-                    __assume(0);
-            }
+        static OtpTypeUInt32 TruncateHmacHash(const OtpTypeByte* lpHmacHash, OtpTypeSize cbHmacHash, OtpTypeUInt32 Digit) noexcept {
+            return Internal::OtpHotpTruncate(lpHmacHash, cbHmacHash, Digit);
         }
 
-        [[nodiscard]]
-        static constexpr OtpTypeUInt32 DigitRangeSpace(OtpTypeUInt32 Digit) noexcept {
-            OtpTypeUInt32 Result = 1;
+        template<typename __CharType>
+        OtpTypeSize FormatCode(OtpTypeUInt32 Code, __CharType* lpszCode, OtpTypeSize cchCode) const {
+            Internal::OtpInstrumentationScope Scope(OtpInstrumentedOperation::FormatCode);
 
-            for (OtpTypeUInt32 i = 0; i < Digit; ++i) {
-                Result *= 10;
+            if (cchCode < m_Digit + 1) {
+                throw std::length_error("Code buffer is too small.");
+            } else {
+                Internal::OtpHotpFormat(Code, m_Digit, lpszCode);
+                lpszCode[m_Digit] = 0;
+                return m_Digit;
             }
+        }
 
-            return Result;
+        template<typename __StringType>
+        __StringType FormatCode(OtpTypeUInt32 Code) const {
+            Internal::OtpInstrumentationScope Scope(OtpInstrumentedOperation::FormatCode);
+            __StringType CodeString(m_Digit, 0);
+            Internal::OtpHotpFormat(Code, m_Digit, CodeString.data());
+            return CodeString;
         }
 
         OtpGeneratorRfc4226& ImportSecretRaw(OtpByteArraySecure& RawSecret) {
-            if (RawSecret.size() > ULONG_MAX) {
-                throw std::length_error("Secret is too long.");
+            Internal::OtpInstrumentationScope Scope(OtpInstrumentedOperation::ImportSecret);
+
+            switch (m_HashBackend) {
+                case OtpHashBackend::Portable:
+                    m_HmacPortable.ImportKey(RawSecret.data(), RawSecret.size());
+                    break;
+#if WINOTP_PLATFORM_WINDOWS
+                case OtpHashBackend::Cng:
+                    m_HmacCng.ImportKey(RawSecret.data(), RawSecret.size());
+                    break;
+#endif
+                default:
+                    WINOTP_UNREACHABLE();
+            }
+
+            m_RawSecret.swap(RawSecret);
+
+            return *this;
+        }
+
+        //
+        // calls Callback(i, Code) with the code of counter FirstCounter + i, for every i in [0, Count).
+        //
+        template<typename __CallbackType>
+        void EnumerateCodes(OtpTypeUInt64 FirstCounter, OtpTypeSize Count, __CallbackType&& Callback) const {
+            Internal::OtpInstrumentationScope Scope(OtpInstrumentedOperation::GenerateCodes);
+
+            if (m_RawSecret.size() == 0) {
+                throw std::runtime_error("Secret is not given.");
             } else {
-                using namespace Internal;
-
-                const auto& HashProvider = OtpCngCategoryHmac(ConvertToCngHashEnum(m_HashMode));
-                OtpByteArraySecure HashObject(HashProvider.GetHashObjectSize());
-                OtpResource<OtpResourceTraitsCngHashHandle> HashHandle;
-
-                auto ntStatus = BCryptCreateHash(
-                    HashProvider.GetNativeHandle(),
-                    HashHandle.GetAddressOf(),
-                    HashObject.data(),
-                    static_cast<ULONG>(HashObject.size()),
-                    RawSecret.data(),
-                    static_cast<ULONG>(RawSecret.size()),
-                    BCRYPT_HASH_REUSABLE_FLAG
-                );
-                if (!BCRYPT_SUCCESS(ntStatus)) {
-                    throw std::system_error(
-                        ntStatus,
-                        OtpExceptionWinNTCategory()
-                    );
+                switch (m_HashBackend) {
+                    case OtpHashBackend::Portable:
+                        m_HmacPortable.ComputeCounters(
+                            FirstCounter,
+                            Count,
+                            [this, &Callback](OtpTypeSize i, const OtpTypeByte* lpHmacHash, OtpTypeSize cbHmacHash) {
+                                Callback(i, TruncateHmacHash(lpHmacHash, cbHmacHash, m_Digit));
+                            }
+                        );
+                        break;
+#if WINOTP_PLATFORM_WINDOWS
+                    case OtpHashBackend::Cng: {
+                        OtpTypeByte HmacHash[Internal::OtpHmacMaxDigestSize];
+                        alignas(OtpTypeUInt64) OtpTypeByte CounterBytes[sizeof(OtpTypeUInt64)];
+
+                        for (OtpTypeSize i = 0; i < Count; ++i) {
+                            OtpSerializationIntegerToBytes<OtpSerializationEndian::Big>(FirstCounter + i, CounterBytes);
+                            auto cbHmacHash = m_HmacCng.Compute(CounterBytes, sizeof(CounterBytes), HmacHash);
+                            Callback(i, TruncateHmacHash(HmacHash, cbHmacHash, m_Digit));
+                        }
+
+                        break;
+                    }
+#endif
+                    default:
+                        WINOTP_UNREACHABLE();
                 }
+            }
+        }
 
-                m_RawSecret.swap(RawSecret);
-                m_HashObject.swap(HashObject);
-                std::swap(m_HashHandle, HashHandle);
+        //
+        // compares Code against every counter in [FirstCounter, FirstCounter + Count) and returns the index of
+        // the first match, or Count if none matched. All candidates are generated and compared without
+        // data-dependent branches, so the time taken does not reveal whether or where the code matched.
+        //
+        [[nodiscard]]
+        OtpTypeSize VerifyCounters(OtpTypeUInt32 Code, OtpTypeUInt64 FirstCounter, OtpTypeSize Count) const {
+            Internal::OtpHotpWindowMatch Match(Code, Count);
 
-                auto p = m_HashObject.data();
-                auto pp = m_HashHandle.Get();
+            EnumerateCodes(FirstCounter, Count, [&Match](OtpTypeSize i, OtpTypeUInt32 Candidate) { Match.Update(i, Candidate); });
 
-                return *this;
-            }
+            return Match.Result();
         }
 
     public:
 
-        OtpGeneratorRfc4226(OtpHashMode HashMode = OtpHashMode::Sha1, OtpTypeUInt32 Digit = 6) :
+        //
+        // characters needed by the buffer overloads of GenerateCodeString for any digit count, terminator included.
+        //
+        static constexpr OtpTypeSize MaxCodeStringLength = Internal::OtpHotpMaxDigit + 1;
+
+        OtpGeneratorRfc4226(OtpHashMode HashMode = OtpHashMode::Sha1, OtpTypeUInt32 Digit = 6, OtpHashBackend HashBackend = OtpHashBackend::Portable) :
             m_HashMode(HashMode),
-            m_Digit(Digit) 
+            m_HashBackend(HashBackend),
+            m_Digit(Digit),
+            m_HmacPortable(HashMode)
+#if WINOTP_PLATFORM_WINDOWS
+            , m_HmacCng(HashMode)
+#endif
         {
-            if ((6 <= Digit && Digit <= 8) == false) {
+            if ((6 <= Digit && Digit <= Internal::OtpHotpMaxDigit) == false) {
                 throw std::invalid_argument("Digit is required to be between 6 to 8.");
             }
+
+#if WINOTP_PLATFORM_WINDOWS == 0
+            if (HashBackend == OtpHashBackend::Cng) {
+                throw std::invalid_argument("CNG hash backend is only available on Windows.");
+            }
+#endif
         }
 
         [[nodiscard]]
@@ -113,6 +168,11 @@ namespace WinOTP {
             return m_HashMode;
         }
 
+        [[nodiscard]]
+        OtpHashBackend GetHashBackend() const noexcept {
+            return m_HashBackend;
+        }
+
         [[nodiscard]]
         OtpTypeUInt32 GetDigit() const noexcept {
             return m_Digit;
@@ -164,98 +224,127 @@ namespace WinOTP {
         }
 
         OtpGeneratorRfc4226& ImportSecretRaw(const void* lpRawSecret, size_t cbRawSecret) {
-            if (cbRawSecret > ULONG_MAX) {
-                throw std::length_error("Secret is too long.");
-            } else {
-                OtpByteArraySecure RawSecret(
-                    reinterpret_cast<const OtpTypeByte*>(lpRawSecret),
-                    reinterpret_cast<const OtpTypeByte*>(lpRawSecret) + cbRawSecret
-                );
+            OtpByteArraySecure RawSecret(
+                reinterpret_cast<const OtpTypeByte*>(lpRawSecret),
+                reinterpret_cast<const OtpTypeByte*>(lpRawSecret) + cbRawSecret
+            );
 
-                return ImportSecretRaw(RawSecret);
-            }
+            return ImportSecretRaw(RawSecret);
         }
 
         OtpGeneratorRfc4226& ImportSecretBase32A(std::string_view Base32Secret) {
-            OtpByteArraySecure RawSecret = OtpBase32DecodeA(Base32Secret);
+            OtpByteArraySecure RawSecret(OtpBase32DecodedLength(Base32Secret.length()));
+            RawSecret.resize(OtpBase32DecodeA(Base32Secret, RawSecret.data(), RawSecret.size()));
             return ImportSecretRaw(RawSecret);
         }
 
         OtpGeneratorRfc4226& ImportSecretBase32W(std::wstring_view Base32Secret) {
-            OtpByteArraySecure RawSecret = OtpBase32DecodeW(Base32Secret);
+            OtpByteArraySecure RawSecret(OtpBase32DecodedLength(Base32Secret.length()));
+            RawSecret.resize(OtpBase32DecodeW(Base32Secret, RawSecret.data(), RawSecret.size()));
             return ImportSecretRaw(RawSecret);
         }
 
+        //
+        // lenient decoding: standard or URL-safe alphabet, padding optional.
+        //
         OtpGeneratorRfc4226& ImportSecretBase64A(std::string_view Base64Secret) {
-            OtpByteArraySecure RawSecret = OtpBase64DecodeA(Base64Secret);
+            OtpByteArraySecure RawSecret(OtpBase64DecodedLength(Base64Secret.length()));
+            RawSecret.resize(OtpBase64DecodeA(Base64Secret, RawSecret.data(), RawSecret.size()));
             return ImportSecretRaw(RawSecret);
         }
 
         OtpGeneratorRfc4226& ImportSecretBase64W(std::wstring_view Base64Secret) {
-            OtpByteArraySecure RawSecret = OtpBase64DecodeW(Base64Secret);
+            OtpByteArraySecure RawSecret(OtpBase64DecodedLength(Base64Secret.length()));
+            RawSecret.resize(OtpBase64DecodeW(Base64Secret, RawSecret.data(), RawSecret.size()));
             return ImportSecretRaw(RawSecret);
         }
 
         [[nodiscard]]
         OtpTypeUInt32 GenerateCode(OtpTypeUInt64 Counter) const {
+            Internal::OtpInstrumentationScope Scope(OtpInstrumentedOperation::GenerateCode);
+
             if (m_RawSecret.size() == 0) {
                 throw std::runtime_error("Secret is not given.");
             } else {
-                using namespace Internal;
-
-                OtpByteArray HmacHash(OtpCngCategoryHmac(ConvertToCngHashEnum(m_HashMode)).GetHashSize());
-                alignas(OtpTypeUInt64) UCHAR CounterBytes[sizeof(OtpTypeUInt64)];
+                OtpTypeByte HmacHash[Internal::OtpHmacMaxDigestSize];
+                OtpTypeSize cbHmacHash;
+                alignas(OtpTypeUInt64) OtpTypeByte CounterBytes[sizeof(OtpTypeUInt64)];
 
                 OtpSerializationIntegerToBytes<OtpSerializationEndian::Big>(Counter, CounterBytes);
 
-                auto ntStatus = BCryptHashData(m_HashHandle.Get(), CounterBytes, sizeof(CounterBytes), 0);
-                if (!BCRYPT_SUCCESS(ntStatus)) {
-                    throw std::system_error(
-                        ntStatus,
-                        OtpExceptionWinNTCategory()
-                    );
+                switch (m_HashBackend) {
+                    case OtpHashBackend::Portable:
+                        cbHmacHash = m_HmacPortable.Compute(CounterBytes, sizeof(CounterBytes), HmacHash);
+                        break;
+#if WINOTP_PLATFORM_WINDOWS
+                    case OtpHashBackend::Cng:
+                        cbHmacHash = m_HmacCng.Compute(CounterBytes, sizeof(CounterBytes), HmacHash);
+                        break;
+#endif
+                    default:
+                        WINOTP_UNREACHABLE();
                 }
 
-                ntStatus = BCryptFinishHash(m_HashHandle.Get(), HmacHash.data(), static_cast<ULONG>(HmacHash.size()), 0);
-                if (!BCRYPT_SUCCESS(ntStatus)) {
-                    throw std::system_error(
-                        ntStatus,
-                        OtpExceptionWinNTCategory()
-                    );
-                }
+                return TruncateHmacHash(HmacHash, cbHmacHash, m_Digit);
+            }
+        }
 
-                OtpTypeByte Offset = HmacHash.back() & 0xF;
-                OtpTypeUInt32 Code = OtpSerializationBytesToInteger<OtpSerializationEndian::Big, OtpTypeUInt32>(HmacHash.data() + Offset);
-                
-                Code &= static_cast<OtpTypeUInt32>(0x7FFFFFFF);
-                Code %= DigitRangeSpace(m_Digit);
+        //
+        // writes the codes for counters [FirstCounter, FirstCounter + Count) into lpCodes[0 .. Count).
+        // Equivalent to calling GenerateCode in a loop, but the secret check and hash dispatch happen once
+        // and nothing is allocated. On x86 the portable backend hashes SHA-1/SHA-256 windows several counters
+        // at a time in SIMD lanes (SSE2/AVX2/AVX-512, picked at runtime).
+        //
+        void GenerateCodes(OtpTypeUInt64 FirstCounter, OtpTypeSize Count, OtpTypeUInt32* lpCodes) const {
+            EnumerateCodes(FirstCounter, Count, [lpCodes](OtpTypeSize i, OtpTypeUInt32 Code) { lpCodes[i] = Code; });
+        }
 
-                return Code;
-            }
+        //
+        // constant-time check of Code against counter Counter. Prefer this over comparing code strings.
+        //
+        [[nodiscard]]
+        bool Verify(OtpTypeUInt32 Code, OtpTypeUInt64 Counter) const {
+            return VerifyCounters(Code, Counter, 1) == 0;
         }
 
+        //
+        // constant-time check of Code against counters [Counter, Counter + LookAhead].
+        // Returns the offset of the matching counter from Counter (the caller should then resynchronise to
+        // Counter + offset + 1), or std::nullopt if no counter in the window matches. Every counter in the
+        // window is evaluated regardless of where the match is. Nothing is allocated.
+        //
         [[nodiscard]]
-        std::string GenerateCodeStringA(OtpTypeUInt64 Counter) const {
-            auto Code = GenerateCode(Counter);
-            auto CodeString = std::to_string(Code);
+        std::optional<OtpTypeUInt64> VerifyWindow(OtpTypeUInt32 Code, OtpTypeUInt64 Counter, OtpTypeSize LookAhead) const {
+            auto Window = Internal::OtpHotpWindow::Around(Counter, 0, LookAhead);
+            auto MatchedIndex = VerifyCounters(Code, Window.FirstCounter, Window.Count);
 
-            if (CodeString.length() < m_Digit) {
-                CodeString.insert(CodeString.begin(), m_Digit - CodeString.length(), '0');
+            if (MatchedIndex < Window.Count) {
+                return MatchedIndex;
+            } else {
+                return std::nullopt;
             }
+        }
 
-            return CodeString;
+        [[nodiscard]]
+        std::string GenerateCodeStringA(OtpTypeUInt64 Counter) const {
+            return FormatCode<std::string>(GenerateCode(Counter));
         }
 
         [[nodiscard]]
         std::wstring GenerateCodeStringW(OtpTypeUInt64 Counter) const {
-            auto Code = GenerateCode(Counter);
-            auto CodeString = std::to_wstring(Code);
+            return FormatCode<std::wstring>(GenerateCode(Counter));
+        }
 
-            if (CodeString.length() < m_Digit) {
-                CodeString.insert(CodeString.begin(), m_Digit - CodeString.length(), L'0');
-            }
+        //
+        // writes the zero-padded code and a terminator into lpszCode without allocating, and returns the
+        // number of digits written. cchCode must be at least GetDigit() + 1 (MaxCodeStringLength always is).
+        //
+        OtpTypeSize GenerateCodeStringA(OtpTypeUInt64 Counter, char* lpszCode, OtpTypeSize cchCode) const {
+            return FormatCode(GenerateCode(Counter), lpszCode, cchCode);
+        }
 
-            return CodeString;
+        OtpTypeSize GenerateCodeStringW(OtpTypeUInt64 Counter, wchar_t* lpszCode, OtpTypeSize cchCode) const {
+            return FormatCode(GenerateCode(Counter), lpszCode, cchCode);
         }
 
 #if defined(_UNICODE) || defined(UNICODE)
@@ -276,6 +365,10 @@ namespace WinOTP {
         std::wstring GenerateCodeString(OtpTypeUInt64 Counter) const {
             return GenerateCodeStringW(Counter);
         }
+
+        OtpTypeSize GenerateCodeString(OtpTypeUInt64 Counter, wchar_t* lpszCode, OtpTypeSize cchCode) const {
+            return GenerateCodeStringW(Counter, lpszCode, cchCode);
+        }
 #else
         [[nodiscard]]
         std::string ExportSecretBase32() const {
@@ -294,6 +387,10 @@ namespace WinOTP {
         std::string GenerateCodeString(OtpTypeUInt64 Counter) const {
             return GenerateCodeStringA(Counter);
         }
+
+        OtpTypeSize GenerateCodeString(OtpTypeUInt64 Counter, char* lpszCode, OtpTypeSize cchCode) const {
+            return GenerateCodeStringA(Counter, lpszCode, cchCode);
+        }
 #endif
 
     };
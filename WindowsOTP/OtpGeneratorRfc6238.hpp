@@ -1,14 +1,18 @@
 #pragma once
 #include "OtpGeneratorRfc4226.hpp"
-#include <time.h>
+#include "OtpClock.hpp"
 
 namespace WinOTP {
 
+    //
+    // thread-safety is the same as OtpGeneratorRfc4226.
+    //
     class OtpGeneratorRfc6238 : public OtpGeneratorRfc4226 {
     protected:
 
         const OtpTypeUInt32 m_Interval;
-        
+        const OtpClock*     m_lpClock;
+
         using OtpGeneratorRfc4226::ImportSecretRaw;
         using OtpGeneratorRfc4226::ImportSecretBase32;
         using OtpGeneratorRfc4226::ImportSecretBase32A;
@@ -17,21 +21,49 @@ namespace WinOTP {
         using OtpGeneratorRfc4226::ImportSecretBase64A;
         using OtpGeneratorRfc4226::ImportSecretBase64W;
         using OtpGeneratorRfc4226::GenerateCode;
+        using OtpGeneratorRfc4226::GenerateCodes;
         using OtpGeneratorRfc4226::GenerateCodeString;
         using OtpGeneratorRfc4226::GenerateCodeStringA;
         using OtpGeneratorRfc4226::GenerateCodeStringW;
+        using OtpGeneratorRfc4226::Verify;
+        using OtpGeneratorRfc4226::VerifyWindow;
 
     public:
 
-        OtpGeneratorRfc6238(OtpHashMode HashMode = OtpHashMode::Sha1, OtpTypeUInt32 Digit = 6, OtpTypeUInt32 Interval = 30) :
-            OtpGeneratorRfc4226(HashMode, Digit),
-            m_Interval(Interval) 
+        OtpGeneratorRfc6238(OtpHashMode HashMode = OtpHashMode::Sha1, OtpTypeUInt32 Digit = 6, OtpTypeUInt32 Interval = 30, OtpHashBackend HashBackend = OtpHashBackend::Portable) :
+            OtpGeneratorRfc4226(HashMode, Digit, HashBackend),
+            m_Interval(Interval),
+            m_lpClock(nullptr)
         {
             if (m_Interval == 0) {
                 throw std::invalid_argument("Interval cannot be zero.");
             }
         }
 
+        [[nodiscard]]
+        OtpTypeUInt32 GetInterval() const noexcept {
+            return m_Interval;
+        }
+
+        //
+        // the clock read by the overloads without a timestamp; nullptr (the default) reads the wall clock.
+        // The generator does not own the clock, which must outlive it.
+        //
+        OtpGeneratorRfc6238& SetClock(const OtpClock* lpClock) noexcept {
+            m_lpClock = lpClock;
+            return *this;
+        }
+
+        [[nodiscard]]
+        const OtpClock* GetClock() const noexcept {
+            return m_lpClock;
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetUnixTime() const noexcept {
+            return m_lpClock != nullptr ? m_lpClock->GetUnixTime() : OtpClockSystem::Read();
+        }
+
         OtpGeneratorRfc6238& ImportSecretRaw(const void* lpRawSecret, size_t cbRawSecret) {
             OtpGeneratorRfc4226::ImportSecretRaw(lpRawSecret, cbRawSecret);
             return *this;
@@ -58,62 +90,82 @@ namespace WinOTP {
         }
 
         [[nodiscard]]
-        OtpTypeUInt32 GenerateCode(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) {
+        OtpTypeUInt32 GenerateCode(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
             auto T = (UnixTimestamp - UnixTimestampStartCounting) / m_Interval;
             return OtpGeneratorRfc4226::GenerateCode(T);
         }
 
         [[nodiscard]]
-        OtpTypeUInt32 GenerateCode() {
-            return GenerateCode(_time64(nullptr), 0);
+        OtpTypeUInt32 GenerateCode() const {
+            return GenerateCode(GetUnixTime(), 0);
         }
 
+        //
+        // constant-time check of Code against the time step containing UnixTimestamp.
+        //
         [[nodiscard]]
-        std::string GenerateCodeStringA(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) {
-            auto Code = GenerateCode(UnixTimestamp, UnixTimestampStartCounting);
-            auto CodeString = std::to_string(Code);
-
-            if (CodeString.length() < m_Digit) {
-                CodeString.insert(CodeString.begin(), m_Digit - CodeString.length(), '0');
-            }
-
-            return CodeString;
+        bool Verify(OtpTypeUInt32 Code, OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            auto T = (UnixTimestamp - UnixTimestampStartCounting) / m_Interval;
+            return OtpGeneratorRfc4226::Verify(Code, T);
         }
 
+        //
+        // constant-time check of Code against time steps [T - StepsBehind, T + StepsAhead], T being the step
+        // containing UnixTimestamp, to tolerate clock drift between client and server.
+        // Returns the offset in steps of the matching time step from T (negative means the client is behind),
+        // or std::nullopt if nothing in the window matches. Every step in the window is evaluated regardless
+        // of where the match is. Nothing is allocated.
+        //
         [[nodiscard]]
-        std::string GenerateCodeStringA() {
-            auto Code = GenerateCode();
-            auto CodeString = std::to_string(Code);
+        std::optional<OtpTypeInt64> VerifyWindow(
+            OtpTypeUInt32 Code,
+            OtpTypeUInt64 UnixTimestamp,
+            OtpTypeUInt32 StepsBehind,
+            OtpTypeUInt32 StepsAhead,
+            OtpTypeUInt64 UnixTimestampStartCounting = 0) const
+        {
+            auto T = (UnixTimestamp - UnixTimestampStartCounting) / m_Interval;
+            auto Window = Internal::OtpHotpWindow::Around(T, StepsBehind, StepsAhead);
+            auto MatchedIndex = VerifyCounters(Code, Window.FirstCounter, Window.Count);
+            std::optional<OtpTypeInt64> Offset;
 
-            if (CodeString.length() < m_Digit) {
-                CodeString.insert(CodeString.begin(), m_Digit - CodeString.length(), '0');
+            if (MatchedIndex < Window.Count) {
+                Offset = static_cast<OtpTypeInt64>(Window.FirstCounter + MatchedIndex - T);
             }
 
-            return CodeString;
+            Internal::OtpInstrumentationRecordDrift(Offset);
+            return Offset;
         }
 
         [[nodiscard]]
-        std::wstring GenerateCodeStringW(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) {
-            auto Code = GenerateCode(UnixTimestamp, UnixTimestampStartCounting);
-            auto CodeString = std::to_wstring(Code);
+        std::string GenerateCodeStringA(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return FormatCode<std::string>(GenerateCode(UnixTimestamp, UnixTimestampStartCounting));
+        }
 
-            if (CodeString.length() < m_Digit) {
-                CodeString.insert(CodeString.begin(), m_Digit - CodeString.length(), L'0');
-            }
+        [[nodiscard]]
+        std::string GenerateCodeStringA() const {
+            return FormatCode<std::string>(GenerateCode());
+        }
 
-            return CodeString;
+        [[nodiscard]]
+        std::wstring GenerateCodeStringW(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return FormatCode<std::wstring>(GenerateCode(UnixTimestamp, UnixTimestampStartCounting));
         }
 
         [[nodiscard]]
-        std::wstring GenerateCodeStringW() {
-            auto Code = GenerateCode();
-            auto CodeString = std::to_wstring(Code);
+        std::wstring GenerateCodeStringW() const {
+            return FormatCode<std::wstring>(GenerateCode());
+        }
 
-            if (CodeString.length() < m_Digit) {
-                CodeString.insert(CodeString.begin(), m_Digit - CodeString.length(), L'0');
-            }
+        //
+        // buffer overloads: see OtpGeneratorRfc4226::GenerateCodeStringA.
+        //
+        OtpTypeSize GenerateCodeStringA(OtpTypeUInt64 UnixTimestamp, char* lpszCode, OtpTypeSize cchCode, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return FormatCode(GenerateCode(UnixTimestamp, UnixTimestampStartCounting), lpszCode, cchCode);
+        }
 
-            return CodeString;
+        OtpTypeSize GenerateCodeStringW(OtpTypeUInt64 UnixTimestamp, wchar_t* lpszCode, OtpTypeSize cchCode, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return FormatCode(GenerateCode(UnixTimestamp, UnixTimestampStartCounting), lpszCode, cchCode);
         }
 
 #if defined(_UNICODE) || defined(UNICODE)
@@ -128,14 +180,18 @@ namespace WinOTP {
         }
 
         [[nodiscard]]
-        std::wstring GenerateCodeString(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) {
+        std::wstring GenerateCodeString(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
             return GenerateCodeStringW(UnixTimestamp, UnixTimestampStartCounting);
         }
 
         [[nodiscard]]
-        std::wstring GenerateCodeString() {
+        std::wstring GenerateCodeString() const {
             return GenerateCodeStringW();
         }
+
+        OtpTypeSize GenerateCodeString(OtpTypeUInt64 UnixTimestamp, wchar_t* lpszCode, OtpTypeSize cchCode, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return GenerateCodeStringW(UnixTimestamp, lpszCode, cchCode, UnixTimestampStartCounting);
+        }
 #else
         OtpGeneratorRfc6238& ImportSecretBase32(std::string_view Base32Secret) {
             OtpGeneratorRfc4226::ImportSecretBase32(Base32Secret);
@@ -148,14 +204,18 @@ namespace WinOTP {
         }
 
         [[nodiscard]]
-        std::string GenerateCodeString(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) {
+        std::string GenerateCodeString(OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
             return GenerateCodeStringA(UnixTimestamp, UnixTimestampStartCounting);
         }
 
         [[nodiscard]]
-        std::string GenerateCodeString() {
+        std::string GenerateCodeString() const {
             return GenerateCodeStringA();
         }
+
+        OtpTypeSize GenerateCodeString(OtpTypeUInt64 UnixTimestamp, char* lpszCode, OtpTypeSize cchCode, OtpTypeUInt64 UnixTimestampStartCounting = 0) const {
+            return GenerateCodeStringA(UnixTimestamp, lpszCode, cchCode, UnixTimestampStartCounting);
+        }
 #endif
 
     };
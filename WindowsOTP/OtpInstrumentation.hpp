@@ -0,0 +1,285 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+
+namespace WinOTP {
+
+    //
+    // Optional hot-path instrumentation, compiled in only when WINOTP_INSTRUMENTATION is defined.
+    //
+    // The generators and codecs time each operation listed below and record it in a per-thread slot: a call
+    // count, the total time and a log-linear (HDR-style) latency histogram. Every TOTP window check also
+    // records the drift offset it accepted, or a rejection: VerifyWindow of OtpGeneratorRfc6238, of
+    // OtpGenerator and of OtpTotpCodeCache, and OtpCredentialStore's VerifyTotp and the TOTP requests of
+    // VerifyBatch (requests for unknown users or HOTP-only credentials are not counted). Plain Verify, which
+    // checks a single step, records no drift. Slots are cache-line aligned and assigned round-robin on a
+    // thread's first record, so threads do not share lines until there are more than 64 of them; every
+    // update is a relaxed atomic add, so sharing a slot only costs contention, never counts.
+    //
+    // OtpInstrumentationTakeSnapshot sums the slots into a plain struct a scraper can export or diff against
+    // its previous snapshot. Without WINOTP_INSTRUMENTATION nothing is stored, the hooks are empty inline
+    // functions and every snapshot is zero.
+    //
+    enum class OtpInstrumentedOperation : OtpTypeUInt32 {
+        GenerateCode,       // one HMAC and truncation, string forms included
+        GenerateCodes,      // a run of counters: GenerateCodes, Verify and VerifyWindow
+        FormatCode,         // code to zero-padded text
+        ImportSecret,       // the HMAC key schedule; decoding a Base32/Base64 secret is recorded as a decode
+        Base32Encode,
+        Base32Decode,
+        Base64Encode,
+        Base64Decode
+    };
+
+    inline constexpr OtpTypeSize OtpInstrumentedOperationCount = 8;
+
+    inline constexpr bool OtpInstrumentationEnabled = WINOTP_INSTRUMENTATION_ENABLED != 0;
+
+    [[nodiscard]]
+    constexpr const char* OtpInstrumentationGetName(OtpInstrumentedOperation Operation) noexcept {
+        switch (Operation) {
+            case OtpInstrumentedOperation::GenerateCode:
+                return "GenerateCode";
+            case OtpInstrumentedOperation::GenerateCodes:
+                return "GenerateCodes";
+            case OtpInstrumentedOperation::FormatCode:
+                return "FormatCode";
+            case OtpInstrumentedOperation::ImportSecret:
+                return "ImportSecret";
+            case OtpInstrumentedOperation::Base32Encode:
+                return "Base32Encode";
+            case OtpInstrumentedOperation::Base32Decode:
+                return "Base32Decode";
+            case OtpInstrumentedOperation::Base64Encode:
+                return "Base64Encode";
+            case OtpInstrumentedOperation::Base64Decode:
+                return "Base64Decode";
+            default:
+                return "Unknown";
+        }
+    }
+
+    //
+    // latencies in nanoseconds. Values below 8 get a bucket each; above that every power of two is split
+    // into 8 buckets, so a bucket is at most 12.5% wide. The last bucket also holds everything from 2^40 ns
+    // (about 18 minutes) up.
+    //
+    struct OtpInstrumentationHistogram {
+        static constexpr OtpTypeSize SubBucketCount = 8;
+        static constexpr OtpTypeSize MaxExponent = 39;
+        static constexpr OtpTypeSize BucketCount = (MaxExponent - 1) * SubBucketCount;
+
+        OtpTypeUInt64   Count;
+        OtpTypeUInt64   TotalNanoseconds;
+        OtpTypeUInt64   Buckets[BucketCount];
+
+        [[nodiscard]]
+        static constexpr OtpTypeSize GetBucketIndex(OtpTypeUInt64 Nanoseconds) noexcept {
+            if (Nanoseconds < SubBucketCount) {
+                return static_cast<OtpTypeSize>(Nanoseconds);
+            }
+
+            OtpTypeSize Exponent = 3;
+            while (Exponent < 63 && (Nanoseconds >> (Exponent + 1)) != 0) {
+                ++Exponent;
+            }
+
+            if (Exponent > MaxExponent) {
+                return BucketCount - 1;
+            }
+
+            return (Exponent - 2) * SubBucketCount + static_cast<OtpTypeSize>((Nanoseconds >> (Exponent - 3)) & (SubBucketCount - 1));
+        }
+
+        //
+        // the smallest latency that falls into bucket Index.
+        //
+        [[nodiscard]]
+        static constexpr OtpTypeUInt64 GetBucketLowerBound(OtpTypeSize Index) noexcept {
+            if (Index < SubBucketCount) {
+                return Index;
+            } else {
+                return (SubBucketCount + Index % SubBucketCount) << (Index / SubBucketCount - 1);
+            }
+        }
+
+        [[nodiscard]]
+        double GetMeanNanoseconds() const noexcept {
+            return Count != 0 ? static_cast<double>(TotalNanoseconds) / static_cast<double>(Count) : 0;
+        }
+
+        //
+        // upper bound of the bucket holding the Percentile-th (0 to 100) latency, 0 if nothing was recorded.
+        //
+        [[nodiscard]]
+        OtpTypeUInt64 GetPercentileNanoseconds(double Percentile) const noexcept {
+            OtpTypeUInt64 Total = 0;
+            for (OtpTypeSize i = 0; i < BucketCount; ++i) {
+                Total += Buckets[i];
+            }
+
+            OtpTypeUInt64 Rank = static_cast<OtpTypeUInt64>(static_cast<double>(Total) * Percentile / 100.0);
+            OtpTypeUInt64 Seen = 0;
+
+            for (OtpTypeSize i = 0; i < BucketCount; ++i) {
+                Seen += Buckets[i];
+                if (Seen != 0 && (Seen > Rank || Seen == Total)) {
+                    return i + 1 < BucketCount ? GetBucketLowerBound(i + 1) : GetBucketLowerBound(i);
+                }
+            }
+
+            return 0;
+        }
+    };
+
+    struct OtpInstrumentationSnapshot {
+
+        //
+        // drift offsets further than MaxDrift steps are counted at -MaxDrift or +MaxDrift.
+        //
+        static constexpr OtpTypeInt64 MaxDrift = 8;
+
+        OtpInstrumentationHistogram Operations[OtpInstrumentedOperationCount];
+        OtpTypeUInt64               DriftCounts[2 * MaxDrift + 1];
+        OtpTypeUInt64               DriftRejectedCount;
+
+        [[nodiscard]]
+        const OtpInstrumentationHistogram& operator[](OtpInstrumentedOperation Operation) const noexcept {
+            return Operations[static_cast<OtpTypeSize>(Operation)];
+        }
+
+        //
+        // TOTP codes accepted Offset steps from the server's time step.
+        //
+        [[nodiscard]]
+        OtpTypeUInt64 GetDriftCount(OtpTypeInt64 Offset) const noexcept {
+            return -MaxDrift <= Offset && Offset <= MaxDrift ? DriftCounts[Offset + MaxDrift] : 0;
+        }
+    };
+
+    namespace Internal {
+
+#if WINOTP_INSTRUMENTATION_ENABLED
+        struct alignas(WINOTP_CACHE_LINE_SIZE) OtpInstrumentationSlot {
+            struct Histogram {
+                std::atomic<OtpTypeUInt64>  Count;
+                std::atomic<OtpTypeUInt64>  TotalNanoseconds;
+                std::atomic<OtpTypeUInt64>  Buckets[OtpInstrumentationHistogram::BucketCount];
+            };
+
+            Histogram                   Operations[OtpInstrumentedOperationCount];
+            std::atomic<OtpTypeUInt64>  DriftCounts[2 * OtpInstrumentationSnapshot::MaxDrift + 1];
+            std::atomic<OtpTypeUInt64>  DriftRejectedCount;
+        };
+
+        inline constexpr OtpTypeSize OtpInstrumentationSlotCount = 64;
+
+        //
+        // static storage, so zero before any thread records; pages are only touched by slots in use.
+        //
+        inline OtpInstrumentationSlot OtpInstrumentationSlots[OtpInstrumentationSlotCount];
+        inline std::atomic<OtpTypeSize> OtpInstrumentationNextSlot(0);
+
+        [[nodiscard]]
+        inline OtpInstrumentationSlot& OtpInstrumentationGetSlot() noexcept {
+            thread_local OtpInstrumentationSlot* lpSlot =
+                &OtpInstrumentationSlots[OtpInstrumentationNextSlot.fetch_add(1, std::memory_order_relaxed) % OtpInstrumentationSlotCount];
+            return *lpSlot;
+        }
+
+        inline void OtpInstrumentationRecord(OtpInstrumentedOperation Operation, OtpTypeUInt64 Nanoseconds) noexcept {
+            auto& Target = OtpInstrumentationGetSlot().Operations[static_cast<OtpTypeSize>(Operation)];
+
+            Target.Count.fetch_add(1, std::memory_order_relaxed);
+            Target.TotalNanoseconds.fetch_add(Nanoseconds, std::memory_order_relaxed);
+            Target.Buckets[OtpInstrumentationHistogram::GetBucketIndex(Nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        }
+#endif
+
+        //
+        // times its own lifetime as one Operation.
+        //
+        class OtpInstrumentationScope {
+#if WINOTP_INSTRUMENTATION_ENABLED
+        private:
+
+            OtpInstrumentedOperation                m_Operation;
+            std::chrono::steady_clock::time_point   m_StartTime;
+
+        public:
+
+            explicit OtpInstrumentationScope(OtpInstrumentedOperation Operation) noexcept :
+                m_Operation(Operation),
+                m_StartTime(std::chrono::steady_clock::now()) {}
+
+            ~OtpInstrumentationScope() {
+                auto Elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_StartTime);
+                OtpInstrumentationRecord(m_Operation, static_cast<OtpTypeUInt64>(Elapsed.count()));
+            }
+#else
+        public:
+
+            explicit constexpr OtpInstrumentationScope(OtpInstrumentedOperation) noexcept {}
+#endif
+
+            OtpInstrumentationScope(const OtpInstrumentationScope& Other) = delete;
+
+            OtpInstrumentationScope& operator=(const OtpInstrumentationScope& Other) = delete;
+        };
+
+        //
+        // called after the constant-time comparison, with its result, so it reveals nothing the caller does not
+        // learn anyway.
+        //
+        inline void OtpInstrumentationRecordDrift([[maybe_unused]] const std::optional<OtpTypeInt64>& Offset) noexcept {
+#if WINOTP_INSTRUMENTATION_ENABLED
+            auto& Slot = OtpInstrumentationGetSlot();
+
+            if (Offset.has_value()) {
+                OtpTypeInt64 Clamped = Offset.value();
+                Clamped = Clamped < -OtpInstrumentationSnapshot::MaxDrift ? -OtpInstrumentationSnapshot::MaxDrift : Clamped;
+                Clamped = Clamped > OtpInstrumentationSnapshot::MaxDrift ? OtpInstrumentationSnapshot::MaxDrift : Clamped;
+                Slot.DriftCounts[Clamped + OtpInstrumentationSnapshot::MaxDrift].fetch_add(1, std::memory_order_relaxed);
+            } else {
+                Slot.DriftRejectedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+#endif
+        }
+
+    }
+
+    //
+    // sums every thread's slot. Records made while the snapshot is taken may be missing from it, and a
+    // histogram's Count may be a few records off its buckets; the next snapshot has them.
+    //
+    [[nodiscard]]
+    inline OtpInstrumentationSnapshot OtpInstrumentationTakeSnapshot() noexcept {
+        OtpInstrumentationSnapshot Snapshot = {};
+
+#if WINOTP_INSTRUMENTATION_ENABLED
+        for (const auto& Slot : Internal::OtpInstrumentationSlots) {
+            for (OtpTypeSize i = 0; i < OtpInstrumentedOperationCount; ++i) {
+                Snapshot.Operations[i].Count += Slot.Operations[i].Count.load(std::memory_order_relaxed);
+                Snapshot.Operations[i].TotalNanoseconds += Slot.Operations[i].TotalNanoseconds.load(std::memory_order_relaxed);
+
+                for (OtpTypeSize j = 0; j < OtpInstrumentationHistogram::BucketCount; ++j) {
+                    Snapshot.Operations[i].Buckets[j] += Slot.Operations[i].Buckets[j].load(std::memory_order_relaxed);
+                }
+            }
+
+            for (OtpTypeSize i = 0; i < 2 * OtpInstrumentationSnapshot::MaxDrift + 1; ++i) {
+                Snapshot.DriftCounts[i] += Slot.DriftCounts[i].load(std::memory_order_relaxed);
+            }
+
+            Snapshot.DriftRejectedCount += Slot.DriftRejectedCount.load(std::memory_order_relaxed);
+        }
+#endif
+
+        return Snapshot;
+    }
+
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include "Internal/OtpSplitMix.hpp"
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace WinOTP {
+
+    //
+    // Per-credential replay state: the next counter (HOTP) or time step (TOTP) that may still be accepted.
+    //
+    // RFC 4226 moves a user's counter past every accepted code and RFC 6238 forbids accepting a code twice;
+    // both come down to "accept step S only if no step >= S was accepted before". TryAccept makes that
+    // decision with one compare-and-swap, so any number of threads can verify the same user at once and
+    // exactly one of them wins each step.
+    //
+    // The table is open-addressed with linear probing and sized once, in the constructor, for a maximum
+    // number of users: it never allocates or rehashes afterwards and takes no lock. Users are never removed,
+    // only reset, which is what keeps every operation a plain atomic load or CAS.
+    //
+    // Used with an OtpCredentialStore:
+    //
+    //     auto Next = Table.GetNextCounter(UserId);
+    //     auto Offset = Store.VerifyHotp(UserId, Code, Next, LookAhead);
+    //     bool Accepted = Offset && Table.TryAccept(UserId, Next + *Offset);
+    //
+    //     auto Drift = Store.VerifyTotp(UserId, Code, UnixTimestamp);
+    //     bool Accepted = Drift && Table.TryAccept(UserId, UnixTimestamp / Store.GetInterval(UserId) + *Drift);
+    //
+    class OtpReplayTable {
+    public:
+
+        using UserIdType = OtpTypeUInt64;
+
+        // marks a free slot, so it cannot be used as a user ID.
+        static constexpr UserIdType KeyEmpty = UINT64_MAX;
+
+    private:
+
+        //
+        // Value is the last accepted step plus one; 0 means nothing was accepted yet.
+        //
+        struct Slot {
+            std::atomic<UserIdType>     Key{ KeyEmpty };
+            std::atomic<OtpTypeUInt64>  Value{ 0 };
+        };
+
+        std::unique_ptr<Slot[]>     m_Slots;
+        OtpTypeSize                 m_SlotMask;
+        OtpTypeSize                 m_Capacity;
+
+        // m_Reserved counts claims in flight as well as claimed slots; m_Count only the latter.
+        std::atomic<OtpTypeSize>    m_Reserved;
+        std::atomic<OtpTypeSize>    m_Count;
+
+        [[nodiscard]]
+        const Slot* FindSlot(UserIdType UserId) const noexcept {
+            for (OtpTypeSize i = Internal::OtpSplitMix64(UserId) & m_SlotMask, Probe = 0; Probe <= m_SlotMask; i = (i + 1) & m_SlotMask, ++Probe) {
+                UserIdType Key = m_Slots[i].Key.load(std::memory_order_acquire);
+                if (Key == UserId) {
+                    return &m_Slots[i];
+                }
+                if (Key == KeyEmpty) {
+                    return nullptr;
+                }
+            }
+
+            return nullptr;
+        }
+
+        //
+        // claims a slot for UserId if it has none. Racing claims of the same user end up in the same slot,
+        // because a slot's key only ever goes from KeyEmpty to a user ID.
+        //
+        // A claim reserves its place in m_Reserved before the CAS and gives it back if the CAS loses, so
+        // racing new users never take more than Capacity slots. A claim that finds no room while others are
+        // still in flight waits for them rather than report a table that may turn out not to be full.
+        //
+        [[nodiscard]]
+        Slot& FindOrClaimSlot(UserIdType UserId) {
+            if (UserId == KeyEmpty) {
+                throw std::invalid_argument("User ID is reserved by the replay table.");
+            }
+
+            for (OtpTypeSize i = Internal::OtpSplitMix64(UserId) & m_SlotMask, Probe = 0; Probe <= m_SlotMask; i = (i + 1) & m_SlotMask, ++Probe) {
+                UserIdType Key = m_Slots[i].Key.load(std::memory_order_acquire);
+
+                while (Key == KeyEmpty) {
+                    if (m_Reserved.fetch_add(1, std::memory_order_relaxed) < m_Capacity) {
+                        if (m_Slots[i].Key.compare_exchange_strong(Key, UserId, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                            m_Count.fetch_add(1, std::memory_order_relaxed);
+                            return m_Slots[i];
+                        }
+
+                        // Key now holds whoever won the slot.
+                        m_Reserved.fetch_sub(1, std::memory_order_relaxed);
+                        break;
+                    }
+
+                    m_Reserved.fetch_sub(1, std::memory_order_relaxed);
+
+                    if (m_Count.load(std::memory_order_relaxed) >= m_Capacity) {
+                        throw std::length_error("Replay table is full.");
+                    }
+
+                    std::this_thread::yield();
+                    Key = m_Slots[i].Key.load(std::memory_order_acquire);
+                }
+
+                if (Key == UserId) {
+                    return m_Slots[i];
+                }
+            }
+
+            throw std::length_error("Replay table is full.");
+        }
+
+    public:
+
+        //
+        // room for Capacity users, kept at most 3/4 full so probes stay short. Throws std::length_error if
+        // Capacity is too large to allocate.
+        //
+        explicit OtpReplayTable(OtpTypeSize Capacity) :
+            m_SlotMask(0),
+            m_Capacity(Capacity),
+            m_Reserved(0),
+            m_Count(0)
+        {
+            OtpTypeSize SlotCount = 16;
+
+            while (SlotCount / 4 * 3 < Capacity) {
+                if (SlotCount > SIZE_MAX / 2 / sizeof(Slot)) {
+                    throw std::length_error("Replay table capacity is too large.");
+                }
+                SlotCount *= 2;
+            }
+
+            m_Slots.reset(new Slot[SlotCount]);
+            m_SlotMask = SlotCount - 1;
+        }
+
+        OtpReplayTable(const OtpReplayTable& Other) = delete;
+
+        OtpReplayTable& operator=(const OtpReplayTable& Other) = delete;
+
+        //
+        // accepts Step if it is later than every step accepted for UserId so far. Returns false when the
+        // step, or a later one, was already accepted: the code is a replay.
+        // Throws std::invalid_argument for Step UINT64_MAX or UserId KeyEmpty, and std::length_error when
+        // UserId is new and the table already holds Capacity users.
+        //
+        [[nodiscard]]
+        bool TryAccept(UserIdType UserId, OtpTypeUInt64 Step) {
+            if (Step == UINT64_MAX) {
+                throw std::invalid_argument("Step is out of range.");
+            }
+
+            Slot& Entry = FindOrClaimSlot(UserId);
+            OtpTypeUInt64 Next = Entry.Value.load(std::memory_order_acquire);
+
+            do {
+                if (Step < Next) {
+                    return false;
+                }
+            } while (Entry.Value.compare_exchange_weak(Next, Step + 1, std::memory_order_acq_rel, std::memory_order_acquire) == false);
+
+            return true;
+        }
+
+        //
+        // the first counter TryAccept would still accept for UserId: where a HOTP look-ahead window starts.
+        // 0 for an unknown user.
+        //
+        [[nodiscard]]
+        OtpTypeUInt64 GetNextCounter(UserIdType UserId) const noexcept {
+            const Slot* lpEntry = FindSlot(UserId);
+            return lpEntry != nullptr ? lpEntry->Value.load(std::memory_order_acquire) : 0;
+        }
+
+        //
+        // overwrites UserId's state, e.g. with a persisted HOTP counter at startup, or with 0 on
+        // re-enrolment. Throws like TryAccept.
+        //
+        void SetNextCounter(UserIdType UserId, OtpTypeUInt64 NextCounter) {
+            FindOrClaimSlot(UserId).Value.store(NextCounter, std::memory_order_release);
+        }
+
+        [[nodiscard]]
+        OtpTypeSize GetCount() const noexcept {
+            return m_Count.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        OtpTypeSize GetCapacity() const noexcept {
+            return m_Capacity;
+        }
+
+        //
+        // fixed at construction.
+        //
+        [[nodiscard]]
+        OtpTypeSize GetMemoryUsage() const noexcept {
+            return sizeof(OtpReplayTable) + (m_SlotMask + 1) * sizeof(Slot);
+        }
+    };
+
+}
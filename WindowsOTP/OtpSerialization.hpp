@@ -1,5 +1,7 @@
 #pragma once
-#include <stdlib.h>
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include <type_traits>
 
 namespace WinOTP {
 
@@ -27,24 +29,24 @@ namespace WinOTP {
             }
 
             if constexpr (sizeof(__IntegerType) == 2) {
-                *reinterpret_cast<__IntegerType*>(lpBytes) = _byteswap_ushort(Integer);
+                *reinterpret_cast<__IntegerType*>(lpBytes) = Internal::OtpByteSwap16(Integer);
                 return;
             }
 
             if constexpr (sizeof(__IntegerType) == 4) {
-                *reinterpret_cast<__IntegerType*>(lpBytes) = _byteswap_ulong(Integer);
+                *reinterpret_cast<__IntegerType*>(lpBytes) = Internal::OtpByteSwap32(Integer);
                 return;
             }
 
             if constexpr (sizeof(__IntegerType) == 8) {
-                *reinterpret_cast<__IntegerType*>(lpBytes) = _byteswap_uint64(Integer);
+                *reinterpret_cast<__IntegerType*>(lpBytes) = Internal::OtpByteSwap64(Integer);
                 return;
             }
 
-            __assume(0);
+            WINOTP_UNREACHABLE();
         }
 
-        __assume(0);
+        WINOTP_UNREACHABLE();
     }
 
     template<OtpSerializationEndian __Endian, typename __IntegerType>
@@ -69,26 +71,26 @@ namespace WinOTP {
 
             if constexpr (sizeof(__IntegerType) == 2) {
                 return static_cast<__IntegerType>(
-                    _byteswap_ushort(*reinterpret_cast<const __IntegerType*>(lpBytes))
+                    Internal::OtpByteSwap16(*reinterpret_cast<const __IntegerType*>(lpBytes))
                 );
             }
 
             if constexpr (sizeof(__IntegerType) == 4) {
                 return static_cast<__IntegerType>(
-                    _byteswap_ulong(*reinterpret_cast<const __IntegerType*>(lpBytes))
+                    Internal::OtpByteSwap32(*reinterpret_cast<const __IntegerType*>(lpBytes))
                 );
             }
 
             if constexpr (sizeof(__IntegerType) == 8) {
                 return static_cast<__IntegerType>(
-                    _byteswap_uint64(*reinterpret_cast<const __IntegerType*>(lpBytes))
+                    Internal::OtpByteSwap64(*reinterpret_cast<const __IntegerType*>(lpBytes))
                 );
             }
 
-            __assume(0);
+            WINOTP_UNREACHABLE();
         }
 
-        __assume(0);
+        WINOTP_UNREACHABLE();
     }
 
 }
@@ -0,0 +1,343 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include "Internal/OtpSplitMix.hpp"
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace WinOTP {
+
+    struct OtpThrottlePolicy {
+        // unconfirmed attempts a user may make before being locked out; a successful one clears the count.
+        OtpTypeUInt32 MaxFailures = 5;
+
+        // the failure count halves every DecaySeconds, so occasional typos never add up to a lockout.
+        OtpTypeUInt32 DecaySeconds = 60;
+
+        OtpTypeUInt32 LockoutSeconds = 300;
+    };
+
+    //
+    // In-process attempt limiting for code verification.
+    //
+    // A 6-digit code has only 10^6 values, so an attacker who may guess freely finds it quickly. Every
+    // verification first calls TryAttempt, which counts the attempt as failed until RecordSuccess clears it.
+    // Counting before verifying is what bounds parallel guessing: however many threads verify one user at
+    // once, at most MaxFailures attempts get through before the lockout, since each is one compare-and-swap.
+    //
+    //     if (Throttle.TryAttempt(UserId, UnixTime) == false) {
+    //         return Rejected;                                            // locked out, code not even checked
+    //     }
+    //     if (Store.VerifyTotp(UserId, Code, UnixTime)) {
+    //         Throttle.RecordSuccess(UserId);
+    //     }
+    //
+    // The whole state of a user is one 64-bit word: the failure count, a lockout flag and a time stamp (the
+    // start of the current decay period, or the end of the lockout). Slots are grouped in cache-line
+    // shards; a user's key and state live in the shard its hash selects, or, when that is full, in one of the
+    // following shards. As with OtpReplayTable, the table is sized once for a maximum number of users, about
+    // 32 MiB per million, and never allocates, locks or removes users afterwards.
+    //
+    // Times are Unix seconds and must be below 2^40.
+    //
+    class OtpThrottleTable {
+    public:
+
+        using UserIdType = OtpTypeUInt64;
+
+        // marks a free slot, so it cannot be used as a user ID.
+        static constexpr UserIdType KeyEmpty = UINT64_MAX;
+
+    private:
+
+        static constexpr OtpTypeUInt64 StateFailureMask = (OtpTypeUInt64{ 1 } << 23) - 1;
+        static constexpr OtpTypeUInt64 StateLocked = OtpTypeUInt64{ 1 } << 23;
+        static constexpr unsigned StateStampShift = 24;
+
+        struct Slot {
+            std::atomic<UserIdType>     Key{ KeyEmpty };
+            std::atomic<OtpTypeUInt64>  State{ 0 };
+        };
+
+        static constexpr OtpTypeSize SlotsPerShard = WINOTP_CACHE_LINE_SIZE / sizeof(Slot);
+
+        struct alignas(WINOTP_CACHE_LINE_SIZE) Shard {
+            Slot Slots[SlotsPerShard];
+        };
+
+        //
+        // statistics are bumped from every thread; spreading them over padded shards keeps them from
+        // becoming the one cache line all verifications fight over.
+        //
+        static constexpr OtpTypeSize CounterShardCount = 16;
+
+        struct alignas(WINOTP_CACHE_LINE_SIZE) CounterShard {
+            std::atomic<OtpTypeUInt64> LockoutCount{ 0 };
+            std::atomic<OtpTypeUInt64> RejectedCount{ 0 };
+        };
+
+        std::unique_ptr<Shard[]>    m_Shards;
+        OtpTypeSize                 m_ShardMask;
+        OtpTypeSize                 m_Capacity;
+        OtpThrottlePolicy           m_Policy;
+        std::atomic<OtpTypeSize>    m_Reserved;
+        std::atomic<OtpTypeSize>    m_Count;
+        CounterShard                m_Counters[CounterShardCount];
+
+        [[nodiscard]]
+        static constexpr OtpTypeUInt64 PackState(OtpTypeUInt64 Failures, bool Locked, OtpTypeUInt64 Stamp) noexcept {
+            return (Stamp << StateStampShift) | (Locked ? StateLocked : 0) | Failures;
+        }
+
+        //
+        // State as of UnixTime: an expired lockout is lifted, and the failure count is halved once per
+        // full decay period elapsed.
+        //
+        [[nodiscard]]
+        OtpTypeUInt64 DecayState(OtpTypeUInt64 State, OtpTypeUInt64 UnixTime) const noexcept {
+            OtpTypeUInt64 Failures = State & StateFailureMask;
+            OtpTypeUInt64 Stamp = State >> StateStampShift;
+
+            if ((State & StateLocked) != 0) {
+                return UnixTime < Stamp ? State : PackState(0, false, UnixTime);
+            }
+
+            if (UnixTime > Stamp) {
+                OtpTypeUInt64 Periods = (UnixTime - Stamp) / m_Policy.DecaySeconds;
+                Failures = Periods < 23 ? Failures >> Periods : 0;
+                Stamp += Periods * m_Policy.DecaySeconds;
+            }
+
+            return PackState(Failures, false, Failures != 0 ? Stamp : UnixTime);
+        }
+
+        [[nodiscard]]
+        CounterShard& SelectCounters(UserIdType UserId) noexcept {
+            return m_Counters[Internal::OtpSplitMix64(UserId) % CounterShardCount];
+        }
+
+        [[nodiscard]]
+        Slot* FindSlot(UserIdType UserId) const noexcept {
+            for (OtpTypeSize i = Internal::OtpSplitMix64(UserId) & m_ShardMask, Probe = 0; Probe <= m_ShardMask; i = (i + 1) & m_ShardMask, ++Probe) {
+                for (Slot& Entry : m_Shards[i].Slots) {
+                    UserIdType Key = Entry.Key.load(std::memory_order_acquire);
+                    if (Key == UserId) {
+                        return &Entry;
+                    }
+                    if (Key == KeyEmpty) {
+                        return nullptr;
+                    }
+                }
+            }
+
+            return nullptr;
+        }
+
+        //
+        // same protocol as OtpReplayTable: a key only ever goes from KeyEmpty to a user ID, so racing claims of
+        // one user end up in the same slot, and m_Reserved is taken before the CAS so that racing new users
+        // never take more than Capacity slots.
+        //
+        [[nodiscard]]
+        Slot& FindOrClaimSlot(UserIdType UserId) {
+            if (UserId == KeyEmpty) {
+                throw std::invalid_argument("User ID is reserved by the throttle table.");
+            }
+
+            for (OtpTypeSize i = Internal::OtpSplitMix64(UserId) & m_ShardMask, Probe = 0; Probe <= m_ShardMask; i = (i + 1) & m_ShardMask, ++Probe) {
+                for (Slot& Entry : m_Shards[i].Slots) {
+                    UserIdType Key = Entry.Key.load(std::memory_order_acquire);
+
+                    while (Key == KeyEmpty) {
+                        if (m_Reserved.fetch_add(1, std::memory_order_relaxed) < m_Capacity) {
+                            if (Entry.Key.compare_exchange_strong(Key, UserId, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                                m_Count.fetch_add(1, std::memory_order_relaxed);
+                                return Entry;
+                            }
+
+                            m_Reserved.fetch_sub(1, std::memory_order_relaxed);
+                            break;
+                        }
+
+                        m_Reserved.fetch_sub(1, std::memory_order_relaxed);
+
+                        if (m_Count.load(std::memory_order_relaxed) >= m_Capacity) {
+                            throw std::length_error("Throttle table is full.");
+                        }
+
+                        std::this_thread::yield();
+                        Key = Entry.Key.load(std::memory_order_acquire);
+                    }
+
+                    if (Key == UserId) {
+                        return Entry;
+                    }
+                }
+            }
+
+            throw std::length_error("Throttle table is full.");
+        }
+
+    public:
+
+        //
+        // room for Capacity users, with shards kept at most 3/4 full. Throws std::invalid_argument for a
+        // policy with a zero MaxFailures or DecaySeconds, or a MaxFailures of 2^23 or more.
+        //
+        explicit OtpThrottleTable(OtpTypeSize Capacity, const OtpThrottlePolicy& Policy = OtpThrottlePolicy()) :
+            m_ShardMask(0),
+            m_Capacity(Capacity),
+            m_Policy(Policy),
+            m_Reserved(0),
+            m_Count(0)
+        {
+            if (Policy.MaxFailures == 0 || Policy.MaxFailures > StateFailureMask || Policy.DecaySeconds == 0) {
+                throw std::invalid_argument("Throttle policy is invalid.");
+            }
+
+            OtpTypeSize ShardCount = 4;
+
+            while (ShardCount / 4 * 3 * SlotsPerShard < Capacity) {
+                if (ShardCount > SIZE_MAX / 2 / sizeof(Shard)) {
+                    throw std::length_error("Throttle table capacity is too large.");
+                }
+                ShardCount *= 2;
+            }
+
+            m_Shards.reset(new Shard[ShardCount]);
+            m_ShardMask = ShardCount - 1;
+        }
+
+        OtpThrottleTable(const OtpThrottleTable& Other) = delete;
+
+        OtpThrottleTable& operator=(const OtpThrottleTable& Other) = delete;
+
+        //
+        // counts one attempt for UserId and returns true, or returns false without counting while UserId is
+        // locked out. The attempt that reaches MaxFailures still goes through and starts the lockout.
+        // Throws std::invalid_argument for UserId KeyEmpty or a UnixTime of 2^40 or more, and
+        // std::length_error when UserId is new and the table already holds Capacity users.
+        //
+        [[nodiscard]]
+        bool TryAttempt(UserIdType UserId, OtpTypeUInt64 UnixTime) {
+            if (UnixTime >> (64 - StateStampShift) != 0) {
+                throw std::invalid_argument("Time is out of range.");
+            }
+
+            Slot& Entry = FindOrClaimSlot(UserId);
+            OtpTypeUInt64 State = Entry.State.load(std::memory_order_acquire);
+            OtpTypeUInt64 NewState;
+
+            do {
+                OtpTypeUInt64 Current = DecayState(State, UnixTime);
+
+                if ((Current & StateLocked) != 0) {
+                    SelectCounters(UserId).RejectedCount.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                OtpTypeUInt64 Failures = (Current & StateFailureMask) + 1;
+
+                if (Failures >= m_Policy.MaxFailures) {
+                    NewState = PackState(Failures, true, UnixTime + m_Policy.LockoutSeconds);
+                } else {
+                    NewState = PackState(Failures, false, Current >> StateStampShift);
+                }
+            } while (Entry.State.compare_exchange_weak(State, NewState, std::memory_order_acq_rel, std::memory_order_acquire) == false);
+
+            if ((NewState & StateLocked) != 0) {
+                SelectCounters(UserId).LockoutCount.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            return true;
+        }
+
+        //
+        // clears UserId's failures, and its lockout if a concurrent attempt just started one: a correct code
+        // proves the attempt was not a guess.
+        //
+        void RecordSuccess(UserIdType UserId) noexcept {
+            if (Slot* lpEntry = FindSlot(UserId)) {
+                lpEntry->State.store(0, std::memory_order_release);
+            }
+        }
+
+        //
+        // unconfirmed attempts counted against UserId as of UnixTime, after decay.
+        //
+        [[nodiscard]]
+        OtpTypeUInt32 GetFailureCount(UserIdType UserId, OtpTypeUInt64 UnixTime) const noexcept {
+            const Slot* lpEntry = FindSlot(UserId);
+            return lpEntry != nullptr ? static_cast<OtpTypeUInt32>(DecayState(lpEntry->State.load(std::memory_order_acquire), UnixTime) & StateFailureMask) : 0;
+        }
+
+        //
+        // the Unix time at which UserId's lockout ends, or 0 if UserId is not locked out at UnixTime.
+        //
+        [[nodiscard]]
+        OtpTypeUInt64 GetLockoutExpiry(UserIdType UserId, OtpTypeUInt64 UnixTime) const noexcept {
+            const Slot* lpEntry = FindSlot(UserId);
+
+            if (lpEntry != nullptr) {
+                OtpTypeUInt64 State = DecayState(lpEntry->State.load(std::memory_order_acquire), UnixTime);
+                if ((State & StateLocked) != 0) {
+                    return State >> StateStampShift;
+                }
+            }
+
+            return 0;
+        }
+
+        //
+        // lockouts started so far.
+        //
+        [[nodiscard]]
+        OtpTypeUInt64 GetLockoutCount() const noexcept {
+            OtpTypeUInt64 Count = 0;
+            for (const auto& Counters : m_Counters) {
+                Count += Counters.LockoutCount.load(std::memory_order_relaxed);
+            }
+            return Count;
+        }
+
+        //
+        // attempts turned away by a lockout so far.
+        //
+        [[nodiscard]]
+        OtpTypeUInt64 GetRejectedCount() const noexcept {
+            OtpTypeUInt64 Count = 0;
+            for (const auto& Counters : m_Counters) {
+                Count += Counters.RejectedCount.load(std::memory_order_relaxed);
+            }
+            return Count;
+        }
+
+        [[nodiscard]]
+        const OtpThrottlePolicy& GetPolicy() const noexcept {
+            return m_Policy;
+        }
+
+        [[nodiscard]]
+        OtpTypeSize GetCount() const noexcept {
+            return m_Count.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        OtpTypeSize GetCapacity() const noexcept {
+            return m_Capacity;
+        }
+
+        //
+        // fixed at construction.
+        //
+        [[nodiscard]]
+        OtpTypeSize GetMemoryUsage() const noexcept {
+            return sizeof(OtpThrottleTable) + (m_ShardMask + 1) * sizeof(Shard);
+        }
+    };
+
+}
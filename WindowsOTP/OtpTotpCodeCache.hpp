@@ -0,0 +1,189 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include "Internal/OtpHotp.hpp"
+#include "OtpInstrumentation.hpp"
+#include "OtpGeneratorRfc6238.hpp"
+
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+
+namespace WinOTP {
+
+    //
+    // Memoizes the codes of one TOTP generator's verification window for the current time step.
+    //
+    // A user is often verified several times within one step (retries, several services checking the same
+    // code), and each VerifyWindow would recompute the same HMACs. The cache keeps the window's codes for the
+    // most recently computed step T; a verification against the same step only compares, in constant time,
+    // against the cached codes. A verification against another step recomputes and republishes, so the
+    // cache follows the clock without any explicit invalidation.
+    //
+    // The window is published with a sequence lock: readers never block or write the shared window, and a
+    // verification that finds a writer mid-update just computes its own codes. The hit/miss counters sit on
+    // a cache line of their own, so counting does not invalidate the line readers copy the window from.
+    // Hits and misses take different times, which reveals whether the step was cached but nothing about
+    // the submitted code.
+    //
+    // The generator is not owned and must outlive the cache; its secret must not change while the cache
+    // is in use, since the cached codes would go stale.
+    //
+    class OtpTotpCodeCache {
+    public:
+
+        static constexpr OtpTypeSize MaxWindowSize = 16;
+
+    private:
+
+        const OtpGeneratorRfc6238&  m_Generator;
+        const OtpTypeUInt32         m_StepsBehind;
+        const OtpTypeUInt32         m_StepsAhead;
+
+        // even while stable, odd while a writer is updating m_Step and m_Codes.
+        std::atomic<OtpTypeUInt64>  m_Sequence;
+        std::atomic<OtpTypeUInt64>  m_Step;
+        std::atomic<OtpTypeUInt32>  m_Codes[MaxWindowSize];
+
+        //
+        // one pair per cache, which usually means per user: sharding them would cost far more memory than
+        // the rare contention on one user's cache is worth.
+        //
+        alignas(WINOTP_CACHE_LINE_SIZE) std::atomic<OtpTypeUInt64> m_HitCount;
+        std::atomic<OtpTypeUInt64>  m_MissCount;
+
+        //
+        // copies the cached window into lpCodes if it is the window of step T.
+        //
+        [[nodiscard]]
+        bool Lookup(OtpTypeUInt64 T, OtpTypeSize Count, OtpTypeUInt32* lpCodes) const noexcept {
+            OtpTypeUInt64 Sequence = m_Sequence.load(std::memory_order_acquire);
+
+            if ((Sequence & 1) != 0 || m_Step.load(std::memory_order_relaxed) != T) {
+                return false;
+            }
+
+            for (OtpTypeSize i = 0; i < Count; ++i) {
+                lpCodes[i] = m_Codes[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return m_Sequence.load(std::memory_order_relaxed) == Sequence;
+        }
+
+        //
+        // best effort: gives up if another writer holds the lock, since that writer is storing a window too.
+        //
+        void Publish(OtpTypeUInt64 T, OtpTypeSize Count, const OtpTypeUInt32* lpCodes) noexcept {
+            OtpTypeUInt64 Sequence = m_Sequence.load(std::memory_order_relaxed);
+
+            if ((Sequence & 1) != 0 || m_Sequence.compare_exchange_strong(Sequence, Sequence + 1, std::memory_order_acquire) == false) {
+                return;
+            }
+
+            std::atomic_thread_fence(std::memory_order_release);
+
+            m_Step.store(T, std::memory_order_relaxed);
+            for (OtpTypeSize i = 0; i < Count; ++i) {
+                m_Codes[i].store(lpCodes[i], std::memory_order_relaxed);
+            }
+
+            m_Sequence.store(Sequence + 2, std::memory_order_release);
+        }
+
+    public:
+
+        OtpTotpCodeCache(const OtpGeneratorRfc6238& Generator, OtpTypeUInt32 StepsBehind = 1, OtpTypeUInt32 StepsAhead = 1) :
+            m_Generator(Generator),
+            m_StepsBehind(StepsBehind),
+            m_StepsAhead(StepsAhead),
+            m_Sequence(0),
+            m_Step(UINT64_MAX),
+            m_Codes{},
+            m_HitCount(0),
+            m_MissCount(0)
+        {
+            if (static_cast<OtpTypeUInt64>(StepsBehind) + StepsAhead + 1 > MaxWindowSize) {
+                throw std::invalid_argument("Verification window is too large to cache.");
+            }
+        }
+
+        OtpTotpCodeCache(const OtpTotpCodeCache& Other) = delete;
+
+        OtpTotpCodeCache& operator=(const OtpTotpCodeCache& Other) = delete;
+
+        //
+        // same result as m_Generator.VerifyWindow(Code, UnixTimestamp, StepsBehind, StepsAhead, UnixTimestampStartCounting).
+        //
+        [[nodiscard]]
+        std::optional<OtpTypeInt64> VerifyWindow(OtpTypeUInt32 Code, OtpTypeUInt64 UnixTimestamp, OtpTypeUInt64 UnixTimestampStartCounting = 0) {
+            auto T = (UnixTimestamp - UnixTimestampStartCounting) / m_Generator.GetInterval();
+            auto Window = Internal::OtpHotpWindow::Around(T, m_StepsBehind, m_StepsAhead);
+
+            OtpTypeUInt32 Codes[MaxWindowSize];
+
+            if (Lookup(T, Window.Count, Codes)) {
+                m_HitCount.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                m_MissCount.fetch_add(1, std::memory_order_relaxed);
+                static_cast<const OtpGeneratorRfc4226&>(m_Generator).GenerateCodes(Window.FirstCounter, Window.Count, Codes);
+                Publish(T, Window.Count, Codes);
+            }
+
+            Internal::OtpHotpWindowMatch Match(Code, Window.Count);
+            for (OtpTypeSize i = 0; i < Window.Count; ++i) {
+                Match.Update(i, Codes[i]);
+            }
+
+            auto MatchedIndex = Match.Result();
+            std::optional<OtpTypeInt64> Offset;
+
+            if (MatchedIndex < Window.Count) {
+                Offset = static_cast<OtpTypeInt64>(Window.FirstCounter + MatchedIndex - T);
+            }
+
+            Internal::OtpInstrumentationRecordDrift(Offset);
+            return Offset;
+        }
+
+        //
+        // against the generator's clock.
+        //
+        [[nodiscard]]
+        std::optional<OtpTypeInt64> VerifyWindow(OtpTypeUInt32 Code) {
+            return VerifyWindow(Code, m_Generator.GetUnixTime());
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetHitCount() const noexcept {
+            return m_HitCount.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetMissCount() const noexcept {
+            return m_MissCount.load(std::memory_order_relaxed);
+        }
+
+        //
+        // hits over all verifications so far, 0 before the first one.
+        //
+        [[nodiscard]]
+        double GetHitRate() const noexcept {
+            OtpTypeUInt64 HitCount = GetHitCount();
+            OtpTypeUInt64 Total = HitCount + GetMissCount();
+            return Total != 0 ? static_cast<double>(HitCount) / static_cast<double>(Total) : 0;
+        }
+
+        void ResetCounters() noexcept {
+            m_HitCount.store(0, std::memory_order_relaxed);
+            m_MissCount.store(0, std::memory_order_relaxed);
+        }
+
+        ~OtpTotpCodeCache() {
+            for (auto& Code : m_Codes) {
+                Code.store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+
+}
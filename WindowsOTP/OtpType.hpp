@@ -10,7 +10,35 @@ namespace WinOTP {
     using OtpTypeUInt16 = uint16_t;
     using OtpTypeUInt32 = uint32_t;
     using OtpTypeUInt64 = uint64_t;
+    using OtpTypeInt64  = int64_t;
     using OtpTypeSize   = size_t;
 
+    enum class OtpHashMode {
+        Sha1,
+        Sha256,
+        Sha384,
+        Sha512
+    };
+
+    enum class OtpHashBackend {
+        Portable,   // in-process SHA-1/SHA-2 implementation, available on every platform
+        Cng         // Windows CNG (bcrypt.dll), Windows only
+    };
+
+    enum class OtpAuthType {
+        Hotp,       // otpauth://hotp/, RFC 4226
+        Totp        // otpauth://totp/, RFC 6238
+    };
+
+    enum class OtpBase64Alphabet {
+        Standard,   // RFC 4648 section 4: '+' and '/', padded with '='
+        Url         // RFC 4648 section 5: '-' and '_', unpadded
+    };
+
+    enum class OtpBase64Mode {
+        Lenient,    // either alphabet, padding optional, trailing bits ignored
+        Strict      // only the requested alphabet, canonical padding and zero trailing bits
+    };
+
 }
 
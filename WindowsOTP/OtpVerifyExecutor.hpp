@@ -0,0 +1,289 @@
+#pragma once
+#include "OtpType.hpp"
+#include "Internal/OtpPlatform.hpp"
+#include "Internal/OtpMpmcQueue.hpp"
+#include "OtpCredentialStore.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace WinOTP {
+
+    //
+    // Asynchronous verification against an OtpCredentialStore on a fixed pool of worker threads.
+    //
+    // Request threads only push a request into a bounded lock-free queue and return; each worker pops up
+    // to MaxBatchSize queued requests at a time, verifies them with OtpCredentialStore::VerifyBatch (grouped
+    // by hash mode) and completes them in queue order, by callback or through a std::future. Batching is
+    // what keeps the per-request overhead flat under load: a busy worker takes whole batches without
+    // sleeping, and an idle one is woken only when it is actually waiting.
+    //
+    // The queue bounds the work in flight. TrySubmit refuses a request when the queue is full, so a
+    // frontend can shed load or answer "try again"; Submit blocks until there is room instead.
+    //
+    // The store is only read; it must outlive the executor and must not be modified while requests are
+    // pending. The destructor completes every request already queued, then joins the workers.
+    //
+    class OtpVerifyExecutor {
+    public:
+
+        using RequestType = OtpCredentialStore::VerifyRequest;
+        using ResultType = OtpCredentialStore::VerifyResult;
+
+        //
+        // runs on a worker thread and must not throw. Long work here delays the rest of its batch.
+        //
+        using CallbackType = void (*)(void* lpContext, const ResultType& Result);
+
+        static constexpr OtpTypeSize MaxBatchSize = 64;
+
+    private:
+
+        struct Item {
+            RequestType     Request;
+            CallbackType    lpfnCallback;
+            void*           lpContext;
+        };
+
+        const OtpCredentialStore&       m_Store;
+        Internal::OtpMpmcQueue<Item>    m_Queue;
+
+        //
+        // sleeping workers and producers register in these counts before re-checking the queue under
+        // m_WaitLock, so a push or pop only takes the lock when someone may be waiting for it.
+        //
+        std::mutex                      m_WaitLock;
+        std::condition_variable         m_WorkAvailable;
+        std::condition_variable         m_SpaceAvailable;
+        std::atomic<unsigned>           m_IdleWorkerCount;
+        std::atomic<unsigned>           m_BlockedProducerCount;
+        std::atomic<bool>               m_Stopping;
+
+        std::atomic<OtpTypeUInt64>      m_BatchCount;
+        std::atomic<OtpTypeUInt64>      m_CompletedCount;
+
+        std::vector<std::thread>        m_Workers;
+
+        void WakeWorker() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_IdleWorkerCount.load(std::memory_order_relaxed) != 0) {
+                std::lock_guard<std::mutex> Lock(m_WaitLock);
+                m_WorkAvailable.notify_one();
+            }
+        }
+
+        void WakeProducers() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_BlockedProducerCount.load(std::memory_order_relaxed) != 0) {
+                std::lock_guard<std::mutex> Lock(m_WaitLock);
+                m_SpaceAvailable.notify_all();
+            }
+        }
+
+        //
+        // false once the executor is stopping and the queue is drained.
+        //
+        bool WaitForWork() {
+            // a short spin catches the next request of a steady stream without a sleep and wake-up.
+            for (unsigned Spin = 0; Spin < 64; ++Spin) {
+                if (m_Queue.GetSize() != 0) {
+                    return true;
+                }
+                std::this_thread::yield();
+            }
+
+            std::unique_lock<std::mutex> Lock(m_WaitLock);
+
+            m_IdleWorkerCount.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            m_WorkAvailable.wait(Lock, [this]() {
+                return m_Queue.GetSize() != 0 || m_Stopping.load(std::memory_order_relaxed);
+            });
+
+            m_IdleWorkerCount.fetch_sub(1, std::memory_order_relaxed);
+            return m_Queue.GetSize() != 0;
+        }
+
+        void WorkerMain() {
+            Item Items[MaxBatchSize];
+            RequestType Requests[MaxBatchSize];
+            ResultType Results[MaxBatchSize];
+
+            for (;;) {
+                OtpTypeSize Count = 0;
+
+                while (Count < MaxBatchSize && m_Queue.TryPop(Items[Count])) {
+                    ++Count;
+                }
+
+                if (Count == 0) {
+                    if (WaitForWork() == false) {
+                        return;
+                    }
+                    continue;
+                }
+
+                WakeProducers();
+
+                for (OtpTypeSize i = 0; i < Count; ++i) {
+                    Requests[i] = Items[i].Request;
+                }
+
+                m_Store.VerifyBatch(Requests, Count, Results);
+
+                for (OtpTypeSize i = 0; i < Count; ++i) {
+                    Items[i].lpfnCallback(Items[i].lpContext, Results[i]);
+                }
+
+                m_BatchCount.fetch_add(1, std::memory_order_relaxed);
+                m_CompletedCount.fetch_add(Count, std::memory_order_relaxed);
+            }
+        }
+
+        void Stop() noexcept {
+            {
+                std::lock_guard<std::mutex> Lock(m_WaitLock);
+                m_Stopping.store(true, std::memory_order_relaxed);
+                m_WorkAvailable.notify_all();
+            }
+
+            for (auto& Worker : m_Workers) {
+                Worker.join();
+            }
+        }
+
+    public:
+
+        //
+        // WorkerCount 0 uses every hardware thread. QueueCapacity is rounded up to a power of two.
+        //
+        explicit OtpVerifyExecutor(const OtpCredentialStore& Store, unsigned WorkerCount = 0, OtpTypeSize QueueCapacity = 65536) :
+            m_Store(Store),
+            m_Queue(QueueCapacity),
+            m_IdleWorkerCount(0),
+            m_BlockedProducerCount(0),
+            m_Stopping(false),
+            m_BatchCount(0),
+            m_CompletedCount(0)
+        {
+            if (WorkerCount == 0) {
+                WorkerCount = std::thread::hardware_concurrency();
+            }
+            if (WorkerCount == 0) {
+                WorkerCount = 1;
+            }
+
+            m_Workers.reserve(WorkerCount);
+
+            try {
+                for (unsigned i = 0; i < WorkerCount; ++i) {
+                    m_Workers.emplace_back(&OtpVerifyExecutor::WorkerMain, this);
+                }
+            } catch (...) {
+                Stop();
+                throw;
+            }
+        }
+
+        OtpVerifyExecutor(const OtpVerifyExecutor& Other) = delete;
+
+        OtpVerifyExecutor& operator=(const OtpVerifyExecutor& Other) = delete;
+
+        //
+        // queues Request to be completed with lpfnCallback(lpContext, Result), or returns false at once if
+        // the queue is full.
+        //
+        [[nodiscard]]
+        bool TrySubmit(const RequestType& Request, CallbackType lpfnCallback, void* lpContext) {
+            if (m_Queue.TryPush(Item{ Request, lpfnCallback, lpContext }) == false) {
+                return false;
+            }
+
+            WakeWorker();
+            return true;
+        }
+
+        //
+        // same as TrySubmit, but waits for room instead of failing.
+        //
+        void Submit(const RequestType& Request, CallbackType lpfnCallback, void* lpContext) {
+            while (m_Queue.TryPush(Item{ Request, lpfnCallback, lpContext }) == false) {
+                std::unique_lock<std::mutex> Lock(m_WaitLock);
+
+                m_BlockedProducerCount.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                m_SpaceAvailable.wait(Lock, [this]() {
+                    return m_Queue.GetSize() < m_Queue.GetCapacity();
+                });
+
+                m_BlockedProducerCount.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            WakeWorker();
+        }
+
+        //
+        // waits for room like Submit. The future costs one heap allocation per request; callbacks do not.
+        //
+        [[nodiscard]]
+        std::future<ResultType> Submit(const RequestType& Request) {
+            auto lpPromise = std::make_unique<std::promise<ResultType>>();
+            std::future<ResultType> Future = lpPromise->get_future();
+
+            Submit(
+                Request,
+                [](void* lpContext, const ResultType& Result) {
+                    std::unique_ptr<std::promise<ResultType>> lpPromise(static_cast<std::promise<ResultType>*>(lpContext));
+                    lpPromise->set_value(Result);
+                },
+                lpPromise.get()
+            );
+
+            static_cast<void>(lpPromise.release());
+            return Future;
+        }
+
+        [[nodiscard]]
+        OtpTypeSize GetWorkerCount() const noexcept {
+            return m_Workers.size();
+        }
+
+        [[nodiscard]]
+        OtpTypeSize GetQueueCapacity() const noexcept {
+            return m_Queue.GetCapacity();
+        }
+
+        //
+        // requests queued and not yet taken by a worker.
+        //
+        [[nodiscard]]
+        OtpTypeSize GetPendingCount() const noexcept {
+            return m_Queue.GetSize();
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetCompletedCount() const noexcept {
+            return m_CompletedCount.load(std::memory_order_relaxed);
+        }
+
+        //
+        // GetCompletedCount() / GetBatchCount() is the mean batch size so far.
+        //
+        [[nodiscard]]
+        OtpTypeUInt64 GetBatchCount() const noexcept {
+            return m_BatchCount.load(std::memory_order_relaxed);
+        }
+
+        ~OtpVerifyExecutor() {
+            Stop();
+        }
+    };
+
+}
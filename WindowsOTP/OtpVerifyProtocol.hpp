@@ -0,0 +1,116 @@
+#pragma once
+#include "OtpType.hpp"
+#include "OtpSerialization.hpp"
+#include "OtpCredentialStore.hpp"
+
+#include <stdexcept>
+
+namespace WinOTP {
+
+    //
+    // Binary request/response protocol of the verification daemon (WindowsOTPDaemon).
+    //
+    // Both directions are streams of fixed-size little-endian frames, so a reader never needs a length
+    // prefix and a client may write any number of requests before reading (pipelining). The server answers
+    // the requests of one connection in order; the tag is echoed anyway so clients can match responses to
+    // requests without counting.
+    //
+    //     request, 32 bytes                       response, 16 bytes
+    //      0  u64  tag                             0  u64  tag
+    //      8  u64  user ID                         8  i32  offset (counter offset or drift when accepted)
+    //     16  u64  HOTP counter / TOTP Unix time  12  u8   status
+    //     24  u32  code                           13  u8   reserved, 0
+    //     28  u8   kind: 0 HOTP, 1 TOTP           14  u16  reserved, 0
+    //     29  u8   TOTP steps behind
+    //     30  u8   steps ahead (HOTP look-ahead)
+    //     31  u8   reserved, 0
+    //
+    inline constexpr OtpTypeSize OtpVerifyProtocolRequestSize = 32;
+    inline constexpr OtpTypeSize OtpVerifyProtocolResponseSize = 16;
+
+    //
+    // the first four match OtpCredentialStore::VerifyStatus.
+    //
+    enum class OtpVerifyProtocolStatus : OtpTypeUInt8 {
+        Accepted,
+        Rejected,
+        UnknownUser,
+        NotTotp,
+        Malformed       // the request frame could not be decoded
+    };
+
+    static_assert(static_cast<int>(OtpVerifyProtocolStatus::NotTotp) == static_cast<int>(OtpCredentialStore::VerifyStatus::NotTotp));
+
+    struct OtpVerifyProtocolResponse {
+        OtpTypeUInt64           Tag;
+        OtpVerifyProtocolStatus Status;
+        OtpTypeInt64            Offset;
+    };
+
+    //
+    // writes OtpVerifyProtocolRequestSize bytes. Throws std::invalid_argument if a window exceeds 255 steps.
+    //
+    inline void OtpVerifyProtocolEncodeRequest(OtpTypeUInt64 Tag, const OtpCredentialStore::VerifyRequest& Request, OtpTypeByte* lpFrame) {
+        if (Request.StepsBehind > 0xFF || Request.StepsAhead > 0xFF) {
+            throw std::invalid_argument("Verification window is too large for the protocol.");
+        }
+
+        OtpSerializationIntegerToBytes<OtpSerializationEndian::Little>(Tag, lpFrame);
+        OtpSerializationIntegerToBytes<OtpSerializationEndian::Little>(Request.UserId, lpFrame + 8);
+        OtpSerializationIntegerToBytes<OtpSerializationEndian::Little>(Request.CounterOrTime, lpFrame + 16);
+        OtpSerializationIntegerToBytes<OtpSerializationEndian::Little>(Request.Code, lpFrame + 24);
+        lpFrame[28] = Request.IsTotp ? 1 : 0;
+        lpFrame[29] = static_cast<OtpTypeByte>(Request.StepsBehind);
+        lpFrame[30] = static_cast<OtpTypeByte>(Request.StepsAhead);
+        lpFrame[31] = 0;
+    }
+
+    //
+    // reads OtpVerifyProtocolRequestSize bytes. Returns false for a malformed frame; Tag is still decoded.
+    //
+    [[nodiscard]]
+    inline bool OtpVerifyProtocolDecodeRequest(const OtpTypeByte* lpFrame, OtpTypeUInt64& Tag, OtpCredentialStore::VerifyRequest& Request) noexcept {
+        Tag = OtpSerializationBytesToInteger<OtpSerializationEndian::Little, OtpTypeUInt64>(lpFrame);
+
+        if (lpFrame[28] > 1 || lpFrame[31] != 0) {
+            return false;
+        }
+
+        Request.UserId = OtpSerializationBytesToInteger<OtpSerializationEndian::Little, OtpTypeUInt64>(lpFrame + 8);
+        Request.CounterOrTime = OtpSerializationBytesToInteger<OtpSerializationEndian::Little, OtpTypeUInt64>(lpFrame + 16);
+        Request.Code = OtpSerializationBytesToInteger<OtpSerializationEndian::Little, OtpTypeUInt32>(lpFrame + 24);
+        Request.IsTotp = lpFrame[28] == 1;
+        Request.StepsBehind = Request.IsTotp ? lpFrame[29] : 0;
+        Request.StepsAhead = lpFrame[30];
+        return true;
+    }
+
+    //
+    // writes OtpVerifyProtocolResponseSize bytes.
+    //
+    inline void OtpVerifyProtocolEncodeResponse(OtpTypeUInt64 Tag, OtpVerifyProtocolStatus Status, OtpTypeInt64 Offset, OtpTypeByte* lpFrame) noexcept {
+        OtpSerializationIntegerToBytes<OtpSerializationEndian::Little>(Tag, lpFrame);
+        OtpSerializationIntegerToBytes<OtpSerializationEndian::Little>(static_cast<OtpTypeUInt32>(static_cast<int32_t>(Offset)), lpFrame + 8);
+        lpFrame[12] = static_cast<OtpTypeByte>(Status);
+        lpFrame[13] = 0;
+        lpFrame[14] = 0;
+        lpFrame[15] = 0;
+    }
+
+    inline void OtpVerifyProtocolEncodeResponse(OtpTypeUInt64 Tag, const OtpCredentialStore::VerifyResult& Result, OtpTypeByte* lpFrame) noexcept {
+        OtpVerifyProtocolEncodeResponse(Tag, static_cast<OtpVerifyProtocolStatus>(Result.Status), Result.Offset, lpFrame);
+    }
+
+    //
+    // reads OtpVerifyProtocolResponseSize bytes.
+    //
+    [[nodiscard]]
+    inline OtpVerifyProtocolResponse OtpVerifyProtocolDecodeResponse(const OtpTypeByte* lpFrame) noexcept {
+        return OtpVerifyProtocolResponse{
+            OtpSerializationBytesToInteger<OtpSerializationEndian::Little, OtpTypeUInt64>(lpFrame),
+            static_cast<OtpVerifyProtocolStatus>(lpFrame[12]),
+            static_cast<int32_t>(OtpSerializationBytesToInteger<OtpSerializationEndian::Little, OtpTypeUInt32>(lpFrame + 8))
+        };
+    }
+
+}
@@ -1,6 +1,17 @@
 #pragma once
+#include "OtpClock.hpp"
 #include "OtpGeneratorRfc4226.hpp"
 #include "OtpGeneratorRfc6238.hpp"
+#include "OtpGenerator.hpp"
+#include "OtpTotpCodeCache.hpp"
+#include "OtpCredentialStore.hpp"
+#include "OtpReplayTable.hpp"
+#include "OtpThrottleTable.hpp"
+#include "OtpVerifyExecutor.hpp"
+#include "OtpVerifyProtocol.hpp"
+#include "OtpAuthUri.hpp"
+#include "OtpInstrumentation.hpp"
+#include "OtpCredentialImport.hpp"
 
 namespace WinOTP {
     using HOTP = OtpGeneratorRfc4226;
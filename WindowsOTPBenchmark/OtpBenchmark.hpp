@@ -0,0 +1,166 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace WinOTP::Benchmark {
+
+    //
+    // sink that keeps results alive without letting the optimizer drop the benchmarked call.
+    //
+    inline volatile uint64_t OtpBenchmarkSink = 0;
+
+    template<typename __Type>
+    inline void OtpBenchmarkConsume(const __Type& Value) noexcept {
+        OtpBenchmarkSink = OtpBenchmarkSink + static_cast<uint64_t>(Value);
+    }
+
+    //
+    // heap allocations so far. The host program counts them in its replacement operator new; without one it
+    // stays 0 and every benchmark reports 0 allocations/op.
+    //
+    inline std::atomic<uint64_t> OtpBenchmarkAllocationCount(0);
+
+    //
+    // CSV copy of every result, open once OtpBenchmarkOpenReport succeeded.
+    //
+    inline std::ofstream OtpBenchmarkReportFile;
+
+    struct OtpBenchmarkResult {
+        std::string Name;
+        uint64_t    Iterations;
+        uint64_t    ItemsPerOp;
+        double      NanosecondsPerOp;
+        double      AllocationsPerOp;
+    };
+
+    //
+    // starts a CSV report at lpszPath, one row per benchmark, so that runs of two builds can be compared
+    // mechanically. Returns false if the file cannot be written.
+    //
+    inline bool OtpBenchmarkOpenReport(const char* lpszPath) {
+        OtpBenchmarkReportFile.open(lpszPath, std::ios::binary | std::ios::trunc);
+        OtpBenchmarkReportFile << "name,iterations,items_per_op,ns_per_op,ops_per_s,items_per_s,allocations_per_op\n";
+        OtpBenchmarkReportFile.flush();
+        return OtpBenchmarkReportFile.good();
+    }
+
+    inline void OtpBenchmarkReport(const OtpBenchmarkResult& Result) {
+        double OpsPerSecond = 1e9 / Result.NanosecondsPerOp;
+        double ItemsPerSecond = OpsPerSecond * static_cast<double>(Result.ItemsPerOp);
+
+        printf(
+            "%-48s %12.1f ns/op %14.0f ops/s %14.0f items/s %8.2f allocs/op\n",
+            Result.Name.c_str(),
+            Result.NanosecondsPerOp,
+            OpsPerSecond,
+            ItemsPerSecond,
+            Result.AllocationsPerOp
+        );
+
+        if (OtpBenchmarkReportFile.is_open()) {
+            char Row[256];
+            snprintf(
+                Row,
+                sizeof(Row),
+                ",%llu,%llu,%.3f,%.1f,%.1f,%.4f\n",
+                static_cast<unsigned long long>(Result.Iterations),
+                static_cast<unsigned long long>(Result.ItemsPerOp),
+                Result.NanosecondsPerOp,
+                OpsPerSecond,
+                ItemsPerSecond,
+                Result.AllocationsPerOp
+            );
+
+            OtpBenchmarkReportFile << '"' << Result.Name << '"' << Row;
+            OtpBenchmarkReportFile.flush();
+        }
+    }
+
+    //
+    // runs Routine(i) for i in [0, Iterations) after a short warm-up and reports the mean cost and heap
+    // allocations per call. When one call processes several items (codes, bytes...), ItemsPerOp scales the
+    // reported throughput.
+    //
+    template<typename __RoutineType>
+    OtpBenchmarkResult OtpBenchmarkRun(std::string Name, uint64_t Iterations, __RoutineType&& Routine, uint64_t ItemsPerOp = 1) {
+        for (uint64_t i = 0; i < Iterations / 16 + 1; ++i) {
+            Routine(i);
+        }
+
+        uint64_t AllocationsBefore = OtpBenchmarkAllocationCount.load(std::memory_order_relaxed);
+        auto Start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < Iterations; ++i) {
+            Routine(i);
+        }
+        auto Stop = std::chrono::steady_clock::now();
+        uint64_t Allocations = OtpBenchmarkAllocationCount.load(std::memory_order_relaxed) - AllocationsBefore;
+
+        OtpBenchmarkResult Result;
+        Result.Name = std::move(Name);
+        Result.Iterations = Iterations;
+        Result.ItemsPerOp = ItemsPerOp;
+        Result.NanosecondsPerOp = std::chrono::duration<double, std::nano>(Stop - Start).count() / static_cast<double>(Iterations);
+        Result.AllocationsPerOp = static_cast<double>(Allocations) / static_cast<double>(Iterations);
+
+        OtpBenchmarkReport(Result);
+        return Result;
+    }
+
+    //
+    // runs Routine(ThreadIndex, i) for i in [0, IterationsPerThread) on ThreadCount threads released together,
+    // and reports the aggregate throughput. NanosecondsPerOp and AllocationsPerOp are divided by the total call count.
+    //
+    template<typename __RoutineType>
+    OtpBenchmarkResult OtpBenchmarkRunThreads(std::string Name, unsigned ThreadCount, uint64_t IterationsPerThread, __RoutineType&& Routine, uint64_t ItemsPerOp = 1) {
+        std::atomic<unsigned> Ready(0);
+        std::atomic<bool> Go(false);
+        std::vector<std::thread> Threads;
+
+        for (unsigned t = 0; t < ThreadCount; ++t) {
+            Threads.emplace_back([&, t]() {
+                for (uint64_t i = 0; i < IterationsPerThread / 16 + 1; ++i) {
+                    Routine(t, i);
+                }
+
+                Ready.fetch_add(1);
+                while (Go.load() == false) {
+                    std::this_thread::yield();
+                }
+
+                for (uint64_t i = 0; i < IterationsPerThread; ++i) {
+                    Routine(t, i);
+                }
+            });
+        }
+
+        while (Ready.load() != ThreadCount) {
+            std::this_thread::yield();
+        }
+
+        uint64_t AllocationsBefore = OtpBenchmarkAllocationCount.load(std::memory_order_relaxed);
+        auto Start = std::chrono::steady_clock::now();
+        Go.store(true);
+        for (auto& Thread : Threads) {
+            Thread.join();
+        }
+        auto Stop = std::chrono::steady_clock::now();
+        uint64_t Allocations = OtpBenchmarkAllocationCount.load(std::memory_order_relaxed) - AllocationsBefore;
+
+        OtpBenchmarkResult Result;
+        Result.Name = std::move(Name);
+        Result.Iterations = IterationsPerThread * ThreadCount;
+        Result.ItemsPerOp = ItemsPerOp;
+        Result.NanosecondsPerOp = std::chrono::duration<double, std::nano>(Stop - Start).count() / static_cast<double>(Result.Iterations);
+        Result.AllocationsPerOp = static_cast<double>(Allocations) / static_cast<double>(Result.Iterations);
+
+        OtpBenchmarkReport(Result);
+        return Result;
+    }
+
+}
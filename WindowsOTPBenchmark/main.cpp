@@ -0,0 +1,2221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <WinOTP.hpp>
+#include "OtpBenchmark.hpp"
+
+using namespace WinOTP;
+using namespace WinOTP::Benchmark;
+
+//
+// every heap allocation in the process goes through these, so a check can assert that a call allocated nothing
+// and every benchmark reports its allocations per call.
+// The nothrow and array forms forward here by default; the library uses the aligned forms only to build
+// its lock-free tables and queues, never on a verification path.
+// GCC flags malloc/free pairing once these are inlined into the standard containers, so keep them out of line.
+//
+#if defined(__GNUC__)
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#else
+#define BENCHMARK_NOINLINE __declspec(noinline)
+#endif
+
+BENCHMARK_NOINLINE void* operator new(size_t cbSize) {
+    OtpBenchmarkAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* p = malloc(cbSize == 0 ? 1 : cbSize)) {
+        return p;
+    } else {
+        throw std::bad_alloc();
+    }
+}
+
+BENCHMARK_NOINLINE void operator delete(void* p) noexcept {
+    free(p);
+}
+
+BENCHMARK_NOINLINE void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static const char* HashModeName(OtpHashMode HashMode) {
+    switch (HashMode) {
+        case OtpHashMode::Sha1:
+            return "SHA1";
+        case OtpHashMode::Sha256:
+            return "SHA256";
+        case OtpHashMode::Sha384:
+            return "SHA384";
+        case OtpHashMode::Sha512:
+            return "SHA512";
+        default:
+            return "?";
+    }
+}
+
+static const char* HashBackendName(OtpHashBackend HashBackend) {
+    switch (HashBackend) {
+        case OtpHashBackend::Portable:
+            return "Portable";
+        case OtpHashBackend::Cng:
+            return "Cng";
+        default:
+            return "?";
+    }
+}
+
+static std::vector<OtpHashBackend> AvailableBackends() {
+#if WINOTP_PLATFORM_WINDOWS
+    return { OtpHashBackend::Portable, OtpHashBackend::Cng };
+#else
+    return { OtpHashBackend::Portable };
+#endif
+}
+
+//
+// RFC 4226 Appendix D and RFC 6238 Appendix B.
+// Benchmark numbers are meaningless if the backend under test produces wrong codes.
+//
+static bool CheckRfcTestVectors(OtpHashBackend HashBackend) {
+    static const char SecretSha1[] = "12345678901234567890";
+    static const char SecretSha256[] = "12345678901234567890123456789012";
+    static const char SecretSha512[] = "1234567890123456789012345678901234567890123456789012345678901234";
+
+    static const OtpTypeUInt32 HotpCodes[] = {
+        755224, 287082, 359152, 969429, 338314, 254676, 287922, 162583, 399871, 520489
+    };
+
+    static const struct {
+        OtpTypeUInt64 Time;
+        OtpTypeUInt32 Sha1;
+        OtpTypeUInt32 Sha256;
+        OtpTypeUInt32 Sha512;
+    } TotpCodes[] = {
+        { 59,           94287082, 46119246, 90693936 },
+        { 1111111109,   7081804,  68084774, 25091201 },
+        { 1111111111,   14050471, 67062674, 99943326 },
+        { 1234567890,   89005924, 91819424, 93441116 },
+        { 2000000000,   69279037, 90698825, 38618901 },
+        { 20000000000,  65353130, 77737706, 47863826 }
+    };
+
+    bool Passed = true;
+
+    OtpGeneratorRfc4226 Hotp(OtpHashMode::Sha1, 6, HashBackend);
+    Hotp.ImportSecretRaw(SecretSha1, sizeof(SecretSha1) - 1);
+    for (OtpTypeUInt64 i = 0; i < sizeof(HotpCodes) / sizeof(HotpCodes[0]); ++i) {
+        if (Hotp.GenerateCode(i) != HotpCodes[i]) {
+            printf("[%s] RFC 4226 mismatch at counter %llu\n", HashBackendName(HashBackend), static_cast<unsigned long long>(i));
+            Passed = false;
+        }
+    }
+
+    OtpGeneratorRfc6238 TotpSha1(OtpHashMode::Sha1, 8, 30, HashBackend);
+    OtpGeneratorRfc6238 TotpSha256(OtpHashMode::Sha256, 8, 30, HashBackend);
+    OtpGeneratorRfc6238 TotpSha512(OtpHashMode::Sha512, 8, 30, HashBackend);
+    TotpSha1.ImportSecretRaw(SecretSha1, sizeof(SecretSha1) - 1);
+    TotpSha256.ImportSecretRaw(SecretSha256, sizeof(SecretSha256) - 1);
+    TotpSha512.ImportSecretRaw(SecretSha512, sizeof(SecretSha512) - 1);
+    for (const auto& Vector : TotpCodes) {
+        if (TotpSha1.GenerateCode(Vector.Time) != Vector.Sha1 ||
+            TotpSha256.GenerateCode(Vector.Time) != Vector.Sha256 ||
+            TotpSha512.GenerateCode(Vector.Time) != Vector.Sha512)
+        {
+            printf("[%s] RFC 6238 mismatch at time %llu\n", HashBackendName(HashBackend), static_cast<unsigned long long>(Vector.Time));
+            Passed = false;
+        }
+    }
+
+    // the compile-time generators have no backend choice; checking them once per backend is harmless.
+    OtpGeneratorHotp<OtpHashMode::Sha1, 6> StaticHotp;
+    StaticHotp.ImportSecretRaw(SecretSha1, sizeof(SecretSha1) - 1);
+    for (OtpTypeUInt64 i = 0; i < sizeof(HotpCodes) / sizeof(HotpCodes[0]); ++i) {
+        if (StaticHotp.GenerateCode(i) != HotpCodes[i]) {
+            printf("[Static] RFC 4226 mismatch at counter %llu\n", static_cast<unsigned long long>(i));
+            Passed = false;
+        }
+    }
+
+    OtpGeneratorTotp<OtpHashMode::Sha1, 8, 30> StaticTotpSha1;
+    OtpGeneratorTotp<OtpHashMode::Sha256, 8, 30> StaticTotpSha256;
+    OtpGeneratorTotp<OtpHashMode::Sha512, 8, 30> StaticTotpSha512;
+    StaticTotpSha1.ImportSecretRaw(SecretSha1, sizeof(SecretSha1) - 1);
+    StaticTotpSha256.ImportSecretRaw(SecretSha256, sizeof(SecretSha256) - 1);
+    StaticTotpSha512.ImportSecretRaw(SecretSha512, sizeof(SecretSha512) - 1);
+    for (const auto& Vector : TotpCodes) {
+        if (StaticTotpSha1.GenerateCode(Vector.Time) != Vector.Sha1 ||
+            StaticTotpSha256.GenerateCode(Vector.Time) != Vector.Sha256 ||
+            StaticTotpSha512.GenerateCode(Vector.Time) != Vector.Sha512)
+        {
+            printf("[Static] RFC 6238 mismatch at time %llu\n", static_cast<unsigned long long>(Vector.Time));
+            Passed = false;
+        }
+    }
+
+    return Passed;
+}
+
+//
+// the portable SHA-1 and SHA-256 compressions against the FIPS 180 "abc" digests, then, where the CPU has
+// SHA instructions, against those on a chain of random blocks. The RFC vectors only reach whichever of the
+// two the dispatcher picks, so without this a broken portable path passes on SHA-NI hosts.
+//
+static bool CheckShaTransform() {
+    static const OtpTypeUInt32 DigestSha1[] = { 0xa9993e36, 0x4706816a, 0xba3e2571, 0x7850c26c, 0x9cd0d89d };
+    static const OtpTypeUInt32 DigestSha256[] = { 0xba7816bf, 0x8f01cfea, 0x414140de, 0x5dae2223, 0xb00361a3, 0x96177a9c, 0xb410ff61, 0xf20015ad };
+
+    bool Passed = true;
+
+    alignas(16) OtpTypeByte Block[64] = { 'a', 'b', 'c', 0x80 };
+    Block[63] = 24;
+
+    Internal::OtpHashTraitsSha1::StateType StateSha1 = Internal::OtpHashTraitsSha1::InitialState;
+    Internal::OtpHashTraitsSha256::StateType StateSha256 = Internal::OtpHashTraitsSha256::InitialState;
+    Internal::OtpHashTraitsSha1::TransformGeneric(StateSha1, Block);
+    Internal::OtpHashTraitsSha256::TransformGeneric(StateSha256, Block);
+
+    if (std::equal(std::begin(DigestSha1), std::end(DigestSha1), StateSha1.begin()) == false ||
+        std::equal(std::begin(DigestSha256), std::end(DigestSha256), StateSha256.begin()) == false)
+    {
+        printf("Transform/Generic: SHA-1 or SHA-256 of \"abc\" is wrong\n");
+        Passed = false;
+    }
+
+#if WINOTP_SHA_EXTENSIONS
+    if (Internal::OtpShaExtensionsAvailable()) {
+        Internal::OtpHashTraitsSha1::StateType ExtensionStateSha1 = StateSha1;
+        Internal::OtpHashTraitsSha256::StateType ExtensionStateSha256 = StateSha256;
+
+        for (OtpTypeUInt64 i = 0; i < 1000 && Passed; ++i) {
+            for (OtpTypeSize j = 0; j < sizeof(Block); ++j) {
+                Block[j] = static_cast<OtpTypeByte>(Internal::OtpSplitMix64(i * sizeof(Block) + j));
+            }
+
+            Internal::OtpHashTraitsSha1::TransformGeneric(StateSha1, Block);
+            Internal::OtpHashTraitsSha256::TransformGeneric(StateSha256, Block);
+            Internal::OtpSha1TransformShaExtensions(ExtensionStateSha1.data(), Block);
+            Internal::OtpSha256TransformShaExtensions(ExtensionStateSha256.data(), Block, Internal::OtpHashTraitsSha256::RoundConstants);
+
+            if (StateSha1 != ExtensionStateSha1 || StateSha256 != ExtensionStateSha256) {
+                printf("Transform/ShaExtensions: differs from the portable compression at block %llu\n", static_cast<unsigned long long>(i));
+                Passed = false;
+            }
+        }
+    }
+#endif
+
+    return Passed;
+}
+
+//
+// GenerateCodes against GenerateCode for every hash mode. Runs of 0 to 40 counters from random starts leave
+// partial lane groups at both ends, so every hand-off from one multi-buffer kernel to the next narrower one
+// and to the scalar loop is compared, as are the modes that have no kernel.
+//
+static bool CheckBatchGeneration(OtpHashBackend HashBackend) {
+    static const OtpHashMode HashModes[] = { OtpHashMode::Sha1, OtpHashMode::Sha256, OtpHashMode::Sha384, OtpHashMode::Sha512 };
+
+    bool Passed = true;
+
+    for (auto HashMode : HashModes) {
+        OtpGeneratorRfc4226 Hotp(HashMode, 8, HashBackend);
+        Hotp.ImportSecretRaw("1234567890123456789012345678901234567890", 40);
+
+        for (OtpTypeSize Count = 0; Count <= 40; ++Count) {
+            OtpTypeUInt64 FirstCounter = Internal::OtpSplitMix64(Count) >> 1;
+            OtpTypeUInt32 Codes[40];
+
+            Hotp.GenerateCodes(FirstCounter, Count, Codes);
+
+            for (OtpTypeSize i = 0; i < Count; ++i) {
+                if (Codes[i] != Hotp.GenerateCode(FirstCounter + i)) {
+                    printf("[%s] %s GenerateCodes mismatch at %zu of %zu\n", HashBackendName(HashBackend), HashModeName(HashMode), i, Count);
+                    Passed = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    return Passed;
+}
+
+#if WINOTP_SIMD_X86
+//
+// one multi-buffer kernel against the scalar HMAC, lane by lane: keys of every length up to two blocks, so
+// both the padded and the pre-hashed key schedules feed it, and random counters, so every counter byte
+// reaches the message block.
+//
+template<typename __HashTraits>
+static bool CheckMultiBufferKernel(const char* lpszName, OtpTypeSize Lanes, void (*lpfnHmac)(const Internal::OtpHmacKeyState<__HashTraits>&, const OtpTypeUInt64*, OtpTypeUInt32*) noexcept) {
+    using HmacType = Internal::OtpHmac<__HashTraits>;
+    constexpr OtpTypeSize DigestWords = HmacType::DigestSize / sizeof(OtpTypeUInt32);
+
+    OtpTypeUInt64 Seed = 0;
+
+    for (OtpTypeSize cbKey = 0; cbKey <= 2 * __HashTraits::BlockSize; ++cbKey) {
+        OtpTypeByte Key[2 * __HashTraits::BlockSize];
+        for (OtpTypeSize i = 0; i < cbKey; ++i) {
+            Key[i] = static_cast<OtpTypeByte>(Internal::OtpSplitMix64(++Seed));
+        }
+
+        Internal::OtpHmacKeyState<__HashTraits> KeyState;
+        HmacType::PrepareKeyState(Key, cbKey, KeyState);
+
+        OtpTypeUInt64 Counters[Internal::OtpHmacMultiBufferMaxLanes];
+        OtpTypeUInt32 DigestWordsSoA[DigestWords * Internal::OtpHmacMultiBufferMaxLanes];
+
+        for (OtpTypeSize Lane = 0; Lane < Lanes; ++Lane) {
+            Counters[Lane] = cbKey % 2 == 0 ? cbKey + Lane : Internal::OtpSplitMix64(++Seed);
+        }
+
+        lpfnHmac(KeyState, Counters, DigestWordsSoA);
+
+        for (OtpTypeSize Lane = 0; Lane < Lanes; ++Lane) {
+            OtpTypeByte CounterBytes[sizeof(OtpTypeUInt64)];
+            OtpTypeByte Digest[HmacType::DigestSize];
+
+            Internal::OtpStoreBigEndian<OtpTypeUInt64>(Counters[Lane], CounterBytes);
+            HmacType::Compute(KeyState, CounterBytes, sizeof(CounterBytes), Digest);
+
+            for (OtpTypeSize Word = 0; Word < DigestWords; ++Word) {
+                if (DigestWordsSoA[Word * Lanes + Lane] != Internal::OtpLoadBigEndian<OtpTypeUInt32>(Digest + Word * sizeof(OtpTypeUInt32))) {
+                    printf("MultiBuffer/%s: lane %zu differs from the scalar HMAC for a %zu-byte key\n", lpszName, Lane, cbKey);
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+//
+// every kernel this CPU can run, not just the widest one GenerateCodes dispatches to. The SSE2 kernels are
+// left out of the list where SHA-NI is faster, so they are checked directly.
+//
+static bool CheckMultiBufferKernels() {
+    bool Passed = true;
+
+    if (Internal::OtpCpuFeaturesGet().Sse2 && Internal::OtpShaExtensionsAvailable()) {
+        if (CheckMultiBufferKernel<Internal::OtpHashTraitsSha1>("SHA1/SSE2", Internal::OtpSimdU32x4::Lanes, Internal::OtpHmacMultiBufferSse2::HmacCounters<Internal::OtpHashTraitsSha1>) == false ||
+            CheckMultiBufferKernel<Internal::OtpHashTraitsSha256>("SHA256/SSE2", Internal::OtpSimdU32x4::Lanes, Internal::OtpHmacMultiBufferSse2::HmacCounters<Internal::OtpHashTraitsSha256>) == false)
+        {
+            Passed = false;
+        }
+    }
+
+    const auto& KernelList = Internal::OtpHmacMultiBufferKernels();
+    for (OtpTypeSize k = 0; k < KernelList.Count; ++k) {
+        const auto& Kernel = KernelList.Kernels[k];
+
+        if (CheckMultiBufferKernel<Internal::OtpHashTraitsSha1>((std::string("SHA1/") + Kernel.Name).c_str(), Kernel.Lanes, Kernel.HmacSha1) == false ||
+            CheckMultiBufferKernel<Internal::OtpHashTraitsSha256>((std::string("SHA256/") + Kernel.Name).c_str(), Kernel.Lanes, Kernel.HmacSha256) == false)
+        {
+            Passed = false;
+        }
+    }
+
+    return Passed;
+}
+#endif
+
+//
+// decoded bytes, or nothing if Decode rejected the input.
+//
+template<typename __DecodeType>
+static std::optional<OtpByteArray> TryDecode(OtpTypeSize cbBytes, __DecodeType&& Decode) {
+    OtpByteArray Bytes(cbBytes);
+
+    try {
+        Bytes.resize(Decode(Bytes.data()));
+        return Bytes;
+    } catch (const std::invalid_argument&) {
+        return std::nullopt;
+    }
+}
+
+//
+// random bytes encoded and decoded by the dispatched (SIMD) codec and the portable one, then the same text
+// with one character replaced by any 8-bit value or cut short. Lengths run past several vector blocks and
+// through every residue, so each tail and each error path of the two is compared.
+//
+template<typename __EncodedLengthType, typename __EncodeType, typename __DecodeType>
+static bool CheckCodecAgainstScalar(const char* lpszName, __EncodedLengthType&& EncodedLength, __EncodeType&& Encode, __DecodeType&& Decode) {
+    OtpTypeUInt64 Seed = 0;
+
+    for (OtpTypeSize cbBytes = 0; cbBytes < 200; ++cbBytes) {
+        for (OtpTypeSize Round = 0; Round < 16; ++Round) {
+            OtpByteArray Bytes(cbBytes);
+            for (auto& Byte : Bytes) {
+                Byte = static_cast<OtpTypeByte>(Internal::OtpSplitMix64(++Seed));
+            }
+
+            std::string Text(EncodedLength(cbBytes), '\0');
+            std::string TextScalar(Text.size(), '\0');
+            Encode(Bytes.data(), cbBytes, Text.data(), false);
+            Encode(Bytes.data(), cbBytes, TextScalar.data(), true);
+
+            if (Text != TextScalar || Decode(Text, false) != Bytes) {
+                printf("%s: %zu random bytes do not round-trip like the scalar codec\n", lpszName, cbBytes);
+                return false;
+            }
+
+            OtpTypeUInt64 Random = Internal::OtpSplitMix64(++Seed);
+
+            if (Text.empty() == false) {
+                if (Round % 4 == 3) {
+                    Text.resize(Random % Text.size());
+                } else {
+                    Text[Random % Text.size()] = static_cast<char>(Random >> 32);
+                }
+            }
+
+            if (Decode(Text, false) != Decode(Text, true)) {
+                printf("%s: \"%s\" is decoded differently from the scalar codec\n", lpszName, Text.c_str());
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//
+// RFC 4648 section 10, the decoder that used to append the zero fill of inputs of 2 (mod 5) bytes as a
+// spurious last byte, and the dispatched codec against the scalar one.
+//
+static bool CheckBase32Codec() {
+    static const struct {
+        const char* lpszBytes;
+        const char* lpszBase32;
+    } Vectors[] = {
+        { "", "" }, { "f", "MY======" }, { "fo", "MZXQ====" }, { "foo", "MZXW6===" },
+        { "foob", "MZXW6YQ=" }, { "fooba", "MZXW6YTB" }, { "foobar", "MZXW6YTBOI======" }
+    };
+
+    bool Passed = true;
+
+    for (const auto& Vector : Vectors) {
+        OtpByteArray Bytes(Vector.lpszBytes, Vector.lpszBytes + strlen(Vector.lpszBytes));
+
+        if (OtpBase32EncodeA(Bytes) != Vector.lpszBase32 || OtpBase32DecodeA(Vector.lpszBase32) != Bytes) {
+            printf("Base32: RFC 4648 mismatch for \"%s\"\n", Vector.lpszBytes);
+            Passed = false;
+        }
+    }
+
+    if (OtpBase32DecodeA("MZXQ").size() != 2 || OtpBase32DecodeA("GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQMZXQ").size() != 22) {
+        printf("Base32: 2 (mod 5) byte input decodes with a spurious trailing byte\n");
+        Passed = false;
+    }
+
+    auto Encode = [](const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, char* lpszBase32, bool Scalar) {
+        if (Scalar) {
+            Internal::OtpBase32EncodeScalar(lpBytes, cbBytes, lpszBase32);
+        } else {
+            Internal::OtpBase32Encode(lpBytes, cbBytes, lpszBase32);
+        }
+    };
+
+    auto Decode = [](const std::string& Text, bool Scalar) {
+        return TryDecode(Internal::OtpBase32DecodedMaxLength(Text.size()), [&](OtpTypeByte* lpBytes) {
+            if (Scalar) {
+                return Internal::OtpBase32DecodeScalar(Text.data(), Text.size(), lpBytes);
+            } else {
+                return Internal::OtpBase32Decode(Text.data(), Text.size(), lpBytes);
+            }
+        });
+    };
+
+    return CheckCodecAgainstScalar("Base32", Internal::OtpBase32EncodedLength, Encode, Decode) && Passed;
+}
+
+//
+// RFC 4648 section 10, the padding and alphabet rules of each mode, and the dispatched codec against the
+// scalar one for both alphabets in both modes.
+//
+static bool CheckBase64Codec() {
+    static const struct {
+        const char* lpszBytes;
+        const char* lpszBase64;
+    } Vectors[] = {
+        { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+        { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" }
+    };
+
+    static const struct {
+        const char*         lpszBase64;
+        OtpBase64Alphabet   Alphabet;
+        OtpBase64Mode       Mode;
+        bool                Accepted;
+    } Rules[] = {
+        { "Zm8=",   OtpBase64Alphabet::Standard,    OtpBase64Mode::Strict,  true },
+        { "Zm8",    OtpBase64Alphabet::Standard,    OtpBase64Mode::Strict,  false },     // padding required
+        { "Zm8",    OtpBase64Alphabet::Standard,    OtpBase64Mode::Lenient, true },
+        { "Zm8",    OtpBase64Alphabet::Url,         OtpBase64Mode::Strict,  true },      // padding optional
+        { "Zm8=",   OtpBase64Alphabet::Url,         OtpBase64Mode::Strict,  true },
+        { "Zm8==",  OtpBase64Alphabet::Url,         OtpBase64Mode::Strict,  false },     // but right when present
+        { "Zm9=",   OtpBase64Alphabet::Standard,    OtpBase64Mode::Strict,  false },     // non-zero trailing bits
+        { "Zm9=",   OtpBase64Alphabet::Standard,    OtpBase64Mode::Lenient, true },
+        { "Z===",   OtpBase64Alphabet::Standard,    OtpBase64Mode::Strict,  false },     // 6 bits are no byte
+        { "Zm=8",   OtpBase64Alphabet::Standard,    OtpBase64Mode::Lenient, false },     // data after padding
+        { "-_+/",   OtpBase64Alphabet::Standard,    OtpBase64Mode::Lenient, true },      // both alphabets
+        { "-_-_",   OtpBase64Alphabet::Standard,    OtpBase64Mode::Strict,  false },
+        { "+/+/",   OtpBase64Alphabet::Url,         OtpBase64Mode::Strict,  false },
+        { "-_-_",   OtpBase64Alphabet::Url,         OtpBase64Mode::Strict,  true }
+    };
+
+    bool Passed = true;
+
+    for (const auto& Vector : Vectors) {
+        OtpByteArray Bytes(Vector.lpszBytes, Vector.lpszBytes + strlen(Vector.lpszBytes));
+
+        if (OtpBase64EncodeA(Bytes) != Vector.lpszBase64 || OtpBase64DecodeA(Vector.lpszBase64, OtpBase64Mode::Strict) != Bytes) {
+            printf("Base64: RFC 4648 mismatch for \"%s\"\n", Vector.lpszBytes);
+            Passed = false;
+        }
+    }
+
+    for (const auto& Rule : Rules) {
+        std::string Text = Rule.lpszBase64;
+        auto Bytes = TryDecode(Internal::OtpBase64DecodedMaxLength(Text.size()), [&](OtpTypeByte* lpBytes) {
+            return Internal::OtpBase64Decode(Text.data(), Text.size(), lpBytes, Rule.Alphabet, Rule.Mode);
+        });
+
+        if (Bytes.has_value() != Rule.Accepted) {
+            printf(
+                "Base64: \"%s\" is %s by the %s %s decoder\n",
+                Rule.lpszBase64,
+                Rule.Accepted ? "rejected" : "accepted",
+                Rule.Mode == OtpBase64Mode::Strict ? "strict" : "lenient",
+                Rule.Alphabet == OtpBase64Alphabet::Standard ? "standard" : "URL"
+            );
+            Passed = false;
+        }
+    }
+
+    for (auto Alphabet : { OtpBase64Alphabet::Standard, OtpBase64Alphabet::Url }) {
+        for (auto Mode : { OtpBase64Mode::Lenient, OtpBase64Mode::Strict }) {
+            auto EncodedLength = [Alphabet](OtpTypeSize cbBytes) {
+                return Internal::OtpBase64EncodedLength(cbBytes, Alphabet);
+            };
+
+            auto Encode = [Alphabet](const OtpTypeByte* lpBytes, OtpTypeSize cbBytes, char* lpszBase64, bool Scalar) {
+                if (Scalar) {
+                    Internal::OtpBase64EncodeScalar(lpBytes, cbBytes, lpszBase64, Alphabet);
+                } else {
+                    Internal::OtpBase64Encode(lpBytes, cbBytes, lpszBase64, Alphabet);
+                }
+            };
+
+            auto Decode = [Alphabet, Mode](const std::string& Text, bool Scalar) {
+                return TryDecode(Internal::OtpBase64DecodedMaxLength(Text.size()), [&](OtpTypeByte* lpBytes) {
+                    if (Scalar) {
+                        return Internal::OtpBase64DecodeScalar(Text.data(), Text.size(), lpBytes, Alphabet, Mode);
+                    } else {
+                        return Internal::OtpBase64Decode(Text.data(), Text.size(), lpBytes, Alphabet, Mode);
+                    }
+                });
+            };
+
+            if (CheckCodecAgainstScalar(Alphabet == OtpBase64Alphabet::Standard ? "Base64" : "Base64url", EncodedLength, Encode, Decode) == false) {
+                Passed = false;
+            }
+        }
+    }
+
+    return Passed;
+}
+
+//
+// Format then Parse returns every field, the spellings real provisioning QR codes use are understood in
+// all character types, and parameters the generators cannot honour are rejected up front.
+//
+static bool CheckAuthUri() {
+    static const char* Rejected[] = {
+        "otpauth://totp/a?secret=JBSWY3DPEHPK3PXP&digits=9",
+        "otpauth://totp/a?secret=JBSWY3DPEHPK3PXP&digits=5",
+        "otpauth://totp/a?secret=JBSWY3DPEHPK3PXP&period=0",
+        "otpauth://hotp/a?secret=JBSWY3DPEHPK3PXP&counter=18446744073709551616",
+        "otpauth://hotp/a?secret=JBSWY3DPEHPK3PXP&counter=-1",
+        "otpauth://totp/a?secret=JBSWY3DPEHPK3PXP&algorithm=MD5",
+        "otpauth://totp/a?secret=",
+        "otpauth://totp/a?secret=%3D%3D",
+        "otpauth://totp/a?issuer=Example",
+        "otpauth://totp/a?secret=JBSWY3DPEHPK3PX1",
+        "otpauth://totp/a?secret=JBSW%20Y3DP",
+        "otpauth://xotp/a?secret=JBSWY3DPEHPK3PXP",
+        "https://totp/a?secret=JBSWY3DPEHPK3PXP"
+    };
+
+    bool Passed = true;
+
+    OtpAuthUriA Uri;
+    Uri.Type = OtpAuthType::Hotp;
+    Uri.Label = "Example:alice%40example.com";
+    Uri.Issuer = "Example";
+    Uri.Secret = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+    Uri.HashMode = OtpHashMode::Sha256;
+    Uri.Digit = 8;
+    Uri.Counter = UINT64_MAX;
+
+    std::string szFormatted = OtpAuthUriFormatA(Uri);
+    OtpAuthUriA Parsed = OtpAuthUriParseA(szFormatted);
+
+    if (Parsed.Type != Uri.Type || Parsed.Label != Uri.Label || Parsed.Issuer != Uri.Issuer || Parsed.Secret != Uri.Secret ||
+        Parsed.HashMode != Uri.HashMode || Parsed.Digit != Uri.Digit || Parsed.Counter != Uri.Counter || OtpAuthUriUnescapeA(Parsed.Label) != "Example:alice@example.com")
+    {
+        printf("AuthUri: %s does not parse back to what was formatted\n", szFormatted.c_str());
+        Passed = false;
+    }
+
+    OtpGeneratorRfc6238 Reference(OtpHashMode::Sha512, 7, 60);
+    Reference.ImportSecretBase32A("MZXW6YQ");
+
+    std::string_view szUriA = "OTPAUTH://TOTP/Example:bob?secret=MZXW6YQ%3d&algorithm=sha512&digits=7&period=60#fragment&digits=9";
+    std::wstring_view szUriW = L"otpauth://totp/Example:bob?secret=MZXW6YQ=&algorithm=SHA512&digits=7&period=60#&digits=9";
+    std::u16string_view szUri16 = u"otpauth://Totp/Example:bob?period=60&digits=7&algorithm=SHA512&image=x&secret=MZXW6YQ%3D";
+
+    try {
+        auto UriA = OtpAuthUriParse<char>(szUriA);
+        auto UriW = OtpAuthUriParse<wchar_t>(szUriW);
+        auto Uri16 = OtpAuthUriParse<char16_t>(szUri16);
+
+        for (OtpTypeUInt64 Time : { 59ull, 1111111109ull, 2000000000ull }) {
+            if (UriA.CreateTotp().GenerateCode(Time) != Reference.GenerateCode(Time) ||
+                UriW.CreateTotp().GenerateCode(Time) != Reference.GenerateCode(Time) ||
+                Uri16.CreateTotp().GenerateCode(Time) != Reference.GenerateCode(Time))
+            {
+                printf("AuthUri: padded, fragment or upper-case URIs give the wrong generator\n");
+                Passed = false;
+                break;
+            }
+        }
+    } catch (const std::invalid_argument& Exception) {
+        printf("AuthUri: a valid URI was rejected: %s\n", Exception.what());
+        Passed = false;
+    }
+
+    for (const char* lpszUri : Rejected) {
+        try {
+            auto Rejecting = OtpAuthUriParseA(lpszUri);
+
+            // the parser leaves the secret's Base32 to the decoder, which runs when a generator is created.
+            if (Rejecting.Type == OtpAuthType::Totp) {
+                OtpBenchmarkConsume(Rejecting.CreateTotp().GenerateCode(0));
+            } else {
+                OtpBenchmarkConsume(Rejecting.CreateHotp().GenerateCode(0));
+            }
+
+            printf("AuthUri: %s was accepted\n", lpszUri);
+            Passed = false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+
+    return Passed;
+}
+
+//
+// whether every user in [0, UserCount) has the credential a generator built from Records[UserId] produces,
+// or none if Records has no entry for it.
+//
+struct ImportRecord {
+    std::string     Secret;
+    OtpHashMode     HashMode;
+    OtpTypeUInt32   Digit;
+    OtpTypeUInt32   Interval;
+};
+
+static bool StoreMatches(const OtpCredentialStore& Store, const std::unordered_map<OtpTypeUInt64, ImportRecord>& Records, OtpTypeUInt64 UserCount) {
+    if (Store.GetCount() != Records.size()) {
+        return false;
+    }
+
+    for (OtpTypeUInt64 UserId = 0; UserId < UserCount; ++UserId) {
+        auto Record = Records.find(UserId);
+
+        if (Record == Records.end()) {
+            if (Store.Contains(UserId)) {
+                return false;
+            }
+
+            continue;
+        }
+
+        OtpGeneratorRfc4226 Reference(Record->second.HashMode, Record->second.Digit);
+        Reference.ImportSecretBase32A(Record->second.Secret);
+
+        if (Store.Contains(UserId) == false || Store.GetInterval(UserId) != Record->second.Interval || Store.GenerateCode(UserId, UserId) != Reference.GenerateCode(UserId)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// a multi-chunk import in which user IDs repeat across chunks, so the last record must win; then lines with
+// a bad field, which must be reported with their global line number and leave the store as it was.
+//
+static bool CheckCredentialImport() {
+    static constexpr OtpTypeUInt64 UserCount = 5000;
+    static constexpr OtpHashMode HashModes[] = { OtpHashMode::Sha1, OtpHashMode::Sha256, OtpHashMode::Sha384, OtpHashMode::Sha512 };
+    static constexpr const char* HashModeFields[] = { "SHA1", "sha256", "Sha384", "SHA512" };
+
+    static const char* RejectedLines[] = {
+        "7,JBSWY3DPEHPK3PXP,SHA1,9",
+        "7,JBSWY3DPEHPK3PXP,SHA1,5,30",
+        "7,JBSWY3DPEHPK3PXP,SHA1,six",
+        "7,JBSWY3DPEHPK3PXP,MD5",
+        "7,JBSWY3DPEHPK3PXP,,6,30",
+        "7,JBSWY3DPEHPK3PXP,SHA1,6,-30",
+        "7,JBSWY3DPEHPK3PXP,SHA1,6,30s",
+        "7,JBSWY3DPEHPK3PXP,SHA1,6,30,1",
+        "7,JBSWY3DPEHPK3PX1",
+        "7,",
+        "7",
+        "seven,JBSWY3DPEHPK3PXP",
+        "7,otpauth://totp/a?secret=JBSWY3DPEHPK3PXP&digits=9"
+    };
+
+    std::unordered_map<OtpTypeUInt64, ImportRecord> Records;
+    std::string Text = "# user,secret,algorithm,digits,period\r\n\n";
+    OtpTypeSize LineCount = 2;      // of Text; the rejected line below follows a first record, Text and a comment
+
+    for (OtpTypeUInt64 i = 0; i < UserCount * 4; ++i) {
+        OtpTypeUInt64 UserId = Internal::OtpSplitMix64(i) % UserCount;
+        OtpByteArray Secret(10 + i % 23);
+
+        for (OtpTypeSize j = 0; j < Secret.size(); ++j) {
+            Secret[j] = static_cast<OtpTypeByte>(Internal::OtpSplitMix64(i * 64 + j));
+        }
+
+        ImportRecord Record = { OtpBase32EncodeA(Secret), HashModes[i % 4], static_cast<OtpTypeUInt32>(6 + i % 3), i % 5 == 0 ? 0u : 30u };
+
+        if (i % 7 == 0) {
+            Text += std::to_string(UserId) + ",otpauth://" + (Record.Interval == 0 ? "hotp" : "totp") + "/Example:u?secret=" + Record.Secret;
+            Text += std::string("&algorithm=") + HashModeFields[i % 4] + "&digits=" + std::to_string(Record.Digit) + "\n";
+        } else {
+            Text += std::to_string(UserId) + "," + Record.Secret + "," + HashModeFields[i % 4] + "," + std::to_string(Record.Digit) + "," + std::to_string(Record.Interval) + "\r\n";
+        }
+
+        Records[UserId] = Record;
+        ++LineCount;
+    }
+
+    OtpCredentialStore Store;
+    bool Passed = true;
+
+    try {
+        OtpCredentialImport(Store, Text, 4);
+    } catch (const std::exception& Exception) {
+        printf("CredentialImport: a valid file was rejected: %s\n", Exception.what());
+        return false;
+    }
+
+    if (StoreMatches(Store, Records, UserCount) == false) {
+        printf("CredentialImport: the store does not hold the last record of every user\n");
+        Passed = false;
+    }
+
+    for (const char* lpszLine : RejectedLines) {
+        std::string ExpectedPrefix = "Line " + std::to_string(LineCount + 3) + ": ";
+
+        try {
+            OtpCredentialImport(Store, "1,JBSWY3DPEHPK3PXP,SHA512,8,0\n" + Text + "# end\n" + lpszLine + "\n" + Text, 4);
+            printf("CredentialImport: \"%s\" was accepted\n", lpszLine);
+            Passed = false;
+        } catch (const std::invalid_argument& Exception) {
+            if (std::string_view(Exception.what()).substr(0, ExpectedPrefix.size()) != ExpectedPrefix) {
+                printf("CredentialImport: \"%s\" was reported as \"%s\", not on %s\n", lpszLine, Exception.what(), ExpectedPrefix.c_str());
+                Passed = false;
+            }
+        }
+
+        if (StoreMatches(Store, Records, UserCount) == false) {
+            printf("CredentialImport: a rejected import of \"%s\" changed the store\n", lpszLine);
+            Passed = false;
+        }
+    }
+
+    return Passed;
+}
+
+//
+// threads refreshing and reading one coarse clock across a few second boundaries: no thread may see it go
+// backwards or more than a second away from the wall clock. A fixed clock must drive a generator exactly.
+//
+static bool CheckClock() {
+    static constexpr unsigned ThreadCount = 4;
+
+    OtpClockCoarse CoarseClock;
+    std::atomic<uint64_t> Violations(0);
+    std::vector<std::thread> Threads;
+    auto StopTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(2100);
+
+    for (unsigned t = 0; t < ThreadCount; ++t) {
+        Threads.emplace_back([&]() {
+            OtpTypeUInt64 LastTime = 0;
+
+            while (std::chrono::steady_clock::now() < StopTime) {
+                OtpTypeUInt64 SystemTimeBefore = OtpClockSystem::Read();
+                OtpTypeUInt64 Time = CoarseClock.Refresh();
+                OtpTypeUInt64 CachedTime = CoarseClock.GetUnixTime();
+                OtpTypeUInt64 SystemTimeAfter = OtpClockSystem::Read();
+
+                if (Time < LastTime || CachedTime < Time || Time + 1 < SystemTimeBefore || SystemTimeAfter + 1 < CachedTime) {
+                    Violations.fetch_add(1);
+                }
+
+                LastTime = CachedTime;
+            }
+        });
+    }
+
+    for (auto& Thread : Threads) {
+        Thread.join();
+    }
+
+    OtpClockFixed FixedClock(1111111109);
+    OtpGeneratorRfc6238 Totp(OtpHashMode::Sha1, 8, 30);
+    Totp.ImportSecretRaw("12345678901234567890", 20);
+    Totp.SetClock(&FixedClock);
+
+    if (Totp.GenerateCode() != 7081804 || FixedClock.Advance(2) != 1111111111 || Totp.GenerateCode() != 14050471) {
+        Violations.fetch_add(1);
+    }
+
+    FixedClock.Set(59);
+    if (Totp.GenerateCode() != 94287082) {
+        Violations.fetch_add(1);
+    }
+
+    if (Violations.load() != 0) {
+        printf("OtpClock: %llu reads went backwards, strayed from the wall clock or ignored a fixed clock\n", static_cast<unsigned long long>(Violations.load()));
+        return false;
+    } else {
+        return true;
+    }
+}
+
+//
+// caches walked forwards and then backwards across time-step boundaries, including the first steps where the
+// window is clipped at 0, must accept and reject exactly what the generator's own VerifyWindow does: the
+// codes of every step around the window and one code that is never valid.
+//
+static bool CheckTotpCodeCache() {
+    static constexpr OtpTypeUInt32 Windows[][2] = { { 1, 1 }, { 2, 3 }, { 0, 0 } };
+    static constexpr OtpTypeUInt64 Origins[] = { 0, 1111111000 };
+
+    OtpGeneratorRfc6238 Totp(OtpHashMode::Sha1, 6, 30);
+    Totp.ImportSecretRaw("12345678901234567890", 20);
+
+    const OtpGeneratorRfc4226& Hotp = Totp;
+    uint64_t Mismatches = 0;
+
+    for (const auto& Window : Windows) {
+        OtpTotpCodeCache Cache(Totp, Window[0], Window[1]);
+
+        for (OtpTypeUInt64 Origin : Origins) {
+            for (int Direction = 1; Direction >= -1; Direction -= 2) {
+                for (OtpTypeUInt64 i = 0; i <= 200; i += 7) {
+                    OtpTypeUInt64 UnixTimestamp = Origin + (Direction > 0 ? i : 200 - i);
+                    OtpTypeUInt64 T = UnixTimestamp / Totp.GetInterval();
+
+                    for (OtpTypeUInt64 Counter = T > 4 ? T - 4 : 0; Counter <= T + 5; ++Counter) {
+                        OtpTypeUInt32 Code = Hotp.GenerateCode(Counter);
+
+                        if (Cache.VerifyWindow(Code, UnixTimestamp) != Totp.VerifyWindow(Code, UnixTimestamp, Window[0], Window[1])) {
+                            ++Mismatches;
+                        }
+                    }
+
+                    if (Cache.VerifyWindow(1000000, UnixTimestamp).has_value()) {
+                        ++Mismatches;
+                    }
+                }
+            }
+        }
+
+        if (Cache.GetHitCount() == 0 || Cache.GetMissCount() == 0) {
+            ++Mismatches;
+        }
+    }
+
+    if (Mismatches != 0) {
+        printf("OtpTotpCodeCache: %llu verifications disagreed with OtpGeneratorRfc6238::VerifyWindow\n", static_cast<unsigned long long>(Mismatches));
+        return false;
+    } else {
+        return true;
+    }
+}
+
+//
+// one generator shared by many threads, every code checked against a single-threaded reference.
+// Before the CNG backend duplicated its keyed handle per call, this produced wrong codes or crashed.
+//
+static bool CheckConcurrentGeneration(OtpHashBackend HashBackend) {
+    static constexpr unsigned ThreadCount = 16;
+    static constexpr OtpTypeUInt64 CounterCount = 512;
+
+    OtpGeneratorRfc4226 Hotp(OtpHashMode::Sha256, 8, HashBackend);
+    Hotp.ImportSecretBase32A("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+
+    std::vector<OtpTypeUInt32> Expected(CounterCount);
+    for (OtpTypeUInt64 i = 0; i < CounterCount; ++i) {
+        Expected[i] = Hotp.GenerateCode(i);
+    }
+
+    std::atomic<uint64_t> Mismatches(0);
+    std::vector<std::thread> Threads;
+    for (unsigned t = 0; t < ThreadCount; ++t) {
+        Threads.emplace_back([&Hotp, &Expected, &Mismatches, t]() {
+            OtpTypeUInt32 Codes[17];
+
+            for (unsigned Round = 0; Round < 20; ++Round) {
+                for (OtpTypeUInt64 i = 0; i < CounterCount; ++i) {
+                    OtpTypeUInt64 Counter = (i * 7 + t) % CounterCount;
+                    if (Hotp.GenerateCode(Counter) != Expected[Counter]) {
+                        Mismatches.fetch_add(1);
+                    }
+                }
+
+                OtpTypeUInt64 First = (Round * 31 + t) % (CounterCount - 17);
+                Hotp.GenerateCodes(First, 17, Codes);
+                for (OtpTypeUInt64 i = 0; i < 17; ++i) {
+                    if (Codes[i] != Expected[First + i]) {
+                        Mismatches.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& Thread : Threads) {
+        Thread.join();
+    }
+
+    if (Mismatches.load() != 0) {
+        printf("[%s] %llu wrong codes under concurrent generation\n", HashBackendName(HashBackend), static_cast<unsigned long long>(Mismatches.load()));
+        return false;
+    } else {
+        return true;
+    }
+}
+
+//
+// many threads racing to accept the same steps of a few users: no step may be accepted twice, and each
+// user must end up past the last step.
+//
+static bool CheckReplayTable() {
+    static constexpr unsigned ThreadCount = 32;
+    static constexpr OtpTypeUInt64 UserCount = 4;
+    static constexpr OtpTypeUInt64 StepCount = 4096;
+
+    OtpReplayTable Table(UserCount);
+    std::vector<std::atomic<uint32_t>> AcceptCounts(UserCount * StepCount);
+    std::atomic<uint64_t> Violations(0);
+    std::vector<std::thread> Threads;
+
+    for (unsigned t = 0; t < ThreadCount; ++t) {
+        Threads.emplace_back([&, t]() {
+            for (OtpTypeUInt64 Step = 1; Step < StepCount; ++Step) {
+                // each thread skips a different subset of steps, so accepted steps are not always consecutive.
+                if ((Step + t) % 3 == 0) {
+                    continue;
+                }
+
+                for (OtpTypeUInt64 User = 0; User < UserCount; ++User) {
+                    if (Table.TryAccept(User, Step)) {
+                        AcceptCounts[User * StepCount + Step].fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& Thread : Threads) {
+        Thread.join();
+    }
+
+    for (auto& AcceptCount : AcceptCounts) {
+        if (AcceptCount.load() > 1) {
+            Violations.fetch_add(1);
+        }
+    }
+
+    for (OtpTypeUInt64 User = 0; User < UserCount; ++User) {
+        if (Table.GetNextCounter(User) != StepCount || Table.TryAccept(User, StepCount - 1)) {
+            Violations.fetch_add(1);
+        }
+    }
+
+    if (Table.GetCount() != UserCount || Table.GetNextCounter(UserCount) != 0) {
+        Violations.fetch_add(1);
+    }
+
+    if (Violations.load() != 0) {
+        printf("OtpReplayTable: %llu replays accepted under concurrent verification\n", static_cast<unsigned long long>(Violations.load()));
+        return false;
+    } else {
+        return true;
+    }
+}
+
+//
+// one user guessed from many threads at once: exactly MaxFailures attempts may get through before the
+// lockout, and the lockout must end on time.
+//
+static bool CheckThrottleTable() {
+    static constexpr unsigned ThreadCount = 32;
+    static constexpr OtpTypeUInt64 UnixTime = 1700000000;
+
+    OtpThrottlePolicy Policy;
+    Policy.MaxFailures = 5;
+    Policy.DecaySeconds = 60;
+    Policy.LockoutSeconds = 300;
+
+    OtpThrottleTable Table(16, Policy);
+    std::atomic<uint64_t> Allowed(0);
+    std::vector<std::thread> Threads;
+
+    for (unsigned t = 0; t < ThreadCount; ++t) {
+        Threads.emplace_back([&]() {
+            for (unsigned i = 0; i < 100; ++i) {
+                if (Table.TryAttempt(7, UnixTime)) {
+                    Allowed.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (auto& Thread : Threads) {
+        Thread.join();
+    }
+
+    bool Passed =
+        Allowed.load() == Policy.MaxFailures &&
+        Table.GetLockoutCount() == 1 &&
+        Table.GetRejectedCount() == ThreadCount * 100 - Policy.MaxFailures &&
+        Table.GetLockoutExpiry(7, UnixTime + Policy.LockoutSeconds - 1) == UnixTime + Policy.LockoutSeconds &&
+        Table.GetLockoutExpiry(7, UnixTime + Policy.LockoutSeconds) == 0 &&
+        Table.TryAttempt(7, UnixTime + Policy.LockoutSeconds);
+
+    if (Passed == false) {
+        printf("OtpThrottleTable: %llu of %u concurrent attempts got through a lockout after %u\n", static_cast<unsigned long long>(Allowed.load()), ThreadCount * 100, Policy.MaxFailures);
+    }
+
+    return Passed;
+}
+
+//
+// requests from several threads, through callbacks and futures, must come back with the same answers
+// VerifyHotp and VerifyTotp give, including for unknown users and HOTP-only credentials.
+//
+static bool CheckVerifyExecutor() {
+    static constexpr unsigned ThreadCount = 8;
+    static constexpr OtpTypeUInt64 RequestCount = 2000;
+    static const OtpHashMode HashModes[] = { OtpHashMode::Sha1, OtpHashMode::Sha256, OtpHashMode::Sha384, OtpHashMode::Sha512 };
+
+    OtpCredentialStore Store;
+    OtpTypeByte Secret[32] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    for (OtpTypeUInt64 User = 0; User < 64; ++User) {
+        Secret[0] = static_cast<OtpTypeByte>(User);
+        Store.Insert(User, HashModes[User % 4], 6 + User % 3, User % 5 == 0 ? 0 : 30, Secret, sizeof(Secret));
+    }
+
+    auto MakeRequest = [&Store](unsigned t, OtpTypeUInt64 i) {
+        OtpTypeUInt64 User = (i * 7 + t) % 70;
+        OtpTypeUInt64 Time = 1700000000 + i * 13;
+
+        if (User >= 64 || i % 3 == 0) {
+            return OtpCredentialStore::VerifyRequest::Totp(User, static_cast<OtpTypeUInt32>(i), Time);
+        } else if (Store.GetInterval(User) == 0) {
+            return OtpCredentialStore::VerifyRequest::Hotp(User, Store.GenerateCode(User, i + 2), i, 3);
+        } else {
+            return OtpCredentialStore::VerifyRequest::Totp(User, Store.GenerateCode(User, Time / 30 + i % 3 - 1), Time);
+        }
+    };
+
+    auto Expected = [&Store](const OtpCredentialStore::VerifyRequest& Request) {
+        using Status = OtpCredentialStore::VerifyStatus;
+
+        if (Store.Contains(Request.UserId) == false) {
+            return OtpCredentialStore::VerifyResult{ Status::UnknownUser, 0 };
+        } else if (Request.IsTotp == false) {
+            auto Offset = Store.VerifyHotp(Request.UserId, Request.Code, Request.CounterOrTime, Request.StepsAhead);
+            return OtpCredentialStore::VerifyResult{ Offset ? Status::Accepted : Status::Rejected, static_cast<OtpTypeInt64>(Offset.value_or(0)) };
+        } else if (Store.GetInterval(Request.UserId) == 0) {
+            return OtpCredentialStore::VerifyResult{ Status::NotTotp, 0 };
+        } else {
+            auto Drift = Store.VerifyTotp(Request.UserId, Request.Code, Request.CounterOrTime, Request.StepsBehind, Request.StepsAhead);
+            return OtpCredentialStore::VerifyResult{ Drift ? Status::Accepted : Status::Rejected, Drift.value_or(0) };
+        }
+    };
+
+    struct Pending {
+        OtpCredentialStore::VerifyResult    Result;
+        std::atomic<bool>                   Done;
+    };
+
+    std::vector<Pending> Callbacks(ThreadCount * RequestCount);
+    std::atomic<uint64_t> Mismatches(0);
+    std::vector<std::thread> Threads;
+
+    {
+        OtpVerifyExecutor Executor(Store, 3, 64);
+
+        for (unsigned t = 0; t < ThreadCount; ++t) {
+            Threads.emplace_back([&, t]() {
+                for (OtpTypeUInt64 i = 0; i < RequestCount; ++i) {
+                    auto Request = MakeRequest(t, i);
+                    auto Reference = Expected(Request);
+
+                    if (i % 2 == 0) {
+                        auto Result = Executor.Submit(Request).get();
+                        if (Result.Status != Reference.Status || Result.Offset != Reference.Offset) {
+                            Mismatches.fetch_add(1);
+                        }
+                    } else {
+                        Executor.Submit(Request, [](void* lpContext, const OtpCredentialStore::VerifyResult& Result) {
+                            Pending* lpPending = static_cast<Pending*>(lpContext);
+                            lpPending->Result = Result;
+                            lpPending->Done.store(true, std::memory_order_release);
+                        }, &Callbacks[t * RequestCount + i]);
+                    }
+                }
+            });
+        }
+
+        for (auto& Thread : Threads) {
+            Thread.join();
+        }
+    }
+
+    for (unsigned t = 0; t < ThreadCount; ++t) {
+        for (OtpTypeUInt64 i = 1; i < RequestCount; i += 2) {
+            const Pending& Item = Callbacks[t * RequestCount + i];
+            auto Reference = Expected(MakeRequest(t, i));
+
+            if (Item.Done.load(std::memory_order_acquire) == false || Item.Result.Status != Reference.Status || Item.Result.Offset != Reference.Offset) {
+                Mismatches.fetch_add(1);
+            }
+        }
+    }
+
+    if (Mismatches.load() != 0) {
+        printf("OtpVerifyExecutor: %llu results differ from synchronous verification\n", static_cast<unsigned long long>(Mismatches.load()));
+        return false;
+    } else {
+        return true;
+    }
+}
+
+//
+// the generate and verify paths must not touch the heap: secrets are keyed once, digests live in
+// OtpHmacMaxDigestSize stack buffers, and the buffer overloads of GenerateCodeString format in place.
+//
+static bool CheckZeroAllocation(OtpHashBackend HashBackend) {
+    static const OtpHashMode HashModes[] = { OtpHashMode::Sha1, OtpHashMode::Sha256, OtpHashMode::Sha384, OtpHashMode::Sha512 };
+
+    bool Passed = true;
+
+    auto Expect = [&Passed, HashBackend](const char* Name, OtpHashMode HashMode, auto&& Routine) {
+        uint64_t Before = OtpBenchmarkAllocationCount.load(std::memory_order_relaxed);
+        for (OtpTypeUInt64 i = 0; i < 64; ++i) {
+            Routine(i);
+        }
+        uint64_t Allocations = OtpBenchmarkAllocationCount.load(std::memory_order_relaxed) - Before;
+
+        if (Allocations != 0) {
+            printf("[%s] %s/%s allocated %llu times in 64 calls\n", HashBackendName(HashBackend), Name, HashModeName(HashMode), static_cast<unsigned long long>(Allocations));
+            Passed = false;
+        }
+    };
+
+    for (auto HashMode : HashModes) {
+        OtpGeneratorRfc4226 Hotp(HashMode, 8, HashBackend);
+        OtpGeneratorRfc6238 Totp(HashMode, 8, 30, HashBackend);
+        OtpCredentialStore Store;
+        OtpTypeByte Secret[32] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+        Hotp.ImportSecretRaw(Secret, sizeof(Secret));
+        Totp.ImportSecretRaw(Secret, sizeof(Secret));
+        Store.Insert(7, HashMode, 8, 30, Secret, sizeof(Secret));
+
+        OtpTypeUInt32 Codes[33];
+        char CodeStringA[OtpGeneratorRfc4226::MaxCodeStringLength];
+        wchar_t CodeStringW[OtpGeneratorRfc4226::MaxCodeStringLength];
+        char Base32[OtpBase32EncodedLength(sizeof(Secret))];
+        char Base64[OtpBase64UrlEncodedLength(sizeof(Secret))];
+        OtpTypeByte Decoded[OtpBase32DecodedLength(sizeof(Base32))];
+
+        Expect("Hotp.GenerateCode", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Hotp.GenerateCode(i)); });
+        Expect("Hotp.GenerateCodes", HashMode, [&](OtpTypeUInt64 i) { Hotp.GenerateCodes(i, 33, Codes); });
+        Expect("Hotp.GenerateCodeStringA", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Hotp.GenerateCodeStringA(i, CodeStringA, sizeof(CodeStringA))); });
+        Expect("Hotp.GenerateCodeStringW", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Hotp.GenerateCodeStringW(i, CodeStringW, sizeof(CodeStringW) / sizeof(wchar_t))); });
+        Expect("Hotp.Verify", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Hotp.Verify(12345678, i)); });
+        Expect("Hotp.VerifyWindow", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Hotp.VerifyWindow(12345678, i, 20).value_or(0)); });
+        Expect("Totp.GenerateCode", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Totp.GenerateCode(1700000000 + 30 * i)); });
+        Expect("Totp.GenerateCodeStringA", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Totp.GenerateCodeStringA(1700000000 + 30 * i, CodeStringA, sizeof(CodeStringA))); });
+        Expect("Totp.VerifyWindow", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Totp.VerifyWindow(12345678, 1700000000 + 30 * i, 1, 1).value_or(0)); });
+        Expect("Store.GenerateCode", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Store.GenerateCode(7, i)); });
+        Expect("Store.VerifyHotp", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Store.VerifyHotp(7, 12345678, i, 20).value_or(0)); });
+        Expect("Store.VerifyTotp", HashMode, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(Store.VerifyTotp(7, 12345678, 1700000000 + 30 * i, 1, 1).value_or(0)); });
+        Expect("Store.VerifyBatch", HashMode, [&](OtpTypeUInt64 i) {
+            OtpCredentialStore::VerifyRequest Requests[2] = {
+                OtpCredentialStore::VerifyRequest::Totp(7, 12345678, 1700000000 + 30 * i),
+                OtpCredentialStore::VerifyRequest::Hotp(8, 12345678, i)
+            };
+            OtpCredentialStore::VerifyResult Results[2];
+            Store.VerifyBatch(Requests, 2, Results);
+            OtpBenchmarkConsume(Results[0].Offset);
+        });
+
+        Expect("OtpBase32EncodeA/Buffer", HashMode, [&](OtpTypeUInt64) { OtpBenchmarkConsume(OtpBase32EncodeA(Secret, sizeof(Secret), Base32, sizeof(Base32))); });
+        Expect("OtpBase32DecodeA/Buffer", HashMode, [&](OtpTypeUInt64) { OtpBenchmarkConsume(OtpBase32DecodeA(std::string_view(Base32, OtpBase32EncodedLength(sizeof(Secret))), Decoded, sizeof(Decoded))); });
+        Expect("OtpBase64UrlEncodeA/Buffer", HashMode, [&](OtpTypeUInt64) { OtpBenchmarkConsume(OtpBase64UrlEncodeA(Secret, sizeof(Secret), Base64, sizeof(Base64))); });
+        Expect("OtpBase64UrlDecodeA/Buffer", HashMode, [&](OtpTypeUInt64) { OtpBenchmarkConsume(OtpBase64UrlDecodeA(std::string_view(Base64, OtpBase64UrlEncodedLength(sizeof(Secret))), Decoded, sizeof(Decoded))); });
+
+        OtpAuthUriA Uri = OtpAuthUriParseA("otpauth://totp/Example:alice%40example.com?secret=JBSWY3DPEHPK3PXP&issuer=Example&algorithm=SHA256&digits=8&period=60");
+        char UriText[128];
+
+        Expect("OtpAuthUriParseA", HashMode, [&](OtpTypeUInt64) { OtpBenchmarkConsume(OtpAuthUriParseA(std::string_view(UriText, OtpAuthUriFormatA(Uri, UriText, sizeof(UriText)))).Digit); });
+
+        if (memcmp(Decoded, Secret, sizeof(Secret)) != 0) {
+            printf("[%s] Base64url buffer round trip lost the secret\n", HashBackendName(HashBackend));
+            Passed = false;
+        }
+
+        if (strcmp(CodeStringA, Totp.GenerateCodeStringA(1700000000 + 30 * 63).c_str()) != 0) {
+            printf("[%s] GenerateCodeStringA buffer overload disagrees with the std::string one\n", HashBackendName(HashBackend));
+            Passed = false;
+        }
+    }
+
+    OtpGenerator<OtpHashMode::Sha256, 8, 30> StaticTotp;
+    OtpTypeByte Secret[32] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    char CodeStringA[StaticTotp.CodeStringLength];
+
+    StaticTotp.ImportSecretRaw(Secret, sizeof(Secret));
+
+    Expect("StaticTotp.GenerateCode", OtpHashMode::Sha256, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(StaticTotp.GenerateCode(1700000000 + 30 * i)); });
+    Expect("StaticTotp.GenerateCodeStringA", OtpHashMode::Sha256, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(StaticTotp.GenerateCodeStringA(1700000000 + 30 * i, CodeStringA, sizeof(CodeStringA))); });
+    Expect("StaticTotp.VerifyWindow", OtpHashMode::Sha256, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(StaticTotp.VerifyWindow(12345678, 1700000000 + 30 * i, 1, 1).value_or(0)); });
+
+    OtpReplayTable ReplayTable(16);
+
+    Expect("ReplayTable.TryAccept", OtpHashMode::Sha1, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(ReplayTable.TryAccept(i % 8, i)); });
+
+    OtpThrottleTable ThrottleTable(16);
+
+    Expect("ThrottleTable.TryAttempt", OtpHashMode::Sha1, [&](OtpTypeUInt64 i) { OtpBenchmarkConsume(ThrottleTable.TryAttempt(i % 8, 1700000000 + i)); });
+    Expect("ThrottleTable.RecordSuccess", OtpHashMode::Sha1, [&](OtpTypeUInt64 i) { ThrottleTable.RecordSuccess(i % 8); });
+
+    return Passed;
+}
+
+//
+// every hash mode at every digit count, as a number and as text. The std::string form is measured once.
+//
+static void BenchmarkGenerateCode() {
+    static const OtpHashMode HashModes[] = { OtpHashMode::Sha1, OtpHashMode::Sha256, OtpHashMode::Sha384, OtpHashMode::Sha512 };
+
+    for (auto HashBackend : AvailableBackends()) {
+        for (auto HashMode : HashModes) {
+            for (OtpTypeUInt32 Digit = 6; Digit <= 8; ++Digit) {
+                std::string Suffix = std::string("/") + HashModeName(HashMode) + "/" + std::to_string(Digit) + "/" + HashBackendName(HashBackend);
+                OtpGeneratorRfc4226 Hotp(HashMode, Digit, HashBackend);
+                Hotp.ImportSecretBase32A("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+
+                OtpBenchmarkRun("GenerateCode" + Suffix, 200000, [&Hotp](uint64_t i) {
+                    OtpBenchmarkConsume(Hotp.GenerateCode(i));
+                });
+
+                char CodeString[OtpGeneratorRfc4226::MaxCodeStringLength];
+                OtpBenchmarkRun("GenerateCodeString/Buffer" + Suffix, 200000, [&Hotp, &CodeString](uint64_t i) {
+                    OtpBenchmarkConsume(Hotp.GenerateCodeStringA(i, CodeString, sizeof(CodeString)));
+                });
+            }
+        }
+
+        OtpGeneratorRfc4226 Hotp(OtpHashMode::Sha1, 6, HashBackend);
+        Hotp.ImportSecretBase32A("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+
+        OtpBenchmarkRun(
+            std::string("GenerateCodeString/std::string/SHA1/6/") + HashBackendName(HashBackend),
+            200000,
+            [&Hotp](uint64_t i) { OtpBenchmarkConsume(Hotp.GenerateCodeStringA(i)[0]); }
+        );
+    }
+}
+
+//
+// the same TOTP codes from OtpGenerator<HashMode, 6, 30>, whose parameters are template arguments, against
+// OtpGeneratorRfc6238 on the portable backend. Timestamps advance one step per call so every call hashes.
+//
+template<OtpHashMode __HashMode>
+static void BenchmarkStaticGeneratorOf(const char* lpszBase32Secret) {
+    OtpGeneratorRfc6238 Runtime(__HashMode, 6, 30, OtpHashBackend::Portable);
+    OtpGenerator<__HashMode, 6, 30> Static;
+    Runtime.ImportSecretBase32A(lpszBase32Secret);
+    Static.ImportSecretBase32A(lpszBase32Secret);
+
+    OtpBenchmarkRun(std::string("StaticGenerator/") + HashModeName(__HashMode) + "/Runtime", 500000, [&Runtime](uint64_t i) {
+        OtpBenchmarkConsume(Runtime.GenerateCode(1700000000 + 30 * i));
+    });
+
+    OtpBenchmarkRun(std::string("StaticGenerator/") + HashModeName(__HashMode) + "/Static", 500000, [&Static](uint64_t i) {
+        OtpBenchmarkConsume(Static.GenerateCode(1700000000 + 30 * i));
+    });
+
+    char CodeString[OtpGeneratorRfc4226::MaxCodeStringLength];
+
+    OtpBenchmarkRun(std::string("StaticGenerator/") + HashModeName(__HashMode) + "/Runtime/String", 500000, [&Runtime, &CodeString](uint64_t i) {
+        OtpBenchmarkConsume(Runtime.GenerateCodeStringA(1700000000 + 30 * i, CodeString, sizeof(CodeString)));
+    });
+
+    OtpBenchmarkRun(std::string("StaticGenerator/") + HashModeName(__HashMode) + "/Static/String", 500000, [&Static, &CodeString](uint64_t i) {
+        OtpBenchmarkConsume(Static.GenerateCodeStringA(1700000000 + 30 * i, CodeString, sizeof(CodeString)));
+    });
+}
+
+static void BenchmarkStaticGenerator() {
+    BenchmarkStaticGeneratorOf<OtpHashMode::Sha1>("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+    BenchmarkStaticGeneratorOf<OtpHashMode::Sha256>("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+    BenchmarkStaticGeneratorOf<OtpHashMode::Sha512>("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+}
+
+//
+// HOTP resynchronisation: scan 100 counters ahead of the last accepted one.
+//
+static void BenchmarkGenerateCodes() {
+    static constexpr OtpTypeSize LookAhead = 100;
+
+    for (auto HashBackend : AvailableBackends()) {
+        OtpGeneratorRfc4226 Hotp(OtpHashMode::Sha1, 6, HashBackend);
+        Hotp.ImportSecretBase32A("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+
+        OtpTypeUInt32 Codes[LookAhead];
+
+        OtpBenchmarkRun(
+            std::string("LookAhead100/Scalar/") + HashBackendName(HashBackend),
+            2000,
+            [&Hotp, &Codes](uint64_t i) {
+                for (OtpTypeSize j = 0; j < LookAhead; ++j) {
+                    Codes[j] = Hotp.GenerateCode(i * LookAhead + j);
+                }
+                OtpBenchmarkConsume(Codes[LookAhead - 1]);
+            },
+            LookAhead
+        );
+
+        OtpBenchmarkRun(
+            std::string("LookAhead100/Batch/") + HashBackendName(HashBackend),
+            2000,
+            [&Hotp, &Codes](uint64_t i) {
+                Hotp.GenerateCodes(i * LookAhead, LookAhead, Codes);
+                OtpBenchmarkConsume(Codes[LookAhead - 1]);
+            },
+            LookAhead
+        );
+    }
+}
+
+//
+// a single shared generator, 1 to 64 threads. ops/s should grow with the core count.
+//
+static void BenchmarkConcurrentGeneration() {
+    static const unsigned ThreadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    for (auto HashBackend : AvailableBackends()) {
+        OtpGeneratorRfc4226 Hotp(OtpHashMode::Sha1, 6, HashBackend);
+        Hotp.ImportSecretBase32A("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+
+        for (auto ThreadCount : ThreadCounts) {
+            OtpBenchmarkRunThreads(
+                "SharedGenerator/" + std::to_string(ThreadCount) + "T/" + HashBackendName(HashBackend),
+                ThreadCount,
+                400000 / ThreadCount,
+                [&Hotp](unsigned t, uint64_t i) { OtpBenchmarkConsume(Hotp.GenerateCode((static_cast<uint64_t>(t) << 32) | i)); }
+            );
+        }
+    }
+}
+
+//
+// generator construction and ImportSecret on their own, then service start-up: 100k generators constructed
+// and keyed, spread over 1 to 64 threads. With CNG this is where the hash provider singletons get hammered.
+//
+static void BenchmarkGeneratorStartup() {
+    static constexpr uint64_t GeneratorCount = 100000;
+    static const unsigned ThreadCounts[] = { 1, 4, 16, 64 };
+    static const OtpHashMode HashModes[] = { OtpHashMode::Sha1, OtpHashMode::Sha256, OtpHashMode::Sha384, OtpHashMode::Sha512 };
+
+    for (auto HashBackend : AvailableBackends()) {
+        for (auto HashMode : HashModes) {
+            std::string Suffix = std::string("/") + HashModeName(HashMode) + "/" + HashBackendName(HashBackend);
+            uint64_t Secret[4] = { 1, 2, 3, 4 };
+
+            OtpBenchmarkRun("Generator/Construct" + Suffix, GeneratorCount, [HashMode, HashBackend](uint64_t) {
+                OtpGeneratorRfc4226 Hotp(HashMode, 6, HashBackend);
+                OtpBenchmarkConsume(Hotp.GetDigit());
+            });
+
+            OtpGeneratorRfc4226 Hotp(HashMode, 6, HashBackend);
+
+            OtpBenchmarkRun("Generator/ImportSecretRaw" + Suffix, GeneratorCount, [&Hotp, &Secret](uint64_t i) {
+                Secret[0] = i;
+                Hotp.ImportSecretRaw(Secret, sizeof(Secret));
+            });
+
+            OtpBenchmarkRun("Generator/ImportSecretBase32A" + Suffix, GeneratorCount, [&Hotp](uint64_t) {
+                Hotp.ImportSecretBase32A("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+            });
+        }
+
+        for (auto ThreadCount : ThreadCounts) {
+            OtpBenchmarkRunThreads(
+                "Startup100k/" + std::to_string(ThreadCount) + "T/" + HashBackendName(HashBackend),
+                ThreadCount,
+                GeneratorCount / ThreadCount,
+                [HashBackend](unsigned t, uint64_t i) {
+                    uint64_t Secret[4] = { t, i, t ^ i, ~i };
+                    OtpGeneratorRfc4226 Hotp(HashModes[i % 4], 6, HashBackend);
+                    Hotp.ImportSecretRaw(Secret, sizeof(Secret));
+                    OtpBenchmarkConsume(Hotp.GetDigit());
+                }
+            );
+        }
+    }
+}
+
+//
+// TOTP acceptance with one step of drift either way: string comparison per candidate vs VerifyWindow.
+//
+static void BenchmarkVerifyWindow() {
+    OtpGeneratorRfc6238 Totp(OtpHashMode::Sha1, 6, 30);
+    Totp.ImportSecretBase32A("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+
+    const OtpTypeUInt64 Now = 1700000000;
+    const std::string Submitted = Totp.GenerateCodeStringA(Now + 30);
+    const OtpTypeUInt32 SubmittedCode = std::stoul(Submitted);
+
+    OtpBenchmarkRun("VerifyWindow/-1+1/StringCompare", 100000, [&](uint64_t) {
+        bool Accepted = false;
+        for (OtpTypeUInt64 Step = 0; Step < 3; ++Step) {
+            Accepted |= Totp.GenerateCodeStringA(Now - 30 + Step * 30) == Submitted;
+        }
+        OtpBenchmarkConsume(Accepted);
+    });
+
+    OtpBenchmarkRun("VerifyWindow/-1+1/Verify", 100000, [&](uint64_t) {
+        OtpBenchmarkConsume(Totp.VerifyWindow(SubmittedCode, Now, 1, 1).value_or(-100));
+    });
+}
+
+//
+// "now" for a TOTP generator: the wall clock on every call, the coarse clock refreshed once per burst of
+// 64 calls, and a fixed clock advanced one time step per call, i.e. a replayed timeline.
+//
+static void BenchmarkClock() {
+    OtpClockSystem SystemClock;
+    OtpClockCoarse CoarseClock;
+    OtpClockFixed FixedClock(1700000000);
+
+    OtpBenchmarkRun("Clock/System/GetUnixTime", 2000000, [&SystemClock](uint64_t) {
+        OtpBenchmarkConsume(SystemClock.GetUnixTime());
+    });
+
+    OtpBenchmarkRun("Clock/Coarse/GetUnixTime", 2000000, [&CoarseClock](uint64_t) {
+        OtpBenchmarkConsume(CoarseClock.GetUnixTime());
+    });
+
+    OtpBenchmarkRun("Clock/Coarse/Refresh", 2000000, [&CoarseClock](uint64_t) {
+        OtpBenchmarkConsume(CoarseClock.Refresh());
+    });
+
+    OtpGeneratorRfc6238 Totp(OtpHashMode::Sha1, 6, 30);
+    Totp.ImportSecretBase32A("JBSWY3DPEHPK3PXPJBSWY3DPEHPK3PXP");
+
+    OtpBenchmarkRun("Clock/Totp.GenerateCode()/System", 500000, [&Totp](uint64_t) {
+        OtpBenchmarkConsume(Totp.GenerateCode());
+    });
+
+    Totp.SetClock(&CoarseClock);
+    OtpBenchmarkRun("Clock/Totp.GenerateCode()/Coarse", 500000, [&Totp, &CoarseClock](uint64_t i) {
+        if (i % 64 == 0) {
+            CoarseClock.Refresh();
+        }
+        OtpBenchmarkConsume(Totp.GenerateCode());
+    });
+
+    Totp.SetClock(&FixedClock);
+    OtpBenchmarkRun("Clock/Totp.GenerateCode()/FixedReplay", 500000, [&Totp, &FixedClock](uint64_t) {
+        FixedClock.Advance(30);
+        OtpBenchmarkConsume(Totp.GenerateCode());
+    });
+}
+
+//
+// login traffic with retries: each session verifies one user 1 to 4 times within a time step (55/25/12/8%),
+// sessions of 100000 users interleave, and the clock advances a second every 100 requests. The same trace goes
+// through VerifyWindow(-1, +1) of the generators and of per-user OtpTotpCodeCache objects.
+//
+static void BenchmarkTotpCodeCache() {
+    static constexpr OtpTypeSize UserCount = 100000;
+    static constexpr OtpTypeSize RequestCount = 500000;
+
+    struct Request {
+        OtpTypeSize     User;
+        OtpTypeUInt64   Time;
+        OtpTypeUInt32   Code;
+    };
+
+    std::vector<std::unique_ptr<OtpGeneratorRfc6238>> Generators;
+    std::vector<std::unique_ptr<OtpTotpCodeCache>> Caches;
+    for (OtpTypeSize i = 0; i < UserCount; ++i) {
+        OtpTypeByte Secret[20];
+        for (OtpTypeSize j = 0; j < sizeof(Secret); ++j) {
+            Secret[j] = static_cast<OtpTypeByte>(i * 31 + j * 7);
+        }
+
+        Generators.push_back(std::make_unique<OtpGeneratorRfc6238>(OtpHashMode::Sha1, 6, 30));
+        Generators.back()->ImportSecretRaw(Secret, sizeof(Secret));
+        Caches.push_back(std::make_unique<OtpTotpCodeCache>(*Generators.back(), 1, 1));
+    }
+
+    std::vector<Request> Trace;
+    uint64_t Random = 0x9E3779B97F4A7C15ULL;
+    auto Next = [&Random]() {
+        Random ^= Random << 13;
+        Random ^= Random >> 7;
+        Random ^= Random << 17;
+        return Random;
+    };
+
+    while (Trace.size() < RequestCount) {
+        OtpTypeSize User = Next() % UserCount;
+        OtpTypeUInt64 Time = 1700000000 + Trace.size() / 100;
+        uint64_t Dice = Next() % 100;
+        OtpTypeSize Attempts = Dice < 55 ? 1 : Dice < 80 ? 2 : Dice < 92 ? 3 : 4;
+        OtpTypeUInt32 Code = Generators[User]->GenerateCode(Time);
+
+        for (OtpTypeSize i = 0; i < Attempts; ++i) {
+            Trace.push_back(Request{ User, Time, Code });
+        }
+    }
+
+    OtpBenchmarkRun("TotpCodeCache/Retries/Generator", Trace.size(), [&](uint64_t i) {
+        const Request& Item = Trace[i % Trace.size()];
+        OtpBenchmarkConsume(Generators[Item.User]->VerifyWindow(Item.Code, Item.Time, 1, 1).value_or(-100));
+    });
+
+    OtpBenchmarkRun("TotpCodeCache/Retries/Cache", Trace.size(), [&](uint64_t i) {
+        const Request& Item = Trace[i % Trace.size()];
+        OtpBenchmarkConsume(Caches[Item.User]->VerifyWindow(Item.Code, Item.Time).value_or(-100));
+    });
+
+    // the timed run includes a warm-up, so count hits over one clean pass instead.
+    for (const auto& Cache : Caches) {
+        Cache->ResetCounters();
+    }
+    for (const Request& Item : Trace) {
+        OtpBenchmarkConsume(Caches[Item.User]->VerifyWindow(Item.Code, Item.Time).value_or(-100));
+    }
+
+    OtpTypeUInt64 HitCount = 0;
+    OtpTypeUInt64 MissCount = 0;
+    for (const auto& Cache : Caches) {
+        HitCount += Cache->GetHitCount();
+        MissCount += Cache->GetMissCount();
+    }
+
+    printf("%-48s %12.1f %%\n", "TotpCodeCache/Retries/HitRate", 100.0 * static_cast<double>(HitCount) / static_cast<double>(HitCount + MissCount));
+
+    //
+    // one hot user verified from every thread at once: readers of a stable window share it without writing.
+    //
+    OtpTotpCodeCache& HotCache = *Caches[0];
+    OtpTypeUInt32 HotCode = Generators[0]->GenerateCode(1700000000);
+
+    for (unsigned ThreadCount : { 1u, 4u, 16u }) {
+        OtpBenchmarkRunThreads("TotpCodeCache/HotUser/" + std::to_string(ThreadCount) + "T", ThreadCount, 200000, [&](unsigned, uint64_t) {
+            OtpBenchmarkConsume(HotCache.VerifyWindow(HotCode, 1700000000).value_or(-100));
+        });
+    }
+}
+
+//
+// validation service shape: N SHA-1 TOTP users in one store, random user per request.
+//
+static void BenchmarkCredentialStore() {
+    static const OtpTypeSize UserCounts[] = { 1000000, 10000000 };
+
+    for (auto UserCount : UserCounts) {
+        OtpCredentialStore Store;
+        std::string Suffix = "/" + std::to_string(UserCount / 1000000) + "M";
+
+        Store.Reserve(UserCount, OtpHashMode::Sha1);
+
+        OtpTypeByte Secret[20] = {};
+        OtpBenchmarkRun("CredentialStore/Insert" + Suffix, UserCount, [&Store, &Secret](uint64_t i) {
+            memcpy(Secret, &i, sizeof(i));
+            Store.Insert(i, OtpHashMode::Sha1, 6, 30, Secret, sizeof(Secret));
+        });
+
+        printf(
+            "%-48s %12.1f bytes/user\n",
+            ("CredentialStore/Memory" + Suffix).c_str(),
+            static_cast<double>(Store.GetMemoryUsage()) / static_cast<double>(Store.GetCount())
+        );
+
+        // xorshift keeps the lookup order unpredictable to the cache without costing a division.
+        uint64_t Random = 0x9E3779B97F4A7C15ULL;
+        auto NextUser = [&Random, UserCount]() {
+            Random ^= Random << 13;
+            Random ^= Random >> 7;
+            Random ^= Random << 17;
+            return Random % UserCount;
+        };
+
+        OtpBenchmarkRun("CredentialStore/Lookup" + Suffix, 2000000, [&](uint64_t) {
+            OtpBenchmarkConsume(Store.Contains(NextUser()));
+        });
+
+        OtpBenchmarkRun("CredentialStore/VerifyTotp-1+1" + Suffix, 500000, [&](uint64_t) {
+            OtpBenchmarkConsume(Store.VerifyTotp(NextUser(), 123456, 1700000000, 1, 1).value_or(-100));
+        });
+    }
+}
+
+//
+// replay protection in front of a verifying service: every thread accepts steps of random users among 1M,
+// through OtpReplayTable and through the mutex-guarded std::unordered_map it replaces.
+//
+static void BenchmarkReplayTable() {
+    static constexpr OtpTypeUInt64 UserCount = 1000000;
+    static constexpr uint64_t OperationCount = 4000000;
+
+    OtpReplayTable Table(UserCount);
+    std::mutex MapLock;
+    std::unordered_map<OtpTypeUInt64, OtpTypeUInt64> Map;
+    Map.reserve(UserCount);
+
+    for (OtpTypeUInt64 User = 0; User < UserCount; ++User) {
+        Table.SetNextCounter(User, 0);
+        Map[User] = 0;
+    }
+
+    printf(
+        "%-48s %12.1f bytes/user\n",
+        "ReplayTable/Memory/1M",
+        static_cast<double>(Table.GetMemoryUsage()) / static_cast<double>(UserCount)
+    );
+
+    for (unsigned ThreadCount : { 1u, 8u, 32u, 64u }) {
+        std::string Suffix = "/" + std::to_string(ThreadCount) + "T";
+        std::vector<uint64_t> Randoms(ThreadCount);
+
+        // xorshift per thread; the step is the iteration, so threads keep racing on the same users' steps.
+        auto NextUser = [&Randoms](unsigned t) {
+            uint64_t& Random = Randoms[t];
+            Random ^= Random << 13;
+            Random ^= Random >> 7;
+            Random ^= Random << 17;
+            return Random % UserCount;
+        };
+
+        for (unsigned t = 0; t < ThreadCount; ++t) {
+            Randoms[t] = 0x9E3779B97F4A7C15ULL * (t + 1);
+        }
+
+        OtpBenchmarkRunThreads("ReplayTable/MutexMap" + Suffix, ThreadCount, OperationCount / ThreadCount, [&](unsigned t, uint64_t i) {
+            OtpTypeUInt64 User = NextUser(t);
+            std::lock_guard<std::mutex> Lock(MapLock);
+            OtpTypeUInt64& Next = Map[User];
+            bool Accepted = i >= Next;
+            if (Accepted) {
+                Next = i + 1;
+            }
+            OtpBenchmarkConsume(Accepted);
+        });
+
+        for (unsigned t = 0; t < ThreadCount; ++t) {
+            Randoms[t] = 0x9E3779B97F4A7C15ULL * (t + 1);
+        }
+
+        OtpBenchmarkRunThreads("ReplayTable/TryAccept" + Suffix, ThreadCount, OperationCount / ThreadCount, [&](unsigned t, uint64_t i) {
+            OtpBenchmarkConsume(Table.TryAccept(NextUser(t), i));
+        });
+    }
+}
+
+//
+// attempt limiting in front of a verifying service over 1M users: random users, where threads rarely meet,
+// and one user under a guessing attack from every thread, where they all hit the same cache line.
+//
+static void BenchmarkThrottleTable() {
+    static constexpr OtpTypeUInt64 UserCount = 1000000;
+    static constexpr uint64_t OperationCount = 4000000;
+
+    OtpThrottleTable Table(UserCount);
+    OtpClockFixed Clock(1700000000);
+
+    for (OtpTypeUInt64 User = 0; User < UserCount; ++User) {
+        OtpBenchmarkConsume(Table.TryAttempt(User, Clock.GetUnixTime()));
+        Table.RecordSuccess(User);
+    }
+
+    printf(
+        "%-48s %12.1f bytes/user\n",
+        "ThrottleTable/Memory/1M",
+        static_cast<double>(Table.GetMemoryUsage()) / static_cast<double>(UserCount)
+    );
+
+    for (unsigned ThreadCount : { 1u, 8u, 32u, 64u }) {
+        std::string Suffix = "/" + std::to_string(ThreadCount) + "T";
+        std::vector<uint64_t> Randoms(ThreadCount);
+
+        for (unsigned t = 0; t < ThreadCount; ++t) {
+            Randoms[t] = 0x9E3779B97F4A7C15ULL * (t + 1);
+        }
+
+        // every tenth attempt succeeds, and the clock moves a second per 100k attempts, so counts decay.
+        OtpBenchmarkRunThreads("ThrottleTable/Random" + Suffix, ThreadCount, OperationCount / ThreadCount, [&](unsigned t, uint64_t i) {
+            uint64_t& Random = Randoms[t];
+            Random ^= Random << 13;
+            Random ^= Random >> 7;
+            Random ^= Random << 17;
+
+            OtpTypeUInt64 User = Random % UserCount;
+            OtpTypeUInt64 UnixTime = t == 0 && i % 100000 == 0 ? Clock.Advance(1) : Clock.GetUnixTime();
+
+            if (Table.TryAttempt(User, UnixTime) && i % 10 == 0) {
+                Table.RecordSuccess(User);
+            }
+        });
+
+        OtpBenchmarkRunThreads("ThrottleTable/HotUser" + Suffix, ThreadCount, OperationCount / ThreadCount, [&](unsigned, uint64_t) {
+            OtpBenchmarkConsume(Table.TryAttempt(UserCount / 2, Clock.GetUnixTime()));
+        });
+    }
+
+    printf(
+        "%-48s %12llu lockouts %12llu rejected\n",
+        "ThrottleTable/Totals",
+        static_cast<unsigned long long>(Table.GetLockoutCount()),
+        static_cast<unsigned long long>(Table.GetRejectedCount())
+    );
+}
+
+//
+// a frontend handing verifications to OtpVerifyExecutor: the synchronous store call for reference, the
+// executor saturated by blocking submits, then open-loop arrivals from 1k to 1M requests/s with their
+// submit-to-callback latency. Requests the full queue refuses are shed, not retried.
+//
+static void BenchmarkVerifyExecutor() {
+    static constexpr OtpTypeUInt64 UserCount = 100000;
+    static constexpr OtpTypeUInt64 SaturatedCount = 1000000;
+
+    OtpCredentialStore Store;
+    Store.Reserve(UserCount, OtpHashMode::Sha1);
+
+    OtpTypeByte Secret[20] = {};
+    for (OtpTypeUInt64 User = 0; User < UserCount; ++User) {
+        memcpy(Secret, &User, sizeof(User));
+        Store.Insert(User, OtpHashMode::Sha1, 6, 30, Secret, sizeof(Secret));
+    }
+
+    auto MakeRequest = [](uint64_t i) {
+        return OtpCredentialStore::VerifyRequest::Totp((i * 0x9E3779B97F4A7C15ULL) % UserCount, 123456, 1700000000 + i / 1000);
+    };
+
+    OtpBenchmarkRun("VerifyExecutor/Synchronous", 500000, [&](uint64_t i) {
+        auto Request = MakeRequest(i);
+        OtpBenchmarkConsume(Store.VerifyTotp(Request.UserId, Request.Code, Request.CounterOrTime).value_or(-100));
+    });
+
+    {
+        OtpVerifyExecutor Executor(Store);
+        std::atomic<uint64_t> Completed(0);
+
+        auto Start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < SaturatedCount; ++i) {
+            Executor.Submit(MakeRequest(i), [](void* lpContext, const OtpCredentialStore::VerifyResult&) {
+                static_cast<std::atomic<uint64_t>*>(lpContext)->fetch_add(1, std::memory_order_relaxed);
+            }, &Completed);
+        }
+        while (Completed.load(std::memory_order_relaxed) != SaturatedCount) {
+            std::this_thread::yield();
+        }
+        auto Stop = std::chrono::steady_clock::now();
+
+        double NanosecondsPerOp = std::chrono::duration<double, std::nano>(Stop - Start).count() / static_cast<double>(SaturatedCount);
+
+        printf(
+            "%-48s %12.1f ns/op %14.0f ops/s %14.1f per batch\n",
+            ("VerifyExecutor/Saturated/" + std::to_string(Executor.GetWorkerCount()) + "W").c_str(),
+            NanosecondsPerOp,
+            1e9 / NanosecondsPerOp,
+            static_cast<double>(Executor.GetCompletedCount()) / static_cast<double>(Executor.GetBatchCount())
+        );
+    }
+
+    struct Sample {
+        std::chrono::steady_clock::time_point   Submitted;
+        std::atomic<uint64_t>*                  lpCompleted;
+        int64_t                                 LatencyNs;
+    };
+
+    for (uint64_t Rate : { 1000u, 10000u, 100000u, 1000000u }) {
+        OtpVerifyExecutor Executor(Store, 0, 4096);
+        uint64_t Count = std::max<uint64_t>(Rate / 2, 500);
+        std::vector<Sample> Samples(Count);
+        std::atomic<uint64_t> Completed(0);
+        uint64_t Accepted = 0;
+
+        auto Start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < Count; ++i) {
+            auto Due = Start + std::chrono::nanoseconds(i * 1000000000 / Rate);
+            while (std::chrono::steady_clock::now() < Due) {
+                std::this_thread::yield();
+            }
+
+            Sample& Item = Samples[i];
+            Item.Submitted = std::chrono::steady_clock::now();
+            Item.lpCompleted = &Completed;
+            Item.LatencyNs = -1;
+
+            bool Queued = Executor.TrySubmit(MakeRequest(i), [](void* lpContext, const OtpCredentialStore::VerifyResult&) {
+                Sample* lpItem = static_cast<Sample*>(lpContext);
+                lpItem->LatencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - lpItem->Submitted).count();
+                lpItem->lpCompleted->fetch_add(1, std::memory_order_release);
+            }, &Item);
+
+            Accepted += Queued ? 1 : 0;
+        }
+        while (Completed.load(std::memory_order_acquire) != Accepted) {
+            std::this_thread::yield();
+        }
+        auto Stop = std::chrono::steady_clock::now();
+
+        std::vector<int64_t> Latencies;
+        Latencies.reserve(Accepted);
+        for (const Sample& Item : Samples) {
+            if (Item.LatencyNs >= 0) {
+                Latencies.push_back(Item.LatencyNs);
+            }
+        }
+        std::sort(Latencies.begin(), Latencies.end());
+
+        printf(
+            "%-48s %12.0f req/s %10.1f us p50 %10.1f us p99 %10llu shed\n",
+            ("VerifyExecutor/OpenLoop/" + std::to_string(Rate) + "/s").c_str(),
+            static_cast<double>(Accepted) / std::chrono::duration<double>(Stop - Start).count(),
+            Latencies.empty() ? 0.0 : static_cast<double>(Latencies[Latencies.size() / 2]) / 1000.0,
+            Latencies.empty() ? 0.0 : static_cast<double>(Latencies[Latencies.size() * 99 / 100]) / 1000.0,
+            static_cast<unsigned long long>(Count - Accepted)
+        );
+    }
+}
+
+//
+// secret provisioning: Base32 text <-> raw bytes, the portable one-group-at-a-time code against the
+// dispatching entry points (SSE4.1/AVX2 block kernels on x86), and the std::string API on top.
+//
+static void BenchmarkBase32() {
+    static const OtpTypeSize Sizes[] = { 20, 64, 4096 };
+
+    for (auto cbBytes : Sizes) {
+        std::string Suffix = "/" + std::to_string(cbBytes) + "B";
+        OtpByteArray Bytes(cbBytes);
+        for (OtpTypeSize i = 0; i < cbBytes; ++i) {
+            Bytes[i] = static_cast<OtpTypeByte>(i * 131 + 7);
+        }
+
+        std::string Text(Internal::OtpBase32EncodedLength(cbBytes), '\0');
+        OtpByteArray Decoded(Internal::OtpBase32DecodedMaxLength(Text.size()));
+        uint64_t Iterations = 200000000 / (cbBytes + 64);
+
+        auto ReportThroughput = [cbBytes](const OtpBenchmarkResult& Result) {
+            printf("%-48s %12.1f MB/s\n", Result.Name.c_str(), static_cast<double>(cbBytes) * 1e3 / Result.NanosecondsPerOp);
+        };
+
+        ReportThroughput(OtpBenchmarkRun("Base32/Encode/Scalar" + Suffix, Iterations, [&](uint64_t) {
+            Internal::OtpBase32EncodeScalar(Bytes.data(), Bytes.size(), Text.data());
+            OtpBenchmarkConsume(Text[0]);
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base32/Encode/Dispatch" + Suffix, Iterations, [&](uint64_t) {
+            Internal::OtpBase32Encode(Bytes.data(), Bytes.size(), Text.data());
+            OtpBenchmarkConsume(Text[0]);
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base32/OtpBase32EncodeA" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(OtpBase32EncodeA(Bytes).size());
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base32/Decode/Scalar" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(Internal::OtpBase32DecodeScalar(Text.data(), Text.size(), Decoded.data()));
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base32/Decode/Dispatch" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(Internal::OtpBase32Decode(Text.data(), Text.size(), Decoded.data()));
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base32/OtpBase32DecodeA" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(OtpBase32DecodeA(Text).size());
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base32/OtpBase32DecodeA/Buffer" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(OtpBase32DecodeA(Text, Decoded.data(), Decoded.size()));
+        }));
+
+        std::u16string TextUtf16(Text.begin(), Text.end());
+
+        ReportThroughput(OtpBenchmarkRun("Base32/OtpBase32Decode<char16_t>/Buffer" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(OtpBase32Decode<char16_t>(TextUtf16, Decoded.data(), Decoded.size()));
+        }));
+    }
+}
+
+//
+// same shape as BenchmarkBase32, plus a 1 MiB dump to show bulk decode throughput.
+//
+static void BenchmarkBase64() {
+    static const OtpTypeSize Sizes[] = { 20, 4096, 1 << 20 };
+
+    for (auto cbBytes : Sizes) {
+        std::string Suffix = "/" + std::to_string(cbBytes) + "B";
+        OtpByteArray Bytes(cbBytes);
+        for (OtpTypeSize i = 0; i < cbBytes; ++i) {
+            Bytes[i] = static_cast<OtpTypeByte>(i * 131 + 7);
+        }
+
+        std::string Text(Internal::OtpBase64EncodedLength(cbBytes, OtpBase64Alphabet::Standard), '\0');
+        std::string TextUrl(Internal::OtpBase64EncodedLength(cbBytes, OtpBase64Alphabet::Url), '\0');
+        OtpByteArray Decoded(Internal::OtpBase64DecodedMaxLength(Text.size()));
+        uint64_t Iterations = 400000000 / (cbBytes + 64);
+
+        auto ReportThroughput = [cbBytes](const OtpBenchmarkResult& Result) {
+            printf("%-48s %12.1f MB/s\n", Result.Name.c_str(), static_cast<double>(cbBytes) * 1e3 / Result.NanosecondsPerOp);
+        };
+
+        ReportThroughput(OtpBenchmarkRun("Base64/Encode/Scalar" + Suffix, Iterations, [&](uint64_t) {
+            Internal::OtpBase64EncodeScalar(Bytes.data(), Bytes.size(), Text.data(), OtpBase64Alphabet::Standard);
+            OtpBenchmarkConsume(Text[0]);
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base64/Encode/Dispatch" + Suffix, Iterations, [&](uint64_t) {
+            Internal::OtpBase64Encode(Bytes.data(), Bytes.size(), Text.data(), OtpBase64Alphabet::Standard);
+            OtpBenchmarkConsume(Text[0]);
+        }));
+
+        Internal::OtpBase64Encode(Bytes.data(), Bytes.size(), TextUrl.data(), OtpBase64Alphabet::Url);
+
+        ReportThroughput(OtpBenchmarkRun("Base64/Decode/Scalar" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(Internal::OtpBase64DecodeScalar(Text.data(), Text.size(), Decoded.data(), OtpBase64Alphabet::Standard, OtpBase64Mode::Strict));
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base64/Decode/Dispatch/Strict" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(Internal::OtpBase64Decode(Text.data(), Text.size(), Decoded.data(), OtpBase64Alphabet::Standard, OtpBase64Mode::Strict));
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base64/Decode/Dispatch/Lenient" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(Internal::OtpBase64Decode(Text.data(), Text.size(), Decoded.data(), OtpBase64Alphabet::Standard, OtpBase64Mode::Lenient));
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base64/Decode/Dispatch/Url" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(Internal::OtpBase64Decode(TextUrl.data(), TextUrl.size(), Decoded.data(), OtpBase64Alphabet::Url, OtpBase64Mode::Strict));
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base64/OtpBase64DecodeA" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(OtpBase64DecodeA(Text).size());
+        }));
+
+        ReportThroughput(OtpBenchmarkRun("Base64/OtpBase64DecodeA/Buffer" + Suffix, Iterations, [&](uint64_t) {
+            OtpBenchmarkConsume(OtpBase64DecodeA(Text, Decoded.data(), Decoded.size()));
+        }));
+    }
+}
+
+//
+// provisioning: a million otpauth:// URIs through the parser, then parse plus generator construction,
+// which is dominated by the secret import.
+//
+static void BenchmarkAuthUri() {
+    static constexpr uint64_t UriCount = 1000000;
+    static const char* AlgorithmNames[] = { "SHA1", "SHA256", "SHA512" };
+
+    std::vector<std::string> Uris;
+    for (OtpTypeSize i = 0; i < 1024; ++i) {
+        OtpByteArray Secret(20);
+        for (OtpTypeSize j = 0; j < Secret.size(); ++j) {
+            Secret[j] = static_cast<OtpTypeByte>(i * 31 + j * 7);
+        }
+
+        Uris.push_back(
+            "otpauth://totp/Example:user" + std::to_string(i) + "%40example.com?secret=" + OtpBase32EncodeA(Secret) +
+            "&issuer=Example&algorithm=" + AlgorithmNames[i % 3] + "&digits=" + std::to_string(6 + i % 3) + "&period=30"
+        );
+    }
+
+    OtpBenchmarkRun("AuthUri/OtpAuthUriParseA", UriCount, [&](uint64_t i) {
+        OtpBenchmarkConsume(OtpAuthUriParseA(Uris[i % Uris.size()]).Secret.length());
+    });
+
+    OtpBenchmarkRun("AuthUri/OtpAuthUriParseA+CreateTotp", UriCount / 10, [&](uint64_t i) {
+        OtpBenchmarkConsume(OtpAuthUriParseA(Uris[i % Uris.size()]).CreateTotp().GenerateCode(1700000000));
+    });
+
+    char Buffer[256];
+    OtpAuthUriA Uri = OtpAuthUriParseA(Uris[0]);
+
+    OtpBenchmarkRun("AuthUri/OtpAuthUriFormatA/Buffer", UriCount, [&](uint64_t i) {
+        Uri.Period = static_cast<OtpTypeUInt32>(30 + i % 64);
+        OtpBenchmarkConsume(OtpAuthUriFormatA(Uri, Buffer, sizeof(Buffer)));
+    });
+}
+
+//
+// enrolment: a million records, three CSV to one otpauth:// URI, imported from a file into an empty store
+// on one thread and on every hardware thread. items/s is records/s.
+//
+static void BenchmarkCredentialImport() {
+    static constexpr OtpTypeSize RecordCount = 1000000;
+    static const char* AlgorithmNames[] = { "SHA1", "SHA256", "SHA512" };
+    static const char* FilePath = "WindowsOTPBenchmark.import.txt";
+
+    std::string Text;
+    for (OtpTypeSize i = 0; i < RecordCount; ++i) {
+        OtpByteArray Secret(20);
+        for (OtpTypeSize j = 0; j < Secret.size(); ++j) {
+            Secret[j] = static_cast<OtpTypeByte>(i * 31 + j * 7);
+        }
+
+        Text += std::to_string(i);
+        if (i % 4 == 0) {
+            Text += ",otpauth://totp/Example:user" + std::to_string(i) + "?secret=" + OtpBase32EncodeA(Secret) + "&issuer=Example\n";
+        } else {
+            Text += "," + OtpBase32EncodeA(Secret) + "," + AlgorithmNames[i % 3] + "," + std::to_string(6 + i % 3) + ",30\n";
+        }
+    }
+
+    std::ofstream File(FilePath, std::ios::binary | std::ios::trunc);
+    File.write(Text.data(), static_cast<std::streamsize>(Text.size()));
+    File.close();
+    if (File.fail()) {
+        printf("CredentialImport: cannot write %s\n", FilePath);
+        return;
+    }
+
+    std::vector<unsigned> ThreadCounts = { 1 };
+    if (std::thread::hardware_concurrency() > 1) {
+        ThreadCounts.push_back(std::thread::hardware_concurrency());
+    }
+
+    for (auto ThreadCount : ThreadCounts) {
+        OtpBenchmarkRun("CredentialImport/File/" + std::to_string(ThreadCount) + "T", 2, [ThreadCount](uint64_t) {
+            OtpCredentialStore Store;
+            OtpBenchmarkConsume(OtpCredentialImportFileA(Store, FilePath, ThreadCount).RecordCount);
+        }, RecordCount);
+    }
+
+    remove(FilePath);
+}
+
+//
+// one 64-byte compression, portable C++ against the SHA instructions (SHA-NI / ARMv8) when present.
+//
+static void BenchmarkShaTransform() {
+    alignas(16) OtpTypeByte Block[64] = {};
+
+    Internal::OtpHashTraitsSha1::StateType StateSha1 = Internal::OtpHashTraitsSha1::InitialState;
+    Internal::OtpHashTraitsSha256::StateType StateSha256 = Internal::OtpHashTraitsSha256::InitialState;
+
+    OtpBenchmarkRun("Transform/SHA1/Generic", 1000000, [&](uint64_t i) {
+        Block[0] = static_cast<OtpTypeByte>(i);
+        Internal::OtpHashTraitsSha1::TransformGeneric(StateSha1, Block);
+        OtpBenchmarkConsume(StateSha1[0]);
+    });
+
+    OtpBenchmarkRun("Transform/SHA256/Generic", 1000000, [&](uint64_t i) {
+        Block[0] = static_cast<OtpTypeByte>(i);
+        Internal::OtpHashTraitsSha256::TransformGeneric(StateSha256, Block);
+        OtpBenchmarkConsume(StateSha256[0]);
+    });
+
+#if WINOTP_SHA_EXTENSIONS
+    if (Internal::OtpShaExtensionsAvailable()) {
+        OtpBenchmarkRun("Transform/SHA1/ShaExtensions", 1000000, [&](uint64_t i) {
+            Block[0] = static_cast<OtpTypeByte>(i);
+            Internal::OtpSha1TransformShaExtensions(StateSha1.data(), Block);
+            OtpBenchmarkConsume(StateSha1[0]);
+        });
+
+        OtpBenchmarkRun("Transform/SHA256/ShaExtensions", 1000000, [&](uint64_t i) {
+            Block[0] = static_cast<OtpTypeByte>(i);
+            Internal::OtpSha256TransformShaExtensions(StateSha256.data(), Block, Internal::OtpHashTraitsSha256::RoundConstants);
+            OtpBenchmarkConsume(StateSha256[0]);
+        });
+    } else {
+        printf("SHA extensions are not supported by this CPU.\n");
+    }
+#endif
+}
+
+#if WINOTP_SIMD_X86
+//
+// raw multi-buffer kernels, one call per lane group. items/s is HMACs per second.
+//
+static void BenchmarkMultiBufferKernels() {
+    Internal::OtpHmacKeyState<Internal::OtpHashTraitsSha1> KeyStateSha1;
+    Internal::OtpHmacKeyState<Internal::OtpHashTraitsSha256> KeyStateSha256;
+    Internal::OtpHmac<Internal::OtpHashTraitsSha1>::PrepareKeyState(reinterpret_cast<const OtpTypeByte*>("12345678901234567890"), 20, KeyStateSha1);
+    Internal::OtpHmac<Internal::OtpHashTraitsSha256>::PrepareKeyState(reinterpret_cast<const OtpTypeByte*>("12345678901234567890123456789012"), 32, KeyStateSha256);
+
+    OtpTypeUInt64 Counters[Internal::OtpHmacMultiBufferMaxLanes];
+    OtpTypeUInt32 DigestWords[8 * Internal::OtpHmacMultiBufferMaxLanes];
+
+    const auto& KernelList = Internal::OtpHmacMultiBufferKernels();
+    for (OtpTypeSize k = 0; k < KernelList.Count; ++k) {
+        const auto& Kernel = KernelList.Kernels[k];
+
+        OtpBenchmarkRun(
+            std::string("MultiBuffer/SHA1/") + Kernel.Name,
+            100000,
+            [&](uint64_t i) {
+                for (OtpTypeSize Lane = 0; Lane < Kernel.Lanes; ++Lane) {
+                    Counters[Lane] = i * Kernel.Lanes + Lane;
+                }
+                Kernel.HmacSha1(KeyStateSha1, Counters, DigestWords);
+                OtpBenchmarkConsume(DigestWords[0]);
+            },
+            Kernel.Lanes
+        );
+
+        OtpBenchmarkRun(
+            std::string("MultiBuffer/SHA256/") + Kernel.Name,
+            100000,
+            [&](uint64_t i) {
+                for (OtpTypeSize Lane = 0; Lane < Kernel.Lanes; ++Lane) {
+                    Counters[Lane] = i * Kernel.Lanes + Lane;
+                }
+                Kernel.HmacSha256(KeyStateSha256, Counters, DigestWords);
+                OtpBenchmarkConsume(DigestWords[0]);
+            },
+            Kernel.Lanes
+        );
+    }
+}
+#endif
+
+//
+// what the instrumentation recorded over the whole run; main only calls it when built with WINOTP_INSTRUMENTATION.
+//
+static void PrintInstrumentation() {
+    auto Snapshot = OtpInstrumentationTakeSnapshot();
+
+    printf("\n%-16s %14s %12s %12s %12s\n", "Operation", "count", "mean ns", "p50 ns", "p99 ns");
+
+    for (OtpTypeSize i = 0; i < OtpInstrumentedOperationCount; ++i) {
+        const auto& Histogram = Snapshot.Operations[i];
+
+        printf(
+            "%-16s %14llu %12.1f %12llu %12llu\n",
+            OtpInstrumentationGetName(static_cast<OtpInstrumentedOperation>(i)),
+            static_cast<unsigned long long>(Histogram.Count),
+            Histogram.GetMeanNanoseconds(),
+            static_cast<unsigned long long>(Histogram.GetPercentileNanoseconds(50)),
+            static_cast<unsigned long long>(Histogram.GetPercentileNanoseconds(99))
+        );
+    }
+
+    printf("\nTOTP drift:");
+    for (OtpTypeInt64 Offset = -OtpInstrumentationSnapshot::MaxDrift; Offset <= OtpInstrumentationSnapshot::MaxDrift; ++Offset) {
+        if (Snapshot.GetDriftCount(Offset) != 0) {
+            printf(" %+lld:%llu", static_cast<long long>(Offset), static_cast<unsigned long long>(Snapshot.GetDriftCount(Offset)));
+        }
+    }
+    printf(" rejected:%llu\n", static_cast<unsigned long long>(Snapshot.DriftRejectedCount));
+}
+
+//
+// "--csv <path>" also writes every result to a CSV file for comparing builds.
+//
+int main(int argc, char* argv[]) {
+    if (argc == 3 && strcmp(argv[1], "--csv") == 0) {
+        if (OtpBenchmarkOpenReport(argv[2]) == false) {
+            printf("Cannot write %s.\n", argv[2]);
+            return 1;
+        }
+    } else if (argc != 1) {
+        printf("Usage: WindowsOTPBenchmark [--csv <path>]\n");
+        return 1;
+    }
+
+    if (CheckShaTransform() == false || CheckBase32Codec() == false || CheckBase64Codec() == false || CheckAuthUri() == false) {
+        return 1;
+    }
+
+    if (CheckClock() == false || CheckTotpCodeCache() == false || CheckCredentialImport() == false || CheckReplayTable() == false || CheckThrottleTable() == false || CheckVerifyExecutor() == false) {
+        return 1;
+    }
+
+    for (auto HashBackend : AvailableBackends()) {
+        if (CheckRfcTestVectors(HashBackend) == false || CheckBatchGeneration(HashBackend) == false || CheckConcurrentGeneration(HashBackend) == false || CheckZeroAllocation(HashBackend) == false) {
+            return 1;
+        }
+    }
+
+#if WINOTP_SIMD_X86
+    if (CheckMultiBufferKernels() == false) {
+        return 1;
+    }
+#endif
+
+    BenchmarkShaTransform();
+    BenchmarkGenerateCode();
+    BenchmarkStaticGenerator();
+    BenchmarkGenerateCodes();
+    BenchmarkConcurrentGeneration();
+    BenchmarkGeneratorStartup();
+    BenchmarkVerifyWindow();
+    BenchmarkClock();
+    BenchmarkTotpCodeCache();
+    BenchmarkCredentialStore();
+    BenchmarkReplayTable();
+    BenchmarkThrottleTable();
+    BenchmarkVerifyExecutor();
+    BenchmarkBase32();
+    BenchmarkBase64();
+    BenchmarkAuthUri();
+    BenchmarkCredentialImport();
+#if WINOTP_SIMD_X86
+    BenchmarkMultiBufferKernels();
+#endif
+
+    if (OtpInstrumentationEnabled) {
+        PrintInstrumentation();
+    }
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+#pragma once
+#include "OtpDaemonSocket.hpp"
+#include <OtpVerifyProtocol.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace WinOTP::Daemon {
+
+    //
+    // Closed-loop load generator for OtpDaemonServer.
+    //
+    // Every connection runs on its own thread with a blocking socket and keeps Depth requests in flight: it
+    // writes Depth frames, then for every response it reads writes one more, so the server always sees
+    // pipelined input. Requests are taken round-robin from a prepared workload whose frames carry their own
+    // time, so the daemon's answers are deterministic and each one is checked against the expected status.
+    //
+    // Latency is measured from the write that carried a request to the read that returned its response, for
+    // one request in LatencySampleRate. Both sides of a pipelined exchange are timed once per system call, so
+    // the clock does not dominate at high rates.
+    //
+    class OtpDaemonLoadClient {
+    public:
+
+        static constexpr OtpTypeSize LatencySampleRate = 16;
+
+        struct Workload {
+            std::vector<OtpCredentialStore::VerifyRequest>  Requests;
+            std::vector<OtpCredentialStore::VerifyStatus>   ExpectedStatuses;
+        };
+
+        struct Report {
+            OtpTypeUInt64   RequestCount;
+            OtpTypeUInt64   AcceptedCount;
+            OtpTypeUInt64   MismatchCount;      // responses whose status or tag was not the expected one
+            double          Seconds;
+            double          P50Microseconds;
+            double          P99Microseconds;
+
+            [[nodiscard]]
+            double GetRequestsPerSecond() const noexcept {
+                return Seconds > 0 ? RequestCount / Seconds : 0;
+            }
+        };
+
+    private:
+
+        struct ConnectionReport {
+            OtpTypeUInt64               RequestCount = 0;
+            OtpTypeUInt64               AcceptedCount = 0;
+            OtpTypeUInt64               MismatchCount = 0;
+            std::vector<double>         Latencies;
+        };
+
+        static void RunConnection(
+            const char* lpszSocketPath,
+            const Workload& Load,
+            const std::vector<OtpTypeByte>& Frames,
+            OtpTypeSize Depth,
+            OtpTypeSize FirstRequest,
+            const std::atomic<bool>& Stopping,
+            ConnectionReport& Result)
+        {
+            using Clock = std::chrono::steady_clock;
+
+            OtpDaemonSocket Connection = OtpDaemonConnect(lpszSocketPath);
+            OtpTypeSize RequestCount = Load.Requests.size();
+            std::vector<OtpTypeByte> Output(Depth * OtpVerifyProtocolRequestSize);
+            std::vector<OtpTypeByte> Input(Depth * OtpVerifyProtocolResponseSize);
+            std::vector<Clock::time_point> SendTimes(Depth);
+            OtpTypeSize cbInput = 0;
+            OtpTypeUInt64 NextTag = 0;
+            OtpTypeUInt64 ExpectedTag = 0;
+
+            //
+            // writes Count frames, tagged with consecutive sequence numbers, and remembers when.
+            //
+            auto SendFrames = [&](OtpTypeSize Count) {
+                for (OtpTypeSize i = 0; i < Count; ++i, ++NextTag) {
+                    OtpTypeByte* lpFrame = Output.data() + i * OtpVerifyProtocolRequestSize;
+                    memcpy(lpFrame, Frames.data() + ((FirstRequest + NextTag) % RequestCount) * OtpVerifyProtocolRequestSize, OtpVerifyProtocolRequestSize);
+                    OtpSerializationIntegerToBytes<OtpSerializationEndian::Little>(NextTag, lpFrame);
+                }
+
+                auto SendTime = Clock::now();
+                for (OtpTypeUInt64 Tag = NextTag - Count; Tag < NextTag; ++Tag) {
+                    if (Tag % LatencySampleRate == 0) {
+                        SendTimes[Tag % Depth] = SendTime;
+                    }
+                }
+
+                for (OtpTypeSize cbSent = 0; cbSent < Count * OtpVerifyProtocolRequestSize;) {
+                    auto cbChunk = OtpDaemonSend(Connection.Get(), Output.data() + cbSent, Count * OtpVerifyProtocolRequestSize - cbSent);
+                    if (cbChunk.value_or(0) == 0) {
+                        throw std::runtime_error("Connection to the daemon was lost.");
+                    }
+                    cbSent += cbChunk.value();
+                }
+            };
+
+            SendFrames(Depth);
+
+            while (ExpectedTag < NextTag) {
+                auto cbReceived = OtpDaemonReceive(Connection.Get(), Input.data() + cbInput, Input.size() - cbInput);
+                if (cbReceived.value_or(0) == 0) {
+                    throw std::runtime_error("Connection to the daemon was lost.");
+                }
+
+                auto ReceiveTime = Clock::now();
+                cbInput += cbReceived.value();
+
+                OtpTypeSize ResponseCount = cbInput / OtpVerifyProtocolResponseSize;
+
+                for (OtpTypeSize i = 0; i < ResponseCount; ++i, ++ExpectedTag) {
+                    auto Response = OtpVerifyProtocolDecodeResponse(Input.data() + i * OtpVerifyProtocolResponseSize);
+                    auto ExpectedStatus = Load.ExpectedStatuses[(FirstRequest + ExpectedTag) % RequestCount];
+
+                    if (Response.Tag != ExpectedTag || static_cast<int>(Response.Status) != static_cast<int>(ExpectedStatus)) {
+                        ++Result.MismatchCount;
+                    }
+
+                    if (Response.Status == OtpVerifyProtocolStatus::Accepted) {
+                        ++Result.AcceptedCount;
+                    }
+
+                    if (ExpectedTag % LatencySampleRate == 0) {
+                        Result.Latencies.push_back(std::chrono::duration<double, std::micro>(ReceiveTime - SendTimes[ExpectedTag % Depth]).count());
+                    }
+                }
+
+                Result.RequestCount += ResponseCount;
+                memmove(Input.data(), Input.data() + ResponseCount * OtpVerifyProtocolResponseSize, cbInput - ResponseCount * OtpVerifyProtocolResponseSize);
+                cbInput -= ResponseCount * OtpVerifyProtocolResponseSize;
+
+                if (ResponseCount != 0 && Stopping.load(std::memory_order_relaxed) == false) {
+                    SendFrames(ResponseCount);
+                }
+            }
+        }
+
+    public:
+
+        //
+        // runs ConnectionCount connections with Depth requests in flight each for Seconds, then waits for
+        // the outstanding responses. Throws if a connection fails.
+        //
+        [[nodiscard]]
+        static Report Run(const char* lpszSocketPath, const Workload& Load, unsigned ConnectionCount, OtpTypeSize Depth, double Seconds) {
+            if (Load.Requests.empty() || ConnectionCount == 0 || Depth == 0) {
+                throw std::invalid_argument("Load needs requests, connections and a depth.");
+            }
+
+            std::vector<OtpTypeByte> Frames(Load.Requests.size() * OtpVerifyProtocolRequestSize);
+            for (OtpTypeSize i = 0; i < Load.Requests.size(); ++i) {
+                OtpVerifyProtocolEncodeRequest(0, Load.Requests[i], Frames.data() + i * OtpVerifyProtocolRequestSize);
+            }
+
+            std::atomic<bool> Stopping(false);
+            std::vector<ConnectionReport> Reports(ConnectionCount);
+            std::vector<std::thread> Threads;
+            std::exception_ptr Error;
+            std::mutex ErrorLock;
+
+            auto StartTime = std::chrono::steady_clock::now();
+
+            for (unsigned i = 0; i < ConnectionCount; ++i) {
+                Threads.emplace_back([&, i]() {
+                    try {
+                        RunConnection(lpszSocketPath, Load, Frames, Depth, Load.Requests.size() * i / ConnectionCount, Stopping, Reports[i]);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> Lock(ErrorLock);
+                        Error = std::current_exception();
+                    }
+                });
+            }
+
+            std::this_thread::sleep_for(std::chrono::duration<double>(Seconds));
+            Stopping.store(true, std::memory_order_relaxed);
+
+            for (auto& Thread : Threads) {
+                Thread.join();
+            }
+
+            auto Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime);
+
+            if (Error) {
+                std::rethrow_exception(Error);
+            }
+
+            Report Result = { 0, 0, 0, Elapsed.count(), 0, 0 };
+            std::vector<double> Latencies;
+
+            for (auto& ConnectionResult : Reports) {
+                Result.RequestCount += ConnectionResult.RequestCount;
+                Result.AcceptedCount += ConnectionResult.AcceptedCount;
+                Result.MismatchCount += ConnectionResult.MismatchCount;
+                Latencies.insert(Latencies.end(), ConnectionResult.Latencies.begin(), ConnectionResult.Latencies.end());
+            }
+
+            if (Latencies.empty() == false) {
+                std::sort(Latencies.begin(), Latencies.end());
+                Result.P50Microseconds = Latencies[Latencies.size() / 2];
+                Result.P99Microseconds = Latencies[Latencies.size() * 99 / 100];
+            }
+
+            return Result;
+        }
+    };
+
+}
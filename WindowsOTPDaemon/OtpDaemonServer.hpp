@@ -0,0 +1,379 @@
+#pragma once
+#include "OtpDaemonSocket.hpp"
+#include <OtpVerifyProtocol.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace WinOTP::Daemon {
+
+    //
+    // Verification server speaking OtpVerifyProtocol over a Unix domain socket.
+    //
+    // Every thread runs its own event loop over the shared non-blocking listener and the connections it
+    // accepted, so a connection is only ever touched by one thread and needs no locks. A readable connection
+    // is drained into its input buffer, every complete request frame in it is decoded, up to MaxBatchSize at a
+    // time, and the batch is answered with one OtpCredentialStore::VerifyBatch call. Clients that pipeline
+    // many requests per write therefore get whole batches verified per wake-up, which is where the throughput
+    // comes from.
+    //
+    // Responses are appended to the connection's output buffer and flushed at once; whatever the socket does
+    // not take is sent when it becomes writable again. A client that keeps writing without reading is not
+    // read from while more than MaxPendingOutput bytes wait for it.
+    //
+    // An error on one connection, including running out of memory for its output, closes that connection
+    // only. When accept fails for any reason but an empty queue, typically because the process is out of
+    // descriptors, the loop leaves the listener alone for AcceptBackoffMilliseconds: it is level-triggered and
+    // would otherwise wake the loop again at once for the connection it cannot take.
+    //
+    // The store is only read; it must outlive the server and must not be modified while it runs.
+    //
+    class OtpDaemonServer {
+    public:
+
+        static constexpr OtpTypeSize MaxBatchSize = 64;
+        static constexpr OtpTypeSize InputBufferSize = 64 * 1024;
+        static constexpr OtpTypeSize MaxPendingOutput = 1024 * 1024;
+        static constexpr int AcceptBackoffMilliseconds = 100;
+
+    private:
+
+        struct Connection {
+            OtpDaemonSocket             Socket;
+            std::unique_ptr<OtpTypeByte[]> lpInput;
+            OtpTypeSize                 cbInput;
+            std::vector<OtpTypeByte>    Output;
+            OtpTypeSize                 iOutput;    // bytes of Output already sent
+            bool                        WantRead;
+            bool                        WantWrite;
+
+            explicit Connection(OtpDaemonSocket&& Accepted) :
+                Socket(std::move(Accepted)),
+                lpInput(new OtpTypeByte[InputBufferSize]),
+                cbInput(0),
+                iOutput(0),
+                WantRead(true),
+                WantWrite(false) {}
+        };
+
+        using ConnectionMap = std::unordered_map<Connection*, std::unique_ptr<Connection>>;
+
+        const OtpCredentialStore&       m_Store;
+        OtpDaemonSocket                 m_Listener;
+        std::atomic<bool>               m_Stopping;
+
+        std::atomic<OtpTypeUInt64>      m_ConnectionCount;
+        std::atomic<OtpTypeUInt64>      m_RequestCount;
+        std::atomic<OtpTypeUInt64>      m_BatchCount;
+
+        //
+        // answers every complete frame in the input buffer and keeps the incomplete tail.
+        //
+        void ProcessInput(Connection& Client) {
+            OtpCredentialStore::VerifyRequest Requests[MaxBatchSize];
+            OtpCredentialStore::VerifyResult Results[MaxBatchSize];
+            OtpTypeUInt64 Tags[MaxBatchSize];
+            bool Decoded[MaxBatchSize];
+            OtpTypeSize FrameCount = Client.cbInput / OtpVerifyProtocolRequestSize;
+            OtpTypeUInt64 BatchCount = 0;
+
+            for (OtpTypeSize Base = 0; Base < FrameCount; Base += MaxBatchSize) {
+                OtpTypeSize Size = FrameCount - Base < MaxBatchSize ? FrameCount - Base : MaxBatchSize;
+                OtpTypeSize Count = 0;
+
+                for (OtpTypeSize i = 0; i < Size; ++i) {
+                    const OtpTypeByte* lpFrame = Client.lpInput.get() + (Base + i) * OtpVerifyProtocolRequestSize;
+
+                    Decoded[i] = OtpVerifyProtocolDecodeRequest(lpFrame, Tags[i], Requests[Count]);
+                    if (Decoded[i]) {
+                        ++Count;
+                    }
+                }
+
+                if (Count != 0) {
+                    m_Store.VerifyBatch(Requests, Count, Results);
+                    ++BatchCount;
+                }
+
+                //
+                // malformed frames took no request slot, so results are matched back to frames in order.
+                //
+                OtpTypeSize iResponse = Client.Output.size();
+                Client.Output.resize(iResponse + Size * OtpVerifyProtocolResponseSize);
+
+                for (OtpTypeSize i = 0, iResult = 0; i < Size; ++i) {
+                    OtpTypeByte* lpResponse = Client.Output.data() + iResponse + i * OtpVerifyProtocolResponseSize;
+
+                    if (Decoded[i]) {
+                        OtpVerifyProtocolEncodeResponse(Tags[i], Results[iResult++], lpResponse);
+                    } else {
+                        OtpVerifyProtocolEncodeResponse(Tags[i], OtpVerifyProtocolStatus::Malformed, 0, lpResponse);
+                    }
+                }
+            }
+
+            OtpTypeSize cbConsumed = FrameCount * OtpVerifyProtocolRequestSize;
+            if (cbConsumed != 0) {
+                memmove(Client.lpInput.get(), Client.lpInput.get() + cbConsumed, Client.cbInput - cbConsumed);
+                Client.cbInput -= cbConsumed;
+            }
+
+            m_RequestCount.fetch_add(FrameCount, std::memory_order_relaxed);
+            m_BatchCount.fetch_add(BatchCount, std::memory_order_relaxed);
+        }
+
+        //
+        // false once the peer is gone.
+        //
+        [[nodiscard]]
+        bool Receive(Connection& Client) {
+            for (;;) {
+                if (Client.Output.size() - Client.iOutput > MaxPendingOutput) {
+                    return true;
+                }
+
+                auto cbReceived = OtpDaemonReceive(Client.Socket.Get(), Client.lpInput.get() + Client.cbInput, InputBufferSize - Client.cbInput);
+
+                if (cbReceived.has_value() == false) {
+                    return true;
+                } else if (cbReceived.value() == 0) {
+                    return false;
+                }
+
+                Client.cbInput += cbReceived.value();
+                ProcessInput(Client);
+            }
+        }
+
+        //
+        // false once the peer is gone.
+        //
+        [[nodiscard]]
+        bool Flush(Connection& Client) {
+            while (Client.iOutput < Client.Output.size()) {
+                auto cbSent = OtpDaemonSend(Client.Socket.Get(), Client.Output.data() + Client.iOutput, Client.Output.size() - Client.iOutput);
+
+                if (cbSent.has_value() == false) {
+                    break;
+                } else if (cbSent.value() == 0) {
+                    return false;
+                }
+
+                Client.iOutput += cbSent.value();
+            }
+
+            if (Client.iOutput == Client.Output.size()) {
+                Client.Output.clear();
+                Client.iOutput = 0;
+            }
+
+            return true;
+        }
+
+        //
+        // takes every pending connection. Returns false if accept failed for a reason other than an empty
+        // queue, or a connection could not be set up, in which case that connection is closed.
+        //
+        [[nodiscard]]
+        bool AcceptPending(OtpDaemonPoller& Poller, ConnectionMap& Connections) noexcept {
+            try {
+                for (;;) {
+                    OtpDaemonSocket Accepted = OtpDaemonAccept(m_Listener.Get());
+                    if (Accepted.IsValid() == false) {
+                        return true;
+                    }
+
+                    auto lpClient = std::make_unique<Connection>(std::move(Accepted));
+                    Connection* lpKey = lpClient.get();
+                    Connections.emplace(lpKey, std::move(lpClient));
+
+                    try {
+                        Poller.Watch(lpKey->Socket.Get(), lpKey, true, false);
+                    } catch (...) {
+                        Connections.erase(lpKey);
+                        throw;
+                    }
+
+                    m_ConnectionCount.fetch_add(1, std::memory_order_relaxed);
+                }
+            } catch (const std::exception&) {
+                return false;
+            }
+        }
+
+        //
+        // runs until Stop is called, over a Poller that already watches the listener.
+        //
+        void EventLoop(OtpDaemonPoller& Poller) {
+            ConnectionMap Connections;
+            OtpDaemonPoller::Event Events[64];
+            bool AcceptPaused = false;
+            std::chrono::steady_clock::time_point AcceptResumeTime;
+
+            while (m_Stopping.load(std::memory_order_relaxed) == false) {
+                if (AcceptPaused && std::chrono::steady_clock::now() >= AcceptResumeTime) {
+                    try {
+                        Poller.Watch(m_Listener.Get(), nullptr, true, false, true);
+                        AcceptPaused = false;
+                    } catch (const std::exception&) {
+                        AcceptResumeTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(AcceptBackoffMilliseconds);
+                    }
+                }
+
+                OtpTypeSize EventCount = Poller.Wait(Events, 64, 100);
+
+                for (OtpTypeSize i = 0; i < EventCount; ++i) {
+                    if (Events[i].lpContext == nullptr) {
+                        if (AcceptPending(Poller, Connections) == false) {
+                            Poller.Forget(m_Listener.Get());
+                            AcceptPaused = true;
+                            AcceptResumeTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(AcceptBackoffMilliseconds);
+                        }
+                        continue;
+                    }
+
+                    Connection& Client = *static_cast<Connection*>(Events[i].lpContext);
+                    bool Alive = true;
+
+                    try {
+                        if (Events[i].Readable && Client.WantRead) {
+                            Alive = Receive(Client);
+                        }
+
+                        if (Alive && (Events[i].Writable || Client.Output.empty() == false)) {
+                            Alive = Flush(Client);
+                        }
+
+                        if (Alive) {
+                            bool WantRead = Client.Output.size() - Client.iOutput <= MaxPendingOutput;
+                            bool WantWrite = Client.iOutput < Client.Output.size();
+
+                            if (WantRead != Client.WantRead || WantWrite != Client.WantWrite) {
+                                Poller.Modify(Client.Socket.Get(), &Client, WantRead, WantWrite);
+                                Client.WantRead = WantRead;
+                                Client.WantWrite = WantWrite;
+                            }
+                        }
+                    } catch (const std::exception&) {
+                        Alive = false;
+                    }
+
+                    if (Alive == false) {
+                        Poller.Forget(Client.Socket.Get());
+                        Connections.erase(&Client);
+                    }
+                }
+            }
+
+            for (auto& Entry : Connections) {
+                Poller.Forget(Entry.first->Socket.Get());
+            }
+
+            Poller.Forget(m_Listener.Get());
+        }
+
+    public:
+
+        //
+        // listens on lpszSocketPath, replacing a socket file left behind by a previous run.
+        //
+        OtpDaemonServer(const OtpCredentialStore& Store, const char* lpszSocketPath) :
+            m_Store(Store),
+            m_Listener(OtpDaemonListen(lpszSocketPath)),
+            m_Stopping(false),
+            m_ConnectionCount(0),
+            m_RequestCount(0),
+            m_BatchCount(0) {}
+
+        OtpDaemonServer(const OtpDaemonServer& Other) = delete;
+
+        OtpDaemonServer& operator=(const OtpDaemonServer& Other) = delete;
+
+        //
+        // runs ThreadCount event loops (0 uses every hardware thread) until Stop is called. Every loop's poller
+        // is set up before any loop runs, so once one connection has been answered all of them are serving.
+        // An error that is not confined to one connection stops every loop and is rethrown here, whichever
+        // thread it happened on.
+        //
+        void Run(unsigned ThreadCount = 0) {
+            if (ThreadCount == 0) {
+                ThreadCount = std::thread::hardware_concurrency();
+            }
+            if (ThreadCount == 0) {
+                ThreadCount = 1;
+            }
+
+            std::vector<std::unique_ptr<OtpDaemonPoller>> Pollers;
+            std::vector<std::exception_ptr> Errors(ThreadCount);
+            std::vector<std::thread> Threads;
+
+            for (unsigned i = 0; i < ThreadCount; ++i) {
+                Pollers.push_back(std::make_unique<OtpDaemonPoller>());
+                Pollers.back()->Watch(m_Listener.Get(), nullptr, true, false, true);
+            }
+
+            Threads.reserve(ThreadCount - 1);
+
+            try {
+                for (unsigned i = 1; i < ThreadCount; ++i) {
+                    Threads.emplace_back([this, &Poller = *Pollers[i], &Error = Errors[i]]() {
+                        try {
+                            EventLoop(Poller);
+                        } catch (...) {
+                            Error = std::current_exception();
+                            Stop();
+                        }
+                    });
+                }
+                EventLoop(*Pollers[0]);
+            } catch (...) {
+                Stop();
+                for (auto& Thread : Threads) {
+                    Thread.join();
+                }
+                throw;
+            }
+
+            for (auto& Thread : Threads) {
+                Thread.join();
+            }
+
+            for (auto& Error : Errors) {
+                if (Error) {
+                    std::rethrow_exception(Error);
+                }
+            }
+        }
+
+        //
+        // may be called from any thread. Event loops notice within 100 milliseconds.
+        //
+        void Stop() noexcept {
+            m_Stopping.store(true, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetConnectionCount() const noexcept {
+            return m_ConnectionCount.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        OtpTypeUInt64 GetRequestCount() const noexcept {
+            return m_RequestCount.load(std::memory_order_relaxed);
+        }
+
+        //
+        // VerifyBatch calls so far; GetRequestCount() / GetBatchCount() is the mean batch size.
+        //
+        [[nodiscard]]
+        OtpTypeUInt64 GetBatchCount() const noexcept {
+            return m_BatchCount.load(std::memory_order_relaxed);
+        }
+    };
+
+}
@@ -0,0 +1,407 @@
+#pragma once
+
+//
+// winsock2.h must come before windows.h, which WinOTP.hpp pulls in.
+//
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "ws2_32")
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+#include <WinOTP.hpp>
+#include <Internal/OtpResource.hpp>
+
+namespace WinOTP::Daemon {
+
+#if WINOTP_PLATFORM_WINDOWS
+    using OtpDaemonSocketHandle = SOCKET;
+#else
+    using OtpDaemonSocketHandle = int;
+#endif
+
+    struct OtpResourceTraitsSocket {
+        using HandleType = OtpDaemonSocketHandle;
+
+#if WINOTP_PLATFORM_WINDOWS
+        static inline const HandleType InvalidValue = INVALID_SOCKET;
+#else
+        static inline const HandleType InvalidValue = -1;
+#endif
+
+        [[nodiscard]]
+        static bool IsValid(const HandleType& Handle) noexcept {
+            return Handle != InvalidValue;
+        }
+
+        static void Release(const HandleType& Handle) noexcept {
+#if WINOTP_PLATFORM_WINDOWS
+            closesocket(Handle);
+#else
+            close(Handle);
+#endif
+        }
+    };
+
+    using OtpDaemonSocket = Internal::OtpResource<OtpResourceTraitsSocket>;
+
+    [[noreturn]]
+    inline void OtpDaemonThrowLastError() {
+#if WINOTP_PLATFORM_WINDOWS
+        throw std::system_error(WSAGetLastError(), std::system_category());
+#else
+        throw std::system_error(errno, std::generic_category());
+#endif
+    }
+
+    [[nodiscard]]
+    inline bool OtpDaemonWouldBlock() noexcept {
+#if WINOTP_PLATFORM_WINDOWS
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+    }
+
+    //
+    // Winsock must be started once per process before any socket call; POSIX needs nothing.
+    //
+    class OtpDaemonNetwork {
+    public:
+
+        OtpDaemonNetwork() {
+#if WINOTP_PLATFORM_WINDOWS
+            WSADATA WsaData;
+            int Error = WSAStartup(MAKEWORD(2, 2), &WsaData);
+            if (Error != 0) {
+                throw std::system_error(Error, std::system_category());
+            }
+#endif
+        }
+
+        OtpDaemonNetwork(const OtpDaemonNetwork& Other) = delete;
+
+        OtpDaemonNetwork& operator=(const OtpDaemonNetwork& Other) = delete;
+
+        ~OtpDaemonNetwork() {
+#if WINOTP_PLATFORM_WINDOWS
+            WSACleanup();
+#endif
+        }
+    };
+
+    [[nodiscard]]
+    inline sockaddr_un OtpDaemonAddress(const char* lpszPath) {
+        sockaddr_un Address = {};
+        Address.sun_family = AF_UNIX;
+
+        if (strlen(lpszPath) >= sizeof(Address.sun_path)) {
+            throw std::length_error("Socket path is too long.");
+        }
+
+        memcpy(Address.sun_path, lpszPath, strlen(lpszPath));
+        return Address;
+    }
+
+    inline void OtpDaemonSetNonBlocking(OtpDaemonSocketHandle Socket) {
+#if WINOTP_PLATFORM_WINDOWS
+        u_long NonBlocking = 1;
+        if (ioctlsocket(Socket, FIONBIO, &NonBlocking) != 0) {
+            OtpDaemonThrowLastError();
+        }
+#else
+        int Flags = fcntl(Socket, F_GETFL, 0);
+        if (Flags < 0 || fcntl(Socket, F_SETFL, Flags | O_NONBLOCK) != 0) {
+            OtpDaemonThrowLastError();
+        }
+#endif
+    }
+
+    //
+    // a non-blocking listening socket bound to lpszPath. A socket file left behind by a previous run is
+    // removed first.
+    //
+    [[nodiscard]]
+    inline OtpDaemonSocket OtpDaemonListen(const char* lpszPath) {
+        sockaddr_un Address = OtpDaemonAddress(lpszPath);
+        OtpDaemonSocket Listener(socket(AF_UNIX, SOCK_STREAM, 0));
+
+        if (Listener.IsValid() == false) {
+            OtpDaemonThrowLastError();
+        }
+
+#if WINOTP_PLATFORM_WINDOWS
+        DeleteFileA(lpszPath);
+#else
+        unlink(lpszPath);
+#endif
+
+        if (bind(Listener.Get(), reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0 || listen(Listener.Get(), SOMAXCONN) != 0) {
+            OtpDaemonThrowLastError();
+        }
+
+        OtpDaemonSetNonBlocking(Listener.Get());
+        return Listener;
+    }
+
+    //
+    // a blocking connection to the daemon listening on lpszPath.
+    //
+    [[nodiscard]]
+    inline OtpDaemonSocket OtpDaemonConnect(const char* lpszPath) {
+        sockaddr_un Address = OtpDaemonAddress(lpszPath);
+        OtpDaemonSocket Connection(socket(AF_UNIX, SOCK_STREAM, 0));
+
+        if (Connection.IsValid() == false || connect(Connection.Get(), reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0) {
+            OtpDaemonThrowLastError();
+        }
+
+        return Connection;
+    }
+
+    //
+    // an invalid socket when no connection is pending.
+    //
+    [[nodiscard]]
+    inline OtpDaemonSocket OtpDaemonAccept(OtpDaemonSocketHandle Listener) {
+        OtpDaemonSocket Connection(accept(Listener, nullptr, nullptr));
+
+        if (Connection.IsValid()) {
+            OtpDaemonSetNonBlocking(Connection.Get());
+        } else if (OtpDaemonWouldBlock() == false) {
+            OtpDaemonThrowLastError();
+        }
+
+        return Connection;
+    }
+
+    //
+    // bytes received, 0 once the peer is gone (closed or reset), or std::nullopt if a non-blocking socket
+    // has nothing to read.
+    //
+    [[nodiscard]]
+    inline std::optional<OtpTypeSize> OtpDaemonReceive(OtpDaemonSocketHandle Socket, void* lpBuffer, OtpTypeSize cbBuffer) noexcept {
+#if WINOTP_PLATFORM_WINDOWS
+        int cbReceived = recv(Socket, reinterpret_cast<char*>(lpBuffer), static_cast<int>(cbBuffer > INT32_MAX ? INT32_MAX : cbBuffer), 0);
+#else
+        ssize_t cbReceived = recv(Socket, lpBuffer, cbBuffer, 0);
+#endif
+
+        if (cbReceived >= 0) {
+            return static_cast<OtpTypeSize>(cbReceived);
+        } else if (OtpDaemonWouldBlock()) {
+            return std::nullopt;
+        } else {
+            return 0;
+        }
+    }
+
+    //
+    // bytes sent, 0 once the peer is gone, or std::nullopt if a non-blocking socket's buffer is full.
+    // cbBuffer must not be 0.
+    //
+    [[nodiscard]]
+    inline std::optional<OtpTypeSize> OtpDaemonSend(OtpDaemonSocketHandle Socket, const void* lpBuffer, OtpTypeSize cbBuffer) noexcept {
+#if WINOTP_PLATFORM_WINDOWS
+        int cbSent = send(Socket, reinterpret_cast<const char*>(lpBuffer), static_cast<int>(cbBuffer > INT32_MAX ? INT32_MAX : cbBuffer), 0);
+#else
+        ssize_t cbSent = send(Socket, lpBuffer, cbBuffer, MSG_NOSIGNAL);
+#endif
+
+        if (cbSent >= 0) {
+            return static_cast<OtpTypeSize>(cbSent);
+        } else if (OtpDaemonWouldBlock()) {
+            return std::nullopt;
+        } else {
+            return 0;
+        }
+    }
+
+    //
+    // readiness notification for one event loop: level-triggered epoll on Linux, WSAPoll on Windows, which
+    // has no epoll. Each watched socket carries a context pointer that is handed back with its events.
+    //
+    class OtpDaemonPoller {
+    public:
+
+        struct Event {
+            void*   lpContext;
+            bool    Readable;   // also set when the peer hung up, so that the next receive reports it
+            bool    Writable;
+        };
+
+    private:
+
+#if WINOTP_PLATFORM_WINDOWS
+        std::vector<WSAPOLLFD>                                  m_Sockets;
+        std::vector<void*>                                      m_Contexts;
+        std::unordered_map<OtpDaemonSocketHandle, OtpTypeSize>  m_Indices;
+
+        [[nodiscard]]
+        static SHORT MakeEvents(bool WantRead, bool WantWrite) noexcept {
+            return static_cast<SHORT>((WantRead ? POLLRDNORM : 0) | (WantWrite ? POLLWRNORM : 0));
+        }
+#else
+        OtpDaemonSocket m_Epoll;
+
+        [[nodiscard]]
+        static uint32_t MakeEvents(bool WantRead, bool WantWrite) noexcept {
+            return (WantRead ? static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP) : 0) | (WantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0);
+        }
+
+        void Control(int Operation, OtpDaemonSocketHandle Socket, uint32_t Events, void* lpContext) {
+            epoll_event Event = {};
+            Event.events = Events;
+            Event.data.ptr = lpContext;
+
+            if (epoll_ctl(m_Epoll.Get(), Operation, Socket, &Event) != 0) {
+                OtpDaemonThrowLastError();
+            }
+        }
+#endif
+
+    public:
+
+        OtpDaemonPoller() {
+#if WINOTP_PLATFORM_WINDOWS == 0
+            m_Epoll = OtpDaemonSocket(epoll_create1(EPOLL_CLOEXEC));
+            if (m_Epoll.IsValid() == false) {
+                OtpDaemonThrowLastError();
+            }
+#endif
+        }
+
+        OtpDaemonPoller(const OtpDaemonPoller& Other) = delete;
+
+        OtpDaemonPoller& operator=(const OtpDaemonPoller& Other) = delete;
+
+        //
+        // Exclusive asks the kernel to wake only one of the pollers watching a shared socket, such as the
+        // listener every event loop accepts from. Ignored where that is not supported.
+        //
+        void Watch(OtpDaemonSocketHandle Socket, void* lpContext, bool WantRead, bool WantWrite, bool Exclusive = false) {
+#if WINOTP_PLATFORM_WINDOWS
+            static_cast<void>(Exclusive);
+
+            if (m_Indices.count(Socket) != 0) {
+                throw std::invalid_argument("Socket is already watched.");
+            }
+
+            m_Sockets.push_back(WSAPOLLFD{ Socket, MakeEvents(WantRead, WantWrite), 0 });
+            m_Contexts.push_back(lpContext);
+            m_Indices.emplace(Socket, m_Sockets.size() - 1);
+#else
+            uint32_t Events = MakeEvents(WantRead, WantWrite);
+#if defined(EPOLLEXCLUSIVE)
+            if (Exclusive) {
+                // EPOLLEXCLUSIVE only combines with EPOLLIN, EPOLLOUT, EPOLLWAKEUP and EPOLLET.
+                Events = (Events & ~static_cast<uint32_t>(EPOLLRDHUP)) | EPOLLEXCLUSIVE;
+            }
+#else
+            static_cast<void>(Exclusive);
+#endif
+            Control(EPOLL_CTL_ADD, Socket, Events, lpContext);
+#endif
+        }
+
+        void Modify(OtpDaemonSocketHandle Socket, void* lpContext, bool WantRead, bool WantWrite) {
+#if WINOTP_PLATFORM_WINDOWS
+            auto Index = m_Indices.find(Socket);
+            if (Index == m_Indices.end()) {
+                throw std::invalid_argument("Socket is not watched.");
+            }
+
+            m_Sockets[Index->second].events = MakeEvents(WantRead, WantWrite);
+            m_Contexts[Index->second] = lpContext;
+#else
+            Control(EPOLL_CTL_MOD, Socket, MakeEvents(WantRead, WantWrite), lpContext);
+#endif
+        }
+
+        //
+        // must be called before the socket is closed.
+        //
+        void Forget(OtpDaemonSocketHandle Socket) noexcept {
+#if WINOTP_PLATFORM_WINDOWS
+            auto Index = m_Indices.find(Socket);
+            if (Index != m_Indices.end()) {
+                OtpTypeSize i = Index->second;
+                m_Indices.erase(Index);
+
+                if (i != m_Sockets.size() - 1) {
+                    m_Sockets[i] = m_Sockets.back();
+                    m_Contexts[i] = m_Contexts.back();
+                    m_Indices[m_Sockets[i].fd] = i;
+                }
+
+                m_Sockets.pop_back();
+                m_Contexts.pop_back();
+            }
+#else
+            epoll_ctl(m_Epoll.Get(), EPOLL_CTL_DEL, Socket, nullptr);
+#endif
+        }
+
+        //
+        // waits up to TimeoutMilliseconds (-1 is forever) and stores at most MaxEvents events. Returns the
+        // number stored, 0 on timeout.
+        //
+        [[nodiscard]]
+        OtpTypeSize Wait(Event* lpEvents, OtpTypeSize MaxEvents, int TimeoutMilliseconds) {
+#if WINOTP_PLATFORM_WINDOWS
+            int Ready = WSAPoll(m_Sockets.data(), static_cast<ULONG>(m_Sockets.size()), TimeoutMilliseconds);
+            if (Ready < 0) {
+                OtpDaemonThrowLastError();
+            }
+
+            OtpTypeSize Count = 0;
+
+            for (OtpTypeSize i = 0; i < m_Sockets.size() && Count < MaxEvents; ++i) {
+                SHORT Revents = m_Sockets[i].revents;
+                if (Revents != 0) {
+                    lpEvents[Count].lpContext = m_Contexts[i];
+                    lpEvents[Count].Readable = (Revents & (POLLRDNORM | POLLHUP | POLLERR)) != 0;
+                    lpEvents[Count].Writable = (Revents & (POLLWRNORM | POLLHUP | POLLERR)) != 0;
+                    ++Count;
+                }
+            }
+
+            return Count;
+#else
+            epoll_event Events[64];
+            int MaxCount = static_cast<int>(MaxEvents < 64 ? MaxEvents : 64);
+            int Ready = epoll_wait(m_Epoll.Get(), Events, MaxCount, TimeoutMilliseconds);
+
+            if (Ready < 0) {
+                if (errno == EINTR) {
+                    return 0;
+                }
+                OtpDaemonThrowLastError();
+            }
+
+            for (int i = 0; i < Ready; ++i) {
+                lpEvents[i].lpContext = Events[i].data.ptr;
+                lpEvents[i].Readable = (Events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0;
+                lpEvents[i].Writable = (Events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0;
+            }
+
+            return static_cast<OtpTypeSize>(Ready);
+#endif
+        }
+    };
+
+}
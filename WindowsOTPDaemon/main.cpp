@@ -0,0 +1,336 @@
+#include "OtpDaemonServer.hpp"
+#include "OtpDaemonLoadClient.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+using namespace WinOTP;
+using namespace WinOTP::Daemon;
+
+//
+// requests in the load client's workload; users beyond this are not exercised.
+//
+static constexpr OtpTypeSize WorkloadSize = 65536;
+
+//
+// lock-free, so the signal handler may read it.
+//
+static std::atomic<OtpDaemonServer*> RunningServer(nullptr);
+
+static_assert(std::atomic<OtpDaemonServer*>::is_always_lock_free);
+
+static void StopServer(int) {
+    OtpDaemonServer* lpServer = RunningServer.load();
+    if (lpServer != nullptr) {
+        lpServer->Stop();
+    }
+}
+
+static void PrintUsage() {
+    printf("Usage:\n");
+    printf("    WindowsOTPDaemon generate <enrolment file> <user count>\n");
+    printf("    WindowsOTPDaemon serve <enrolment file> <socket path> [threads]\n");
+    printf("    WindowsOTPDaemon load <enrolment file> <socket path> [connections] [depth] [seconds]\n");
+    printf("    WindowsOTPDaemon check\n");
+    printf("\n");
+    printf("serve answers OtpVerifyProtocol requests until interrupted. load replays codes for the users of the same\n");
+    printf("enrolment file against a running daemon and reports end-to-end verifications per second. check runs\n");
+    printf("the daemon's self-checks.\n");
+}
+
+//
+// users cycle through TOTP/SHA1, TOTP/SHA256 and HOTP/SHA1 credentials with 20- or 32-byte secrets.
+//
+static int RunGenerate(const char* lpszPath, OtpTypeSize UserCount) {
+    std::ofstream File(lpszPath, std::ios::binary | std::ios::trunc);
+
+    for (OtpTypeSize i = 0; i < UserCount && File.good(); ++i) {
+        bool Sha256 = i % 3 == 1;
+        OtpByteArray Secret(Sha256 ? 32 : 20);
+
+        for (OtpTypeSize j = 0; j < Secret.size(); ++j) {
+            Secret[j] = static_cast<OtpTypeByte>(Internal::OtpSplitMix64(i * 64 + j));
+        }
+
+        File << (1000 + i) << ',' << OtpBase32EncodeA(Secret) << (Sha256 ? ",SHA256," : ",SHA1,") << (6 + i % 3) << (i % 3 == 2 ? ",0\n" : ",30\n");
+    }
+
+    File.close();
+
+    if (File.fail()) {
+        printf("Cannot write %s.\n", lpszPath);
+        return 1;
+    }
+
+    printf("Wrote %zu users to %s.\n", UserCount, lpszPath);
+    return 0;
+}
+
+static void LoadStore(OtpCredentialStore& Store, const char* lpszPath) {
+    auto Result = OtpCredentialImportFileA(Store, lpszPath);
+
+    printf("Imported %zu credentials from %s in %.3f s.\n", Result.RecordCount, lpszPath, Result.Seconds);
+}
+
+static int RunServer(const char* lpszPath, const char* lpszSocketPath, unsigned ThreadCount) {
+    OtpCredentialStore Store;
+    LoadStore(Store, lpszPath);
+    OtpDaemonNetwork Network;
+    OtpDaemonServer Server(Store, lpszSocketPath);
+
+    RunningServer = &Server;
+    std::signal(SIGINT, StopServer);
+    std::signal(SIGTERM, StopServer);
+
+    printf("Listening on %s.\n", lpszSocketPath);
+    fflush(stdout);
+
+    Server.Run(ThreadCount);
+
+    RunningServer = nullptr;
+    printf("Served %llu requests in %llu batches over %llu connections.\n",
+        static_cast<unsigned long long>(Server.GetRequestCount()),
+        static_cast<unsigned long long>(Server.GetBatchCount()),
+        static_cast<unsigned long long>(Server.GetConnectionCount()));
+    return 0;
+}
+
+//
+// one request per user of the enrolment file, up to WorkloadSize: the current code of TOTP users and the
+// next counter's code of HOTP users, with every eighth code wrong and every sixteenth user unknown.
+// Expected statuses come from verifying the same requests against a local copy of the store.
+//
+[[nodiscard]]
+static OtpDaemonLoadClient::Workload MakeWorkload(const OtpCredentialStore& Store, const char* lpszPath) {
+    std::ifstream File(lpszPath, std::ios::binary);
+    std::string Line;
+    OtpDaemonLoadClient::Workload Load;
+    OtpTypeUInt64 Now = static_cast<OtpTypeUInt64>(time(nullptr));
+
+    while (Load.Requests.size() < WorkloadSize && std::getline(File, Line)) {
+        if (Line.empty() || Line[0] == '#') {
+            continue;
+        }
+
+        OtpCredentialStore::UserIdType UserId = strtoull(Line.c_str(), nullptr, 10);
+        OtpTypeSize i = Load.Requests.size();
+
+        if (Store.Contains(UserId) == false) {
+            continue;
+        }
+
+        OtpCredentialStore::VerifyRequest Request;
+        OtpTypeUInt32 Interval = Store.GetInterval(UserId);
+
+        if (Interval != 0) {
+            Request = OtpCredentialStore::VerifyRequest::Totp(UserId, Store.GenerateCode(UserId, Now / Interval), Now);
+        } else {
+            Request = OtpCredentialStore::VerifyRequest::Hotp(UserId, Store.GenerateCode(UserId, i + 1), i, 2);
+        }
+
+        if (i % 8 == 7) {
+            Request.Code = (Request.Code + 1) % 1000000;
+        }
+
+        if (i % 16 == 15) {
+            Request.UserId = UINT64_MAX - i;
+        }
+
+        Load.Requests.push_back(Request);
+    }
+
+    std::vector<OtpCredentialStore::VerifyResult> Results(Load.Requests.size());
+    Store.VerifyBatch(Load.Requests.data(), Load.Requests.size(), Results.data());
+
+    for (auto& Result : Results) {
+        Load.ExpectedStatuses.push_back(Result.Status);
+    }
+
+    return Load;
+}
+
+static int RunLoad(const char* lpszPath, const char* lpszSocketPath, unsigned ConnectionCount, OtpTypeSize Depth, double Seconds) {
+    OtpCredentialStore Store;
+    LoadStore(Store, lpszPath);
+    OtpDaemonLoadClient::Workload Workload = MakeWorkload(Store, lpszPath);
+
+    if (Workload.Requests.empty()) {
+        printf("%s has no users.\n", lpszPath);
+        return 1;
+    }
+
+    OtpDaemonNetwork Network;
+    auto Report = OtpDaemonLoadClient::Run(lpszSocketPath, Workload, ConnectionCount, Depth, Seconds);
+
+    printf("%u connections x %zu in flight: %.0f verifications/s, p50 %.1f us, p99 %.1f us\n",
+        ConnectionCount, Depth, Report.GetRequestsPerSecond(), Report.P50Microseconds, Report.P99Microseconds);
+    printf("%llu requests, %llu accepted, %llu unexpected responses\n",
+        static_cast<unsigned long long>(Report.RequestCount),
+        static_cast<unsigned long long>(Report.AcceptedCount),
+        static_cast<unsigned long long>(Report.MismatchCount));
+
+    return Report.MismatchCount == 0 ? 0 : 1;
+}
+
+#if WINOTP_PLATFORM_WINDOWS == 0
+//
+// one TOTP request for user 1 on a fresh connection; true if the daemon accepts it within five seconds.
+//
+[[nodiscard]]
+static bool CheckRoundTrip(const OtpCredentialStore& Store, const char* lpszSocketPath) {
+    OtpTypeUInt64 Now = static_cast<OtpTypeUInt64>(time(nullptr));
+    auto Request = OtpCredentialStore::VerifyRequest::Totp(1, Store.GenerateCode(1, Now / 30), Now);
+    OtpTypeByte Frame[OtpVerifyProtocolRequestSize];
+    OtpTypeByte Response[OtpVerifyProtocolResponseSize];
+    OtpTypeSize cbResponse = 0;
+
+    OtpVerifyProtocolEncodeRequest(7, Request, Frame);
+
+    try {
+        OtpDaemonSocket Client = OtpDaemonConnect(lpszSocketPath);
+        timeval Timeout = { 5, 0 };
+        setsockopt(Client.Get(), SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+
+        if (OtpDaemonSend(Client.Get(), Frame, sizeof(Frame)).value_or(0) == sizeof(Frame)) {
+            while (cbResponse < sizeof(Response)) {
+                auto cbReceived = OtpDaemonReceive(Client.Get(), Response + cbResponse, sizeof(Response) - cbResponse);
+                if (cbReceived.value_or(0) == 0) {
+                    break;
+                }
+                cbResponse += cbReceived.value();
+            }
+        }
+    } catch (const std::system_error&) {
+        return false;
+    }
+
+    return cbResponse == sizeof(Response) && OtpVerifyProtocolDecodeResponse(Response).Status == OtpVerifyProtocolStatus::Accepted;
+}
+
+//
+// a server whose process runs out of descriptors while clients keep connecting must ride it out: its event
+// loops stay up, and once descriptors are free again a new client is answered.
+//
+static bool CheckFileLimit() {
+    std::string SocketPath = "/tmp/WindowsOTPDaemon-check-" + std::to_string(getpid()) + ".sock";
+
+    OtpCredentialStore Store;
+    Store.Insert(1, OtpHashMode::Sha1, 6, 30, "12345678901234567890", 20);
+
+    OtpDaemonServer Server(Store, SocketPath.c_str());
+    std::exception_ptr ServerError;
+    std::thread ServerThread([&]() {
+        try {
+            Server.Run(2);
+        } catch (...) {
+            ServerError = std::current_exception();
+        }
+    });
+
+    // once a request is answered every event loop is set up, so the limit below only hits accept.
+    bool AnsweredBefore = CheckRoundTrip(Store, SocketPath.c_str());
+
+    rlimit OriginalLimit;
+    getrlimit(RLIMIT_NOFILE, &OriginalLimit);
+
+    rlimit Limit = OriginalLimit;
+    Limit.rlim_cur = Limit.rlim_cur < 64 ? Limit.rlim_cur : 64;
+    setrlimit(RLIMIT_NOFILE, &Limit);
+
+    //
+    // the clients share the server's descriptor table, so they run out too and the rest of them wait in the
+    // listen queue for an accept that fails.
+    //
+    std::vector<OtpDaemonSocket> Clients;
+    bool Exhausted = false;
+
+    try {
+        while (Clients.size() < 1024) {
+            Clients.push_back(OtpDaemonConnect(SocketPath.c_str()));
+        }
+    } catch (const std::system_error&) {
+        Exhausted = true;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(3 * OtpDaemonServer::AcceptBackoffMilliseconds));
+
+    Clients.clear();
+    setrlimit(RLIMIT_NOFILE, &OriginalLimit);
+
+    bool AnsweredAfter = CheckRoundTrip(Store, SocketPath.c_str());
+
+    Server.Stop();
+    ServerThread.join();
+    unlink(SocketPath.c_str());
+
+    if (AnsweredBefore == false || Exhausted == false || ServerError || AnsweredAfter == false) {
+        printf("OtpDaemonServer: %s\n",
+            AnsweredBefore == false ? "did not answer" :
+            Exhausted == false ? "never ran out of descriptors" :
+            ServerError ? "stopped on an accept failure" : "did not answer after descriptors were freed");
+        return false;
+    } else {
+        return true;
+    }
+}
+#endif
+
+static int RunCheck() {
+#if WINOTP_PLATFORM_WINDOWS == 0
+    if (CheckFileLimit() == false) {
+        return 1;
+    }
+#endif
+
+    printf("All checks passed.\n");
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc == 2 && strcmp(argv[1], "check") == 0) {
+            return RunCheck();
+        }
+
+        if (argc == 4 && strcmp(argv[1], "generate") == 0) {
+            return RunGenerate(argv[2], strtoull(argv[3], nullptr, 10));
+        }
+
+        if ((argc == 4 || argc == 5) && strcmp(argv[1], "serve") == 0) {
+            return RunServer(argv[2], argv[3], argc > 4 ? atoi(argv[4]) : 0);
+        }
+
+        if (4 <= argc && argc <= 7 && strcmp(argv[1], "load") == 0) {
+            unsigned ConnectionCount = argc > 4 ? atoi(argv[4]) : 4;
+            OtpTypeSize Depth = argc > 5 ? strtoull(argv[5], nullptr, 10) : 128;
+            double Seconds = argc > 6 ? atof(argv[6]) : 5;
+
+            if (ConnectionCount == 0 || Depth == 0 || Depth > 16384 || Seconds <= 0) {
+                printf("Connections must be positive, depth 1 to 16384 and seconds positive.\n");
+                return 1;
+            }
+
+            return RunLoad(argv[2], argv[3], ConnectionCount, Depth, Seconds);
+        }
+    } catch (const std::exception& Exception) {
+        printf("Error: %s\n", Exception.what());
+        return 1;
+    }
+
+    PrintUsage();
+    return 1;
+}